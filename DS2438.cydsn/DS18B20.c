@@ -0,0 +1,57 @@
+/********************************************
+*
+*   \brief Source code for the DS18B20 driver.
+*
+**********************************************/
+
+#include "DS18B20.h"
+#include "OneWire.h"
+#include "project.h"
+
+static const OneWire_Conversion DS18B20_Conversions[] = {
+    {DS18B20_CONVERT_T, DS18B20_CONVERSION_TIME_US},
+};
+
+// Commands that change the state of the DS18B20; READ POWER SUPPLY
+// only answers read slots, which a broadcast does not issue
+static uint8_t DS18B20_DriverIgnores(uint8_t command)
+{
+    switch (command)
+    {
+        case DS18B20_CONVERT_T:
+        case DS18B20_READ_SCRATCHPAD:
+        case DS18B20_WRITE_SCRATCHPAD:
+        case DS18B20_COPY_SCRATCHPAD:
+        case DS18B20_RECALL_E2:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+static uint8_t DS18B20_DriverRead(OneWire_Device* device)
+{
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(device->pin, DS18B20_READ_SCRATCHPAD);
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        device->data[i] = OneWire_ReadByte(device->pin);
+    }
+    if (OneWire_Crc8(device->data, 8) != device->data[8])
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+const OneWire_Driver DS18B20_Driver = {
+    DS18B20_FAMILY_CODE, "DS18B20", DS18B20_Conversions, 1, DS18B20_DriverIgnores, DS18B20_DriverRead
+};
+
+uint8_t DS18B20_GetTemperature(const OneWire_Device* device, float* temperature)
+{
+    if (device->error == DS2438_OK)
+        *temperature = (int16_t)((device->data[1] << 8) | device->data[0]) / 16.0;
+    return device->error;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,63 @@
+/**
+ * \file DS18B20.h
+ * \brief DS18B20 driver of the 1-Wire device layer.
+ *
+ * At each sample cycle of OneWire_Device.h, the driver converts the
+ * temperature, at the resolution set in the configuration register
+ * (12 bits, 750 ms, at power-on), and reads the scratchpad. CONVERT T is
+ * also the temperature conversion command of the DS2438, so the sample
+ * cycle starts both families with one transaction. The sensors must be
+ * powered by VDD: the driver does not drive the strong pull-up needed by
+ * parasite-powered sensors during a conversion.
+*/
+#ifndef __DS18B20_H__
+    #define __DS18B20_H__
+
+    #include "cytypes.h"
+    #include "OneWire_Device.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Family code of the DS18B20.
+    */
+    #define DS18B20_FAMILY_CODE     0x28
+
+    // ===========================================================
+    //                      COMMANDS
+    // ===========================================================
+
+    #define DS18B20_CONVERT_T           0x44    ///< Start a temperature conversion
+    #define DS18B20_READ_SCRATCHPAD     0xBE    ///< Read the 9 bytes of the scratchpad
+    #define DS18B20_WRITE_SCRATCHPAD    0x4E    ///< Write the alarm and configuration registers
+    #define DS18B20_COPY_SCRATCHPAD     0x48    ///< Copy the registers to EEPROM
+    #define DS18B20_RECALL_E2           0xB8    ///< Recall the registers from EEPROM
+    #define DS18B20_READ_POWER_SUPPLY   0xB4    ///< Read slots return 0 if parasite-powered
+
+    /**
+    *   \brief Longest conversion time, at 12-bit resolution, in us.
+    */
+    #define DS18B20_CONVERSION_TIME_US  750000
+
+    /**
+    *   \brief Driver to register with #OneWire_RegisterDriver().
+    */
+    extern const OneWire_Driver DS18B20_Driver;
+
+    /**
+    *   \brief Get the temperature read by the last sample cycle.
+    *
+    *   \param device pointer to a DS18B20 device.
+    *   \param temperature pointer to variable where the temperature, in degree Celsius, will be stored.
+    *   \return the result of the last read of the device.
+    */
+    uint8_t DS18B20_GetTemperature(const OneWire_Device* device, float* temperature);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,120 @@
+/********************************************
+*
+*   \brief Source code for the DS2431 driver.
+*
+*   The CRC16 sent by the device is inverted, and covers
+*   the command and all the bytes of the transaction.
+*
+**********************************************/
+
+#include "DS2431.h"
+#include "OneWire.h"
+#include "project.h"
+#include <string.h>
+
+// Ending offset of a whole row, and flags of the scratchpad status
+#define ES_ROW          0x07
+#define ES_PF           0x20
+
+static uint8_t DS2431_DriverIgnores(uint8_t command)
+{
+    switch (command)
+    {
+        case DS2431_WRITE_SCRATCHPAD:
+        case DS2431_READ_SCRATCHPAD:
+        case DS2431_COPY_SCRATCHPAD:
+        case DS2431_READ_MEMORY:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+const OneWire_Driver DS2431_Driver = {
+    DS2431_FAMILY_CODE, "DS2431", NULL, 0, DS2431_DriverIgnores, NULL
+};
+
+// Read the inverted CRC16 sent by the device and check it
+static uint8_t DS2431_CheckCrc(const OneWire_Device* device, uint16_t crc)
+{
+    uint8_t received[2];
+    received[0] = OneWire_ReadByte(device->pin);
+    received[1] = OneWire_ReadByte(device->pin);
+    crc = ~crc;
+    if ((received[0] != (crc & 0xFF)) || (received[1] != (crc >> 8)))
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+uint8_t DS2431_ReadMemory(const OneWire_Device* device, uint8_t address, uint8_t* buffer, uint8_t length)
+{
+    if ((uint16_t)address + length > DS2431_MEMORY_SIZE)
+        return DS2438_BAD_PARAM;
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(device->pin, DS2431_READ_MEMORY);
+    OneWire_WriteByte(device->pin, address);
+    OneWire_WriteByte(device->pin, 0x00);
+    for (uint8_t i = 0; i < length; i++)
+    {
+        buffer[i] = OneWire_ReadByte(device->pin);
+    }
+    return DS2438_OK;
+}
+
+uint8_t DS2431_WriteRow(const OneWire_Device* device, uint8_t address, const uint8_t* data)
+{
+    uint8_t header[4] = {DS2431_WRITE_SCRATCHPAD, address, 0x00, 0x00};
+    uint8_t row[8];
+
+    if (((address & 0x07) != 0) || (address >= DS2431_MEMORY_SIZE))
+        return DS2438_BAD_PARAM;
+
+    // Write the scratchpad
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        OneWire_WriteByte(device->pin, header[i]);
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        OneWire_WriteByte(device->pin, data[i]);
+    }
+    if (DS2431_CheckCrc(device, OneWire_Crc16(data, 8, OneWire_Crc16(header, 3, 0))) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+
+    // Read it back, with the status needed to authorize the copy
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    header[0] = DS2431_READ_SCRATCHPAD;
+    OneWire_WriteByte(device->pin, header[0]);
+    for (uint8_t i = 1; i < 4; i++)
+    {
+        header[i] = OneWire_ReadByte(device->pin);
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        row[i] = OneWire_ReadByte(device->pin);
+    }
+    if (DS2431_CheckCrc(device, OneWire_Crc16(row, 8, OneWire_Crc16(header, 4, 0))) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    if ((header[1] != address) || (header[2] != 0x00) || ((header[3] & (ES_PF | ES_ROW)) != ES_ROW) ||
+        (memcmp(row, data, 8) != 0))
+        return DS2438_CRC_FAIL;
+
+    // Program the row; the device answers 0xAA once done
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    header[0] = DS2431_COPY_SCRATCHPAD;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        OneWire_WriteByte(device->pin, header[i]);
+    }
+    CyDelay(DS2431_PROG_TIME_MS);
+    if (OneWire_ReadByte(device->pin) != 0xAA)
+        return DS2438_ERROR;
+    return DS2438_OK;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,85 @@
+/**
+ * \file DS2431.h
+ * \brief DS2431 driver of the 1-Wire device layer.
+ *
+ * The DS2431 is a 1024-bit EEPROM: 128 bytes of memory in rows of 8
+ * bytes, followed by protection registers. It has no conversion, so the
+ * sample cycles of OneWire_Device.h skip it, and it ignores the conversion
+ * commands of the other families, which can then be sent to all the
+ * devices of a bus shared with it. The memory is accessed with the
+ * functions below, between sample cycles.
+*/
+#ifndef __DS2431_H__
+    #define __DS2431_H__
+
+    #include "cytypes.h"
+    #include "OneWire_Device.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Family code of the DS2431.
+    */
+    #define DS2431_FAMILY_CODE      0x2D
+
+    /**
+    *   \brief Size of the memory and of the registers, in bytes.
+    */
+    #define DS2431_MEMORY_SIZE      0x90
+
+    /**
+    *   \brief Longest programming time of a row, in ms.
+    */
+    #define DS2431_PROG_TIME_MS     10
+
+    // ===========================================================
+    //                      COMMANDS
+    // ===========================================================
+
+    #define DS2431_WRITE_SCRATCHPAD     0x0F    ///< Write a row to the scratchpad
+    #define DS2431_READ_SCRATCHPAD      0xAA    ///< Read back the scratchpad
+    #define DS2431_COPY_SCRATCHPAD      0x55    ///< Program the scratchpad into memory
+    #define DS2431_READ_MEMORY          0xF0    ///< Read the memory from an address
+
+    /**
+    *   \brief Driver to register with #OneWire_RegisterDriver().
+    */
+    extern const OneWire_Driver DS2431_Driver;
+
+    /**
+    *   \brief Read the memory.
+    *
+    *   \param device pointer to a DS2431 device.
+    *   \param address address of the first byte.
+    *   \param buffer array where the bytes will be stored.
+    *   \param length number of bytes to read.
+    *   \retval #DS2438_OK if the bytes were read.
+    *   \retval #DS2438_DEV_NOT_FOUND if the device did not answer.
+    *   \retval #DS2438_BAD_PARAM if the bytes are not in the memory.
+    */
+    uint8_t DS2431_ReadMemory(const OneWire_Device* device, uint8_t address, uint8_t* buffer, uint8_t length);
+
+    /**
+    *   \brief Write a row of the memory.
+    *
+    *   The row is written to the scratchpad, read back and checked, then
+    *   programmed; the function blocks for #DS2431_PROG_TIME_MS.
+    *   \param device pointer to a DS2431 device.
+    *   \param address address of the row, a multiple of 8.
+    *   \param data the 8 bytes of the row.
+    *   \retval #DS2438_OK if the row was programmed.
+    *   \retval #DS2438_DEV_NOT_FOUND if the device did not answer.
+    *   \retval #DS2438_CRC_FAIL if the scratchpad was not written correctly.
+    *   \retval #DS2438_ERROR if the row was not programmed, e.g. write-protected.
+    *   \retval #DS2438_BAD_PARAM if the address is not the one of a row.
+    */
+    uint8_t DS2431_WriteRow(const OneWire_Device* device, uint8_t address, const uint8_t* data);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
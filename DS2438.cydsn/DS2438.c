@@ -1,777 +1,1212 @@
-/********************************************
-*
-*   \brief Source code for the DS2438 Library.
-*
-*   This file provides all the functions used
-*   to interface the micro-controller to 
-*   DS2438 smart battery monitors.
-*
-**********************************************/
-
-#include "DS2438.h"
-#include "OneWire.h"
-#include "project.h"
-
-static uint8_t crc_enabled = DS2438_DO_CRC_CHECK;
-
-// ===========================================================
-//                 INITIALIZATION FUNCTIONS
-// ===========================================================
-
-uint8_t DS2438_Start(void)
-{
-    return DS2438_IsDevicePresent();
-}
-
-uint8_t DS2438_IsDevicePresent(void)
-{
-    // check if device is present on the bus
-    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-    {
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_DEV_NOT_FOUND;
-    }
-}
-
-uint8_t DS2438_ReadSerialNumber(uint8_t* serial_number)
-{
-    // read rom and get serial number only
-    uint8_t temp_rom[8];
-    uint8_t error = DS2438_ReadRawRom(temp_rom);
-    if (error == DS2438_OK)
-    {
-        // get serial data
-        serial_number[0] = temp_rom[1];
-        serial_number[1] = temp_rom[2];
-        serial_number[2] = temp_rom[3];
-        serial_number[3] = temp_rom[4];
-        serial_number[4] = temp_rom[5];
-        serial_number[5] = temp_rom[6];
-    }
-    return error;
-}
-
-uint8_t DS2438_ReadRawRom(uint8_t* rom)
-{
-    // Reset sequence
-    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-    {
-        // Write read rom command
-        OneWire_WriteByte(DS2438_Pin_0, DS2438_READ_ROM);
-        // Read 8 bytes of rom
-        uint8_t loop;
-        for (loop = 0; loop < 8; loop++)
-        {
-            rom[loop] = OneWire_ReadByte(DS2438_Pin_0);
-        }
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(rom, 7, rom[7]) != DS2438_OK)
-                return DS2438_CRC_FAIL;
-        }
-        return DS2438_OK;
-    }
-    return DS2438_DEV_NOT_FOUND;
-}
-
-// ===========================================================
-//                  VOLTAGE CONVERSION FUNCTIONS
-// ===========================================================
-
-uint8_t DS2438_StartVoltageConversion(void)
-{
-    // Reset sequence
-    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-    {
-        // Write read rom command
-        OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-        OneWire_WriteByte(DS2438_Pin_0, DS2438_VOLTAGE_CONV);
-        return DS2438_OK;
-    }
-    
-    return DS2438_DEV_NOT_FOUND;
-    
-}
-
-uint8_t DS2438_HasVoltageData(void)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-
-        // Read bit
-        if ((page_data[0] & (0x01 << 6)) == 0)
-        {
-            return DS2438_OK;
-        }
-        else
-        {
-            return DS2438_ERROR;
-        }
-        
-    }
-    return DS2438_DEV_NOT_FOUND;
-}
-
-/*
-*   Get voltage data in float format. CRC check defined by parameter.
-*/
-uint8_t DS2438_GetVoltageData(float* voltage)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        uint8_t volt_lsb = page_data[3];
-        uint8_t volt_msb = page_data[4];
-        *voltage = ((volt_msb << 8) | ((volt_lsb & 0xFF))) / 100.0;
-        return DS2438_OK;
-    }
-
-    return DS2438_DEV_NOT_FOUND;
-}
-
-/*
-*   Get voltage data in raw format. CRC check defined by parameter.
-*/
-uint8_t DS2438_GetRawVoltageData(uint16_t* voltage)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        uint8_t volt_lsb = page_data[3];
-        uint8_t volt_msb = page_data[4];
-        *voltage = ((volt_msb << 8) | ((volt_lsb & 0xFF)));
-        return DS2438_OK;
-    }
-
-    return DS2438_DEV_NOT_FOUND;
-}
-
-/*
-*   Blocking read voltage data in float format. CRC check defined by parameter.
-*/
-
-uint8_t DS2438_ReadVoltage(float* voltage)
-{
-    uint8_t error = DS2438_StartVoltageConversion();
-    if (error == DS2438_OK)
-    {
-        while(DS2438_HasVoltageData() != DS2438_OK);
-        return DS2438_GetVoltageData(voltage);
-    }
-    return error;
-}
-
-/*
-*   Blocking read voltage data in raw format. CRC check defined by parameter.
-*/
-uint8_t DS2438_ReadRawVoltage(uint16_t* voltage)
-{
-    uint8_t error = DS2438_StartVoltageConversion();
-    if (error == DS2438_OK)
-    {
-        while(DS2438_HasVoltageData() != DS2438_OK);
-        return DS2438_GetRawVoltageData(voltage);
-    }
-    return error;
-}
-
-uint8_t DS2438_SelectInputSource(uint8_t input_source)
-{
-    // Read page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // crc check
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        // set bit based on input source in first byte of page 0
-        if (input_source == DS2438_INPUT_VOLTAGE_VDD)
-        {
-            // set bit
-            page_data[0] = page_data[0] | (0x08);
-        }
-        else if (input_source == DS2438_INPUT_VOLTAGE_VAD)
-        {
-            // clear bit
-            page_data[0] = page_data[0] & (0xF7);
-        }
-        else
-        {
-            return DS2438_BAD_PARAM;
-        }
-        // write page 0
-        error = DS2438_WritePage(0x00, page_data);
-        
-    }
-    return error;
-}
-
-// ===========================================================
-//                  TEMPERATURE CONVERSION FUNCTIONS
-// ===========================================================
-
-uint8_t DS2438_StartTemperatureConversion(void)
-{
-    // Reset sequence
-    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-    {
-        // Skip ROM and issue temperature conversion command
-        OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-        OneWire_WriteByte(DS2438_Pin_0, DS2438_TEMP_CONV);
-        return DS2438_OK;
-    }
-    
-    return DS2438_DEV_NOT_FOUND;
-}
-
-uint8_t DS2438_HasTemperatureData(void)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        // Read bit
-        if ((page_data[0] & (0x01 << 4)) == 0)
-        {
-            return DS2438_OK;
-        }
-        else
-        {
-            return DS2438_ERROR;
-        }
-
-    }
-    return DS2438_DEV_NOT_FOUND;
-}
-
-uint8_t DS2438_GetTemperatureData(float* temperature)
-{
-    // Read nine bytes
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-            
-        }
-        uint8_t temp_lsb = page_data[1];
-        uint8_t temp_msb = page_data[2];
-        *temperature = (((int16_t)temp_msb << 8) | ((temp_lsb & 0xFF) >> 3)) * 0.03125;
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_ERROR;
-    }  
-
-    
-    return DS2438_DEV_NOT_FOUND;
-}
-
-uint8_t DS2438_GetRawTemperatureData(uint16_t* temperature)
-{
-    // Read nine bytes
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-            
-        }
-        uint8_t temp_lsb = page_data[1];
-        uint8_t temp_msb = page_data[2];
-        *temperature = (temp_msb << 8) | (temp_lsb & 0xFF);
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_ERROR;
-    }  
-
-    
-    return DS2438_DEV_NOT_FOUND;
-}
-
-uint8_t DS2438_ReadTemperature(float* temperature)
-{
-    uint8_t error = DS2438_StartTemperatureConversion();
-    if (error == DS2438_OK)
-    {
-        while(DS2438_HasTemperatureData() != DS2438_OK);
-        return DS2438_GetTemperatureData(temperature);
-    }
-    return error;
-}
-
-/*
-*   Blocking read temperature data in raw format. CRC check defined by parameter.
-*/
-uint8_t DS2438_ReadRawTemperature(uint16_t* temperature)
-{
-    uint8_t error = DS2438_StartTemperatureConversion();
-    if (error == DS2438_OK)
-    {
-        while(DS2438_HasTemperatureData() != DS2438_OK);
-        return DS2438_GetRawTemperatureData(temperature);
-    }
-    return error;
-}
-
-// ===========================================================
-//             CURRENT AND ACCUMULATOR FUNCTIONS
-// ===========================================================
-
-// Get current data in float format
-uint8_t DS2438_GetCurrentData(float* current)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        uint8_t curr_lsb = page_data[5];
-        uint8_t curr_msb = page_data[6];
-        int16_t curr_data = 0;
-        // Get if positive or negative
-        if ((curr_msb & 0x03) > 1)
-        {
-            // current is negative
-            uint16_t data = (curr_msb<<8) | (curr_lsb);
-            // perform 2's complement
-            int16_t temp = (~data) & 0x3FF;
-            curr_data = (short)(temp * -1);
-        }
-        else
-        {
-            curr_data = (curr_msb << 8) | (curr_lsb & 0xFF);
-        }
-        
-        *current = (curr_data) / (4096.*DS2438_SENSE_RESISTOR);
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_ERROR;
-    }    
-    return DS2438_DEV_NOT_FOUND;
-}
-
-// Get current data in raw format
-uint8_t DS2438_GetRawCurrentData(uint16_t* current)
-{
-    uint8_t page_data[9];
-    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }
-        }
-        uint8_t curr_lsb = page_data[5];
-        uint8_t curr_msb = page_data[6];
-        int16_t curr_data = 0;
-        
-        *current = (curr_msb << 8) | (curr_lsb & 0xFF);
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_ERROR;
-    }    
-    return DS2438_DEV_NOT_FOUND;
-}
-
-// Get value of integrated current accumalator
-uint8_t DS2438_GetICA(uint8_t* ica)
-{
-    // Read byte 4 of page 1
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x01, page_data);
-    if (error == DS2438_OK)
-    {
-        if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-            {
-                return DS2438_CRC_FAIL;
-            }  
-        }
-        *ica = page_data[4];
-        
-    }   
-    return error;
-}
-
-uint8_t DS2438_GetCapacity(float* capacity)
-{
-    uint8_t error = DS2438_OK;
-    uint8_t ica = 0;
-    error = DS2438_GetICA(&ica);
-    if (error == DS2438_OK)
-    {
-        *capacity = ica/(2048.0*DS2438_SENSE_RESISTOR);
-    }
-    return error;
-}
-
-// Read current threshold value
-uint8_t DS2438_ReadThreshold(uint8_t* threshold)
-{
-    // Threshold is located at byte 7 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if ( error == DS2438_OK)
-    {
-            if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-                return DS2438_CRC_FAIL;
-        }
-        // Return two MSBs
-        *threshold = page_data[7] >> 6;
-    }
-    return error;
-}
-
-// Write current threshold value
-uint8_t DS2438_WriteThreshold(uint8_t threshold)
-{
-    if (threshold > 3)
-        return DS2438_BAD_PARAM;
-    // Threshold is located at byte 7 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    uint8_t IAD_active = 0;
-    if ( error == DS2438_OK)
-    {
-        
-        // Stop IAD 
-        if (page_data[0] | 0x01)
-        {
-            DS2438_DisableIAD();
-            IAD_active = 1;
-        }
-        
-        // Update threshold bits
-        page_data[7] = threshold << 6;
-        // Write new page data
-        DS2438_WritePage(0x00, page_data);
-        if (IAD_active == 1)
-        {
-            DS2438_EnableIAD();
-        }
-    }
-    return error;
-}
-
-uint8_t DS2438_WriteOffset(int16_t offset)
-{
-    // Offset is located at bytes 5-6 of page 1
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x01, page_data);
-    uint8_t IAD_active = 0;
-    if ( error == DS2438_OK)
-    {
-        
-        // Stop IAD 
-        if (page_data[0] | 0x01)
-        {
-            DS2438_DisableIAD();
-            IAD_active = 1;
-        }
-        // Keep 5 LSBs and shift them to the left by 3
-        uint8_t offset_lsb = ( (offset << 3) & 0xF8);
-        
-        // Keep 5 MSBs and shift them to the right by 8
-        uint8_t offset_msb = ( (offset & 0x3E0) >> 8);
-        // Update threshold bits
-        page_data[5] = offset_lsb;
-        page_data[6] = offset_msb;
-        // Write new page data
-        DS2438_WritePage(0x00, page_data);
-        if (IAD_active == 1)
-        {
-            DS2438_EnableIAD();
-        }
-    }
-    return error;
-}
-
-uint8_t DS2438_ReadOffset(uint16_t* offset)
-{
-    // Offset is located at bytes 5-6 of page 1
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x01, page_data);
-    if ( error == DS2438_OK)
-    {
-         if (crc_enabled == DS2438_DO_CRC_CHECK)
-        {
-            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
-                return DS2438_CRC_FAIL;
-        }
-        // Return two MSBs
-        *offset = (page_data[6] << 8 | page_data[5]);
-    }
-    return error;
-}
-
-// Enable current measurement and ICA
-uint8_t DS2438_EnableIAD(void)
-{
-    // Set bit 0 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // set bit 0
-        page_data[0] = page_data[0] | 0x01;
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-}
-
-uint8_t DS2438_DisableIAD(void)
-{
-    // Clear bit 0 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // Clear bit 0
-        page_data[0] = page_data[0] & (~0x01);
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-}
-
-uint8_t DS2438_EnableCA(void)
-{
-    // Set bit 1 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // set bit 0
-        page_data[0] = page_data[0] | 0x02;
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-    
-}
-
-uint8_t DS2438_DisableCA(void)
-{
-    // Clear bit 1 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // Clear bit 0
-        page_data[0] = page_data[0] & (~0x02);
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-}
-
-uint8_t DS2438_EnableShadowEE(void)
-{
-    // Set bit 2 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // set bit 2
-        page_data[0] = page_data[0] | 0x04;
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-}
-
-
-uint8_t DS2438_DisableShadowEE(void)
-{
-    // Clear bit 2 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        // Clear bit 2
-        page_data[0] = page_data[0] & (~0x04);
-        return DS2438_WritePage(0x00, page_data);
-    }
-    return error;
-}
-
-uint8_t DS2438_CopyInProgress(uint8_t* copy)
-{
-     // Read bit 5 in byte 0 of page 0
-    uint8_t page_data[9];
-    uint8_t error = DS2438_ReadPage(0x00, page_data);
-    if (error == DS2438_OK)
-    {
-        *copy = page_data[0] & 0x20;
-    }
-    return error;
-}
-
-    
-// ===========================================================
-//                    LOW LEVEL FUNCTIONS
-// ===========================================================
-// Read one page of data
-uint8_t DS2438_ReadPage(uint8_t page_number, uint8_t* page_data)
-{
-    if (page_number > 0x07)
-        return DS2438_BAD_PARAM;
-    else
-    {
-        // Reset sequence
-        if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-        {
-            // Skip ROM command 
-            OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-            // Recall memory command
-            OneWire_WriteByte(DS2438_Pin_0, DS2438_RECALL_MEMORY);
-            // Page number
-            OneWire_WriteByte(DS2438_Pin_0, page_number);
-            if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-            {
-                // Skip ROM command 
-                OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-                // Read scratchpad command
-                OneWire_WriteByte(DS2438_Pin_0, DS2438_READ_SCRATCHPAD);
-                // Page 0
-                OneWire_WriteByte(DS2438_Pin_0, page_number);
-                // Read nine bytes
-                for (uint8_t i = 0; i < 9; i++)
-                {
-                    page_data[i] = OneWire_ReadByte(DS2438_Pin_0);
-                }
-                return DS2438_OK;
-                
-            }
-        }
-    }
-    return DS2438_DEV_NOT_FOUND;
-}
-
-// Write one page of data
-uint8_t DS2438_WritePage(uint8_t page_number, uint8_t* page_data)
-{
-    if (page_number > 0x07)
-        return DS2438_BAD_PARAM;
-    else
-    {
-        // Reset sequence
-        if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-        {
-            // Skip ROM command 
-            OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-            // Write scratchpad command
-            OneWire_WriteByte(DS2438_Pin_0, DS2438_WRITE_SCRATCHPAD);
-            // Write page data followed by page data
-            OneWire_WriteByte(DS2438_Pin_0, page_number);
-            for (uint8_t i = 0; i < 9; i++)
-            {
-                OneWire_WriteByte(DS2438_Pin_0, page_data[i]);
-            }
-            if (OneWire_TouchReset(DS2438_Pin_0) == 0)
-            {
-                // Skip ROM command 
-                OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
-                // Copy scratchpad command
-                OneWire_WriteByte(DS2438_Pin_0, DS2438_COPY_SCRATCHPAD);
-                // Write page number
-                OneWire_WriteByte(DS2438_Pin_0, page_number);
-                return DS2438_OK;
-            }
-        }
-    }
-    return DS2438_DEV_NOT_FOUND;
-}
-
-// Check if retrieved CRC value is equal to the computed one
-uint8_t DS2438_CheckCrcValue(uint8_t* data, uint8_t len, uint8_t crc_value)
-{
-    uint8_t computed_crc = DS2438_ComputeCrc(data, len);
-    if (computed_crc == crc_value)
-    {
-        return DS2438_OK;
-    }
-    else
-    {
-        return DS2438_CRC_FAIL;
-    }
-}
-
-// Compute CRC value
-uint8_t DS2438_ComputeCrc(const uint8_t *data, uint8_t len)
-{
-	uint8_t crc = 0;
-
-	while (len--) {
-
-		uint8_t inbyte = *data++;
-		for (uint8_t i = 8; i; i--) {
-			uint8_t mix = (crc ^ inbyte) & 0x01;
-			crc >>= 1;
-			if (mix) crc ^= 0x8C;
-			inbyte >>= 1;
-		}
-	}
-	return crc;
-
-}
-/* [] END OF FILE */
+/********************************************
+*
+*   \brief Source code for the DS2438 Library.
+*
+*   This file provides all the functions used
+*   to interface the micro-controller to 
+*   DS2438 smart battery monitors.
+*
+**********************************************/
+
+#include "DS2438.h"
+#include "DS2438_Cache.h"
+#include "DS2438_Snapshot.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include "project.h"
+
+static uint8_t crc_enabled = DS2438_DO_CRC_CHECK;
+
+static uint8_t DS2438_WaitConversion(void);
+static uint8_t DS2438_ReadPageFromDevice(uint8_t page_number, uint8_t* page_data);
+static uint8_t DS2438_ReadScratchpadFromDevice(uint8_t page_number, uint8_t* page_data);
+
+// Cache of the pages of the device
+static DS2438_PageCache page_cache;
+
+// Last copy scratchpad command issued to the device
+static DS2438_CopyToken last_copy;
+static uint8_t copy_pending = 0;
+static uint16_t copy_sequence = 0;
+
+// Time of the last recall memory command
+static uint32_t last_recall_us = 0;
+
+// ===========================================================
+//                 INITIALIZATION FUNCTIONS
+// ===========================================================
+
+uint8_t DS2438_Start(void)
+{
+    Timebase_Start();
+    DS2438_CacheInit(&page_cache);
+    return DS2438_IsDevicePresent();
+}
+
+uint8_t DS2438_IsDevicePresent(void)
+{
+    // check if device is present on the bus
+    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+    {
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_DEV_NOT_FOUND;
+    }
+}
+
+uint8_t DS2438_ReadSerialNumber(uint8_t* serial_number)
+{
+    // read rom and get serial number only
+    uint8_t temp_rom[8];
+    uint8_t error = DS2438_ReadRawRom(temp_rom);
+    if (error == DS2438_OK)
+    {
+        // get serial data
+        serial_number[0] = temp_rom[1];
+        serial_number[1] = temp_rom[2];
+        serial_number[2] = temp_rom[3];
+        serial_number[3] = temp_rom[4];
+        serial_number[4] = temp_rom[5];
+        serial_number[5] = temp_rom[6];
+    }
+    return error;
+}
+
+uint8_t DS2438_ReadRawRom(uint8_t* rom)
+{
+    // Reset sequence
+    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+    {
+        // Write read rom command
+        OneWire_WriteByte(DS2438_Pin_0, DS2438_READ_ROM);
+        // Read 8 bytes of rom
+        uint8_t loop;
+        for (loop = 0; loop < 8; loop++)
+        {
+            rom[loop] = OneWire_ReadByte(DS2438_Pin_0);
+        }
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(rom, 7, rom[7]) != DS2438_OK)
+                return DS2438_CRC_FAIL;
+        }
+        return DS2438_OK;
+    }
+    return DS2438_DEV_NOT_FOUND;
+}
+
+// ===========================================================
+//                  1-WIRE TIMING FUNCTIONS
+// ===========================================================
+
+// Read ROM several times and compare it with the reference one
+static uint8_t DS2438_VerifyTiming(const uint8_t* reference_rom)
+{
+    uint8_t rom[8];
+    for (uint8_t read = 0; read < DS2438_CALIBRATION_READS; read++)
+    {
+        if (DS2438_ReadRawRom(rom) != DS2438_OK)
+            return DS2438_ERROR;
+        if (DS2438_CheckCrcValue(rom, 7, rom[7]) != DS2438_OK)
+            return DS2438_CRC_FAIL;
+        for (uint8_t i = 0; i < 8; i++)
+        {
+            if (rom[i] != reference_rom[i])
+                return DS2438_ERROR;
+        }
+    }
+    return DS2438_OK;
+}
+
+uint8_t DS2438_CalibrateTiming(OneWire_Timing* calibrated)
+{
+    OneWire_Timing base, candidate;
+    uint8_t reference_rom[8];
+    uint8_t best_step = 0;
+    
+    // Reference ROM read with standard timing, using custom profile for candidates
+    OneWire_GetProfileTiming(ONEWIRE_PROFILE_STANDARD, &base);
+    OneWire_SetCustomTiming(&base);
+    OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_CUSTOM);
+    uint8_t error = DS2438_ReadRawRom(reference_rom);
+    if (error != DS2438_OK)
+        return error;
+    // A line that does not rise in time reads a ROM of zeros, whose CRC is valid
+    if (OneWire_CheckRom(reference_rom) != ONEWIRE_SEARCH_OK)
+        return DS2438_CRC_FAIL;
+    
+    // Try progressively shorter recovery times
+    for (uint8_t step = 1; step <= ONEWIRE_CALIBRATION_STEPS; step++)
+    {
+        OneWire_ShrinkTiming(&base, step, &candidate);
+        OneWire_SetCustomTiming(&candidate);
+        if (DS2438_VerifyTiming(reference_rom) != DS2438_OK)
+            break;
+        best_step = step;
+    }
+    
+    // Keep a safety margin from the fastest reliable timing
+    if (best_step > DS2438_CALIBRATION_MARGIN_STEPS)
+        best_step -= DS2438_CALIBRATION_MARGIN_STEPS;
+    else
+        best_step = 0;
+    OneWire_ShrinkTiming(&base, best_step, calibrated);
+    OneWire_SetCustomTiming(calibrated);
+    return DS2438_OK;
+}
+
+// ===========================================================
+//                  VOLTAGE CONVERSION FUNCTIONS
+// ===========================================================
+
+uint8_t DS2438_StartVoltageConversion(void)
+{
+    // Reset sequence
+    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+    {
+        // Write read rom command
+        OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+        OneWire_WriteByte(DS2438_Pin_0, DS2438_VOLTAGE_CONV);
+        DS2438_CacheInvalidate(&page_cache, 0x00);
+        return DS2438_OK;
+    }
+    
+    return DS2438_DEV_NOT_FOUND;
+    
+}
+
+uint8_t DS2438_HasVoltageData(void)
+{
+    // Busy flag must always be read from the device
+    uint8_t page_data[9];
+    if (DS2438_ReadPageFromDevice(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+
+        // Read bit
+        if ((page_data[0] & (0x01 << 6)) == 0)
+        {
+            return DS2438_OK;
+        }
+        else
+        {
+            return DS2438_ERROR;
+        }
+        
+    }
+    return DS2438_DEV_NOT_FOUND;
+}
+
+/*
+*   Get voltage data in float format. CRC check defined by parameter.
+*/
+uint8_t DS2438_GetVoltageData(float* voltage)
+{
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        uint8_t volt_lsb = page_data[3];
+        uint8_t volt_msb = page_data[4];
+        *voltage = ((volt_msb << 8) | ((volt_lsb & 0xFF))) / 100.0;
+        return DS2438_OK;
+    }
+
+    return DS2438_DEV_NOT_FOUND;
+}
+
+/*
+*   Get voltage data in raw format. CRC check defined by parameter.
+*/
+uint8_t DS2438_GetRawVoltageData(uint16_t* voltage)
+{
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        uint8_t volt_lsb = page_data[3];
+        uint8_t volt_msb = page_data[4];
+        *voltage = ((volt_msb << 8) | ((volt_lsb & 0xFF)));
+        return DS2438_OK;
+    }
+
+    return DS2438_DEV_NOT_FOUND;
+}
+
+/*
+*   Blocking read voltage data in float format. CRC check defined by parameter.
+*/
+
+uint8_t DS2438_ReadVoltage(float* voltage)
+{
+    uint8_t error = DS2438_StartVoltageConversion();
+    if (error == DS2438_OK)
+    {
+        while(DS2438_HasVoltageData() != DS2438_OK);
+        return DS2438_GetVoltageData(voltage);
+    }
+    return error;
+}
+
+/*
+*   Blocking read voltage data in raw format. CRC check defined by parameter.
+*/
+uint8_t DS2438_ReadRawVoltage(uint16_t* voltage)
+{
+    uint8_t error = DS2438_StartVoltageConversion();
+    if (error == DS2438_OK)
+    {
+        while(DS2438_HasVoltageData() != DS2438_OK);
+        return DS2438_GetRawVoltageData(voltage);
+    }
+    return error;
+}
+
+uint8_t DS2438_SelectInputSource(uint8_t input_source)
+{
+    // Read page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // crc check
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        // set bit based on input source in first byte of page 0
+        if (input_source == DS2438_INPUT_VOLTAGE_VDD)
+        {
+            // set bit
+            page_data[0] = page_data[0] | (0x08);
+        }
+        else if (input_source == DS2438_INPUT_VOLTAGE_VAD)
+        {
+            // clear bit
+            page_data[0] = page_data[0] & (0xF7);
+        }
+        else
+        {
+            return DS2438_BAD_PARAM;
+        }
+        // write page 0
+        error = DS2438_WritePage(0x00, page_data);
+        
+    }
+    return error;
+}
+
+/*
+*   Start a voltage conversion on the stored input source, wait for it
+*   and read back page 0 with the result.
+*/
+static uint8_t DS2438_ConvertVoltageNow(uint8_t* page_data)
+{
+    // Start conversion and wait for it in the same transaction
+    if (OneWire_TouchReset(DS2438_Pin_0) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_VOLTAGE_CONV);
+    DS2438_CacheInvalidate(&page_cache, 0x00);
+    if (DS2438_WaitConversion() != DS2438_OK)
+        return DS2438_ERROR;
+    
+    uint8_t error = DS2438_ReadPageFromDevice(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+    }
+    return error;
+}
+
+/*
+*   Store the AD bit of page 0 and wait for the end of the copy: the
+*   converter takes the input source from the stored configuration.
+*/
+static uint8_t DS2438_StoreInputSource(uint8_t input_source, uint8_t* page_data)
+{
+    DS2438_CopyToken token;
+    if (input_source == DS2438_INPUT_VOLTAGE_VDD)
+    {
+        page_data[0] = page_data[0] | 0x08;
+    }
+    else
+    {
+        page_data[0] = page_data[0] & 0xF7;
+    }
+    uint8_t error = DS2438_WritePageAsync(0x00, page_data, &token);
+    if (error == DS2438_OK)
+    {
+        error = DS2438_WaitCopy(&token);
+    }
+    return error;
+}
+
+uint8_t DS2438_ReadBothVoltages(uint16_t* vdd, uint16_t* vad)
+{
+    // First conversion on the stored input, its read-back gives the configuration,
+    // so whichever input the last call or DS2438_SelectInputSource() left stored
+    // is converted without a copy
+    uint8_t page_data[9];
+    if (copy_pending == 1)
+    {
+        DS2438_WaitCopy(&last_copy);
+    }
+    uint8_t error = DS2438_ConvertVoltageNow(page_data);
+    if (error != DS2438_OK)
+        return error;
+    uint8_t stored_input = (page_data[0] & 0x08) ? DS2438_INPUT_VOLTAGE_VDD : DS2438_INPUT_VOLTAGE_VAD;
+    uint8_t other_input = (stored_input == DS2438_INPUT_VOLTAGE_VDD) ? DS2438_INPUT_VOLTAGE_VAD : DS2438_INPUT_VOLTAGE_VDD;
+    uint16_t* first = (stored_input == DS2438_INPUT_VOLTAGE_VDD) ? vdd : vad;
+    uint16_t* second = (stored_input == DS2438_INPUT_VOLTAGE_VDD) ? vad : vdd;
+    *first = (page_data[4] << 8) | page_data[3];
+    
+    // Switch to the other input for the second conversion
+    error = DS2438_StoreInputSource(other_input, page_data);
+    if (error != DS2438_OK)
+        return error;
+    error = DS2438_ConvertVoltageNow(page_data);
+    if (error == DS2438_OK)
+    {
+        *second = (page_data[4] << 8) | page_data[3];
+    }
+    
+    // The other input stays stored: the next call converts it first
+    return error;
+}
+
+// ===========================================================
+//                  VOLTAGE STREAMING FUNCTIONS
+// ===========================================================
+
+// Issue a voltage conversion and leave the transaction open
+static uint8_t DS2438_StreamConvert(DS2438_VoltageStream* stream)
+{
+    if (OneWire_TouchReset(DS2438_Pin_0) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_VOLTAGE_CONV);
+    stream->conversion_start_us = Timebase_GetUs();
+    DS2438_CacheInvalidate(&page_cache, 0x00);
+    return DS2438_OK;
+}
+
+uint8_t DS2438_StreamStart(DS2438_VoltageStream* stream, DS2438_VoltageSample* samples, uint16_t size)
+{
+    if ((samples == NULL) || (size < 2))
+        return DS2438_BAD_PARAM;
+    stream->samples = samples;
+    stream->size = size;
+    stream->head = 0;
+    stream->tail = 0;
+    stream->running = 0;
+    stream->first_us = 0;
+    stream->last_us = 0;
+    stream->produced = 0;
+    stream->dropped = 0;
+    stream->errors = 0;
+    if (copy_pending == 1)
+    {
+        DS2438_WaitCopy(&last_copy);
+    }
+    uint8_t error = DS2438_StreamConvert(stream);
+    if (error == DS2438_OK)
+    {
+        stream->running = 1;
+    }
+    return error;
+}
+
+uint8_t DS2438_StreamService(DS2438_VoltageStream* stream)
+{
+    uint8_t page_data[9];
+    
+    if (stream->running == 0)
+        return DS2438_ERROR;
+    if (!Timebase_IsExpired(stream->conversion_start_us + DS2438_CONVERSION_TIME_US))
+        return DS2438_OK;
+    uint32_t timestamp_us = stream->conversion_start_us;
+    
+    // Recall the completed result to the scratchpad
+    if (OneWire_TouchReset(DS2438_Pin_0) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_RECALL_MEMORY);
+    OneWire_WriteByte(DS2438_Pin_0, 0x00);
+    // Start the next conversion, the scratchpad is not affected by it
+    uint8_t error = DS2438_StreamConvert(stream);
+    if (error != DS2438_OK)
+        return error;
+    // Read the completed result while the next conversion is running
+    error = DS2438_ReadScratchpadFromDevice(0x00, page_data);
+    if (error != DS2438_OK)
+        return error;
+    
+    if (crc_enabled == DS2438_DO_CRC_CHECK)
+    {
+        if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+        {
+            stream->errors++;
+            return DS2438_CRC_FAIL;
+        }
+    }
+    // ADB set: the conversion was still running when recalled
+    if ((page_data[0] & (0x01 << 6)) != 0)
+    {
+        stream->errors++;
+        return DS2438_ERROR;
+    }
+    
+    if (stream->produced == 0)
+    {
+        stream->first_us = timestamp_us;
+    }
+    stream->last_us = timestamp_us;
+    stream->produced++;
+    uint16_t next = (stream->head + 1) % stream->size;
+    if (next == stream->tail)
+    {
+        stream->dropped++;
+        return DS2438_OK;
+    }
+    stream->samples[stream->head].timestamp_us = timestamp_us;
+    stream->samples[stream->head].voltage = (page_data[4] << 8) | page_data[3];
+    stream->head = next;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_StreamRead(DS2438_VoltageStream* stream, DS2438_VoltageSample* sample)
+{
+    if (stream->tail == stream->head)
+        return DS2438_ERROR;
+    *sample = stream->samples[stream->tail];
+    stream->tail = (stream->tail + 1) % stream->size;
+    return DS2438_OK;
+}
+
+void DS2438_StreamStop(DS2438_VoltageStream* stream)
+{
+    stream->running = 0;
+}
+
+float DS2438_StreamGetRate(const DS2438_VoltageStream* stream)
+{
+    if ((stream->produced < 2) || (stream->last_us == stream->first_us))
+        return 0;
+    return (stream->produced - 1) * 1000000.0 / (uint32_t)(stream->last_us - stream->first_us);
+}
+
+// ===========================================================
+//                  TEMPERATURE CONVERSION FUNCTIONS
+// ===========================================================
+
+uint8_t DS2438_StartTemperatureConversion(void)
+{
+    // Reset sequence
+    if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+    {
+        // Skip ROM and issue temperature conversion command
+        OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+        OneWire_WriteByte(DS2438_Pin_0, DS2438_TEMP_CONV);
+        DS2438_CacheInvalidate(&page_cache, 0x00);
+        return DS2438_OK;
+    }
+    
+    return DS2438_DEV_NOT_FOUND;
+}
+
+uint8_t DS2438_HasTemperatureData(void)
+{
+    // Busy flag must always be read from the device
+    uint8_t page_data[9];
+    if (DS2438_ReadPageFromDevice(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        // Read bit
+        if ((page_data[0] & (0x01 << 4)) == 0)
+        {
+            return DS2438_OK;
+        }
+        else
+        {
+            return DS2438_ERROR;
+        }
+
+    }
+    return DS2438_DEV_NOT_FOUND;
+}
+
+uint8_t DS2438_GetTemperatureData(float* temperature)
+{
+    // Read nine bytes
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+            
+        }
+        uint8_t temp_lsb = page_data[1];
+        uint8_t temp_msb = page_data[2];
+        *temperature = (((int16_t)temp_msb << 8) | ((temp_lsb & 0xFF) >> 3)) * 0.03125;
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_ERROR;
+    }  
+
+    
+    return DS2438_DEV_NOT_FOUND;
+}
+
+uint8_t DS2438_GetRawTemperatureData(uint16_t* temperature)
+{
+    // Read nine bytes
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+            
+        }
+        uint8_t temp_lsb = page_data[1];
+        uint8_t temp_msb = page_data[2];
+        *temperature = (temp_msb << 8) | (temp_lsb & 0xFF);
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_ERROR;
+    }  
+
+    
+    return DS2438_DEV_NOT_FOUND;
+}
+
+uint8_t DS2438_ReadTemperature(float* temperature)
+{
+    uint8_t error = DS2438_StartTemperatureConversion();
+    if (error == DS2438_OK)
+    {
+        while(DS2438_HasTemperatureData() != DS2438_OK);
+        return DS2438_GetTemperatureData(temperature);
+    }
+    return error;
+}
+
+/*
+*   Blocking read temperature data in raw format. CRC check defined by parameter.
+*/
+uint8_t DS2438_ReadRawTemperature(uint16_t* temperature)
+{
+    uint8_t error = DS2438_StartTemperatureConversion();
+    if (error == DS2438_OK)
+    {
+        while(DS2438_HasTemperatureData() != DS2438_OK);
+        return DS2438_GetRawTemperatureData(temperature);
+    }
+    return error;
+}
+
+// ===========================================================
+//             CURRENT AND ACCUMULATOR FUNCTIONS
+// ===========================================================
+
+// Get current data in float format
+uint8_t DS2438_GetCurrentData(float* current)
+{
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        uint8_t curr_lsb = page_data[5];
+        uint8_t curr_msb = page_data[6];
+        int16_t curr_data = 0;
+        // Get if positive or negative
+        if ((curr_msb & 0x03) > 1)
+        {
+            // current is negative
+            uint16_t data = (curr_msb<<8) | (curr_lsb);
+            // perform 2's complement
+            int16_t temp = (~data) & 0x3FF;
+            curr_data = (short)(temp * -1);
+        }
+        else
+        {
+            curr_data = (curr_msb << 8) | (curr_lsb & 0xFF);
+        }
+        
+        *current = (curr_data) / (4096.*DS2438_SENSE_RESISTOR);
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_ERROR;
+    }    
+    return DS2438_DEV_NOT_FOUND;
+}
+
+// Get current data in raw format
+uint8_t DS2438_GetRawCurrentData(uint16_t* current)
+{
+    uint8_t page_data[9];
+    if (DS2438_ReadPage(0x00, page_data) == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }
+        }
+        uint8_t curr_lsb = page_data[5];
+        uint8_t curr_msb = page_data[6];
+        
+        *current = (curr_msb << 8) | (curr_lsb & 0xFF);
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_ERROR;
+    }    
+    return DS2438_DEV_NOT_FOUND;
+}
+
+// Get value of integrated current accumalator
+uint8_t DS2438_GetICA(uint8_t* ica)
+{
+    // Read byte 4 of page 1
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x01, page_data);
+    if (error == DS2438_OK)
+    {
+        if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            {
+                return DS2438_CRC_FAIL;
+            }  
+        }
+        *ica = page_data[4];
+        
+    }   
+    return error;
+}
+
+uint8_t DS2438_GetCapacity(float* capacity)
+{
+    uint8_t error = DS2438_OK;
+    uint8_t ica = 0;
+    error = DS2438_GetICA(&ica);
+    if (error == DS2438_OK)
+    {
+        *capacity = ica/(2048.0*DS2438_SENSE_RESISTOR);
+    }
+    return error;
+}
+
+// Read current threshold value
+uint8_t DS2438_ReadThreshold(uint8_t* threshold)
+{
+    // Threshold is located at byte 7 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if ( error == DS2438_OK)
+    {
+            if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+                return DS2438_CRC_FAIL;
+        }
+        // Return two MSBs
+        *threshold = page_data[7] >> 6;
+    }
+    return error;
+}
+
+// Write current threshold value
+uint8_t DS2438_WriteThreshold(uint8_t threshold)
+{
+    if (threshold > 3)
+        return DS2438_BAD_PARAM;
+    // Threshold is located at byte 7 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    uint8_t IAD_active = 0;
+    if ( error == DS2438_OK)
+    {
+        
+        // Stop IAD 
+        if (page_data[0] | 0x01)
+        {
+            DS2438_DisableIAD();
+            IAD_active = 1;
+        }
+        
+        // Update threshold bits
+        page_data[7] = threshold << 6;
+        // Write new page data
+        DS2438_WritePage(0x00, page_data);
+        if (IAD_active == 1)
+        {
+            DS2438_EnableIAD();
+        }
+    }
+    return error;
+}
+
+uint8_t DS2438_WriteOffset(int16_t offset)
+{
+    // Offset is located at bytes 5-6 of page 1
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x01, page_data);
+    uint8_t IAD_active = 0;
+    if ( error == DS2438_OK)
+    {
+        
+        // Stop IAD 
+        if (page_data[0] | 0x01)
+        {
+            DS2438_DisableIAD();
+            IAD_active = 1;
+        }
+        // Keep 5 LSBs and shift them to the left by 3
+        uint8_t offset_lsb = ( (offset << 3) & 0xF8);
+        
+        // Keep 5 MSBs and shift them to the right by 8
+        uint8_t offset_msb = ( (offset & 0x3E0) >> 8);
+        // Update threshold bits
+        page_data[5] = offset_lsb;
+        page_data[6] = offset_msb;
+        // Write new page data
+        DS2438_WritePage(0x00, page_data);
+        if (IAD_active == 1)
+        {
+            DS2438_EnableIAD();
+        }
+    }
+    return error;
+}
+
+uint8_t DS2438_ReadOffset(uint16_t* offset)
+{
+    // Offset is located at bytes 5-6 of page 1
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x01, page_data);
+    if ( error == DS2438_OK)
+    {
+         if (crc_enabled == DS2438_DO_CRC_CHECK)
+        {
+            if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+                return DS2438_CRC_FAIL;
+        }
+        // Return two MSBs
+        *offset = (page_data[6] << 8 | page_data[5]);
+    }
+    return error;
+}
+
+// Enable current measurement and ICA
+uint8_t DS2438_EnableIAD(void)
+{
+    // Set bit 0 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // set bit 0
+        page_data[0] = page_data[0] | 0x01;
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+}
+
+uint8_t DS2438_DisableIAD(void)
+{
+    // Clear bit 0 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // Clear bit 0
+        page_data[0] = page_data[0] & (~0x01);
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+}
+
+uint8_t DS2438_EnableCA(void)
+{
+    // Set bit 1 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // set bit 0
+        page_data[0] = page_data[0] | 0x02;
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+    
+}
+
+uint8_t DS2438_DisableCA(void)
+{
+    // Clear bit 1 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // Clear bit 0
+        page_data[0] = page_data[0] & (~0x02);
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+}
+
+uint8_t DS2438_EnableShadowEE(void)
+{
+    // Set bit 2 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // set bit 2
+        page_data[0] = page_data[0] | 0x04;
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+}
+
+
+uint8_t DS2438_DisableShadowEE(void)
+{
+    // Clear bit 2 in byte 0 of page 0
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPage(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        // Clear bit 2
+        page_data[0] = page_data[0] & (~0x04);
+        return DS2438_WritePage(0x00, page_data);
+    }
+    return error;
+}
+
+uint8_t DS2438_CopyInProgress(uint8_t* copy)
+{
+    // Status of the last copy is tracked, no need to read NVB bit
+    if (copy_pending == 1)
+    {
+        *copy = DS2438_TrackedCopyInProgress();
+        return DS2438_OK;
+    }
+    // Read bit 5 in byte 0 of page 0, set by copies of other masters too
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPageFromDevice(0x00, page_data);
+    if (error == DS2438_OK)
+    {
+        *copy = ((page_data[0] & 0x20) != 0) ? 1 : 0;
+    }
+    return error;
+}
+
+uint8_t DS2438_TrackedCopyInProgress(void)
+{
+    uint8_t done = 1;
+    DS2438_PollCopy(&last_copy, &done);
+    return (done == 1) ? 0 : 1;
+}
+
+    
+// ===========================================================
+//                    LOW LEVEL FUNCTIONS
+// ===========================================================
+// Read one page of data
+uint8_t DS2438_ReadPage(uint8_t page_number, uint8_t* page_data)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    if (DS2438_CacheLookup(&page_cache, page_number, page_data) == DS2438_OK)
+        return DS2438_OK;
+    return DS2438_ReadPageFromDevice(page_number, page_data);
+}
+
+// Read one page of data accepting cached data up to a given age
+uint8_t DS2438_ReadPageWithMaxAge(uint8_t page_number, uint32_t max_age_ms, uint8_t* page_data)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    if (DS2438_CacheLookupWithMaxAge(&page_cache, page_number, max_age_ms, page_data) == DS2438_OK)
+        return DS2438_OK;
+    return DS2438_ReadPageFromDevice(page_number, page_data);
+}
+
+// Read one page of data from the device and get the time of the recall
+uint8_t DS2438_ReadPageTimestamped(uint8_t page_number, uint8_t* page_data, uint32_t* recall_us)
+{
+    uint8_t error = DS2438_ReadPageFromDevice(page_number, page_data);
+    *recall_us = last_recall_us;
+    return error;
+}
+
+// Read one page of data from the device and store it in the cache
+static uint8_t DS2438_ReadPageFromDevice(uint8_t page_number, uint8_t* page_data)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    else
+    {
+        // Wait for a pending copy of the same page
+        if ((copy_pending == 1) && (last_copy.page_number == page_number))
+        {
+            DS2438_WaitCopy(&last_copy);
+        }
+        // Reset sequence
+        if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+        {
+            // Skip ROM command 
+            OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+            // Recall memory command
+            OneWire_WriteByte(DS2438_Pin_0, DS2438_RECALL_MEMORY);
+            // Page number
+            OneWire_WriteByte(DS2438_Pin_0, page_number);
+            last_recall_us = Timebase_GetUs();
+            if (DS2438_ReadScratchpadFromDevice(page_number, page_data) == DS2438_OK)
+            {
+                DS2438_CacheFill(&page_cache, page_number, page_data);
+                return DS2438_OK;
+            }
+        }
+    }
+    return DS2438_DEV_NOT_FOUND;
+}
+
+// Read the scratchpad of a page, publish page 0 if its CRC matches
+static uint8_t DS2438_ReadScratchpadFromDevice(uint8_t page_number, uint8_t* page_data)
+{
+    // Reset sequence
+    if (OneWire_TouchReset(DS2438_Pin_0) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    // Skip ROM command 
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+    // Read scratchpad command
+    OneWire_WriteByte(DS2438_Pin_0, DS2438_READ_SCRATCHPAD);
+    // Page number
+    OneWire_WriteByte(DS2438_Pin_0, page_number);
+    // Read nine bytes
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        page_data[i] = OneWire_ReadByte(DS2438_Pin_0);
+    }
+    if ((page_number == 0x00) && (DS2438_CheckCrcValue(page_data, 8, page_data[8]) == DS2438_OK))
+    {
+        DS2438_SnapshotPublish(page_data);
+    }
+    return DS2438_OK;
+}
+
+// Write one page of data
+uint8_t DS2438_WritePage(uint8_t page_number, uint8_t* page_data)
+{
+    return DS2438_WritePageAsync(page_number, page_data, NULL);
+}
+
+// Write one page of data and track the copy to EEPROM
+uint8_t DS2438_WritePageAsync(uint8_t page_number, uint8_t* page_data, DS2438_CopyToken* token)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    else
+    {
+        // Only one copy at a time: wait for the previous one
+        if (copy_pending == 1)
+        {
+            DS2438_WaitCopy(&last_copy);
+        }
+        // Reset sequence
+        if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+        {
+            // Skip ROM command 
+            OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+            // Write scratchpad command
+            OneWire_WriteByte(DS2438_Pin_0, DS2438_WRITE_SCRATCHPAD);
+            // Write page data followed by page data
+            OneWire_WriteByte(DS2438_Pin_0, page_number);
+            for (uint8_t i = 0; i < 9; i++)
+            {
+                OneWire_WriteByte(DS2438_Pin_0, page_data[i]);
+            }
+            if (OneWire_TouchReset(DS2438_Pin_0) == 0)
+            {
+                // Skip ROM command 
+                OneWire_WriteByte(DS2438_Pin_0, DS2438_SKIP_ROM);
+                // Copy scratchpad command
+                OneWire_WriteByte(DS2438_Pin_0, DS2438_COPY_SCRATCHPAD);
+                // Write page number
+                OneWire_WriteByte(DS2438_Pin_0, page_number);
+                DS2438_RecordCopy(page_number, page_data, token);
+                return DS2438_OK;
+            }
+        }
+    }
+    return DS2438_DEV_NOT_FOUND;
+}
+
+// Write a copied page through the cache and track the copy
+void DS2438_RecordCopy(uint8_t page_number, const uint8_t* page_data, DS2438_CopyToken* token)
+{
+    DS2438_CacheWriteThrough(&page_cache, page_number, page_data);
+    last_copy.page_number = page_number;
+    last_copy.sequence = ++copy_sequence;
+    last_copy.deadline_us = Timebase_GetUs() + DS2438_COPY_TIME_US;
+    last_copy.reset_count = OneWire_GetResetCount();
+    copy_pending = 1;
+    if (token != NULL)
+    {
+        *token = last_copy;
+    }
+}
+
+// Get the page cache of the device
+DS2438_PageCache* DS2438_GetPageCache(void)
+{
+    return &page_cache;
+}
+
+// Check if a copy scratchpad is completed
+uint8_t DS2438_PollCopy(DS2438_CopyToken* token, uint8_t* done)
+{
+    // Older copies were completed before issuing the pending one
+    if ((copy_pending == 0) || (token->sequence != last_copy.sequence))
+    {
+        *done = 1;
+        return DS2438_OK;
+    }
+    *done = 0;
+    // If no reset was issued after the copy command, the transaction
+    // is still open and the DS2438 answers read slots with 1 when done.
+    // A 1 read before the shortest copy time is not trusted.
+    uint32_t min_done_us = last_copy.deadline_us - (DS2438_COPY_TIME_US - DS2438_COPY_MIN_TIME_US);
+    if ((OneWire_GetResetCount() == last_copy.reset_count) && Timebase_IsExpired(min_done_us))
+    {
+        if (OneWire_ReadBit(DS2438_Pin_0))
+        {
+            *done = 1;
+        }
+    }
+    if (Timebase_IsExpired(last_copy.deadline_us))
+    {
+        *done = 1;
+    }
+    if (*done == 1)
+    {
+        copy_pending = 0;
+    }
+    return DS2438_OK;
+}
+
+// Wait for a copy scratchpad to be completed
+uint8_t DS2438_WaitCopy(DS2438_CopyToken* token)
+{
+    uint8_t done = 0;
+    uint8_t error = DS2438_OK;
+    while ((error == DS2438_OK) && (done == 0))
+    {
+        error = DS2438_PollCopy(token, &done);
+        if (done == 0)
+        {
+            // Let the copy progress, and the time base with it
+            CyDelayUs(DS2438_COPY_POLL_US);
+        }
+    }
+    return error;
+}
+
+// Wait for the end of a conversion using read time slots. Must be
+// called right after the conversion command, in the same transaction.
+static uint8_t DS2438_WaitConversion(void)
+{
+    uint32_t deadline_us = Timebase_GetUs() + DS2438_CONVERSION_TIME_US;
+    // DS2438 answers read slots with 0 while busy. The expiry is checked
+    // before the slot, so the last slot is read after the deadline.
+    for (;;)
+    {
+        uint8_t expired = Timebase_IsExpired(deadline_us);
+        if (OneWire_ReadBit(DS2438_Pin_0) != 0)
+            return DS2438_OK;
+        if (expired)
+            return DS2438_ERROR;
+    }
+}
+
+// Check if retrieved CRC value is equal to the computed one
+uint8_t DS2438_CheckCrcValue(uint8_t* data, uint8_t len, uint8_t crc_value)
+{
+    uint8_t computed_crc = DS2438_ComputeCrc(data, len);
+    if (computed_crc == crc_value)
+    {
+        return DS2438_OK;
+    }
+    else
+    {
+        return DS2438_CRC_FAIL;
+    }
+}
+
+// Compute CRC value, the CRC8 of all the 1-Wire ROMs and scratchpads
+uint8_t DS2438_ComputeCrc(const uint8_t *data, uint8_t len)
+{
+    return OneWire_Crc8(data, len);
+}
+/* [] END OF FILE */
@@ -1,519 +1,797 @@
-/**
- * \file DS2438.h
- * \brief DS2438 Library with 1-Wire interface. 
- *
- * This library allows to use the DS2438 device
- * on PSoC 3/5LP devices. The current implementation
- * only allows to have one single DS2438 in your system,
- * as all the functions perform a skip ROM command when
- * sending commands to the device. 
- *
-*/
-
-#ifndef __DS2438_H__
-    #define __DS2438_H__
-    
-    #include "cytypes.h"
-    #include "OneWire.h"
-    #include "DS2438_Defines.h"
-    
-    // ===========================================================
-    //                 INITIALIZATION FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Initializes the DS2438.
-    *
-    *   This function starts the device by checking that
-    *   the DS2438 is present on the 1-Wire bus.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_Start(void);
-    
-    /**
-    *   \brief Check that the DS2438 is present on the bus.
-    *
-    *   This function checks that the DS2438 is present
-    *   on the 1-Wire bus.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_IsDevicePresent(void);
-    
-    /**
-    *   \brief Stop the DS2438.
-    *
-    *   This function starts the device by checking that
-    *   the DS2438 is present on the 1-Wire bus.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    void DS2438_Stop(void);
-    
-    // ===========================================================
-    //                  64-BIT LASERED ROM FUNCTIONS
-    // ===========================================================
-    /**
-    *   \brief Read 64-bit lasered ROM.
-    *
-    *   This function reads the 64-bit lasered ROM of the DS2438
-    *   and returns its content in the array passed in as
-    *   parameter to the function.
-    *   \param rom pointer to array where raw ROM data will be saved.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_ReadRawRom(uint8_t* rom);
-    
-    /**
-    *   \brief Read 48-bit Serial Number from ROM.
-    *
-    *   This function reads the 64-bit lasered ROM of the DS2438
-    *   and returns the serial number contained in it 
-    *   in the array passed in as parameter to the function.
-    *   \param serial_number pointer to array where raw ROM data will be saved.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadSerialNumber(uint8_t* serial_number);
-    
-    // ===========================================================
-    //                  VOLTAGE CONVERSION FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Start voltage conversion.
-    *
-    *   This function starts a voltage conversion by sending the
-    *   appropriate command to the DS2438.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_StartVoltageConversion(void);
-    
-    /**
-    *   \brief Check if voltage conversion completed.
-    *
-    *   This function checks if a voltage conversion has been completed
-    *   by reading the appropriate bit in the Status/Configuration register.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_HasVoltageData(void);
-    
-    /**
-    *   \brief Get voltage data.
-    *
-    *   This function gets the voltage data from the DS2438.
-    *   \param voltage pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetVoltageData(float* voltage);
-    
-    /**
-    *   \brief Get voltage data in raw format.
-    *
-    *   This function gets the voltage data from the DS2438 in raw 
-    *   format. Conversion must be performed later.
-    *   \param voltage pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetRawVoltageData(uint16_t* voltage);
-    
-    /**
-    *   \brief Read voltage data.
-    *
-    *   This function is a blocking function that starts a voltage conversion,
-    *   wait until new voltage data are available, and gets the voltage data from 
-    *   the DS2438 converting it in float format.
-    *   \param voltage pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadVoltage(float* voltage);
-    
-    /**
-    *   \brief Read raw voltage data.
-    *
-    *   This function is a blocking function that starts a voltage conversion,
-    *   wait until new voltage data are available, and gets the voltage data from 
-    *   the DS2438 in raw format. Conversion must be performed later.
-    *   \param voltage pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadRawVoltage(uint16_t* voltage);
-    
-    /**
-    *   \brief Select input source for A/D conversion.
-    *
-    *   This function sets the input source for the A/D conversion of the DS2438.
-    *   \param input_source selection of AD voltage source:
-    *       - #DS2438_INPUT_VOLTAGE_VDD for battery input
-    *       - #DS2438_INPUT_VAD for VAD pin
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed when reading scratchpad.
-    */
-    uint8_t DS2438_SelectInputSource(uint8_t input_source);
-    
-    // ===========================================================
-    //                  TEMPERATURE CONVERSION FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Start temperature conversion.
-    *
-    *   This function starts a new temperature conversion.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_StartTemperatureConversion(void);
-    
-    /**
-    *   \brief Check if temperature conversion is complete. 
-    *
-    *   This function checks if temperature conversion is complete
-    *   by reading the appropriate bit in the Status/Configuration register.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_HasTemperatureData(void);
-    
-    /**
-    *   \brief Get temperature data in float format.
-    *
-    *   This function is gets the temperature data from the DS2438 in float format.
-    *   It is a non-blocking function since it does not wait for the 
-    *   completion of the conversion, that must be started prior to calling this function.
-    *   \param temperature pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetTemperatureData(float* temperature);
-    
-    /**
-    *   \brief Get temperature data in raw format.
-    *
-    *   This function is gets the temperature data from the DS2438 in raw format.
-    *   It is a non-blocking function since it does not wait for the 
-    *   completion of the conversion, that must be started prior to calling this function.
-    *   \param temperature pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetRawTemperatureData(uint16_t* temperature);
-    
-    /**
-    *   \brief Read temperature data in float format.
-    *
-    *   This function is a blocking function that starts a temperature conversion,
-    *   wait until new temperature data are available, and gets the temperature data from 
-    *   the DS2438 in float format.
-    *   \param temperature pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadTemperature(float* temperature);
-    
-    /**
-    *   \brief Read raw temperature data.
-    *
-    *   This function is a blocking function that starts a temperature conversion,
-    *   wait until new temperature data are available, and gets the temperature data from 
-    *   the DS2438 in raw format. Conversion must be performed later.
-    *   \param temperature pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadRawTemperature(uint16_t* temperature);
-        
-    // ===========================================================
-    //              CURRENT AND ACCUMULATORS FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Read current data in float format.
-    *
-    *   This function gets the current data in float format. A positive current
-    *   means that the battery is being charged, while a negative current
-    *   means that current is flowing out of the battery. In order to correctly
-    *   convert the current value from raw to float format, the true value of
-    *   the sense resistor must be set in the #DS2348_SENSE_RESISTOR macro.
-    *   \param current pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetCurrentData(float* current);
-    
-    /**
-    *   \brief Read current data in raw format.
-    *
-    *   This function gets the current data in raw format. No conversion is
-    *   performed in this function, therefore this must be later done by the
-    *   user using the appropriate value of sense resistor.
-    *   \param current pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetRawCurrentData(uint16_t* current);
-    
-    /**
-    *   \brief Read content of ICA register.
-    *
-    *   This function gets the current content of the ICA register,
-    *   which is a 8-bit value representing the integration of the
-    *   voltage across sense resistor over time..
-    *   \param current pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetICA(uint8_t* ica);
-    
-    /**
-    *   \brief Get remaining capacity of the battery.
-    *
-    *   This function converts the content of the ICA into
-    *   remaining capacity according to the formula:
-    *   \f$capacity = \dfrac{ICA}{2048\dotR_{sense}} \f$.
-    *   \param capacity pointer to variable where voltage data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_GetCapacity(float* capacity);
-    
-    /**
-    *   \brief Write threshold value for accumulator.
-    *
-    *   This function writes the new value to be used as a 
-    *   threshold for the accumulator.
-    *   If current conversion is enabled, it is temporarily
-    *   disabled while writing the new threshold value.
-    *   \param threshold the new threshold value to be written.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_WriteThreshold(uint8_t threshold);
-    
-    /**
-    *   \brief Read threshold value for accumulator.
-    *
-    *   This function reads the current threshold value stored in
-    *   the threshold register which is used to determine the
-    *   functionality of the current accumlators.
-    *   \param threshold pointer to variable where threshold data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadThreshold(uint8_t* threshold);
-    
-    /**
-    *   \brief Write new offset value.
-    *   
-    *   This function writes a new offset value so that small currents
-    *   are removed from current values. Because small current ADC offset errors
-    *   can have a large cumulative effect when current is integrated over time,
-    *   the DS2438 provides a method for canceling offset errors in the current 
-    *   ADC. After each current measurement is completed, the measured value
-    *   is added to the contents of the Offset Register and the result 
-    *   is then stored in the Current Register. 
-    *   The Offset Register is a two-byte nonvolatile read/write register 
-    *   formatted in two’s-complement format.
-    *   \param offset new offset value to be written.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_WriteOffset(int16_t offset);
-    
-    /**
-    *   \brief Read offset value.
-    *
-    *   This function reads the current offset value stored
-    *   in the offset register. The value returned is in raw
-    *   format and needs to be converted in two's complement.
-    *   \param offset pointer to variable where offset value will be stored
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    *   \retval #DS2438_CRC_FAIL if CRC check failed.
-    */
-    uint8_t DS2438_ReadOffset(uint16_t* offset);
-
-    // ===========================================================
-    //                  CRC FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Enable CRC Check for all reading/writing functions.
-    *
-    *   This function sets a global flag that enables the CRC Check
-    *   for all the functions requiring it.
-    */
-    void DS2438_EnableCRC(void);
-    
-    /**
-    *   \brief Disable CRC Check for all reading/writing functions.
-    *
-    *   This function sets a global flag that disables the CRC Check
-    *   for all the functions requiring it.
-    */
-    void DS2438_DisableCRC(void);
-    
-    // ===========================================================
-    //                  CONFIGURATION FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Enable current measurements and ICA.
-    *
-    *   If IAD is enabeld, current measurements will be taken at a rate
-    *   of 36.41 Hz, and the results of the conversion can be retrieved
-    *   using the #DS2438_GetCurrentData().
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_EnableIAD(void);
-    
-    /**
-    *   \brief Disable current measurements and ICA.
-    *
-    *   DIsable current conversion and ICA. No current conversion
-    *   will be performed by the DS2438.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_DisableIAD(void);
-    
-    /**
-    *   \brief Enable current accumulator.
-    *
-    *   If CA is enabled, bot charging current accumulator and discharging
-    *   current accumulator are used. These registers store the total
-    *   charging/discharging current the battery has encountered in
-    *   its lifetime.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_EnableCA(void);
-    
-    /**
-    *   \brief Disable current measurements and ICA.
-    *
-    *   Disable current conversion and ICA. No current conversion
-    *   will be performed by the DS2438.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_DisableCA(void);
-    
-    /**
-    *   \brief Enable shadow of data to EEPROM.
-    *
-    *   Enable shadow of CCA and DCA to EEPROM. When enabled, 
-    *   CCA and DCA counters will be shadowed to EEPROM whenever
-    *   their values change. This function has no effect it
-    *   the CA are not enabled.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_EnableShadowEE(void);
-    
-    /**
-    *   \brief Disable shadow of data to EEPROM.
-    *
-    *   Disable shadow of CCA and DCA to EEPROM. If battery
-    *   becomes discharged, CCA/DCA data could be lost.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_DisableShadowEE(void);
-    
-    /**
-    *   \brief Check if a copy from scratchpad to EEPROM is in progress.
-    *
-    *   This function checks whether a copy from scratchpad to
-    *   EEPROM is currently in progress.
-    *   \param copy set to 1 if copy in progress, 0 otherwise.
-    *   \retval #DS2438_OK if no error was generated.
-    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
-    */
-    uint8_t DS2438_CopyInProgress(uint8_t* copy);
-    
-    // ===========================================================
-    //                  LOW LEVEL FUNCTIONS
-    // ===========================================================
-    
-    /**
-    *   \brief Read one page of data.
-    *
-    *   This function reads one page of data and return the read samples
-    *   in the array passed in as parameter. This function issues a
-    *   recall memory command, followed by a read scratchpage command
-    *   and the page to be read.
-    *   \param page_number the page to be read.
-    *   \param page_data pointer to array where data will be stored.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_ReadPage(uint8_t page_number, uint8_t* page_data);
-    
-    /**
-    *   \brief Write one page of data.
-    *
-    *   This function writes one page of data to the DS2438. This can be
-    *   used to either configure bits in the registers or to write user bytes
-    *   to the device in its EEPROM.
-    *   \param page_number the page number to be written.
-    *   \param page_data the data to be written to the page.
-    *   \retval #DS2438_OK if device is present on the bus.
-    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
-    */
-    uint8_t DS2438_WritePage(uint8_t page_number, uint8_t* page_data);
-    
-    /**
-    *   \brief Compute CRC value based on Dallas specs.
-    *
-    *   This function computes the CRC value according to the
-    *   specification of Dallas.
-    *   \param data the data from which to compute the CRC value.
-    *   \param len the length of the data.
-    *   \return CRC value.
-    */
-    uint8_t DS2438_ComputeCrc(const uint8_t *data, uint8_t len);
-    
-    /**
-    *   \brief Check if CRC value is equal to the expected one.
-    *
-    *   This function checks if the computed CRC value is equal
-    *   to the expected one.
-    *   \param data the data from which to compute the CRC value.
-    *   \param len the length of the data.
-    *   \param crc_value the expected CRC value.
-    *   \retval #DS2438_OK if CRC is equal to the expected one.
-    *   \retval #DS2438_CRC_FAIL if CRC is not equal to the expected one.
-    */
-    uint8_t DS2438_CheckCrcValue(uint8_t* data, uint8_t len, uint8_t crc_value);
-    
-
-#endif
-
-/* [] END OF FILE */
+/**
+ * \file DS2438.h
+ * \brief DS2438 Library with 1-Wire interface. 
+ *
+ * This library allows to use the DS2438 device
+ * on PSoC 3/5LP devices. The current implementation
+ * only allows to have one single DS2438 in your system,
+ * as all the functions perform a skip ROM command when
+ * sending commands to the device. 
+ *
+*/
+
+#ifndef __DS2438_H__
+    #define __DS2438_H__
+    
+    #include "cytypes.h"
+    #include "OneWire.h"
+    #include "DS2438_Defines.h"
+    #include "DS2438_Cache.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+    
+    // ===========================================================
+    //                          TYPES
+    // ===========================================================
+    
+    /**
+    *   \brief Completion token of a scratchpad to EEPROM copy.
+    *
+    *   A token is returned by #DS2438_WritePageAsync() and can be
+    *   used to check whether the copy of the scratchpad to EEPROM 
+    *   has been completed by the DS2438.
+    */
+    typedef struct {
+        uint8_t page_number;        ///< Page being copied
+        uint16_t sequence;          ///< Sequence number of the copy
+        uint32_t deadline_us;       ///< Time at which the copy is guaranteed to be completed
+        uint32_t reset_count;       ///< 1-Wire reset counter when the copy was issued
+    } DS2438_CopyToken;
+    
+    /**
+    *   \brief Timestamped voltage sample produced by the streaming mode.
+    */
+    typedef struct {
+        uint32_t timestamp_us;      ///< Time at which the conversion was started
+        uint16_t voltage;           ///< Raw voltage
+    } DS2438_VoltageSample;
+    
+    /**
+    *   \brief Voltage streaming state.
+    *
+    *   The ring buffer is supplied by the caller with #DS2438_StreamStart().
+    *   Samples are pushed by #DS2438_StreamService() and popped by
+    *   #DS2438_StreamRead(). When the ring buffer is full, new samples
+    *   are dropped.
+    */
+    typedef struct {
+        DS2438_VoltageSample* samples;  ///< Caller supplied ring buffer
+        uint16_t size;                  ///< Number of samples of the ring buffer
+        volatile uint16_t head;         ///< Next sample to be written
+        volatile uint16_t tail;         ///< Next sample to be read
+        uint8_t running;                ///< A conversion is running
+        uint32_t conversion_start_us;   ///< Start time of the running conversion
+        uint32_t first_us;              ///< Timestamp of the first sample
+        uint32_t last_us;               ///< Timestamp of the last sample
+        uint32_t produced;              ///< Samples read from the device
+        uint32_t dropped;               ///< Samples dropped because the ring buffer was full
+        uint32_t errors;                ///< Samples lost because of CRC errors or late conversions
+    } DS2438_VoltageStream;
+    
+    // ===========================================================
+    //                 INITIALIZATION FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Initializes the DS2438.
+    *
+    *   This function starts the device by checking that
+    *   the DS2438 is present on the 1-Wire bus.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_Start(void);
+    
+    /**
+    *   \brief Check that the DS2438 is present on the bus.
+    *
+    *   This function checks that the DS2438 is present
+    *   on the 1-Wire bus.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_IsDevicePresent(void);
+    
+    /**
+    *   \brief Stop the DS2438.
+    *
+    *   This function starts the device by checking that
+    *   the DS2438 is present on the 1-Wire bus.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    void DS2438_Stop(void);
+    
+    // ===========================================================
+    //                  64-BIT LASERED ROM FUNCTIONS
+    // ===========================================================
+    /**
+    *   \brief Read 64-bit lasered ROM.
+    *
+    *   This function reads the 64-bit lasered ROM of the DS2438
+    *   and returns its content in the array passed in as
+    *   parameter to the function.
+    *   \param rom pointer to array where raw ROM data will be saved.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_ReadRawRom(uint8_t* rom);
+    
+    /**
+    *   \brief Read 48-bit Serial Number from ROM.
+    *
+    *   This function reads the 64-bit lasered ROM of the DS2438
+    *   and returns the serial number contained in it 
+    *   in the array passed in as parameter to the function.
+    *   \param serial_number pointer to array where raw ROM data will be saved.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadSerialNumber(uint8_t* serial_number);
+    
+    // ===========================================================
+    //                  1-WIRE TIMING FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Calibrate 1-Wire timing against the connected device.
+    *
+    *   This function starts from the standard speed timing and
+    *   progressively reduces the recovery and reset recovery times
+    *   (see #OneWire_ShrinkTiming()). Each candidate timing is verified with
+    *   #DS2438_CALIBRATION_READS CRC-checked ROM reads, that must match the
+    *   ROM read with standard timing. The fastest reliable timing is then
+    *   relaxed by #DS2438_CALIBRATION_MARGIN_STEPS steps, set as the
+    *   timing of the #ONEWIRE_PROFILE_CUSTOM profile, which is attached to the
+    *   DS2438 bus, and returned to the caller so that it can be stored.
+    *   \param calibrated pointer to variable where the calibrated timing will be stored.
+    *   \retval #DS2438_OK if calibration was successful.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if the ROM could not be read with standard timing: wrong
+    *       CRC, or a ROM of zeros as read when the line does not rise in time.
+    */
+    uint8_t DS2438_CalibrateTiming(OneWire_Timing* calibrated);
+    
+    // ===========================================================
+    //                  VOLTAGE CONVERSION FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Start voltage conversion.
+    *
+    *   This function starts a voltage conversion by sending the
+    *   appropriate command to the DS2438.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_StartVoltageConversion(void);
+    
+    /**
+    *   \brief Check if voltage conversion completed.
+    *
+    *   This function checks if a voltage conversion has been completed
+    *   by reading the appropriate bit in the Status/Configuration register.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_HasVoltageData(void);
+    
+    /**
+    *   \brief Get voltage data.
+    *
+    *   This function gets the voltage data from the DS2438.
+    *   \param voltage pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetVoltageData(float* voltage);
+    
+    /**
+    *   \brief Get voltage data in raw format.
+    *
+    *   This function gets the voltage data from the DS2438 in raw 
+    *   format. Conversion must be performed later.
+    *   \param voltage pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetRawVoltageData(uint16_t* voltage);
+    
+    /**
+    *   \brief Read voltage data.
+    *
+    *   This function is a blocking function that starts a voltage conversion,
+    *   wait until new voltage data are available, and gets the voltage data from 
+    *   the DS2438 converting it in float format.
+    *   \param voltage pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadVoltage(float* voltage);
+    
+    /**
+    *   \brief Read raw voltage data.
+    *
+    *   This function is a blocking function that starts a voltage conversion,
+    *   wait until new voltage data are available, and gets the voltage data from 
+    *   the DS2438 in raw format. Conversion must be performed later.
+    *   \param voltage pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadRawVoltage(uint16_t* voltage);
+    
+    /**
+    *   \brief Select input source for A/D conversion.
+    *
+    *   This function sets the input source for the A/D conversion of the DS2438.
+    *   \param input_source selection of AD voltage source:
+    *       - #DS2438_INPUT_VOLTAGE_VDD for battery input
+    *       - #DS2438_INPUT_VAD for VAD pin
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed when reading scratchpad.
+    */
+    uint8_t DS2438_SelectInputSource(uint8_t input_source);
+    
+    /**
+    *   \brief Read battery voltage and general purpose input voltage.
+    *
+    *   This function performs two voltage conversions, the first one on
+    *   the stored input source and the second one on the other input. The
+    *   converter takes the input source from the stored Status/Configuration
+    *   register, so the AD bit is copied to page 0 before the second
+    *   conversion and is not restored after it: the second input stays
+    *   selected and is the first one converted by the next call. Each call
+    *   performs one copy to EEPROM, that is one write cycle of page 0, and
+    *   takes two conversions (up to 10 ms each), the copy (up to 10 ms) and
+    *   three page 0 transactions, about 65 ms at standard speed. The end of
+    *   each conversion is detected with read time slots, and a single page 0
+    *   read is performed after each conversion. Call
+    *   #DS2438_SelectInputSource() before #DS2438_ReadVoltage() when a given
+    *   input is needed after this function.
+    *   \param vdd pointer to variable where raw VDD voltage data will be stored.
+    *   \param vad pointer to variable where raw VAD voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    *   \retval #DS2438_ERROR if a conversion did not complete in time.
+    */
+    uint8_t DS2438_ReadBothVoltages(uint16_t* vdd, uint16_t* vad);
+    
+    // ===========================================================
+    //                  VOLTAGE STREAMING FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Start back-to-back voltage conversions.
+    *
+    *   This function starts the first conversion on the currently selected
+    *   input. Following conversions are driven by #DS2438_StreamService().
+    *   No other access to the device should be performed while streaming.
+    *   \param stream pointer to the streaming state.
+    *   \param samples caller supplied ring buffer.
+    *   \param size number of samples of the ring buffer.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_BAD_PARAM if the ring buffer is not valid.
+    */
+    uint8_t DS2438_StreamStart(DS2438_VoltageStream* stream, DS2438_VoltageSample* samples, uint16_t size);
+    
+    /**
+    *   \brief Collect the result of the running conversion.
+    *
+    *   This function returns immediately until the running conversion is
+    *   completed. Then it recalls page 0 to the scratchpad, starts the next
+    *   conversion, and reads the result of the completed conversion from
+    *   the scratchpad while the next conversion is running. The result
+    *   is pushed to the ring buffer. This function must be called at least
+    *   once every #DS2438_CONVERSION_TIME_US to reach the highest rate:
+    *   one sample per conversion and the RECALL and conversion commands
+    *   between two conversions, about 15 ms at standard speed.
+    *   \param stream pointer to the streaming state.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    *   \retval #DS2438_ERROR if streaming is not started or the conversion was not completed.
+    */
+    uint8_t DS2438_StreamService(DS2438_VoltageStream* stream);
+    
+    /**
+    *   \brief Pop a sample from the ring buffer.
+    *
+    *   \param stream pointer to the streaming state.
+    *   \param sample pointer to variable where the sample will be stored.
+    *   \retval #DS2438_OK if a sample was available.
+    *   \retval #DS2438_ERROR if the ring buffer is empty.
+    */
+    uint8_t DS2438_StreamRead(DS2438_VoltageStream* stream, DS2438_VoltageSample* sample);
+    
+    /**
+    *   \brief Stop back-to-back voltage conversions.
+    *
+    *   The running conversion, if any, is left to complete.
+    *   \param stream pointer to the streaming state.
+    */
+    void DS2438_StreamStop(DS2438_VoltageStream* stream);
+    
+    /**
+    *   \brief Get the rate achieved by the streaming mode.
+    *
+    *   \param stream pointer to the streaming state.
+    *   \return the number of samples per second, computed from the
+    *       timestamps of the first and last samples.
+    */
+    float DS2438_StreamGetRate(const DS2438_VoltageStream* stream);
+    
+    // ===========================================================
+    //                  TEMPERATURE CONVERSION FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Start temperature conversion.
+    *
+    *   This function starts a new temperature conversion.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_StartTemperatureConversion(void);
+    
+    /**
+    *   \brief Check if temperature conversion is complete. 
+    *
+    *   This function checks if temperature conversion is complete
+    *   by reading the appropriate bit in the Status/Configuration register.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_HasTemperatureData(void);
+    
+    /**
+    *   \brief Get temperature data in float format.
+    *
+    *   This function is gets the temperature data from the DS2438 in float format.
+    *   It is a non-blocking function since it does not wait for the 
+    *   completion of the conversion, that must be started prior to calling this function.
+    *   \param temperature pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetTemperatureData(float* temperature);
+    
+    /**
+    *   \brief Get temperature data in raw format.
+    *
+    *   This function is gets the temperature data from the DS2438 in raw format.
+    *   It is a non-blocking function since it does not wait for the 
+    *   completion of the conversion, that must be started prior to calling this function.
+    *   \param temperature pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetRawTemperatureData(uint16_t* temperature);
+    
+    /**
+    *   \brief Read temperature data in float format.
+    *
+    *   This function is a blocking function that starts a temperature conversion,
+    *   wait until new temperature data are available, and gets the temperature data from 
+    *   the DS2438 in float format.
+    *   \param temperature pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadTemperature(float* temperature);
+    
+    /**
+    *   \brief Read raw temperature data.
+    *
+    *   This function is a blocking function that starts a temperature conversion,
+    *   wait until new temperature data are available, and gets the temperature data from 
+    *   the DS2438 in raw format. Conversion must be performed later.
+    *   \param temperature pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadRawTemperature(uint16_t* temperature);
+        
+    // ===========================================================
+    //              CURRENT AND ACCUMULATORS FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Read current data in float format.
+    *
+    *   This function gets the current data in float format. A positive current
+    *   means that the battery is being charged, while a negative current
+    *   means that current is flowing out of the battery. In order to correctly
+    *   convert the current value from raw to float format, the true value of
+    *   the sense resistor must be set in the #DS2348_SENSE_RESISTOR macro.
+    *   \param current pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetCurrentData(float* current);
+    
+    /**
+    *   \brief Read current data in raw format.
+    *
+    *   This function gets the current data in raw format. No conversion is
+    *   performed in this function, therefore this must be later done by the
+    *   user using the appropriate value of sense resistor.
+    *   \param current pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetRawCurrentData(uint16_t* current);
+    
+    /**
+    *   \brief Read content of ICA register.
+    *
+    *   This function gets the current content of the ICA register,
+    *   which is a 8-bit value representing the integration of the
+    *   voltage across sense resistor over time..
+    *   \param current pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetICA(uint8_t* ica);
+    
+    /**
+    *   \brief Get remaining capacity of the battery.
+    *
+    *   This function converts the content of the ICA into
+    *   remaining capacity according to the formula:
+    *   \f$capacity = \dfrac{ICA}{2048\dotR_{sense}} \f$.
+    *   \param capacity pointer to variable where voltage data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_GetCapacity(float* capacity);
+    
+    /**
+    *   \brief Write threshold value for accumulator.
+    *
+    *   This function writes the new value to be used as a 
+    *   threshold for the accumulator.
+    *   If current conversion is enabled, it is temporarily
+    *   disabled while writing the new threshold value.
+    *   \param threshold the new threshold value to be written.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_WriteThreshold(uint8_t threshold);
+    
+    /**
+    *   \brief Read threshold value for accumulator.
+    *
+    *   This function reads the current threshold value stored in
+    *   the threshold register which is used to determine the
+    *   functionality of the current accumlators.
+    *   \param threshold pointer to variable where threshold data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadThreshold(uint8_t* threshold);
+    
+    /**
+    *   \brief Write new offset value.
+    *   
+    *   This function writes a new offset value so that small currents
+    *   are removed from current values. Because small current ADC offset errors
+    *   can have a large cumulative effect when current is integrated over time,
+    *   the DS2438 provides a method for canceling offset errors in the current 
+    *   ADC. After each current measurement is completed, the measured value
+    *   is added to the contents of the Offset Register and the result 
+    *   is then stored in the Current Register. 
+    *   The Offset Register is a two-byte nonvolatile read/write register 
+    *   formatted in two’s-complement format.
+    *   \param offset new offset value to be written.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_WriteOffset(int16_t offset);
+    
+    /**
+    *   \brief Read offset value.
+    *
+    *   This function reads the current offset value stored
+    *   in the offset register. The value returned is in raw
+    *   format and needs to be converted in two's complement.
+    *   \param offset pointer to variable where offset value will be stored
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_ReadOffset(uint16_t* offset);
+
+    // ===========================================================
+    //                  CRC FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Enable CRC Check for all reading/writing functions.
+    *
+    *   This function sets a global flag that enables the CRC Check
+    *   for all the functions requiring it.
+    */
+    void DS2438_EnableCRC(void);
+    
+    /**
+    *   \brief Disable CRC Check for all reading/writing functions.
+    *
+    *   This function sets a global flag that disables the CRC Check
+    *   for all the functions requiring it.
+    */
+    void DS2438_DisableCRC(void);
+    
+    // ===========================================================
+    //                  CONFIGURATION FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Enable current measurements and ICA.
+    *
+    *   If IAD is enabeld, current measurements will be taken at a rate
+    *   of 36.41 Hz, and the results of the conversion can be retrieved
+    *   using the #DS2438_GetCurrentData().
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_EnableIAD(void);
+    
+    /**
+    *   \brief Disable current measurements and ICA.
+    *
+    *   DIsable current conversion and ICA. No current conversion
+    *   will be performed by the DS2438.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_DisableIAD(void);
+    
+    /**
+    *   \brief Enable current accumulator.
+    *
+    *   If CA is enabled, bot charging current accumulator and discharging
+    *   current accumulator are used. These registers store the total
+    *   charging/discharging current the battery has encountered in
+    *   its lifetime.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_EnableCA(void);
+    
+    /**
+    *   \brief Disable current measurements and ICA.
+    *
+    *   Disable current conversion and ICA. No current conversion
+    *   will be performed by the DS2438.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_DisableCA(void);
+    
+    /**
+    *   \brief Enable shadow of data to EEPROM.
+    *
+    *   Enable shadow of CCA and DCA to EEPROM. When enabled, 
+    *   CCA and DCA counters will be shadowed to EEPROM whenever
+    *   their values change. This function has no effect it
+    *   the CA are not enabled.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_EnableShadowEE(void);
+    
+    /**
+    *   \brief Disable shadow of data to EEPROM.
+    *
+    *   Disable shadow of CCA and DCA to EEPROM. If battery
+    *   becomes discharged, CCA/DCA data could be lost.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_DisableShadowEE(void);
+    
+    /**
+    *   \brief Check if a copy from scratchpad to EEPROM is in progress.
+    *
+    *   This function checks whether a copy from scratchpad to
+    *   EEPROM is currently in progress. While a copy issued by the
+    *   library is tracked, its status is obtained without a page read,
+    *   see #DS2438_TrackedCopyInProgress(). Otherwise, the NVB bit of
+    *   the status register is read, so that copies issued by another
+    *   bus master are seen too.
+    *   \param copy set to 1 if copy in progress, 0 otherwise.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device was found on the bus.
+    */
+    uint8_t DS2438_CopyInProgress(uint8_t* copy);
+    
+    /**
+    *   \brief Check if a copy issued by the library is in progress.
+    *
+    *   Only the copies issued by #DS2438_WritePage(), #DS2438_WritePageAsync()
+    *   and #DS2438_RecordCopy() are checked, as with #DS2438_PollCopy(), so no
+    *   page is read when none is tracked.
+    *   \return 1 if copy in progress, 0 otherwise.
+    */
+    uint8_t DS2438_TrackedCopyInProgress(void);
+    
+    // ===========================================================
+    //                  LOW LEVEL FUNCTIONS
+    // ===========================================================
+    
+    /**
+    *   \brief Read one page of data.
+    *
+    *   This function reads one page of data and return the read samples
+    *   in the array passed in as parameter. If the page is in the page
+    *   cache and its volatile bytes are recent enough, it is served from RAM.
+    *   Otherwise, this function issues a recall memory command, followed by
+    *   a read scratchpage command and the page to be read.
+    *   \param page_number the page to be read.
+    *   \param page_data pointer to array where data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_ReadPage(uint8_t page_number, uint8_t* page_data);
+    
+    /**
+    *   \brief Read one page of data with a freshness tolerance.
+    *
+    *   This function behaves like #DS2438_ReadPage(), but the page is served
+    *   from the page cache only if its volatile bytes are younger than the
+    *   maximum age passed in as parameter.
+    *   \param page_number the page to be read.
+    *   \param max_age_ms maximum age of cached data, in milliseconds. 0 forces a read from the device
+    *       of pages that contain volatile bytes.
+    *   \param page_data pointer to array where data will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_ReadPageWithMaxAge(uint8_t page_number, uint32_t max_age_ms, uint8_t* page_data);
+    
+    /**
+    *   \brief Read one page of data from the device and get the time of the recall.
+    *
+    *   This function always reads the page from the device. The recall memory
+    *   command copies the page to the scratchpad, so the data returned are a
+    *   snapshot of the page taken at the time of the recall.
+    *   \param page_number the page to be read.
+    *   \param page_data pointer to array where data will be stored.
+    *   \param recall_us pointer to variable where the time of the recall, in microseconds, will be stored.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_ReadPageTimestamped(uint8_t page_number, uint8_t* page_data, uint32_t* recall_us);
+    
+    /**
+    *   \brief Write one page of data.
+    *
+    *   This function writes one page of data to the DS2438. This can be
+    *   used to either configure bits in the registers or to write user bytes
+    *   to the device in its EEPROM.
+    *   \param page_number the page number to be written.
+    *   \param page_data the data to be written to the page.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_WritePage(uint8_t page_number, uint8_t* page_data);
+    
+    /**
+    *   \brief Write one page of data without waiting for the EEPROM copy.
+    *
+    *   This function writes one page of data to the DS2438 and returns
+    *   as soon as the copy scratchpad command has been issued. The copy
+    *   is tracked by the library: a following transaction that depends on it
+    *   (a read of the same page or another write) waits for its completion,
+    *   while unrelated transactions (e.g. conversions, reads of other pages)
+    *   can be performed during the copy window.
+    *   \param page_number the page number to be written.
+    *   \param page_data the data to be written to the page.
+    *   \param token pointer to the completion token of the copy. Can be NULL.
+    *   \retval #DS2438_OK if device is present on the bus.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    */
+    uint8_t DS2438_WritePageAsync(uint8_t page_number, uint8_t* page_data, DS2438_CopyToken* token);
+    
+    /**
+    *   \brief Record a copy issued outside of this API on its device.
+    *
+    *   Used by the non-blocking operations of DS2438_Async.h on the device
+    *   addressed with SKIP ROM on DS2438_Pin_0: the page is written through
+    *   the page cache and the copy is tracked as one issued by
+    *   #DS2438_WritePageAsync(). Must be called right after the copy
+    *   scratchpad command, before the next reset.
+    *   \param page_number the page copied, from 0 to 7.
+    *   \param page_data the 8 bytes written to the scratchpad.
+    *   \param token pointer to the completion token of the copy. Can be NULL.
+    */
+    void DS2438_RecordCopy(uint8_t page_number, const uint8_t* page_data, DS2438_CopyToken* token);
+    
+    /**
+    *   \brief Check if the copy associated to a token is completed.
+    *
+    *   If no other 1-Wire transaction was performed after the copy was
+    *   issued, the status is polled with a single read time slot, once
+    *   #DS2438_COPY_MIN_TIME_US elapsed. Otherwise, the copy is considered
+    *   completed once its deadline has expired.
+    *   This function never performs a page read.
+    *   \param token the completion token returned by #DS2438_WritePageAsync().
+    *   \param done set to 1 if the copy is completed, 0 otherwise.
+    *   \retval #DS2438_OK if no error was generated.
+    */
+    uint8_t DS2438_PollCopy(DS2438_CopyToken* token, uint8_t* done);
+    
+    /**
+    *   \brief Wait until the copy associated to a token is completed.
+    *
+    *   \param token the completion token returned by #DS2438_WritePageAsync().
+    *   \retval #DS2438_OK if no error was generated.
+    */
+    uint8_t DS2438_WaitCopy(DS2438_CopyToken* token);
+    
+    /**
+    *   \brief Get the page cache of the device.
+    *
+    *   #DS2438_ReadPage() serves pages from this cache when their volatile
+    *   bytes are younger than the maximum age of their class, and 
+    *   #DS2438_WritePage() updates it. The returned pointer can be used to
+    *   configure the maximum ages with #DS2438_CacheSetMaxAge() and to
+    *   get hit/miss counters with #DS2438_CacheGetStats().
+    *   \return pointer to the page cache.
+    */
+    DS2438_PageCache* DS2438_GetPageCache(void);
+    
+    /**
+    *   \brief Compute CRC value based on Dallas specs.
+    *
+    *   This function computes the CRC value according to the
+    *   specification of Dallas.
+    *   \param data the data from which to compute the CRC value.
+    *   \param len the length of the data.
+    *   \return CRC value.
+    */
+    uint8_t DS2438_ComputeCrc(const uint8_t *data, uint8_t len);
+    
+    /**
+    *   \brief Check if CRC value is equal to the expected one.
+    *
+    *   This function checks if the computed CRC value is equal
+    *   to the expected one.
+    *   \param data the data from which to compute the CRC value.
+    *   \param len the length of the data.
+    *   \param crc_value the expected CRC value.
+    *   \retval #DS2438_OK if CRC is equal to the expected one.
+    *   \retval #DS2438_CRC_FAIL if CRC is not equal to the expected one.
+    */
+    uint8_t DS2438_CheckCrcValue(uint8_t* data, uint8_t len, uint8_t crc_value);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,571 @@
+/**
+ * \file DS2438.hpp
+ * \brief Header-only C++ front end for the DS2438 Library.
+ *
+ * This header implements the main DS2438 transactions as a class template,
+ * Ds2438<Bus, Timing, CrcPolicy>, where the pin, the 1-Wire timing and the
+ * CRC policy are template parameters. It issues the same transactions as
+ * the C API, and its timings are the profiles of OneWire.h. Slot delays are compile-time constants
+ * and the pin register is known at compile time, so the compiler can inline
+ * the whole bit-banging path and drop the CRC check when it is not needed,
+ * with no timing table lookup and no runtime flag.
+ *
+ * The C API declared in DS2438.h is not affected. The two front ends share
+ * the CRC code and the timebase. On the bus of the C API, PinBus<DS2438_Pin_0>,
+ * the template also keeps the state of the C API up to date, so the two can
+ * be mixed: it waits for a copy issued by #DS2438_WritePageAsync() before
+ * using the bus, fills the page cache and the page 0 snapshot with the pages
+ * it reads, writes the pages it writes through the cache and invalidates
+ * page 0 when it starts a conversion. On any other bus the template reads
+ * every page from the device and touches no C state.
+ *
+ * Requires C++17.
+*/
+#ifndef __DS2438_HPP__
+    #define __DS2438_HPP__
+
+    extern "C" {
+    #include "project.h"
+    }
+    #include "DS2438.h"
+    #include "DS2438_Cache.h"
+    #include "OneWire.h"
+    #include "DS2438_Snapshot.h"
+    #include "Timebase.h"
+    #include <type_traits>
+
+    namespace ds2438
+    {
+
+    // ===========================================================
+    //                      BUS
+    // ===========================================================
+
+    /**
+    *   \brief 1-Wire bus on a PSoC pin.
+    *
+    *   \tparam Pin pin address, as used by the CyPins_* macros (e.g. DS2438_Pin_0).
+    */
+    template <uint32_t Pin>
+    struct PinBus
+    {
+        static inline void DriveLow() { CyPins_ClearPin(Pin); }
+        static inline void Release() { CyPins_SetPin(Pin); }
+        static inline bool Sample() { return CyPins_ReadPin(Pin) > 0; }
+    };
+
+    // ===========================================================
+    //                      TIMING
+    // ===========================================================
+
+    /**
+    *   \brief Compile-time 1-Wire timing, in us.
+    *
+    *   Delays A to J have the same meaning as the fields of #OneWire_Timing.
+    */
+    template <uint16_t A, uint16_t B, uint16_t C, uint16_t D, uint16_t E,
+              uint16_t F, uint16_t G, uint16_t H, uint16_t I, uint16_t J>
+    struct Timing
+    {
+        static constexpr uint16_t a = A;
+        static constexpr uint16_t b = B;
+        static constexpr uint16_t c = C;
+        static constexpr uint16_t d = D;
+        static constexpr uint16_t e = E;
+        static constexpr uint16_t f = F;
+        static constexpr uint16_t g = G;
+        static constexpr uint16_t h = H;
+        static constexpr uint16_t i = I;
+        static constexpr uint16_t j = J;
+
+        static_assert(A + B >= 60, "Write 1 slot shorter than 60 us");
+        static_assert(C >= 60, "Write 0 slot shorter than 60 us");
+        static_assert(A + E + F >= 60, "Read slot shorter than 60 us");
+        static_assert(H >= 480, "Reset pulse shorter than 480 us");
+    };
+
+    /**
+    *   \brief Same timing as #ONEWIRE_PROFILE_STANDARD.
+    */
+    using StandardTiming = Timing<ONEWIRE_TIMING_STANDARD>;
+
+    /**
+    *   \brief Same timing as #ONEWIRE_PROFILE_SHORT_TRACE.
+    */
+    using ShortTraceTiming = Timing<ONEWIRE_TIMING_SHORT_TRACE>;
+
+    /**
+    *   \brief Same timing as #ONEWIRE_PROFILE_LONG_LINE.
+    */
+    using LongLineTiming = Timing<ONEWIRE_TIMING_LONG_LINE>;
+
+    // ===========================================================
+    //                      CRC POLICIES
+    // ===========================================================
+
+    /**
+    *   \brief Check the CRC of every page read, as #DS2438_DO_CRC_CHECK.
+    */
+    struct CrcCheck
+    {
+        static constexpr bool enabled = true;
+    };
+
+    /**
+    *   \brief Skip the CRC check, as #DS2438_NO_CRC_CHECK.
+    */
+    struct NoCrcCheck
+    {
+        static constexpr bool enabled = false;
+    };
+
+    // ===========================================================
+    //                      DEVICE
+    // ===========================================================
+
+    /**
+    *   \brief DS2438 device on a dedicated 1-Wire bus.
+    *
+    *   All the functions are static and return the same error codes
+    *   as the C API.
+    *   \tparam Bus bus type, e.g. PinBus<DS2438_Pin_0>.
+    *   \tparam T timing type, e.g. StandardTiming.
+    *   \tparam CrcPolicy CrcCheck or NoCrcCheck.
+    */
+    template <class Bus, class T = StandardTiming, class CrcPolicy = CrcCheck>
+    class Ds2438
+    {
+    public:
+        /**
+        *   \brief True if the device is the one of the C API, whose state is kept up to date.
+        */
+        static constexpr bool shares_c_state = std::is_same<Bus, PinBus<DS2438_Pin_0>>::value;
+
+        // ===========================================================
+        //                      1-WIRE FUNCTIONS
+        // ===========================================================
+
+        /**
+        *   \brief Generate a 1-Wire reset.
+        *
+        *   \retval 0 if a device is present.
+        *   \retval 1 if no device is present.
+        */
+        static inline int Reset()
+        {
+            CyDelayUs(T::g);
+            Bus::DriveLow();
+            CyDelayUs(T::h);
+            Bus::Release();
+            CyDelayUs(T::i);
+            int result = Bus::Sample() ? 1 : 0;
+            CyDelayUs(T::j);
+            return result;
+        }
+
+        /**
+        *   \brief Send a bit.
+        */
+        static inline void WriteBit(bool bit)
+        {
+            Bus::DriveLow();
+            if (bit)
+            {
+                CyDelayUs(T::a);
+                Bus::Release();
+                CyDelayUs(T::b);
+            }
+            else
+            {
+                CyDelayUs(T::c);
+                Bus::Release();
+                CyDelayUs(T::d);
+            }
+        }
+
+        /**
+        *   \brief Read a bit.
+        */
+        static inline bool ReadBit()
+        {
+            Bus::DriveLow();
+            CyDelayUs(T::a);
+            Bus::Release();
+            CyDelayUs(T::e);
+            bool result = Bus::Sample();
+            CyDelayUs(T::f);
+            return result;
+        }
+
+        /**
+        *   \brief Send a byte, LSB first.
+        */
+        static inline void WriteByte(uint8_t data)
+        {
+            for (uint8_t loop = 0; loop < 8; loop++)
+            {
+                WriteBit(data & 0x01);
+                data >>= 1;
+            }
+        }
+
+        /**
+        *   \brief Read a byte, LSB first.
+        */
+        static inline uint8_t ReadByte()
+        {
+            uint8_t result = 0;
+            for (uint8_t loop = 0; loop < 8; loop++)
+            {
+                result >>= 1;
+                if (ReadBit())
+                    result |= 0x80;
+            }
+            return result;
+        }
+
+        // ===========================================================
+        //                      DEVICE FUNCTIONS
+        // ===========================================================
+
+        /**
+        *   \brief Check if the device is present on the bus.
+        *
+        *   \retval #DS2438_OK if the device is present.
+        *   \retval #DS2438_DEV_NOT_FOUND if the device is not present.
+        */
+        static uint8_t IsPresent()
+        {
+            return (Reset() == 0) ? DS2438_OK : DS2438_DEV_NOT_FOUND;
+        }
+
+        /**
+        *   \brief Read the 64-bit ROM of the device.
+        *
+        *   \param rom pointer to an array of 8 bytes.
+        *   \retval #DS2438_OK if the ROM was read.
+        *   \retval #DS2438_CRC_FAIL if the CRC of the ROM is not valid.
+        *   \retval #DS2438_DEV_NOT_FOUND if the device is not present.
+        */
+        static uint8_t ReadRom(uint8_t* rom)
+        {
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_READ_ROM);
+            for (uint8_t loop = 0; loop < 8; loop++)
+            {
+                rom[loop] = ReadByte();
+            }
+            return CheckCrc(rom, 7, rom[7]);
+        }
+
+        /**
+        *   \brief Read a page from the device.
+        *
+        *   \param page_number the page to read, from 0 to 7.
+        *   \param page_data pointer to an array of 9 bytes: 8 data bytes and the CRC.
+        *   \retval #DS2438_OK if the page was read.
+        *   \retval #DS2438_CRC_FAIL if the CRC of the page is not valid.
+        *   \retval #DS2438_BAD_PARAM if the page number is not valid.
+        *   \retval #DS2438_DEV_NOT_FOUND if the device is not present.
+        */
+        static uint8_t ReadPage(uint8_t page_number, uint8_t* page_data)
+        {
+            if (page_number > 0x07)
+                return DS2438_BAD_PARAM;
+            WaitCopyOfC();
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_SKIP_ROM);
+            WriteByte(DS2438_RECALL_MEMORY);
+            WriteByte(page_number);
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_SKIP_ROM);
+            WriteByte(DS2438_READ_SCRATCHPAD);
+            WriteByte(page_number);
+            for (uint8_t i = 0; i < 9; i++)
+            {
+                page_data[i] = ReadByte();
+            }
+            if constexpr (shares_c_state)
+            {
+                // Same as a read of the C API; pages with a bad CRC are not stored
+                DS2438_CacheFill(DS2438_GetPageCache(), page_number, page_data);
+                if ((page_number == 0x00) && (DS2438_ComputeCrc(page_data, 8) == page_data[8]))
+                    DS2438_SnapshotPublish(page_data);
+            }
+            return CheckCrc(page_data, 8, page_data[8]);
+        }
+
+        /**
+        *   \brief Write a page to the device and wait for the copy.
+        *
+        *   The transactions and the wait for the copy are the ones of
+        *   #DS2438_WritePage(): the ninth byte of the page, the position of
+        *   the CRC, is sent too.
+        *   \param page_number the page to write, from 0 to 7.
+        *   \param page_data pointer to an array of 9 bytes, as the pages of the C API.
+        *   \retval #DS2438_OK if the page was written.
+        *   \retval #DS2438_BAD_PARAM if the page number is not valid.
+        *   \retval #DS2438_DEV_NOT_FOUND if the device is not present.
+        */
+        static uint8_t WritePage(uint8_t page_number, const uint8_t* page_data)
+        {
+            if (page_number > 0x07)
+                return DS2438_BAD_PARAM;
+            WaitCopyOfC();
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_SKIP_ROM);
+            WriteByte(DS2438_WRITE_SCRATCHPAD);
+            WriteByte(page_number);
+            for (uint8_t i = 0; i < 9; i++)
+            {
+                WriteByte(page_data[i]);
+            }
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_SKIP_ROM);
+            WriteByte(DS2438_COPY_SCRATCHPAD);
+            WriteByte(page_number);
+            if constexpr (shares_c_state)
+                DS2438_CacheWriteThrough(DS2438_GetPageCache(), page_number, page_data);
+            WaitCopy();
+            return DS2438_OK;
+        }
+
+        // ===========================================================
+        //                  CONVERSION FUNCTIONS
+        // ===========================================================
+
+        /**
+        *   \brief Start a voltage conversion, as #DS2438_StartVoltageConversion().
+        */
+        static uint8_t StartVoltageConversion()
+        {
+            return StartConversion(DS2438_VOLTAGE_CONV);
+        }
+
+        /**
+        *   \brief Check if the voltage conversion is complete, as #DS2438_HasVoltageData().
+        *
+        *   \retval #DS2438_ERROR if the conversion is running.
+        */
+        static uint8_t HasVoltageData()
+        {
+            return HasData(0x01 << 6);
+        }
+
+        /**
+        *   \brief Read the raw voltage from page 0, as #DS2438_GetRawVoltageData().
+        */
+        static uint8_t GetRawVoltageData(uint16_t* voltage)
+        {
+            uint8_t page_data[9];
+            uint8_t error = ReadMeasurementPage(page_data);
+            if (error == DS2438_OK)
+                *voltage = (page_data[4] << 8) | page_data[3];
+            return error;
+        }
+
+        /**
+        *   \brief Start a temperature conversion, as #DS2438_StartTemperatureConversion().
+        */
+        static uint8_t StartTemperatureConversion()
+        {
+            return StartConversion(DS2438_TEMP_CONV);
+        }
+
+        /**
+        *   \brief Check if the temperature conversion is complete, as #DS2438_HasTemperatureData().
+        *
+        *   \retval #DS2438_ERROR if the conversion is running.
+        */
+        static uint8_t HasTemperatureData()
+        {
+            return HasData(0x01 << 4);
+        }
+
+        /**
+        *   \brief Read the raw temperature from page 0, as #DS2438_GetRawTemperatureData().
+        */
+        static uint8_t GetRawTemperatureData(uint16_t* temperature)
+        {
+            uint8_t page_data[9];
+            uint8_t error = ReadMeasurementPage(page_data);
+            if (error == DS2438_OK)
+                *temperature = (page_data[2] << 8) | page_data[1];
+            return error;
+        }
+
+        /**
+        *   \brief Convert and read the raw voltage of the selected input.
+        *
+        *   Same transactions as #DS2438_ReadRawVoltage().
+        *   \param voltage pointer to variable where the voltage, in units of 10 mV, will be stored.
+        */
+        static uint8_t ReadRawVoltage(uint16_t* voltage)
+        {
+            uint8_t error = Convert(DS2438_VOLTAGE_CONV, 0x01 << 6);
+            if (error == DS2438_OK)
+                error = GetRawVoltageData(voltage);
+            return error;
+        }
+
+        /**
+        *   \brief Convert and read the raw temperature.
+        *
+        *   Same transactions as #DS2438_ReadRawTemperature().
+        *   \param temperature pointer to variable where the temperature, in units of 1/256 degree Celsius, will be stored.
+        */
+        static uint8_t ReadRawTemperature(uint16_t* temperature)
+        {
+            uint8_t error = Convert(DS2438_TEMP_CONV, 0x01 << 4);
+            if (error == DS2438_OK)
+                error = GetRawTemperatureData(temperature);
+            return error;
+        }
+
+        /**
+        *   \brief Read the raw current from page 0.
+        *
+        *   \param current pointer to variable where the current register will be stored.
+        */
+        static uint8_t ReadRawCurrent(uint16_t* current)
+        {
+            uint8_t page_data[9];
+            uint8_t error = ReadPage(0x00, page_data);
+            if (error == DS2438_OK)
+                *current = (page_data[6] << 8) | page_data[5];
+            return error;
+        }
+
+        /**
+        *   \brief Convert and read the voltage, in V.
+        */
+        static uint8_t ReadVoltage(float* voltage)
+        {
+            uint16_t raw;
+            uint8_t error = ReadRawVoltage(&raw);
+            if (error == DS2438_OK)
+                *voltage = raw / 100.0;
+            return error;
+        }
+
+        /**
+        *   \brief Convert and read the temperature, in degrees Celsius.
+        */
+        static uint8_t ReadTemperature(float* temperature)
+        {
+            uint16_t raw;
+            uint8_t error = ReadRawTemperature(&raw);
+            if (error == DS2438_OK)
+                *temperature = (int16_t)raw / 256.0;
+            return error;
+        }
+
+        /**
+        *   \brief Read the current, in A.
+        */
+        static uint8_t ReadCurrent(float* current)
+        {
+            uint16_t raw;
+            uint8_t error = ReadRawCurrent(&raw);
+            if (error == DS2438_OK)
+                *current = (int16_t)raw / (4096. * DS2438_SENSE_RESISTOR);
+            return error;
+        }
+
+    private:
+        // CRC check, removed at compile time with NoCrcCheck
+        static inline uint8_t CheckCrc(const uint8_t* data, uint8_t len, uint8_t crc_value)
+        {
+            if constexpr (CrcPolicy::enabled)
+                return (DS2438_ComputeCrc(data, len) == crc_value) ? DS2438_OK : DS2438_CRC_FAIL;
+            else
+                return DS2438_OK;
+        }
+
+        // Wait for a copy issued by the C API: the template does not count
+        // its resets, so the C API could not tell that the copy was ended
+        static inline void WaitCopyOfC()
+        {
+            if constexpr (shares_c_state)
+            {
+                while (DS2438_TrackedCopyInProgress())
+                {
+                    CyDelayUs(DS2438_COPY_POLL_US);
+                }
+            }
+        }
+
+        // Wait for the copy just issued, as DS2438_WaitCopy(): read slots
+        // answer 1 when it is done, but are not trusted before the shortest
+        // copy time, and the copy is taken as done at its longest time
+        static void WaitCopy()
+        {
+            uint32_t start_us = Timebase_GetUs();
+            for (;;)
+            {
+                if (Timebase_IsExpired(start_us + DS2438_COPY_MIN_TIME_US) && ReadBit())
+                    return;
+                if (Timebase_IsExpired(start_us + DS2438_COPY_TIME_US))
+                    return;
+                CyDelayUs(DS2438_COPY_POLL_US);
+            }
+        }
+
+        // Start a conversion
+        static uint8_t StartConversion(uint8_t command)
+        {
+            WaitCopyOfC();
+            if (Reset() != 0)
+                return DS2438_DEV_NOT_FOUND;
+            WriteByte(DS2438_SKIP_ROM);
+            WriteByte(command);
+            if constexpr (shares_c_state)
+                DS2438_CacheInvalidate(DS2438_GetPageCache(), 0x00);
+            return DS2438_OK;
+        }
+
+        // Read page 0 from the device and check the busy flag
+        static uint8_t HasData(uint8_t busy_flag)
+        {
+            uint8_t page_data[9];
+            uint8_t error = ReadPage(0x00, page_data);
+            if (error != DS2438_OK)
+                return error;
+            return ((page_data[0] & busy_flag) == 0) ? DS2438_OK : DS2438_ERROR;
+        }
+
+        // Read page 0 through the page cache of the C API if shared, as DS2438_ReadPage()
+        static uint8_t ReadMeasurementPage(uint8_t* page_data)
+        {
+            if constexpr (shares_c_state)
+            {
+                if (DS2438_CacheLookup(DS2438_GetPageCache(), 0x00, page_data) == DS2438_OK)
+                    return CheckCrc(page_data, 8, page_data[8]);
+            }
+            return ReadPage(0x00, page_data);
+        }
+
+        // Start a conversion and poll page 0 until it is complete, as the
+        // C API. A missing device ends the wait, which the C API does not.
+        static uint8_t Convert(uint8_t command, uint8_t busy_flag)
+        {
+            uint8_t error = StartConversion(command);
+            if (error != DS2438_OK)
+                return error;
+            do
+            {
+                error = HasData(busy_flag);
+            } while ((error == DS2438_ERROR) || (error == DS2438_CRC_FAIL));
+            return error;
+        }
+    };
+
+    } // namespace ds2438
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,225 @@
+/********************************************
+*
+*   \brief Source code for the extended accumulators.
+*
+*   ICA is an up/down counter, so its variation
+*   between two polls is computed as a signed 8-bit
+*   difference. CCA and DCA only count up, so their
+*   variation is an unsigned 16-bit difference.
+*
+**********************************************/
+
+#include "DS2438_Accumulators.h"
+#include "DS2438.h"
+#include "DS2438_History.h"
+#include "DS2438_Storage.h"
+#include "Timebase.h"
+
+// Identifies a valid record in EEPROM
+#define RECORD_MAGIC 0xA5C4
+
+// Size of the serialized record, including ROM ID and CRC
+#define RECORD_SIZE 28
+
+// Offset of the ROM ID of the device in the record
+#define RECORD_ROM_OFFSET 19
+
+static DS2438_AccumulatorTotals totals;
+
+// ROM ID of the device whose registers are accumulated
+static uint8_t rom_id[8];
+
+// Raw register values at the last poll
+static uint8_t last_ica;
+static uint16_t last_cca;
+static uint16_t last_dca;
+static uint32_t last_poll_ms;
+static uint32_t last_save_ms;
+static uint8_t accumulators_started = 0;
+
+// Longest interval in which a register cannot change by more than half its range
+static uint32_t DS2438_WrapSafeInterval(uint32_t half_range, uint32_t counts_per_hour)
+{
+    uint64_t interval_ms = ((uint64_t)half_range * 3600000) / counts_per_hour;
+    return (interval_ms > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)interval_ms;
+}
+
+// Read current value of ICA, CCA and DCA
+static uint8_t DS2438_ReadAccumulators(uint8_t* ica, uint16_t* cca, uint16_t* dca)
+{
+    uint8_t page_data[9];
+    uint8_t error = DS2438_ReadPageWithMaxAge(0x01, 0, page_data);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    *ica = page_data[4];
+
+    error = DS2438_ReadPageWithMaxAge(0x07, 0, page_data);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    *cca = DS2438_DecodeCCA(page_data);
+    *dca = DS2438_DecodeDCA(page_data);
+    return DS2438_OK;
+}
+
+// Read registers and add variations since last poll to totals
+static uint8_t DS2438_UpdateAccumulators(void)
+{
+    uint8_t ica;
+    uint16_t cca, dca;
+    uint8_t error = DS2438_ReadAccumulators(&ica, &cca, &dca);
+    if (error != DS2438_OK)
+        return error;
+
+    uint32_t now_ms = Timebase_GetMs();
+    if ((now_ms - last_poll_ms) > 2 * DS2438_GetAccumulatorsPollInterval())
+    {
+        // A wrap may have been missed
+        totals.late_polls++;
+    }
+    totals.ica += (int8_t)(ica - last_ica);
+    totals.cca += (uint16_t)(cca - last_cca);
+    totals.dca += (uint16_t)(dca - last_dca);
+    last_ica = ica;
+    last_cca = cca;
+    last_dca = dca;
+    last_poll_ms = now_ms;
+    return DS2438_OK;
+}
+
+static void DS2438_PutUint32(uint8_t* data, uint32_t value)
+{
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >> 24) & 0xFF;
+}
+
+static uint32_t DS2438_GetUint32(const uint8_t* data)
+{
+    return ((uint32_t)data[3] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[1] << 8) | data[0];
+}
+
+// The record was saved for the device on the bus
+static uint8_t DS2438_RecordMatchesRom(const uint8_t* record)
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (record[RECORD_ROM_OFFSET + i] != rom_id[i])
+            return 0;
+    }
+    return 1;
+}
+
+uint8_t DS2438_AccumulatorsStart(void)
+{
+    uint8_t record[RECORD_SIZE];
+
+    accumulators_started = 0;
+    totals.ica = 0;
+    totals.cca = 0;
+    totals.dca = 0;
+    totals.late_polls = 0;
+
+    uint8_t error = DS2438_ReadRawRom(rom_id);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(rom_id, 7, rom_id[7]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    error = DS2438_ReadAccumulators(&last_ica, &last_cca, &last_dca);
+    if (error != DS2438_OK)
+        return error;
+    last_poll_ms = Timebase_GetMs();
+    last_save_ms = last_poll_ms;
+
+    // Restore totals and raw values of the last save, unless the battery was swapped:
+    // the registers of another device start again from the current values
+    if ((DS2438_StorageStart() == DS2438_OK) &&
+        (DS2438_StorageRead(DS2438_STORAGE_ACCUMULATORS_OFFSET, record, RECORD_SIZE) == DS2438_OK) &&
+        (((record[1] << 8) | record[0]) == RECORD_MAGIC) &&
+        (DS2438_CheckCrcValue(record, RECORD_SIZE - 1, record[RECORD_SIZE - 1]) == DS2438_OK) &&
+        (DS2438_RecordMatchesRom(record) == 1))
+    {
+        uint8_t ica = last_ica;
+        uint16_t cca = last_cca;
+        uint16_t dca = last_dca;
+        totals.ica = (int32_t)DS2438_GetUint32(&record[2]);
+        totals.cca = DS2438_GetUint32(&record[6]);
+        totals.dca = DS2438_GetUint32(&record[10]);
+        last_ica = record[14];
+        last_cca = (record[16] << 8) | record[15];
+        last_dca = (record[18] << 8) | record[17];
+        // Counts accumulated by the device since the last save
+        totals.ica += (int8_t)(ica - last_ica);
+        totals.cca += (uint16_t)(cca - last_cca);
+        totals.dca += (uint16_t)(dca - last_dca);
+        last_ica = ica;
+        last_cca = cca;
+        last_dca = dca;
+    }
+    accumulators_started = 1;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_AccumulatorsPoll(void)
+{
+    if (accumulators_started == 0)
+        return DS2438_AccumulatorsStart();
+    if ((Timebase_GetMs() - last_poll_ms) < DS2438_GetAccumulatorsPollInterval())
+        return DS2438_OK;
+
+    uint8_t error = DS2438_UpdateAccumulators();
+    if ((error == DS2438_OK) && ((last_poll_ms - last_save_ms) >= DS2438_ACCUMULATORS_SAVE_INTERVAL_MS))
+    {
+        DS2438_AccumulatorsSave();
+    }
+    return error;
+}
+
+uint8_t DS2438_AccumulatorsSave(void)
+{
+    uint8_t record[RECORD_SIZE];
+
+    if (accumulators_started == 0)
+        return DS2438_ERROR;
+    record[0] = RECORD_MAGIC & 0xFF;
+    record[1] = RECORD_MAGIC >> 8;
+    DS2438_PutUint32(&record[2], (uint32_t)totals.ica);
+    DS2438_PutUint32(&record[6], totals.cca);
+    DS2438_PutUint32(&record[10], totals.dca);
+    record[14] = last_ica;
+    record[15] = last_cca & 0xFF;
+    record[16] = last_cca >> 8;
+    record[17] = last_dca & 0xFF;
+    record[18] = last_dca >> 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        record[RECORD_ROM_OFFSET + i] = rom_id[i];
+    }
+    record[RECORD_SIZE - 1] = DS2438_ComputeCrc(record, RECORD_SIZE - 1);
+
+    if (DS2438_StorageStart() != DS2438_OK)
+        return DS2438_ERROR;
+    if (DS2438_StorageWrite(DS2438_STORAGE_ACCUMULATORS_OFFSET, record, RECORD_SIZE) != DS2438_OK)
+        return DS2438_ERROR;
+    last_save_ms = last_poll_ms;
+    return DS2438_OK;
+}
+
+void DS2438_GetAccumulatorTotals(DS2438_AccumulatorTotals* accumulator_totals)
+{
+    *accumulator_totals = totals;
+}
+
+uint32_t DS2438_GetAccumulatorsPollInterval(void)
+{
+    uint32_t ica_interval = DS2438_WrapSafeInterval(127, DS2438_ICA_MAX_COUNTS_PER_HOUR);
+    uint32_t ca_interval = DS2438_WrapSafeInterval(32767, DS2438_CA_MAX_COUNTS_PER_HOUR);
+    // Half of the wrap-safe interval as safety margin
+    return ((ica_interval < ca_interval) ? ica_interval : ca_interval) / 2;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,112 @@
+/**
+ * \file DS2438_Accumulators.h
+ * \brief Extended current accumulators for the DS2438 Library.
+ *
+ * The ICA of the DS2438 is an 8-bit register, while CCA and DCA
+ * are 16-bit registers, and all of them wrap around. This module
+ * polls the registers often enough to never miss a wrap, given the
+ * maximum count rate of each register, and extends them to 32-bit
+ * totals. Totals are saved periodically to the emulated EEPROM
+ * together with the raw register values and the ROM ID of the
+ * device, so that the charge accumulated by the device while the
+ * micro-controller was reset is accounted for at the next start,
+ * and the totals of a swapped battery are not carried over.
+*/
+#ifndef __DS2438_ACCUMULATORS_H__
+    #define __DS2438_ACCUMULATORS_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Maximum count rate of the ICA, in counts per hour.
+    *
+    *   Full scale sense voltage (250mV) divided by the ICA LSB (0.4883mVh).
+    */
+    #define DS2438_ICA_MAX_COUNTS_PER_HOUR      512
+
+    /**
+    *   \brief Maximum count rate of CCA and DCA, in counts per hour.
+    *
+    *   Full scale sense voltage (250mV) divided by the CCA/DCA LSB (15.625mVh).
+    */
+    #define DS2438_CA_MAX_COUNTS_PER_HOUR       16
+
+    /**
+    *   \brief Interval between two saves of the totals to EEPROM, in milliseconds.
+    */
+    #define DS2438_ACCUMULATORS_SAVE_INTERVAL_MS 3600000
+
+    /**
+    *   \brief Extended accumulators.
+    */
+    typedef struct {
+        int32_t ica;                ///< Extended ICA, in ICA counts
+        uint32_t cca;               ///< Extended CCA, in CCA counts
+        uint32_t dca;               ///< Extended DCA, in DCA counts
+        uint32_t late_polls;        ///< Polls performed after the wrap-safe interval expired
+    } DS2438_AccumulatorTotals;
+
+    /**
+    *   \brief Start the extended accumulators.
+    *
+    *   This function reads the ROM ID and the current value of the
+    *   registers. If the record saved in EEPROM belongs to the same
+    *   device, the totals are restored and the counts accumulated since
+    *   the last save are added; otherwise the totals start from 0, with
+    *   the current register values as baseline.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_AccumulatorsStart(void);
+
+    /**
+    *   \brief Poll the accumulator registers.
+    *
+    *   This function must be called periodically, e.g. from the main loop.
+    *   It does nothing until the poll interval has expired (see
+    *   #DS2438_GetAccumulatorsPollInterval()), then it reads pages 1 and 7
+    *   and adds the counts since the last poll to the totals. Totals are
+    *   saved every #DS2438_ACCUMULATORS_SAVE_INTERVAL_MS.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_AccumulatorsPoll(void);
+
+    /**
+    *   \brief Save totals to EEPROM.
+    *
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if totals could not be saved.
+    */
+    uint8_t DS2438_AccumulatorsSave(void);
+
+    /**
+    *   \brief Get the extended accumulators.
+    *
+    *   \param totals pointer to variable where totals will be stored.
+    */
+    void DS2438_GetAccumulatorTotals(DS2438_AccumulatorTotals* totals);
+
+    /**
+    *   \brief Get the poll interval of the accumulators.
+    *
+    *   The poll interval is the longest interval in which no register can
+    *   change by more than half its range at the maximum count rate,
+    *   divided by two as safety margin.
+    *   \return the poll interval, in milliseconds.
+    */
+    uint32_t DS2438_GetAccumulatorsPollInterval(void);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,255 @@
+/********************************************
+*
+*   \brief Source code for the priority arbitration.
+*
+*   The operation of a pin is chosen again before every
+*   step, so the operations of a pin are interleaved.
+*   After each step, the other operations of the pin
+*   are told with DS2438_AsyncPreempt(), which repeats
+*   the previous step of an operation if its scratchpad
+*   was replaced: a preemption costs the preempted
+*   operation at most one transaction.
+*
+*   Every pending operation keeps the class of the last
+*   step run on its pin, so that an aged step is only run
+*   right after a step of the class it is run ahead of.
+*   An aged operation whose next step uses the scratchpad
+*   holds its pin for that step: otherwise the operation it
+*   was run ahead of would recall the same page again, and
+*   the two would repeat their recalls without end.
+*
+**********************************************/
+
+#include "DS2438_Arbiter.h"
+#include "Timebase.h"
+#include "project.h"
+
+void DS2438_ArbiterInit(DS2438_Arbiter* arbiter)
+{
+    arbiter->count = 0;
+    for (uint8_t p = 0; p < DS2438_ARBITER_PRIORITIES; p++)
+    {
+        DS2438_ArbiterStats* stats = &arbiter->stats[p];
+        stats->completed = 0;
+        stats->steps = 0;
+        stats->repeated = 0;
+        stats->aged = 0;
+        stats->max_wait_us = 0;
+        stats->max_latency_us = 0;
+        stats->max_step_us = 0;
+    }
+}
+
+uint8_t DS2438_ArbiterSubmit(DS2438_Arbiter* arbiter, DS2438_AsyncOp* op, uint8_t priority)
+{
+    if (priority >= DS2438_ARBITER_PRIORITIES)
+        return DS2438_BAD_PARAM;
+    if (arbiter->count >= DS2438_ARBITER_MAX_OPS)
+        return DS2438_ERROR;
+    op->busy = 1;
+    op->wake_us = Timebase_GetUs();
+    // Last step of the pin, if another operation is pending on it
+    uint8_t last_step = DS2438_ARBITER_AGED;
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (arbiter->ops[i]->pin == op->pin)
+            last_step = arbiter->last_steps[i];
+    }
+    arbiter->last_steps[arbiter->count] = last_step;
+    arbiter->priorities[arbiter->count] = priority;
+    arbiter->submit_us[arbiter->count] = op->wake_us;
+    arbiter->step_us[arbiter->count] = op->wake_us;
+    arbiter->ops[arbiter->count++] = op;
+    return DS2438_OK;
+}
+
+// Time from which the next step of an operation is ready
+static uint32_t DS2438_ArbiterReadyUs(const DS2438_Arbiter* arbiter, uint8_t index)
+{
+    uint32_t wake_us = arbiter->ops[index]->wake_us;
+    return ((int32_t)(wake_us - arbiter->step_us[index]) > 0) ? wake_us : arbiter->step_us[index];
+}
+
+// An operation waits for the copy of another operation of the same device
+static uint8_t DS2438_ArbiterIsBlocked(const DS2438_Arbiter* arbiter, uint8_t index)
+{
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (DS2438_AsyncWaitsFor(arbiter->ops[index], arbiter->ops[i]))
+            return 1;
+    }
+    return 0;
+}
+
+// Ready operation of a pin with the highest priority, the oldest one within a class,
+// or the one that has waited longest if it has aged and the last step allows it
+static int8_t DS2438_ArbiterSelect(const DS2438_Arbiter* arbiter, unsigned int pin, uint8_t* aged)
+{
+    int8_t selected = -1;
+    int8_t longest = -1;
+    uint32_t now_us = Timebase_GetUs();
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        DS2438_AsyncOp* op = arbiter->ops[i];
+        if ((op->pin != pin) || !Timebase_IsExpired(op->wake_us) || DS2438_ArbiterIsBlocked(arbiter, i))
+            continue;
+        if ((selected < 0) || (arbiter->priorities[i] < arbiter->priorities[selected]))
+            selected = i;
+        if ((longest < 0) ||
+            ((int32_t)(DS2438_ArbiterReadyUs(arbiter, i) - DS2438_ArbiterReadyUs(arbiter, longest)) < 0))
+            longest = i;
+    }
+    *aged = 0;
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if ((arbiter->ops[i]->pin == pin) && (arbiter->last_steps[i] == DS2438_ARBITER_HOLD) &&
+            Timebase_IsExpired(arbiter->ops[i]->wake_us) && !DS2438_ArbiterIsBlocked(arbiter, i))
+        {
+            *aged = 1;
+            return i;
+        }
+    }
+    if ((selected >= 0) && (arbiter->priorities[longest] > arbiter->priorities[selected]) &&
+        (now_us - DS2438_ArbiterReadyUs(arbiter, longest) >= DS2438_ARBITER_AGING_US) &&
+        (arbiter->last_steps[selected] <= arbiter->priorities[selected]))
+    {
+        *aged = 1;
+        return longest;
+    }
+    return selected;
+}
+
+// Run a step and tell the other operations of the pin
+static void DS2438_ArbiterStep(DS2438_Arbiter* arbiter, uint8_t index, uint8_t aged)
+{
+    DS2438_AsyncOp* op = arbiter->ops[index];
+    DS2438_ArbiterStats* stats = &arbiter->stats[arbiter->priorities[index]];
+    uint32_t start_us = Timebase_GetUs();
+    uint32_t wait_us = start_us - DS2438_ArbiterReadyUs(arbiter, index);
+
+    DS2438_AsyncStep(op);
+    arbiter->step_us[index] = Timebase_GetUs();
+    uint32_t step_us = arbiter->step_us[index] - start_us;
+    stats->steps++;
+    stats->aged += aged;
+    if (wait_us > stats->max_wait_us)
+        stats->max_wait_us = wait_us;
+    if (step_us > stats->max_step_us)
+        stats->max_step_us = step_us;
+
+    uint8_t last_step = aged ? DS2438_ARBITER_AGED : arbiter->priorities[index];
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (DS2438_AsyncPreempt(arbiter->ops[i], op))
+            arbiter->stats[arbiter->priorities[i]].repeated++;
+        if (arbiter->ops[i]->pin == op->pin)
+            arbiter->last_steps[i] = last_step;
+    }
+    if (aged && op->busy && DS2438_AsyncUsesScratchpad(op))
+        arbiter->last_steps[index] = DS2438_ARBITER_HOLD;
+}
+
+uint8_t DS2438_ArbiterRun(DS2438_Arbiter* arbiter)
+{
+    DS2438_AsyncOp* completed[DS2438_ARBITER_MAX_OPS];
+    uint8_t n_completed = 0;
+    uint8_t served[DS2438_ARBITER_MAX_OPS] = {0};
+
+    // One step per pin: the first operation of each pin stands for its pin
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (served[i])
+            continue;
+        unsigned int pin = arbiter->ops[i]->pin;
+        for (uint8_t j = i; j < arbiter->count; j++)
+        {
+            if (arbiter->ops[j]->pin == pin)
+                served[j] = 1;
+        }
+        uint8_t aged;
+        int8_t selected = DS2438_ArbiterSelect(arbiter, pin, &aged);
+        if (selected >= 0)
+            DS2438_ArbiterStep(arbiter, selected, aged);
+    }
+
+    // Remove completed operations before calling the completion
+    // functions, so that they can submit new operations
+    uint32_t now_us = Timebase_GetUs();
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (arbiter->ops[i]->busy)
+        {
+            arbiter->ops[kept] = arbiter->ops[i];
+            arbiter->priorities[kept] = arbiter->priorities[i];
+            arbiter->submit_us[kept] = arbiter->submit_us[i];
+            arbiter->step_us[kept] = arbiter->step_us[i];
+            arbiter->last_steps[kept] = arbiter->last_steps[i];
+            kept++;
+        }
+        else
+        {
+            DS2438_ArbiterStats* stats = &arbiter->stats[arbiter->priorities[i]];
+            uint32_t latency_us = now_us - arbiter->submit_us[i];
+            stats->completed++;
+            if (latency_us > stats->max_latency_us)
+                stats->max_latency_us = latency_us;
+            completed[n_completed++] = arbiter->ops[i];
+        }
+    }
+    arbiter->count = kept;
+    for (uint8_t i = 0; i < n_completed; i++)
+    {
+        if (completed[i]->callback != NULL)
+            completed[i]->callback(completed[i], completed[i]->context);
+    }
+    return arbiter->count;
+}
+
+uint8_t DS2438_ArbiterNextWake(const DS2438_Arbiter* arbiter, uint32_t* wake_us)
+{
+    uint8_t found = 0;
+    for (uint8_t i = 0; i < arbiter->count; i++)
+    {
+        if (DS2438_ArbiterIsBlocked(arbiter, i))
+            continue;
+        if ((found == 0) || ((int32_t)(arbiter->ops[i]->wake_us - *wake_us) < 0))
+        {
+            *wake_us = arbiter->ops[i]->wake_us;
+            found = 1;
+        }
+    }
+    return arbiter->count;
+}
+
+uint8_t DS2438_ArbiterGetStats(const DS2438_Arbiter* arbiter, uint8_t priority, DS2438_ArbiterStats* stats)
+{
+    if (priority >= DS2438_ARBITER_PRIORITIES)
+        return DS2438_BAD_PARAM;
+    *stats = arbiter->stats[priority];
+    return DS2438_OK;
+}
+
+uint32_t DS2438_ArbiterGetBound(unsigned int pin, uint8_t priority, uint8_t copy)
+{
+    if (priority >= DS2438_ARBITER_PRIORITIES - 1)
+        return 0;
+    uint32_t step_us = DS2438_AsyncGetMaxStepUs(pin);
+    // An aged step, then the step that uses its scratchpad
+    if (!copy)
+        return 2 * step_us;
+    // Write and copy command, copy, then a transaction started just before its end
+    return 2 * step_us + DS2438_ASYNC_POLL_US + DS2438_COPY_TIME_US + step_us;
+}
+
+uint32_t DS2438_ArbiterGetAgingBound(unsigned int pin, uint8_t copy)
+{
+    uint32_t step_us = DS2438_AsyncGetMaxStepUs(pin);
+    // Running step, then each older aged step and its scratchpad step, after two steps of the higher classes
+    uint32_t bound_us = DS2438_ARBITER_AGING_US + step_us + DS2438_ARBITER_MAX_OPS * 4 * step_us;
+    if (copy)
+        bound_us += DS2438_ASYNC_POLL_US + DS2438_COPY_TIME_US + step_us;
+    return bound_us;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,207 @@
+/**
+ * \file DS2438_Arbiter.h
+ * \brief Priority arbitration of the 1-Wire buses for the DS2438 Library.
+ *
+ * The executor of DS2438_Async.h runs the operations of a pin one after
+ * the other, so a diagnostic dump of all the pages (16 transactions, more
+ * than 100 ms) delays an urgent current read until it completes. The
+ * arbiter runs the same operations, but chooses the operation of each
+ * pin again before every step: the ready operation of the highest
+ * priority class, the oldest one within a class. As each step is a single
+ * reset-delimited transaction, a ready step of the urgent class waits for
+ * at most two transactions of a lower class, whatever else is queued.
+ *
+ * The exception is a page copied to memory by a lower class: the steps
+ * of the same device that read it, or write, wait for the end of the copy
+ * (see #DS2438_AsyncWaitsFor()).
+ *
+ * Higher classes are served first, so a class that keeps the bus busy
+ * would delay the lower ones without bound. A ready step that has waited
+ * #DS2438_ARBITER_AGING_US is therefore run ahead of the higher classes,
+ * but only after a step of the class it is run ahead of, and never after
+ * another aged step or a step of a lower class. If its next step reads or
+ * copies the scratchpad it filled, that step follows at once, as a step
+ * of another operation on the page would make it repeat the first one
+ * (see #DS2438_AsyncPreempt()). Under a load of the higher classes that
+ * leaves no idle time, each lower operation still runs about one step
+ * every #DS2438_ARBITER_AGING_US.
+ *
+ * The arbiter measures, for each class, the longest wait of a ready step
+ * and the longest transaction. #DS2438_ArbiterGetBound() gives the
+ * worst-case wait of a class caused by the lower classes, and
+ * #DS2438_ArbiterGetAgingBound() the worst-case wait of any step, both
+ * computed from the longest step possible with the timing of the pin,
+ * with or without a copy.
+ *
+ * The transactions of the blocking API are not arbitrated, and must not
+ * be issued on a pin while the arbiter has operations pending on it.
+*/
+#ifndef __DS2438_ARBITER_H__
+    #define __DS2438_ARBITER_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Async.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Maximum number of operations of an arbiter.
+    */
+    #define DS2438_ARBITER_MAX_OPS      8
+
+    /**
+    *   \brief Wait of a ready step after which it is run ahead of the higher classes, in us.
+    */
+    #define DS2438_ARBITER_AGING_US     100000
+
+    // ===========================================================
+    //                      PRIORITY CLASSES
+    // ===========================================================
+
+    #define DS2438_PRIORITY_URGENT      0   ///< Safety checks, e.g. overcurrent
+    #define DS2438_PRIORITY_NORMAL      1   ///< Periodic measurements
+    #define DS2438_PRIORITY_BACKGROUND  2   ///< Diagnostics and configuration
+    #define DS2438_ARBITER_PRIORITIES   3   ///< Number of priority classes
+    #define DS2438_ARBITER_AGED         DS2438_ARBITER_PRIORITIES   ///< Last step of a pin run ahead of the higher classes, or none
+    #define DS2438_ARBITER_HOLD         (DS2438_ARBITER_PRIORITIES + 1) ///< Aged operation whose next step uses the scratchpad
+
+    /**
+    *   \brief Statistics of a priority class.
+    *
+    *   Times are in us. The wait of a step is measured from the time it is
+    *   ready, the end of the previous step of its operation or its wake
+    *   time if later, to the time it starts, so it includes the interval
+    *   between two calls to #DS2438_ArbiterRun().
+    */
+    typedef struct {
+        uint32_t completed;         ///< Operations completed
+        uint32_t steps;             ///< Transactions run
+        uint32_t repeated;          ///< Transactions repeated after a preemption
+        uint32_t aged;              ///< Transactions run ahead of the higher classes
+        uint32_t max_wait_us;       ///< Longest wait of a ready step
+        uint32_t max_latency_us;    ///< Longest time from submission to completion
+        uint32_t max_step_us;       ///< Longest transaction
+    } DS2438_ArbiterStats;
+
+    /**
+    *   \brief Arbiter of asynchronous operations.
+    */
+    typedef struct {
+        DS2438_AsyncOp* ops[DS2438_ARBITER_MAX_OPS];    ///< Pending operations, in order of submission
+        uint8_t priorities[DS2438_ARBITER_MAX_OPS];     ///< Priority class of the pending operations
+        uint32_t submit_us[DS2438_ARBITER_MAX_OPS];     ///< Submission time of the pending operations
+        uint32_t step_us[DS2438_ARBITER_MAX_OPS];       ///< End of the last step of the pending operations, or submission time
+        uint8_t last_steps[DS2438_ARBITER_MAX_OPS];     ///< Class of the last step run on the pin of the pending operations, #DS2438_ARBITER_AGED or #DS2438_ARBITER_HOLD
+        uint8_t count;                                  ///< Number of pending operations
+        DS2438_ArbiterStats stats[DS2438_ARBITER_PRIORITIES];   ///< Statistics of each class
+    } DS2438_Arbiter;
+
+    // ===========================================================
+    //                      FUNCTIONS
+    // ===========================================================
+
+    /**
+    *   \brief Initialize an arbiter.
+    *
+    *   \param arbiter pointer to the arbiter.
+    */
+    void DS2438_ArbiterInit(DS2438_Arbiter* arbiter);
+
+    /**
+    *   \brief Submit an operation to an arbiter.
+    *
+    *   The operation must not be modified until it completes.
+    *   \param arbiter pointer to the arbiter.
+    *   \param op pointer to an operation prepared by one of the DS2438_Async* functions.
+    *   \param priority one of the DS2438_PRIORITY_* classes.
+    *   \retval #DS2438_OK if the operation was submitted.
+    *   \retval #DS2438_BAD_PARAM if the priority class is not valid.
+    *   \retval #DS2438_ERROR if the arbiter is full.
+    */
+    uint8_t DS2438_ArbiterSubmit(DS2438_Arbiter* arbiter, DS2438_AsyncOp* op, uint8_t priority);
+
+    /**
+    *   \brief Run one step on every pin with a ready operation.
+    *
+    *   The step run on a pin is the one of the ready operation of the
+    *   highest priority class, or of the ready operation that has waited
+    *   longest if it has waited #DS2438_ARBITER_AGING_US. Completed
+    *   operations are removed from the arbiter, and their completion
+    *   function is called.
+    *   \param arbiter pointer to the arbiter.
+    *   \return the number of pending operations.
+    */
+    uint8_t DS2438_ArbiterRun(DS2438_Arbiter* arbiter);
+
+    /**
+    *   \brief Get the earliest time at which an operation can be resumed.
+    *
+    *   \param arbiter pointer to the arbiter.
+    *   \param wake_us pointer to variable where the time will be stored.
+    *   \return the number of pending operations; wake_us is not set if 0.
+    */
+    uint8_t DS2438_ArbiterNextWake(const DS2438_Arbiter* arbiter, uint32_t* wake_us);
+
+    /**
+    *   \brief Get the statistics of a priority class.
+    *
+    *   \param arbiter pointer to the arbiter.
+    *   \param priority one of the DS2438_PRIORITY_* classes.
+    *   \param stats pointer to variable where the statistics will be stored.
+    *   \retval #DS2438_OK if the statistics were stored.
+    *   \retval #DS2438_BAD_PARAM if the priority class is not valid.
+    */
+    uint8_t DS2438_ArbiterGetStats(const DS2438_Arbiter* arbiter, uint8_t priority, DS2438_ArbiterStats* stats);
+
+    /**
+    *   \brief Get the worst-case wait of a class caused by the lower classes.
+    *
+    *   A ready step waits for at most two transactions of a lower class, an
+    *   aged step and the step that uses its scratchpad, each the longest
+    *   step of #DS2438_AsyncGetMaxStepUs(). If a lower class copies a page
+    *   the step must wait for, the wait can include a write, a copy command,
+    *   the longest copy time, #DS2438_ASYNC_POLL_US and a transaction started
+    *   before the end of the copy. With a single pending operation in the
+    *   class and none in the higher ones, the bound holds for each of its
+    *   steps, plus the interval between two calls to #DS2438_ArbiterRun().
+    *
+    *   The bound only covers the blocking by the lower classes: a step also
+    *   waits for the steps of the other operations of its class, and the
+    *   latency of an operation adds up the waits and transactions of all its
+    *   steps, with the ones repeated after a preemption, to the operations
+    *   of its class queued before it. With three devices, the urgent reads
+    *   of tools/arbiter_bench.c need more bus time than their period leaves:
+    *   their steps wait 18.8 ms at most, within the bound, but the reads
+    *   complete up to 110 ms after they are due, and half of them are
+    *   missed while the previous one is queued.
+    *   \param pin 1-Wire interface pin.
+    *   \param priority one of the DS2438_PRIORITY_* classes.
+    *   \param copy 1 if the lower classes can copy a page the class waits for, 0 otherwise.
+    *   \return the bound in us, 0 for the lowest class or an invalid one.
+    */
+    uint32_t DS2438_ArbiterGetBound(unsigned int pin, uint8_t priority, uint8_t copy);
+
+    /**
+    *   \brief Get the worst-case wait of a step of any class.
+    *
+    *   A ready step is run at most #DS2438_ARBITER_AGING_US after it is
+    *   ready, plus the aged steps of the older operations of the pin, each
+    *   with the step that uses its scratchpad and preceded by up to two
+    *   steps of the higher classes, and the step running when it became
+    *   ready. The copy wait is the one of #DS2438_ArbiterGetBound(). The
+    *   bound holds whatever the load of the higher classes, plus the
+    *   interval between two calls to #DS2438_ArbiterRun().
+    *   \param pin 1-Wire interface pin.
+    *   \param copy 1 if another operation can copy a page the step waits for, 0 otherwise.
+    *   \return the bound in us.
+    */
+    uint32_t DS2438_ArbiterGetAgingBound(unsigned int pin, uint8_t copy);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
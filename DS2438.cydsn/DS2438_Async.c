@@ -0,0 +1,465 @@
+/********************************************
+*
+*   \brief Source code for the non-blocking operations.
+*
+*   Every step is one complete 1-Wire transaction,
+*   started with a reset, so the bus is idle between
+*   steps. The only exception is the wait for a copy,
+*   which samples read slots within the copy command
+*   transaction: this is safe because an operation
+*   owns its pin until it completes.
+*
+*   When the arbiter runs another operation in between,
+*   the copy is waited for its longest duration, as the
+*   blocking API does after a reset. A step that reads
+*   the scratchpad filled by the previous one (read after
+*   recall, copy after write) is preceded by it again if
+*   the other operation filled the scratchpad of the same
+*   page of the same device.
+*
+*   Operations on the device of the blocking API, with
+*   SKIP ROM on DS2438_Pin_0, keep its state up to date:
+*   pages read fill the page cache, conversions
+*   invalidate page 0, and copies are written through
+*   the cache and tracked as the ones of
+*   DS2438_WritePageAsync(). A write waits for a copy of
+*   the blocking API before filling the scratchpad.
+*
+**********************************************/
+
+#include "DS2438_Async.h"
+#include "DS2438.h"
+#include "DS2438_Cache.h"
+#include "DS2438_Snapshot.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include "project.h"
+#include <string.h>
+
+// Steps of the operations
+#define STEP_CONVERT    0   // Start a conversion
+#define STEP_RECALL     1   // Recall a page to the scratchpad
+#define STEP_READ       2   // Read the scratchpad
+#define STEP_WRITE      3   // Write the scratchpad
+#define STEP_COPY       4   // Copy the scratchpad to memory
+#define STEP_WAIT_COPY  5   // Wait for the end of the copy
+#define STEP_WAIT_COPY_TIME 6   // Wait for the longest copy time, the copy transaction was closed
+
+// Status bits of page 0
+#define STATUS_TB       0x10
+#define STATUS_ADB      0x40
+
+static void DS2438_AsyncPrepare(DS2438_AsyncOp* op, unsigned int pin, uint8_t kind, uint8_t page_number,
+                                uint8_t step, DS2438_AsyncCallback callback, void* context)
+{
+    op->pin = pin;
+    op->rom = NULL;
+    op->kind = kind;
+    op->page_number = page_number;
+    op->step = step;
+    op->busy = 0;
+    op->error = DS2438_OK;
+    op->value = 0;
+    op->callback = callback;
+    op->context = context;
+}
+
+static void DS2438_AsyncComplete(DS2438_AsyncOp* op, uint8_t error)
+{
+    op->error = error;
+    op->busy = 0;
+}
+
+// Reset the bus and address the device, completing the operation if it is not present
+static uint8_t DS2438_AsyncSelect(DS2438_AsyncOp* op)
+{
+    if (OneWire_TouchReset(op->pin) != 0)
+    {
+        DS2438_AsyncComplete(op, DS2438_DEV_NOT_FOUND);
+        return DS2438_DEV_NOT_FOUND;
+    }
+    if (op->rom == NULL)
+    {
+        OneWire_WriteByte(op->pin, DS2438_SKIP_ROM);
+        return DS2438_OK;
+    }
+    OneWire_WriteByte(op->pin, DS2438_MATCH_ROM);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        OneWire_WriteByte(op->pin, op->rom[i]);
+    }
+    return DS2438_OK;
+}
+
+// Operation on the device of the blocking API
+static uint8_t DS2438_AsyncIsBlockingDevice(const DS2438_AsyncOp* op)
+{
+    return (op->pin == DS2438_Pin_0) && (op->rom == NULL);
+}
+
+// Operations addressing the same device
+static uint8_t DS2438_AsyncSameDevice(const DS2438_AsyncOp* op, const DS2438_AsyncOp* other)
+{
+    if (op->pin != other->pin)
+        return 0;
+    // SKIP ROM addresses all the devices of the pin
+    if ((op->rom == NULL) || (other->rom == NULL))
+        return 1;
+    return (memcmp(op->rom, other->rom, 8) == 0);
+}
+
+// Page 0 read after a conversion: complete or wait again if still busy
+static void DS2438_AsyncConversionRead(DS2438_AsyncOp* op)
+{
+    uint8_t busy_bit = (op->kind == DS2438_ASYNC_READ_VOLTAGE) ? STATUS_ADB : STATUS_TB;
+    if ((op->page_data[0] & busy_bit) != 0)
+    {
+        if (Timebase_IsExpired(op->deadline_us))
+        {
+            DS2438_AsyncComplete(op, DS2438_ERROR);
+        }
+        else
+        {
+            op->wake_us = Timebase_GetUs() + DS2438_ASYNC_POLL_US;
+            op->step = STEP_RECALL;
+        }
+        return;
+    }
+    if (op->kind == DS2438_ASYNC_READ_VOLTAGE)
+        op->value = (op->page_data[4] << 8) | op->page_data[3];
+    else
+        op->value = (op->page_data[2] << 8) | op->page_data[1];
+    DS2438_AsyncComplete(op, DS2438_OK);
+}
+
+// ===========================================================
+//                      STEPS
+// ===========================================================
+
+void DS2438_AsyncStep(DS2438_AsyncOp* op)
+{
+    switch (op->step)
+    {
+        case STEP_CONVERT:
+            if (DS2438_AsyncSelect(op) != DS2438_OK)
+                return;
+            OneWire_WriteByte(op->pin, (op->kind == DS2438_ASYNC_READ_VOLTAGE) ?
+                              DS2438_VOLTAGE_CONV : DS2438_TEMP_CONV);
+            if (DS2438_AsyncIsBlockingDevice(op))
+            {
+                DS2438_CacheInvalidate(DS2438_GetPageCache(), 0x00);
+            }
+            op->wake_us = Timebase_GetUs() + DS2438_CONVERSION_TIME_US;
+            op->deadline_us = op->wake_us + DS2438_CONVERSION_TIME_US;
+            op->step = STEP_RECALL;
+            break;
+
+        case STEP_RECALL:
+            if (DS2438_AsyncSelect(op) != DS2438_OK)
+                return;
+            OneWire_WriteByte(op->pin, DS2438_RECALL_MEMORY);
+            OneWire_WriteByte(op->pin, op->page_number);
+            op->step = STEP_READ;
+            break;
+
+        case STEP_READ:
+            if (DS2438_AsyncSelect(op) != DS2438_OK)
+                return;
+            OneWire_WriteByte(op->pin, DS2438_READ_SCRATCHPAD);
+            OneWire_WriteByte(op->pin, op->page_number);
+            for (uint8_t i = 0; i < 9; i++)
+            {
+                op->page_data[i] = OneWire_ReadByte(op->pin);
+            }
+            if (DS2438_CheckCrcValue(op->page_data, 8, op->page_data[8]) != DS2438_OK)
+            {
+                DS2438_AsyncComplete(op, DS2438_CRC_FAIL);
+                return;
+            }
+            if (DS2438_AsyncIsBlockingDevice(op))
+            {
+                DS2438_CacheFill(DS2438_GetPageCache(), op->page_number, op->page_data);
+                if (op->page_number == 0x00)
+                {
+                    DS2438_SnapshotPublish(op->page_data);
+                }
+            }
+            if (op->kind == DS2438_ASYNC_READ_PAGE)
+            {
+                DS2438_AsyncComplete(op, DS2438_OK);
+            }
+            else if (op->kind == DS2438_ASYNC_READ_PAGES)
+            {
+                memcpy(&op->pages[(op->page_number - op->first_page) * 9], op->page_data, 9);
+                if (op->page_number == op->last_page)
+                {
+                    DS2438_AsyncComplete(op, DS2438_OK);
+                }
+                else
+                {
+                    op->page_number++;
+                    op->step = STEP_RECALL;
+                }
+            }
+            else
+            {
+                DS2438_AsyncConversionRead(op);
+            }
+            break;
+
+        case STEP_WRITE:
+            if (DS2438_AsyncIsBlockingDevice(op))
+            {
+                // The device copies one page at a time
+                if (DS2438_TrackedCopyInProgress())
+                {
+                    op->wake_us = Timebase_GetUs() + DS2438_ASYNC_POLL_US;
+                    return;
+                }
+            }
+            if (DS2438_AsyncSelect(op) != DS2438_OK)
+                return;
+            OneWire_WriteByte(op->pin, DS2438_WRITE_SCRATCHPAD);
+            OneWire_WriteByte(op->pin, op->page_number);
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                OneWire_WriteByte(op->pin, op->page_data[i]);
+            }
+            op->step = STEP_COPY;
+            break;
+
+        case STEP_COPY:
+            if (DS2438_AsyncSelect(op) != DS2438_OK)
+                return;
+            OneWire_WriteByte(op->pin, DS2438_COPY_SCRATCHPAD);
+            OneWire_WriteByte(op->pin, op->page_number);
+            if (DS2438_AsyncIsBlockingDevice(op))
+            {
+                DS2438_RecordCopy(op->page_number, op->page_data, NULL);
+            }
+            // A read slot answered with 1 is only trusted after the shortest copy time
+            op->deadline_us = Timebase_GetUs() + DS2438_ASYNC_POLL_US + DS2438_COPY_TIME_US;
+            op->wake_us = Timebase_GetUs() + DS2438_COPY_MIN_TIME_US;
+            op->step = STEP_WAIT_COPY;
+            break;
+
+        case STEP_WAIT_COPY:
+            // The device answers read slots with 1 when the copy is done
+            if (OneWire_ReadBit(op->pin))
+                DS2438_AsyncComplete(op, DS2438_OK);
+            else if (Timebase_IsExpired(op->deadline_us))
+                DS2438_AsyncComplete(op, DS2438_ERROR);
+            else
+                op->wake_us = Timebase_GetUs() + DS2438_ASYNC_POLL_US;
+            break;
+
+        case STEP_WAIT_COPY_TIME:
+            DS2438_AsyncComplete(op, DS2438_OK);
+            break;
+
+        default:
+            DS2438_AsyncComplete(op, DS2438_ERROR);
+            break;
+    }
+}
+
+uint8_t DS2438_AsyncPreempt(DS2438_AsyncOp* op, const DS2438_AsyncOp* by)
+{
+    if ((by == op) || (by->pin != op->pin))
+        return 0;
+    // The reset of the other operation closed the copy transaction
+    if (op->step == STEP_WAIT_COPY)
+    {
+        op->step = STEP_WAIT_COPY_TIME;
+        op->wake_us = op->deadline_us;
+        return 0;
+    }
+    // The other operation filled the scratchpad of its page if its next step reads it
+    if (!by->busy || ((by->step != STEP_READ) && (by->step != STEP_COPY)) ||
+        (by->page_number != op->page_number) || !DS2438_AsyncSameDevice(op, by))
+        return 0;
+    if (op->step == STEP_READ)
+    {
+        op->step = STEP_RECALL;
+        return 1;
+    }
+    if (op->step == STEP_COPY)
+    {
+        op->step = STEP_WRITE;
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t DS2438_AsyncUsesScratchpad(const DS2438_AsyncOp* op)
+{
+    return (op->step == STEP_READ) || (op->step == STEP_COPY);
+}
+
+uint8_t DS2438_AsyncWaitsFor(const DS2438_AsyncOp* op, const DS2438_AsyncOp* other)
+{
+    if ((other == op) || ((other->step != STEP_WAIT_COPY) && (other->step != STEP_WAIT_COPY_TIME)) ||
+        !DS2438_AsyncSameDevice(op, other))
+        return 0;
+    // Copy over, other may still wait for a lower priority step to complete
+    if (Timebase_IsExpired(other->deadline_us))
+        return 0;
+    if (op->kind == DS2438_ASYNC_WRITE_PAGE)
+        return 1;
+    if (op->kind == DS2438_ASYNC_READ_PAGES)
+        return ((other->page_number >= op->page_number) && (other->page_number <= op->last_page));
+    return (other->page_number == op->page_number);
+}
+
+uint32_t DS2438_AsyncGetMaxStepUs(unsigned int pin)
+{
+    OneWire_Timing t;
+    OneWire_GetBusTiming(pin, &t);
+    uint32_t reset_us = t.g + t.h + t.i + t.j;
+    uint32_t write_bit_us = ((t.a + t.b) > (t.c + t.d)) ? (t.a + t.b) : (t.c + t.d);
+    uint32_t read_bit_us = t.a + t.e + t.f;
+    // Reset, MATCH ROM and ROM, command and page
+    uint32_t command_us = reset_us + 11 * 8 * write_bit_us;
+    // Scratchpad and CRC read
+    uint32_t read_us = command_us + 9 * 8 * read_bit_us;
+    // Copy of the blocking API polled, then scratchpad written
+    uint32_t write_us = read_bit_us + command_us + 8 * 8 * write_bit_us;
+    return (read_us > write_us) ? read_us : write_us;
+}
+
+// ===========================================================
+//                      OPERATIONS
+// ===========================================================
+
+uint8_t DS2438_AsyncReadPage(DS2438_AsyncOp* op, unsigned int pin, uint8_t page_number,
+                             DS2438_AsyncCallback callback, void* context)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    DS2438_AsyncPrepare(op, pin, DS2438_ASYNC_READ_PAGE, page_number, STEP_RECALL, callback, context);
+    return DS2438_OK;
+}
+
+uint8_t DS2438_AsyncReadPages(DS2438_AsyncOp* op, unsigned int pin, uint8_t first_page, uint8_t n_pages,
+                              uint8_t* pages, DS2438_AsyncCallback callback, void* context)
+{
+    if ((first_page > 0x07) || (n_pages == 0) || (n_pages > 8 - first_page))
+        return DS2438_BAD_PARAM;
+    DS2438_AsyncPrepare(op, pin, DS2438_ASYNC_READ_PAGES, first_page, STEP_RECALL, callback, context);
+    op->first_page = first_page;
+    op->last_page = first_page + n_pages - 1;
+    op->pages = pages;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_AsyncWritePage(DS2438_AsyncOp* op, unsigned int pin, uint8_t page_number,
+                              const uint8_t* page_data, DS2438_AsyncCallback callback, void* context)
+{
+    if (page_number > 0x07)
+        return DS2438_BAD_PARAM;
+    DS2438_AsyncPrepare(op, pin, DS2438_ASYNC_WRITE_PAGE, page_number, STEP_WRITE, callback, context);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        op->page_data[i] = page_data[i];
+    }
+    return DS2438_OK;
+}
+
+void DS2438_AsyncReadVoltage(DS2438_AsyncOp* op, unsigned int pin,
+                             DS2438_AsyncCallback callback, void* context)
+{
+    DS2438_AsyncPrepare(op, pin, DS2438_ASYNC_READ_VOLTAGE, 0x00, STEP_CONVERT, callback, context);
+}
+
+void DS2438_AsyncReadTemperature(DS2438_AsyncOp* op, unsigned int pin,
+                                 DS2438_AsyncCallback callback, void* context)
+{
+    DS2438_AsyncPrepare(op, pin, DS2438_ASYNC_READ_TEMPERATURE, 0x00, STEP_CONVERT, callback, context);
+}
+
+void DS2438_AsyncSetRom(DS2438_AsyncOp* op, const uint8_t* rom)
+{
+    op->rom = rom;
+}
+
+// ===========================================================
+//                      EXECUTOR
+// ===========================================================
+
+void DS2438_ExecutorInit(DS2438_Executor* executor)
+{
+    executor->count = 0;
+    executor->steps = 0;
+}
+
+uint8_t DS2438_ExecutorSubmit(DS2438_Executor* executor, DS2438_AsyncOp* op)
+{
+    if (executor->count >= DS2438_ASYNC_MAX_OPS)
+        return DS2438_ERROR;
+    op->busy = 1;
+    op->wake_us = Timebase_GetUs();
+    executor->ops[executor->count++] = op;
+    return DS2438_OK;
+}
+
+// An operation waits for the older operations on the same pin
+static uint8_t DS2438_ExecutorIsBlocked(const DS2438_Executor* executor, uint8_t index)
+{
+    for (uint8_t i = 0; i < index; i++)
+    {
+        if (executor->ops[i]->pin == executor->ops[index]->pin)
+            return 1;
+    }
+    return 0;
+}
+
+uint8_t DS2438_ExecutorRun(DS2438_Executor* executor)
+{
+    DS2438_AsyncOp* completed[DS2438_ASYNC_MAX_OPS];
+    uint8_t n_completed = 0;
+
+    for (uint8_t i = 0; i < executor->count; i++)
+    {
+        DS2438_AsyncOp* op = executor->ops[i];
+        if (DS2438_ExecutorIsBlocked(executor, i) || !Timebase_IsExpired(op->wake_us))
+            continue;
+        DS2438_AsyncStep(op);
+        executor->steps++;
+    }
+
+    // Remove completed operations before calling the completion
+    // functions, so that they can submit new operations
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < executor->count; i++)
+    {
+        if (executor->ops[i]->busy)
+            executor->ops[kept++] = executor->ops[i];
+        else
+            completed[n_completed++] = executor->ops[i];
+    }
+    executor->count = kept;
+    for (uint8_t i = 0; i < n_completed; i++)
+    {
+        if (completed[i]->callback != NULL)
+            completed[i]->callback(completed[i], completed[i]->context);
+    }
+    return executor->count;
+}
+
+uint8_t DS2438_ExecutorNextWake(const DS2438_Executor* executor, uint32_t* wake_us)
+{
+    uint8_t found = 0;
+    for (uint8_t i = 0; i < executor->count; i++)
+    {
+        if (DS2438_ExecutorIsBlocked(executor, i))
+            continue;
+        if ((found == 0) || ((int32_t)(executor->ops[i]->wake_us - *wake_us) < 0))
+        {
+            *wake_us = executor->ops[i]->wake_us;
+            found = 1;
+        }
+    }
+    return executor->count;
+}
+
+/* [] END OF FILE */
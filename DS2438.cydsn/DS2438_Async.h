@@ -0,0 +1,303 @@
+/**
+ * \file DS2438_Async.h
+ * \brief Non-blocking operations for the DS2438 Library.
+ *
+ * This module splits the multi-step DS2438 operations (conversion, wait
+ * and page read, or scratchpad write, copy and wait) into short steps,
+ * each of them a single 1-Wire transaction of at most a few ms. An
+ * operation is a resumable state machine: it is submitted to an executor,
+ * which runs one step of every ready operation each time it is called.
+ * Between steps, and while waiting for a conversion or a copy, the
+ * operation is suspended and the CPU is free for other work, including
+ * operations on devices connected to other pins.
+ *
+ * Each operation owns its pin from its first step to its completion, so
+ * operations submitted for the same pin are run one after the other. The
+ * arbiter of DS2438_Arbiter.h runs the steps of the operations of a pin
+ * in order of priority instead, see #DS2438_AsyncPreempt().
+ * Operations use the timing profile attached to their pin, see
+ * #OneWire_AttachProfile(), and always check the CRC of the pages read.
+ * They never serve pages from the page cache of the blocking API, but keep
+ * it up to date when they address its device (SKIP ROM on DS2438_Pin_0),
+ * and track their copies as #DS2438_WritePageAsync() does.
+ *
+ * Operations address the device with SKIP ROM, as the blocking API does,
+ * unless a ROM is set with #DS2438_AsyncSetRom(): the device is then
+ * selected with MATCH ROM, so several devices can share a pin.
+*/
+#ifndef __DS2438_ASYNC_H__
+    #define __DS2438_ASYNC_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Maximum number of operations of an executor.
+    */
+    #define DS2438_ASYNC_MAX_OPS        8
+
+    /**
+    *   \brief Interval between two checks of a conversion or a copy, in us.
+    */
+    #define DS2438_ASYNC_POLL_US        1000
+
+    // ===========================================================
+    //                      OPERATION KINDS
+    // ===========================================================
+
+    #define DS2438_ASYNC_READ_PAGE          0   ///< Recall and read a page
+    #define DS2438_ASYNC_WRITE_PAGE         1   ///< Write and copy a page
+    #define DS2438_ASYNC_READ_VOLTAGE       2   ///< Convert and read the voltage
+    #define DS2438_ASYNC_READ_TEMPERATURE   3   ///< Convert and read the temperature
+    #define DS2438_ASYNC_READ_PAGES         4   ///< Recall and read consecutive pages
+
+    typedef struct DS2438_AsyncOp DS2438_AsyncOp;
+
+    /**
+    *   \brief Function called by the executor when an operation completes.
+    */
+    typedef void (*DS2438_AsyncCallback)(DS2438_AsyncOp* op, void* context);
+
+    /**
+    *   \brief Asynchronous operation.
+    *
+    *   The fields are set by the DS2438_Async* functions and by the
+    *   executor; the caller only reads the results once busy is 0.
+    */
+    struct DS2438_AsyncOp {
+        unsigned int pin;               ///< Pin of the device
+        const uint8_t* rom;             ///< ROM of the device, or NULL to skip ROM
+        uint8_t kind;                   ///< Kind of operation
+        uint8_t page_number;            ///< Page read or written
+        uint8_t first_page;             ///< First page of a read of consecutive pages
+        uint8_t last_page;              ///< Last page of a read of consecutive pages
+        uint8_t* pages;                 ///< Pages read, with CRC, 9 bytes each
+        uint8_t step;                   ///< Next step to be run
+        volatile uint8_t busy;          ///< 1 until the operation completes
+        uint8_t error;                  ///< Result, valid when busy is 0
+        uint16_t value;                 ///< Raw voltage or temperature
+        uint8_t page_data[9];           ///< Page read, with CRC, or page to be written
+        uint32_t wake_us;               ///< Time at which the operation can be resumed
+        uint32_t deadline_us;           ///< End of the current wait
+        DS2438_AsyncCallback callback;  ///< Completion function, may be NULL
+        void* context;                  ///< Argument of the completion function
+    };
+
+    /**
+    *   \brief Executor of asynchronous operations.
+    */
+    typedef struct {
+        DS2438_AsyncOp* ops[DS2438_ASYNC_MAX_OPS];  ///< Pending operations, in order of submission
+        uint8_t count;                              ///< Number of pending operations
+        uint32_t steps;                             ///< Steps run since initialization
+    } DS2438_Executor;
+
+    // ===========================================================
+    //                      OPERATIONS
+    // ===========================================================
+
+    /**
+    *   \brief Prepare the read of a page.
+    *
+    *   On completion, page_data holds the 8 bytes of the page and the CRC.
+    *   \param op pointer to the operation.
+    *   \param pin pin of the device.
+    *   \param page_number the page to read, from 0 to 7.
+    *   \param callback completion function, may be NULL.
+    *   \param context argument of the completion function.
+    *   \retval #DS2438_OK if the operation is ready to be submitted.
+    *   \retval #DS2438_BAD_PARAM if the page number is not valid.
+    */
+    uint8_t DS2438_AsyncReadPage(DS2438_AsyncOp* op, unsigned int pin, uint8_t page_number,
+                                 DS2438_AsyncCallback callback, void* context);
+
+    /**
+    *   \brief Prepare the read of consecutive pages.
+    *
+    *   Each page is recalled and read with two transactions, so the
+    *   operation can be preempted between pages. On completion, pages
+    *   holds the 8 bytes and the CRC of each page; on error, the pages
+    *   before page_number are valid.
+    *   \param op pointer to the operation.
+    *   \param pin pin of the device.
+    *   \param first_page the first page to read, from 0 to 7.
+    *   \param n_pages the number of pages to read.
+    *   \param pages array of 9 * n_pages bytes where the pages will be stored.
+    *   \param callback completion function, may be NULL.
+    *   \param context argument of the completion function.
+    *   \retval #DS2438_OK if the operation is ready to be submitted.
+    *   \retval #DS2438_BAD_PARAM if the pages are not valid.
+    */
+    uint8_t DS2438_AsyncReadPages(DS2438_AsyncOp* op, unsigned int pin, uint8_t first_page, uint8_t n_pages,
+                                  uint8_t* pages, DS2438_AsyncCallback callback, void* context);
+
+    /**
+    *   \brief Prepare the write of a page.
+    *
+    *   The operation completes when the copy to memory is done, which
+    *   is checked every #DS2438_ASYNC_POLL_US from #DS2438_COPY_MIN_TIME_US
+    *   after the copy command.
+    *   \param op pointer to the operation.
+    *   \param pin pin of the device.
+    *   \param page_number the page to write, from 0 to 7.
+    *   \param page_data the 8 bytes to be written, copied into the operation.
+    *   \param callback completion function, may be NULL.
+    *   \param context argument of the completion function.
+    *   \retval #DS2438_OK if the operation is ready to be submitted.
+    *   \retval #DS2438_BAD_PARAM if the page number is not valid.
+    */
+    uint8_t DS2438_AsyncWritePage(DS2438_AsyncOp* op, unsigned int pin, uint8_t page_number,
+                                  const uint8_t* page_data, DS2438_AsyncCallback callback, void* context);
+
+    /**
+    *   \brief Prepare a voltage conversion and read.
+    *
+    *   On completion, value holds the raw voltage of the input selected
+    *   by the AD bit, and page_data holds page 0.
+    *   \param op pointer to the operation.
+    *   \param pin pin of the device.
+    *   \param callback completion function, may be NULL.
+    *   \param context argument of the completion function.
+    */
+    void DS2438_AsyncReadVoltage(DS2438_AsyncOp* op, unsigned int pin,
+                                 DS2438_AsyncCallback callback, void* context);
+
+    /**
+    *   \brief Prepare a temperature conversion and read.
+    *
+    *   On completion, value holds the raw temperature, and page_data
+    *   holds page 0.
+    *   \param op pointer to the operation.
+    *   \param pin pin of the device.
+    *   \param callback completion function, may be NULL.
+    *   \param context argument of the completion function.
+    */
+    void DS2438_AsyncReadTemperature(DS2438_AsyncOp* op, unsigned int pin,
+                                     DS2438_AsyncCallback callback, void* context);
+
+    /**
+    *   \brief Address the device of an operation by its ROM.
+    *
+    *   Must be called after the operation is prepared, and before it is
+    *   submitted. Pages 0 read from an addressed device are not published
+    *   to the snapshot of the blocking API.
+    *   \param op pointer to an operation prepared by one of the DS2438_Async* functions.
+    *   \param rom the 8 bytes of the ROM, which must remain valid until the
+    *       operation completes, or NULL to skip ROM.
+    */
+    void DS2438_AsyncSetRom(DS2438_AsyncOp* op, const uint8_t* rom);
+
+    // ===========================================================
+    //                      STEPS
+    // ===========================================================
+
+    /**
+    *   \brief Run the next step of an operation.
+    *
+    *   The step is a single 1-Wire transaction. busy is set to 0 when the
+    *   operation completes; the completion function is not called.
+    *   \param op pointer to a submitted operation, whose wake_us has expired.
+    */
+    void DS2438_AsyncStep(DS2438_AsyncOp* op);
+
+    /**
+    *   \brief Tell an operation that another one ran a step on its pin.
+    *
+    *   The transaction of the other operation may have replaced the
+    *   scratchpad of the page read by the next step, or closed the transaction in
+    *   which a copy is followed: the previous step is then repeated, and
+    *   the end of a copy is waited for its longest duration.
+    *   \param op pointer to a submitted operation.
+    *   \param by pointer to the operation that ran a step.
+    *   \return 1 if a step of op must be repeated, 0 otherwise.
+    */
+    uint8_t DS2438_AsyncPreempt(DS2438_AsyncOp* op, const DS2438_AsyncOp* by);
+
+    /**
+    *   \brief Check if the next step of an operation uses the scratchpad filled by its previous step.
+    *
+    *   The next step reads the scratchpad recalled, or copies the one
+    *   written: a step of another operation on the page in between makes
+    *   it repeat the previous step, see #DS2438_AsyncPreempt().
+    *   \param op pointer to a submitted operation.
+    *   \return 1 if the next step uses the scratchpad, 0 otherwise.
+    */
+    uint8_t DS2438_AsyncUsesScratchpad(const DS2438_AsyncOp* op);
+
+    /**
+    *   \brief Check if an operation must wait for the copy of another one.
+    *
+    *   As with the blocking API, a page is not read while it is copied to
+    *   memory, and a device copies one page at a time. The copy is over
+    *   once its longest duration elapsed, even if other has not completed
+    *   yet, so op waits at most #DS2438_ASYNC_POLL_US plus
+    *   #DS2438_COPY_TIME_US from the end of the copy command.
+    *   \param op pointer to a submitted operation.
+    *   \param other pointer to another submitted operation.
+    *   \return 1 if op must not run a step before other completes.
+    */
+    uint8_t DS2438_AsyncWaitsFor(const DS2438_AsyncOp* op, const DS2438_AsyncOp* other);
+
+    /**
+    *   \brief Get the longest transaction of a step on a pin.
+    *
+    *   Computed from the timing of the pin, see #OneWire_GetBusTiming(), for
+    *   the longest steps, the read of a scratchpad and the write of a page,
+    *   with the device addressed by MATCH ROM.
+    *   \param pin 1-Wire interface pin.
+    *   \return the duration in us.
+    */
+    uint32_t DS2438_AsyncGetMaxStepUs(unsigned int pin);
+
+    // ===========================================================
+    //                      EXECUTOR
+    // ===========================================================
+
+    /**
+    *   \brief Initialize an executor.
+    *
+    *   \param executor pointer to the executor.
+    */
+    void DS2438_ExecutorInit(DS2438_Executor* executor);
+
+    /**
+    *   \brief Submit an operation to an executor.
+    *
+    *   The operation must not be modified until it completes.
+    *   \param executor pointer to the executor.
+    *   \param op pointer to an operation prepared by one of the DS2438_Async* functions.
+    *   \retval #DS2438_OK if the operation was submitted.
+    *   \retval #DS2438_ERROR if the executor is full.
+    */
+    uint8_t DS2438_ExecutorSubmit(DS2438_Executor* executor, DS2438_AsyncOp* op);
+
+    /**
+    *   \brief Run one step of every ready operation.
+    *
+    *   Completed operations are removed from the executor, and their
+    *   completion function is called.
+    *   \param executor pointer to the executor.
+    *   \return the number of pending operations.
+    */
+    uint8_t DS2438_ExecutorRun(DS2438_Executor* executor);
+
+    /**
+    *   \brief Get the earliest time at which an operation can be resumed.
+    *
+    *   The caller can do other work, or sleep, until then.
+    *   \param executor pointer to the executor.
+    *   \param wake_us pointer to variable where the time will be stored.
+    *   \return the number of pending operations; wake_us is not set if 0.
+    */
+    uint8_t DS2438_ExecutorNextWake(const DS2438_Executor* executor, uint32_t* wake_us);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,170 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 warm boot.
+*
+*   The boot record holds the ROM of the device,
+*   the configuration bits of page 0, the timing
+*   profile attached to the bus and its delays.
+*
+**********************************************/
+
+#include "DS2438_Boot.h"
+#include "DS2438.h"
+#include "DS2438_Storage.h"
+#include "OneWire.h"
+#include "project.h"
+
+// Identifies a valid record in EEPROM
+#define RECORD_MAGIC 0xB007
+
+// Size of the serialized record, including CRC
+#define RECORD_SIZE 33
+
+// Read the ROM and check its CRC, whatever the CRC setting of the library
+static uint8_t DS2438_ReadCheckedRom(uint8_t* rom)
+{
+    uint8_t error = DS2438_ReadRawRom(rom);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(rom, 7, rom[7]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+// Read page 0 from the device and check its CRC
+static uint8_t DS2438_ReadCheckedConfig(uint8_t* page_data)
+{
+    uint8_t error = DS2438_ReadPageWithMaxAge(0x00, 0, page_data);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+static void DS2438_PutTiming(uint8_t* data, const OneWire_Timing* timing)
+{
+    const uint16_t delays[10] = {timing->a, timing->b, timing->c, timing->d, timing->e,
+                                 timing->f, timing->g, timing->h, timing->i, timing->j};
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        data[2 * i] = delays[i] & 0xFF;
+        data[2 * i + 1] = delays[i] >> 8;
+    }
+}
+
+static void DS2438_GetTiming(const uint8_t* data, OneWire_Timing* timing)
+{
+    uint16_t delays[10];
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        delays[i] = (data[2 * i + 1] << 8) | data[2 * i];
+    }
+    timing->a = delays[0];
+    timing->b = delays[1];
+    timing->c = delays[2];
+    timing->d = delays[3];
+    timing->e = delays[4];
+    timing->f = delays[5];
+    timing->g = delays[6];
+    timing->h = delays[7];
+    timing->i = delays[8];
+    timing->j = delays[9];
+}
+
+uint8_t DS2438_WarmBoot(uint8_t config, uint8_t* warm)
+{
+    uint8_t record[RECORD_SIZE];
+    uint8_t rom[8];
+    uint8_t page_data[9];
+
+    *warm = 0;
+    if ((DS2438_StorageStart() != DS2438_OK) ||
+        (DS2438_StorageRead(DS2438_STORAGE_BOOT_OFFSET, record, RECORD_SIZE) != DS2438_OK) ||
+        (((record[1] << 8) | record[0]) != RECORD_MAGIC) ||
+        (DS2438_CheckCrcValue(record, RECORD_SIZE - 1, record[RECORD_SIZE - 1]) != DS2438_OK) ||
+        (record[11] >= ONEWIRE_N_PROFILES))
+    {
+        // No saved configuration, check the device with standard timing
+        OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_STANDARD);
+        return DS2438_IsDevicePresent();
+    }
+
+    // Restore the saved timing
+    if (record[11] == ONEWIRE_PROFILE_CUSTOM)
+    {
+        OneWire_Timing timing;
+        DS2438_GetTiming(&record[12], &timing);
+        OneWire_SetCustomTiming(&timing);
+    }
+    OneWire_AttachProfile(DS2438_Pin_0, record[11]);
+
+    uint8_t error = DS2438_ReadCheckedRom(rom);
+    if (error == DS2438_OK)
+        error = DS2438_ReadCheckedConfig(page_data);
+    if (error != DS2438_OK)
+    {
+        // Saved timing may not suit the bus anymore
+        OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_STANDARD);
+        return error;
+    }
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (rom[i] != record[2 + i])
+        {
+            // Different device, saved timing was calibrated on another one
+            OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_STANDARD);
+            return DS2438_OK;
+        }
+    }
+    if (((page_data[0] & DS2438_CONFIG_MASK) == (config & DS2438_CONFIG_MASK)) &&
+        (record[10] == (config & DS2438_CONFIG_MASK)))
+    {
+        *warm = 1;
+    }
+    return DS2438_OK;
+}
+
+uint8_t DS2438_ColdBoot(uint8_t config, uint8_t profile)
+{
+    uint8_t record[RECORD_SIZE];
+    uint8_t page_data[9];
+    OneWire_Timing timing;
+
+    if (profile >= ONEWIRE_N_PROFILES)
+        return DS2438_BAD_PARAM;
+
+    // Write all the configuration bits with a single copy
+    uint8_t error = DS2438_ReadCheckedConfig(page_data);
+    if (error != DS2438_OK)
+        return error;
+    if ((page_data[0] & DS2438_CONFIG_MASK) != (config & DS2438_CONFIG_MASK))
+    {
+        DS2438_CopyToken token;
+        page_data[0] = (page_data[0] & ~DS2438_CONFIG_MASK) | (config & DS2438_CONFIG_MASK);
+        error = DS2438_WritePageAsync(0x00, page_data, &token);
+        if (error == DS2438_OK)
+            error = DS2438_WaitCopy(&token);
+        if (error != DS2438_OK)
+            return error;
+    }
+
+    record[0] = RECORD_MAGIC & 0xFF;
+    record[1] = RECORD_MAGIC >> 8;
+    error = DS2438_ReadCheckedRom(&record[2]);
+    if (error != DS2438_OK)
+        return error;
+    record[10] = config & DS2438_CONFIG_MASK;
+    record[11] = profile;
+    OneWire_GetProfileTiming(profile, &timing);
+    DS2438_PutTiming(&record[12], &timing);
+    record[RECORD_SIZE - 1] = DS2438_ComputeCrc(record, RECORD_SIZE - 1);
+
+    if ((DS2438_StorageStart() != DS2438_OK) ||
+        (DS2438_StorageWrite(DS2438_STORAGE_BOOT_OFFSET, record, RECORD_SIZE) != DS2438_OK))
+        return DS2438_ERROR;
+    return DS2438_OK;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+/**
+ * \file DS2438_Boot.h
+ * \brief Warm boot support for the DS2438 Library.
+ *
+ * Configuring the DS2438 at every boot requires a read and a
+ * copy to EEPROM of page 0 for each configuration bit. This module
+ * saves the ROM ID of the device, its configuration and the timing
+ * profile of the bus in the emulated EEPROM. At the next boot, the
+ * saved data are verified with one ROM read and one page 0 read, and
+ * the configuration and timing calibration are skipped if they match.
+*/
+#ifndef __DS2438_BOOT_H__
+    #define __DS2438_BOOT_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Verify the saved boot configuration.
+    *
+    *   This function restores the saved timing profile of the bus, then
+    *   reads the ROM and page 0 of the device. The boot is warm if the ROM
+    *   matches the saved one and the configuration bits of page 0 match
+    *   both the saved and the requested configuration. Otherwise the
+    *   standard timing profile is attached to the bus, and the caller
+    *   should calibrate the bus and call #DS2438_ColdBoot().
+    *   \param config the requested configuration, as a combination of
+    *       #DS2438_CONFIG_IAD, #DS2438_CONFIG_CA, #DS2438_CONFIG_EE, #DS2438_CONFIG_AD.
+    *   \param warm pointer to variable set to 1 if the boot is warm, 0 otherwise.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_WarmBoot(uint8_t config, uint8_t* warm);
+
+    /**
+    *   \brief Configure the device and save the boot configuration.
+    *
+    *   This function writes the configuration bits of page 0 with a
+    *   single copy to EEPROM, if they differ from the requested ones,
+    *   and saves the ROM of the device, the configuration and the timing
+    *   of the given profile.
+    *   \param config the requested configuration, as a combination of
+    *       #DS2438_CONFIG_IAD, #DS2438_CONFIG_CA, #DS2438_CONFIG_EE, #DS2438_CONFIG_AD.
+    *   \param profile the timing profile attached to the bus.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    *   \retval #DS2438_ERROR if the boot configuration could not be saved.
+    */
+    uint8_t DS2438_ColdBoot(uint8_t config, uint8_t profile);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
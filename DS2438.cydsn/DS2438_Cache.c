@@ -0,0 +1,157 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 page cache.
+*
+*   The volatility of each byte of the memory
+*   map is described by two tables: the bits that
+*   are only changed by writes of the library, and
+*   the volatility classes present in each page.
+*
+**********************************************/
+
+#include "DS2438_Cache.h"
+#include "DS2438.h"
+#include "Timebase.h"
+
+#define CLASS_BIT(c) (0x01 << (c))
+
+// Bits of each byte that are only changed by writes of the library
+static const uint8_t static_bits[8][8] = {
+    // Page 0: config bits of status register and threshold
+    {0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF},
+    // Page 1: ETM and ICA are volatile, offset is static
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF},
+    // Page 2: disconnect and end of charge timestamps
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    // Pages 3-6: user EEPROM
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    // Page 7: user EEPROM followed by CCA and DCA
+    {0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00}
+};
+
+// Volatility classes present in each page
+static const uint8_t page_classes[8] = {
+    CLASS_BIT(DS2438_CACHE_MEASUREMENT),
+    CLASS_BIT(DS2438_CACHE_ACCUMULATOR),
+    CLASS_BIT(DS2438_CACHE_TIMESTAMP),
+    0,
+    0,
+    0,
+    0,
+    CLASS_BIT(DS2438_CACHE_ACCUMULATOR)
+};
+
+void DS2438_CacheInit(DS2438_PageCache* cache)
+{
+    cache->valid = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->max_age_ms[DS2438_CACHE_STATIC] = 0;
+    cache->max_age_ms[DS2438_CACHE_MEASUREMENT] = DS2438_CACHE_MEASUREMENT_MAX_AGE_MS;
+    cache->max_age_ms[DS2438_CACHE_ACCUMULATOR] = DS2438_CACHE_ACCUMULATOR_MAX_AGE_MS;
+    cache->max_age_ms[DS2438_CACHE_TIMESTAMP] = DS2438_CACHE_TIMESTAMP_MAX_AGE_MS;
+}
+
+// Copy a page to the caller if all its volatile classes are fresh enough.
+// If max_age_ms is NULL, the maximum age of each class is used.
+static uint8_t DS2438_CacheLookupPage(DS2438_PageCache* cache, uint8_t page_number,
+                                      const uint32_t* max_age_ms, uint8_t* page_data)
+{
+    if ((cache->valid & (0x01 << page_number)) != 0)
+    {
+        // Check age of each volatile class present in the page
+        uint8_t fresh = 1;
+        uint32_t age_ms = Timebase_GetMs() - cache->timestamp_ms[page_number];
+        for (uint8_t c = DS2438_CACHE_MEASUREMENT; c < DS2438_CACHE_N_CLASSES; c++)
+        {
+            uint32_t class_max_age_ms = (max_age_ms != NULL) ? *max_age_ms : cache->max_age_ms[c];
+            if ((page_classes[page_number] & CLASS_BIT(c)) && (age_ms >= class_max_age_ms))
+            {
+                fresh = 0;
+            }
+        }
+        if (fresh == 1)
+        {
+            for (uint8_t i = 0; i < 9; i++)
+            {
+                page_data[i] = cache->data[page_number][i];
+            }
+            cache->hits++;
+            return DS2438_OK;
+        }
+    }
+    cache->misses++;
+    return DS2438_ERROR;
+}
+
+uint8_t DS2438_CacheLookup(DS2438_PageCache* cache, uint8_t page_number, uint8_t* page_data)
+{
+    return DS2438_CacheLookupPage(cache, page_number, NULL, page_data);
+}
+
+uint8_t DS2438_CacheLookupWithMaxAge(DS2438_PageCache* cache, uint8_t page_number,
+                                     uint32_t max_age_ms, uint8_t* page_data)
+{
+    return DS2438_CacheLookupPage(cache, page_number, &max_age_ms, page_data);
+}
+
+void DS2438_CacheFill(DS2438_PageCache* cache, uint8_t page_number, const uint8_t* page_data)
+{
+    if (DS2438_ComputeCrc(page_data, 8) != page_data[8])
+        return;
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        cache->data[page_number][i] = page_data[i];
+    }
+    cache->timestamp_ms[page_number] = Timebase_GetMs();
+    cache->valid |= (0x01 << page_number);
+}
+
+void DS2438_CacheWriteThrough(DS2438_PageCache* cache, uint8_t page_number, const uint8_t* page_data)
+{
+    if ((cache->valid & (0x01 << page_number)) == 0)
+    {
+        // Volatile bytes are unknown until the page is read
+        if (page_classes[page_number] != 0)
+            return;
+        cache->timestamp_ms[page_number] = Timebase_GetMs();
+        cache->valid |= (0x01 << page_number);
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t mask = static_bits[page_number][i];
+        cache->data[page_number][i] = (cache->data[page_number][i] & ~mask) | (page_data[i] & mask);
+    }
+    cache->data[page_number][8] = DS2438_ComputeCrc(cache->data[page_number], 8);
+}
+
+void DS2438_CacheInvalidate(DS2438_PageCache* cache, uint8_t page_number)
+{
+    if (page_number == DS2438_CACHE_ALL_PAGES)
+    {
+        cache->valid = 0;
+    }
+    else
+    {
+        cache->valid &= ~(0x01 << page_number);
+    }
+}
+
+uint8_t DS2438_CacheSetMaxAge(DS2438_PageCache* cache, uint8_t volatility_class, uint32_t max_age_ms)
+{
+    if ((volatility_class == DS2438_CACHE_STATIC) || (volatility_class >= DS2438_CACHE_N_CLASSES))
+        return DS2438_BAD_PARAM;
+    cache->max_age_ms[volatility_class] = max_age_ms;
+    return DS2438_OK;
+}
+
+void DS2438_CacheGetStats(DS2438_PageCache* cache, uint32_t* hits, uint32_t* misses)
+{
+    *hits = cache->hits;
+    *misses = cache->misses;
+}
+
+/* [] END OF FILE */
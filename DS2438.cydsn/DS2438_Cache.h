@@ -0,0 +1,188 @@
+/**
+ * \file DS2438_Cache.h
+ * \brief Page cache for the DS2438 Library.
+ *
+ * The cache keeps a copy of the 8 pages of a DS2438 in RAM.
+ * Each byte of the memory map belongs to a volatility class:
+ * static bytes (configuration, threshold, offset, user EEPROM)
+ * only change when they are written by the library and are
+ * served from RAM, while volatile bytes (measurements, accumulators
+ * and timestamps updated by the device) are served from RAM only
+ * if they are younger than the maximum age of their class.
+ * Writes are applied to the cache (write-through) so that it is
+ * kept coherent with the device.
+*/
+#ifndef __DS2438_CACHE_H__
+    #define __DS2438_CACHE_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    // ===========================================================
+    //                   VOLATILITY CLASSES
+    // ===========================================================
+
+    /**
+    *   \brief Bytes that only change when written by the library.
+    */
+    #define DS2438_CACHE_STATIC         0
+
+    /**
+    *   \brief Status flags, temperature, voltage and current (page 0).
+    */
+    #define DS2438_CACHE_MEASUREMENT    1
+
+    /**
+    *   \brief Elapsed time meter and current accumulators (pages 1 and 7).
+    */
+    #define DS2438_CACHE_ACCUMULATOR    2
+
+    /**
+    *   \brief Disconnect and end of charge timestamps (page 2).
+    */
+    #define DS2438_CACHE_TIMESTAMP      3
+
+    /**
+    *   \brief Number of volatility classes.
+    */
+    #define DS2438_CACHE_N_CLASSES      4
+
+    /**
+    *   \brief Default maximum age of measurements, in milliseconds.
+    *
+    *   A maximum age of 0 means that the data are always read from the device.
+    */
+    #define DS2438_CACHE_MEASUREMENT_MAX_AGE_MS     0
+
+    /**
+    *   \brief Default maximum age of accumulators, in milliseconds.
+    */
+    #define DS2438_CACHE_ACCUMULATOR_MAX_AGE_MS     1000
+
+    /**
+    *   \brief Default maximum age of timestamps, in milliseconds.
+    */
+    #define DS2438_CACHE_TIMESTAMP_MAX_AGE_MS       1000
+
+    /**
+    *   \brief Invalidate all the pages of the cache.
+    */
+    #define DS2438_CACHE_ALL_PAGES      0xFF
+
+    // ===========================================================
+    //                          TYPES
+    // ===========================================================
+
+    /**
+    *   \brief Page cache of a single DS2438 device.
+    */
+    typedef struct {
+        uint8_t data[8][9];                             ///< Page data, including CRC
+        uint32_t timestamp_ms[8];                       ///< Time at which each page was read from the device
+        uint8_t valid;                                  ///< Bitmask of valid pages
+        uint32_t max_age_ms[DS2438_CACHE_N_CLASSES];    ///< Maximum age of each volatility class
+        uint32_t hits;                                  ///< Number of reads served from RAM
+        uint32_t misses;                                ///< Number of reads served by the device
+    } DS2438_PageCache;
+
+    // ===========================================================
+    //                      CACHE FUNCTIONS
+    // ===========================================================
+
+    /**
+    *   \brief Initialize a page cache.
+    *
+    *   This function invalidates all the pages, resets the
+    *   counters and sets the default maximum ages.
+    *   \param cache pointer to the cache.
+    */
+    void DS2438_CacheInit(DS2438_PageCache* cache);
+
+    /**
+    *   \brief Look up a page in the cache.
+    *
+    *   \param cache pointer to the cache.
+    *   \param page_number the page to be looked up.
+    *   \param page_data pointer to array where the 9 bytes of the page will be stored.
+    *   \retval #DS2438_OK if the page was served from the cache.
+    *   \retval #DS2438_ERROR if the page must be read from the device.
+    */
+    uint8_t DS2438_CacheLookup(DS2438_PageCache* cache, uint8_t page_number, uint8_t* page_data);
+
+    /**
+    *   \brief Look up a page in the cache with a caller-defined maximum age.
+    *
+    *   This function behaves like #DS2438_CacheLookup(), but the volatile
+    *   bytes of the page are considered valid if they are younger than
+    *   the maximum age passed in as parameter, regardless of their class.
+    *   \param cache pointer to the cache.
+    *   \param page_number the page to be looked up.
+    *   \param max_age_ms maximum age of the volatile bytes, in milliseconds.
+    *   \param page_data pointer to array where the 9 bytes of the page will be stored.
+    *   \retval #DS2438_OK if the page was served from the cache.
+    *   \retval #DS2438_ERROR if the page must be read from the device.
+    */
+    uint8_t DS2438_CacheLookupWithMaxAge(DS2438_PageCache* cache, uint8_t page_number,
+                                         uint32_t max_age_ms, uint8_t* page_data);
+
+    /**
+    *   \brief Store a page read from the device.
+    *
+    *   The page is stored only if its CRC is valid.
+    *   \param cache pointer to the cache.
+    *   \param page_number the page that was read.
+    *   \param page_data the 9 bytes read from the device.
+    */
+    void DS2438_CacheFill(DS2438_PageCache* cache, uint8_t page_number, const uint8_t* page_data);
+
+    /**
+    *   \brief Apply a page write to the cache.
+    *
+    *   Only the bits that are not updated by the device are
+    *   written to the cache. A page without volatile bytes becomes
+    *   valid even if it was not cached before.
+    *   \param cache pointer to the cache.
+    *   \param page_number the page that was written.
+    *   \param page_data the 8 bytes written to the device.
+    */
+    void DS2438_CacheWriteThrough(DS2438_PageCache* cache, uint8_t page_number, const uint8_t* page_data);
+
+    /**
+    *   \brief Invalidate a page of the cache.
+    *
+    *   \param cache pointer to the cache.
+    *   \param page_number the page to be invalidated, or #DS2438_CACHE_ALL_PAGES.
+    */
+    void DS2438_CacheInvalidate(DS2438_PageCache* cache, uint8_t page_number);
+
+    /**
+    *   \brief Set maximum age of a volatility class.
+    *
+    *   \param cache pointer to the cache.
+    *   \param volatility_class one of #DS2438_CACHE_MEASUREMENT, #DS2438_CACHE_ACCUMULATOR,
+    *       #DS2438_CACHE_TIMESTAMP.
+    *   \param max_age_ms the maximum age in milliseconds. 0 disables caching of the class.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_BAD_PARAM if the volatility class is not valid.
+    */
+    uint8_t DS2438_CacheSetMaxAge(DS2438_PageCache* cache, uint8_t volatility_class, uint32_t max_age_ms);
+
+    /**
+    *   \brief Get cache hit and miss counters.
+    *
+    *   \param cache pointer to the cache.
+    *   \param hits pointer to variable where the number of hits will be stored.
+    *   \param misses pointer to variable where the number of misses will be stored.
+    */
+    void DS2438_CacheGetStats(DS2438_PageCache* cache, uint32_t* hits, uint32_t* misses);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,78 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 driver.
+*
+**********************************************/
+
+#include "DS2438_Driver.h"
+#include "OneWire.h"
+#include "project.h"
+
+static const OneWire_Conversion DS2438_Conversions[] = {
+    {DS2438_TEMP_CONV, DS2438_CONVERSION_TIME_US},
+    {DS2438_VOLTAGE_CONV, DS2438_CONVERSION_TIME_US},
+};
+
+// Commands of the DS2438: the other ones leave it waiting for a reset
+static uint8_t DS2438_DriverIgnores(uint8_t command)
+{
+    switch (command)
+    {
+        case DS2438_TEMP_CONV:
+        case DS2438_VOLTAGE_CONV:
+        case DS2438_RECALL_MEMORY:
+        case DS2438_READ_SCRATCHPAD:
+        case DS2438_WRITE_SCRATCHPAD:
+        case DS2438_COPY_SCRATCHPAD:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+// Recall and read page 0
+static uint8_t DS2438_DriverRead(OneWire_Device* device)
+{
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(device->pin, DS2438_RECALL_MEMORY);
+    OneWire_WriteByte(device->pin, 0x00);
+    if (OneWire_SelectDevice(device) != DS2438_OK)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(device->pin, DS2438_READ_SCRATCHPAD);
+    OneWire_WriteByte(device->pin, 0x00);
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        device->data[i] = OneWire_ReadByte(device->pin);
+    }
+    if (OneWire_Crc8(device->data, 8) != device->data[8])
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+const OneWire_Driver DS2438_Driver = {
+    DS2438_FAMILY_CODE, "DS2438", DS2438_Conversions, 2, DS2438_DriverIgnores, DS2438_DriverRead
+};
+
+uint8_t DS2438_DeviceGetTemperature(const OneWire_Device* device, float* temperature)
+{
+    if (device->error == DS2438_OK)
+        *temperature = (int16_t)((device->data[2] << 8) | device->data[1]) / 256.0;
+    return device->error;
+}
+
+uint8_t DS2438_DeviceGetVoltage(const OneWire_Device* device, float* voltage)
+{
+    if (device->error == DS2438_OK)
+        *voltage = (((device->data[4] & 0x03) << 8) | device->data[3]) / 100.0;
+    return device->error;
+}
+
+uint8_t DS2438_DeviceGetCurrent(const OneWire_Device* device, float* current)
+{
+    if (device->error == DS2438_OK)
+        *current = (int16_t)((device->data[6] << 8) | device->data[5]) / (4096. * DS2438_SENSE_RESISTOR);
+    return device->error;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,65 @@
+/**
+ * \file DS2438_Driver.h
+ * \brief DS2438 driver of the 1-Wire device layer.
+ *
+ * At each sample cycle of OneWire_Device.h, the driver converts the
+ * temperature, then the voltage of the input selected by the AD bit, and
+ * reads page 0 once: temperature, voltage and current are all decoded
+ * from it. Unlike the functions of DS2438.h, which address the only
+ * device of #DS2438_Pin_0 with SKIP ROM, the driver works with any number
+ * of DS2438 on any bus.
+*/
+#ifndef __DS2438_DRIVER_H__
+    #define __DS2438_DRIVER_H__
+
+    #include "cytypes.h"
+    #include "OneWire_Device.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Family code of the DS2438.
+    */
+    #define DS2438_FAMILY_CODE  0x26
+
+    /**
+    *   \brief Driver to register with #OneWire_RegisterDriver().
+    */
+    extern const OneWire_Driver DS2438_Driver;
+
+    /**
+    *   \brief Get the temperature read by the last sample cycle.
+    *
+    *   \param device pointer to a DS2438 device.
+    *   \param temperature pointer to variable where the temperature, in degree Celsius, will be stored.
+    *   \return the result of the last read of the device.
+    */
+    uint8_t DS2438_DeviceGetTemperature(const OneWire_Device* device, float* temperature);
+
+    /**
+    *   \brief Get the voltage read by the last sample cycle.
+    *
+    *   \param device pointer to a DS2438 device.
+    *   \param voltage pointer to variable where the voltage, in V, will be stored.
+    *   \return the result of the last read of the device.
+    */
+    uint8_t DS2438_DeviceGetVoltage(const OneWire_Device* device, float* voltage);
+
+    /**
+    *   \brief Get the current read by the last sample cycle.
+    *
+    *   The conversion uses the value of the #DS2438_SENSE_RESISTOR macro.
+    *   \param device pointer to a DS2438 device.
+    *   \param current pointer to variable where the current, in A, will be stored.
+    *   \return the result of the last read of the device.
+    */
+    uint8_t DS2438_DeviceGetCurrent(const OneWire_Device* device, float* current);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,89 @@
+/********************************************
+*
+*   \brief Source code for the event queue.
+*
+*   The slot of position p holds 2p + 1 while the
+*   record is written and 2p + 2 when it is ready.
+*   The consumer at position p finds:
+*   - less than 2p + 2: the record is not ready yet;
+*   - 2p + 2: the record is ready, and it is valid if
+*     the sequence is unchanged after the copy;
+*   - more than 2p + 2: the record was overwritten,
+*     so the consumer skips to the oldest record that
+*     the producer can not be writing.
+*
+**********************************************/
+
+#include "DS2438_Events.h"
+#include "project.h"
+
+#define QUEUE_MASK (DS2438_EVENT_QUEUE_SIZE - 1)
+
+void DS2438_EventQueueInit(DS2438_EventQueue* queue, uint8_t policy)
+{
+    for (uint16_t i = 0; i < DS2438_EVENT_QUEUE_SIZE; i++)
+    {
+        queue->slots[i].sequence = 0;
+    }
+    queue->head = 0;
+    queue->tail = 0;
+    queue->policy = policy;
+    queue->pushed = 0;
+    queue->dropped = 0;
+    queue->popped = 0;
+    queue->overwritten = 0;
+}
+
+uint8_t DS2438_EventQueuePush(DS2438_EventQueue* queue, const DS2438_Event* event)
+{
+    uint32_t position = queue->head;
+    if ((queue->policy == DS2438_EVENT_DROP_NEWEST) && ((position - queue->tail) >= DS2438_EVENT_QUEUE_SIZE))
+    {
+        queue->dropped++;
+        return DS2438_ERROR;
+    }
+
+    queue->slots[position & QUEUE_MASK].sequence = 2 * position + 1;
+    DS2438_BARRIER();
+    queue->slots[position & QUEUE_MASK].event = *event;
+    DS2438_BARRIER();
+    queue->slots[position & QUEUE_MASK].sequence = 2 * position + 2;
+    DS2438_BARRIER();
+    queue->head = position + 1;
+    queue->pushed++;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_EventQueuePop(DS2438_EventQueue* queue, DS2438_Event* event)
+{
+    for (;;)
+    {
+        uint32_t position = queue->tail;
+        uint32_t ready = 2 * position + 2;
+        uint32_t sequence = queue->slots[position & QUEUE_MASK].sequence;
+        DS2438_BARRIER();
+        if (sequence == ready)
+        {
+            *event = queue->slots[position & QUEUE_MASK].event;
+            DS2438_BARRIER();
+            if (queue->slots[position & QUEUE_MASK].sequence == ready)
+            {
+                queue->tail = position + 1;
+                queue->popped++;
+                return DS2438_OK;
+            }
+        }
+        else if ((int32_t)(sequence - ready) < 0)
+        {
+            return DS2438_ERROR;
+        }
+        // Overwritten: the slot of head - size may be in use by the producer
+        uint32_t oldest = queue->head - DS2438_EVENT_QUEUE_SIZE + 1;
+        if ((int32_t)(oldest - position) <= 0)
+            oldest = position + 1;
+        queue->overwritten += oldest - position;
+        queue->tail = oldest;
+    }
+}
+
+/* [] END OF FILE */
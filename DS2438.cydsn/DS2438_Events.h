@@ -0,0 +1,123 @@
+/**
+ * \file DS2438_Events.h
+ * \brief Event queue for the DS2438 Library.
+ *
+ * This module implements a single-producer single-consumer queue of
+ * fixed-size records, used to carry samples and events from the
+ * measurement code to the telemetry output code. The producer and the
+ * consumer never wait for each other, so a slow output link does not
+ * delay the measurements.
+ *
+ * Each slot carries a sequence number, written by the producer after
+ * the record. The consumer checks it before and after copying the
+ * record, so that the producer may overwrite the oldest records when
+ * the queue is full (#DS2438_EVENT_DROP_OLDEST) without any lock. With
+ * #DS2438_EVENT_DROP_NEWEST, records pushed to a full queue are discarded.
+*/
+#ifndef __DS2438_EVENTS_H__
+    #define __DS2438_EVENTS_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Number of records of the queue. Must be a power of 2.
+    */
+    #define DS2438_EVENT_QUEUE_SIZE     32
+
+    // ===========================================================
+    //                      OVERFLOW POLICIES
+    // ===========================================================
+
+    /**
+    *   \brief Discard the oldest record when the queue is full.
+    */
+    #define DS2438_EVENT_DROP_OLDEST    0
+
+    /**
+    *   \brief Discard the new record when the queue is full.
+    */
+    #define DS2438_EVENT_DROP_NEWEST    1
+
+    // ===========================================================
+    //                      EVENT TYPES
+    // ===========================================================
+
+    #define DS2438_EVENT_VOLTAGE        0   ///< Voltage sample, value in mV
+    #define DS2438_EVENT_TEMPERATURE    1   ///< Temperature sample, value in thousandths of degree Celsius
+    #define DS2438_EVENT_CURRENT        2   ///< Current sample, value in mA
+    #define DS2438_EVENT_CAPACITY       3   ///< Remaining capacity, value in mAh
+    #define DS2438_EVENT_PAGE           4   ///< Page content, index is the page number, data holds the page
+    #define DS2438_EVENT_HISTORY        5   ///< Battery history, value is the ETM, data holds CCA and DCA
+    #define DS2438_EVENT_ERROR          6   ///< Failed measurement, index is the event type of the measurement, value is the page number of a page
+    #define DS2438_EVENT_PRESENCE       7   ///< Device attached or detached, value is the DS2438_PRESENCE_* event, data holds the ROM
+
+    /**
+    *   \brief Event record.
+    */
+    typedef struct {
+        uint32_t timestamp_ms;      ///< Time of the event
+        uint8_t type;               ///< Type of the event
+        uint8_t error;              ///< Error code, #DS2438_OK for samples
+        uint8_t index;              ///< Page number or event type, depending on the type
+        int32_t value;              ///< Value of the sample
+        uint8_t data[8];            ///< Raw data
+    } DS2438_Event;
+
+    /**
+    *   \brief Event queue.
+    */
+    typedef struct {
+        struct {
+            volatile uint32_t sequence;     ///< Twice the position of the record, plus 1 while it is written
+            DS2438_Event event;             ///< Record
+        } slots[DS2438_EVENT_QUEUE_SIZE];
+        volatile uint32_t head;             ///< Next position to be written, owned by the producer
+        volatile uint32_t tail;             ///< Next position to be read, owned by the consumer
+        uint8_t policy;                     ///< Overflow policy
+        uint32_t pushed;                    ///< Records pushed, owned by the producer
+        uint32_t dropped;                   ///< Records discarded by the producer, owned by the producer
+        uint32_t popped;                    ///< Records popped, owned by the consumer
+        uint32_t overwritten;               ///< Records overwritten before being popped, owned by the consumer
+    } DS2438_EventQueue;
+
+    /**
+    *   \brief Initialize an event queue.
+    *
+    *   \param queue pointer to the queue.
+    *   \param policy #DS2438_EVENT_DROP_OLDEST or #DS2438_EVENT_DROP_NEWEST.
+    */
+    void DS2438_EventQueueInit(DS2438_EventQueue* queue, uint8_t policy);
+
+    /**
+    *   \brief Push a record to the queue.
+    *
+    *   This function must be called from a single context, the producer.
+    *   \param queue pointer to the queue.
+    *   \param event pointer to the record.
+    *   \retval #DS2438_OK if the record was pushed.
+    *   \retval #DS2438_ERROR if the queue is full and the policy is #DS2438_EVENT_DROP_NEWEST.
+    */
+    uint8_t DS2438_EventQueuePush(DS2438_EventQueue* queue, const DS2438_Event* event);
+
+    /**
+    *   \brief Pop a record from the queue.
+    *
+    *   This function must be called from a single context, the consumer.
+    *   \param queue pointer to the queue.
+    *   \param event pointer to variable where the record will be stored.
+    *   \retval #DS2438_OK if a record was popped.
+    *   \retval #DS2438_ERROR if the queue is empty.
+    */
+    uint8_t DS2438_EventQueuePop(DS2438_EventQueue* queue, DS2438_Event* event);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
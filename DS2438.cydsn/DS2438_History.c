@@ -0,0 +1,123 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 battery history.
+*
+*   All the multi-byte registers of the DS2438
+*   are stored LSB first.
+*
+**********************************************/
+
+#include "DS2438_History.h"
+#include "DS2438.h"
+#include "Timebase.h"
+
+static DS2438_History history;
+static uint8_t history_valid = 0;
+static uint32_t poll_interval_ms = DS2438_HISTORY_POLL_INTERVAL_MS;
+static uint32_t last_poll_ms = 0;
+
+// Read a page from the device and check its CRC
+static uint8_t DS2438_ReadHistoryPage(uint8_t page_number, uint32_t max_age_ms, uint8_t* page_data)
+{
+    uint8_t error = DS2438_ReadPageWithMaxAge(page_number, max_age_ms, page_data);
+    if (error == DS2438_OK)
+    {
+        if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+            return DS2438_CRC_FAIL;
+    }
+    return error;
+}
+
+// ===========================================================
+//                      DECODERS
+// ===========================================================
+
+uint32_t DS2438_DecodeElapsedTime(const uint8_t* page_data)
+{
+    return ((uint32_t)page_data[3] << 24) | ((uint32_t)page_data[2] << 16) |
+           ((uint32_t)page_data[1] << 8) | page_data[0];
+}
+
+uint32_t DS2438_DecodeDisconnectTime(const uint8_t* page_data)
+{
+    return ((uint32_t)page_data[3] << 24) | ((uint32_t)page_data[2] << 16) |
+           ((uint32_t)page_data[1] << 8) | page_data[0];
+}
+
+uint32_t DS2438_DecodeEndOfChargeTime(const uint8_t* page_data)
+{
+    return ((uint32_t)page_data[7] << 24) | ((uint32_t)page_data[6] << 16) |
+           ((uint32_t)page_data[5] << 8) | page_data[4];
+}
+
+uint16_t DS2438_DecodeCCA(const uint8_t* page_data)
+{
+    return (page_data[5] << 8) | page_data[4];
+}
+
+uint16_t DS2438_DecodeDCA(const uint8_t* page_data)
+{
+    return (page_data[7] << 8) | page_data[6];
+}
+
+float DS2438_AccumulatorToCharge(uint16_t accumulator)
+{
+    return accumulator / (64.0 * DS2438_SENSE_RESISTOR);
+}
+
+// ===========================================================
+//                      HISTORY POLLER
+// ===========================================================
+
+void DS2438_SetHistoryPollInterval(uint32_t interval_ms)
+{
+    poll_interval_ms = interval_ms;
+}
+
+uint8_t DS2438_PollHistory(void)
+{
+    uint8_t page_data[9];
+    uint32_t now_ms = Timebase_GetMs();
+
+    if ((history_valid == 1) && ((now_ms - last_poll_ms) < poll_interval_ms))
+        return DS2438_OK;
+
+    // ETM tells whether timestamps and accumulators may have changed
+    uint8_t error = DS2438_ReadHistoryPage(0x01, poll_interval_ms, page_data);
+    if (error != DS2438_OK)
+        return error;
+    last_poll_ms = now_ms;
+    uint32_t elapsed_time = DS2438_DecodeElapsedTime(page_data);
+    if ((history_valid == 1) && (elapsed_time == history.elapsed_time))
+        return DS2438_OK;
+
+    // Timestamps
+    error = DS2438_ReadHistoryPage(0x02, 0, page_data);
+    if (error != DS2438_OK)
+        return error;
+    uint32_t disconnect_time = DS2438_DecodeDisconnectTime(page_data);
+    uint32_t end_of_charge_time = DS2438_DecodeEndOfChargeTime(page_data);
+
+    // Accumulators
+    error = DS2438_ReadHistoryPage(0x07, 0, page_data);
+    if (error != DS2438_OK)
+        return error;
+
+    history.elapsed_time = elapsed_time;
+    history.disconnect_time = disconnect_time;
+    history.end_of_charge_time = end_of_charge_time;
+    history.cca = DS2438_DecodeCCA(page_data);
+    history.dca = DS2438_DecodeDCA(page_data);
+    history_valid = 1;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_GetHistory(DS2438_History* history_data)
+{
+    if (history_valid == 0)
+        return DS2438_ERROR;
+    *history_data = history;
+    return DS2438_OK;
+}
+
+/* [] END OF FILE */
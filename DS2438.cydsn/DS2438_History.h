@@ -0,0 +1,134 @@
+/**
+ * \file DS2438_History.h
+ * \brief Battery history telemetry for the DS2438 Library.
+ *
+ * This module provides decoders for the elapsed time meter (page 1),
+ * the disconnect and end of charge timestamps (page 2) and the
+ * charging/discharging current accumulators (page 7), and a poller
+ * that reads these pages at a low rate. Queries are served from
+ * the last decoded values, so they do not require any bus transaction.
+*/
+#ifndef __DS2438_HISTORY_H__
+    #define __DS2438_HISTORY_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Default interval between two history polls, in milliseconds.
+    */
+    #define DS2438_HISTORY_POLL_INTERVAL_MS     10000
+
+    /**
+    *   \brief Battery history of a DS2438.
+    *
+    *   Times are expressed in seconds, as counted by the elapsed time meter.
+    *   Accumulators are expressed in raw format, with a LSB of 15.625 mVh
+    *   across the sense resistor.
+    */
+    typedef struct {
+        uint32_t elapsed_time;          ///< Elapsed time meter
+        uint32_t disconnect_time;       ///< Value of ETM at the last disconnect
+        uint32_t end_of_charge_time;    ///< Value of ETM at the last end of charge
+        uint16_t cca;                   ///< Charging current accumulator
+        uint16_t dca;                   ///< Discharging current accumulator
+    } DS2438_History;
+
+    // ===========================================================
+    //                      DECODERS
+    // ===========================================================
+
+    /**
+    *   \brief Decode the elapsed time meter.
+    *
+    *   \param page_data the data of page 1.
+    *   \return elapsed time, in seconds.
+    */
+    uint32_t DS2438_DecodeElapsedTime(const uint8_t* page_data);
+
+    /**
+    *   \brief Decode the disconnect timestamp.
+    *
+    *   \param page_data the data of page 2.
+    *   \return value of ETM when the battery was last disconnected, in seconds.
+    */
+    uint32_t DS2438_DecodeDisconnectTime(const uint8_t* page_data);
+
+    /**
+    *   \brief Decode the end of charge timestamp.
+    *
+    *   \param page_data the data of page 2.
+    *   \return value of ETM at the last end of charge, in seconds.
+    */
+    uint32_t DS2438_DecodeEndOfChargeTime(const uint8_t* page_data);
+
+    /**
+    *   \brief Decode the charging current accumulator.
+    *
+    *   \param page_data the data of page 7.
+    *   \return the raw CCA value.
+    */
+    uint16_t DS2438_DecodeCCA(const uint8_t* page_data);
+
+    /**
+    *   \brief Decode the discharging current accumulator.
+    *
+    *   \param page_data the data of page 7.
+    *   \return the raw DCA value.
+    */
+    uint16_t DS2438_DecodeDCA(const uint8_t* page_data);
+
+    /**
+    *   \brief Convert a raw CCA or DCA value to charge.
+    *
+    *   The conversion uses the value of the #DS2438_SENSE_RESISTOR macro,
+    *   according to the formula \f$charge = \dfrac{CA}{64\cdot R_{sense}} \f$.
+    *   \param accumulator the raw accumulator value.
+    *   \return the accumulated charge, in Ah.
+    */
+    float DS2438_AccumulatorToCharge(uint16_t accumulator);
+
+    // ===========================================================
+    //                      HISTORY POLLER
+    // ===========================================================
+
+    /**
+    *   \brief Set the interval between two history polls.
+    *
+    *   \param interval_ms the poll interval, in milliseconds.
+    */
+    void DS2438_SetHistoryPollInterval(uint32_t interval_ms);
+
+    /**
+    *   \brief Poll battery history.
+    *
+    *   This function must be called periodically, e.g. from the main loop.
+    *   It does nothing until the poll interval has expired. Then, page 1 is
+    *   read, and pages 2 and 7 are read only if the elapsed time meter has
+    *   advanced since the last poll.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_PollHistory(void);
+
+    /**
+    *   \brief Get the last polled battery history.
+    *
+    *   This function does not perform any bus transaction.
+    *   \param history pointer to variable where the history will be stored.
+    *   \retval #DS2438_OK if the history is available.
+    *   \retval #DS2438_ERROR if no history was polled yet.
+    */
+    uint8_t DS2438_GetHistory(DS2438_History* history);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,329 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 sample log.
+*
+*   Layout of a flash slot:
+*   - bytes 0-1: magic
+*   - bytes 2-5: sequence number of the batch
+*   - byte 6: number of samples
+*   - byte 7: payload length
+*   - byte 8: CRC of bytes 0-7 and of the payload
+*   - bytes 9 to slot size - 1: payload
+*
+*   A slot is written with a single write of the header
+*   and the payload. The CRC detects slots that were
+*   only partially written, and the sequence number
+*   tells a new batch from the older one it replaces.
+*
+*   The first sample of a batch is encoded as difference
+*   from zero, the following ones as difference from the
+*   previous sample. Each difference is stored as a
+*   zig-zag varint.
+*
+**********************************************/
+
+#include "DS2438_Log.h"
+#include "DS2438.h"
+#include "DS2438_Storage.h"
+#include <string.h>
+
+// Identifies a slot written by the log
+#define SLOT_MAGIC 0x4C47
+
+#define SLOT_HEADER_SIZE 9
+#define SLOT_PAYLOAD_SIZE (DS2438_LOG_SLOT_SIZE - SLOT_HEADER_SIZE)
+
+// Fields of a sample, and worst case size of an encoded sample
+#define SAMPLE_FIELDS 7
+#define SAMPLE_MAX_ENCODED_SIZE (SAMPLE_FIELDS * 5)
+
+static uint8_t DS2438_LogStorageRead(uint32_t offset, void* data, uint32_t size);
+static uint8_t DS2438_LogStorageWrite(uint32_t offset, const void* data, uint32_t size);
+
+static const DS2438_LogFlash storage_flash = {
+    DS2438_LogStorageRead,
+    DS2438_LogStorageWrite,
+    DS2438_STORAGE_LOG_SIZE
+};
+
+static const DS2438_LogFlash* log_flash = &storage_flash;
+static uint16_t n_slots = 0;
+static uint16_t next_slot = 0;
+static uint32_t next_sequence = 0;
+
+// RAM ring buffer
+static DS2438_LogSample ring[DS2438_LOG_RAM_SAMPLES];
+static uint8_t ring_tail = 0;
+static uint8_t ring_count = 0;
+
+static DS2438_LogStats stats;
+
+// Encoding buffer, kept out of the stack
+static uint8_t slot_buffer[DS2438_LOG_SLOT_SIZE];
+
+// ===========================================================
+//                      FLASH BACKEND
+// ===========================================================
+
+static uint8_t DS2438_LogStorageRead(uint32_t offset, void* data, uint32_t size)
+{
+    if (DS2438_StorageStart() != DS2438_OK)
+        return DS2438_ERROR;
+    return DS2438_StorageRead(DS2438_STORAGE_LOG_OFFSET + offset, data, size);
+}
+
+static uint8_t DS2438_LogStorageWrite(uint32_t offset, const void* data, uint32_t size)
+{
+    if (DS2438_StorageStart() != DS2438_OK)
+        return DS2438_ERROR;
+    return DS2438_StorageWrite(DS2438_STORAGE_LOG_OFFSET + offset, data, size);
+}
+
+// ===========================================================
+//                      ENCODING
+// ===========================================================
+
+static uint8_t DS2438_LogPutVarint(uint8_t* data, int32_t value)
+{
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t length = 0;
+    do
+    {
+        uint8_t byte = zigzag & 0x7F;
+        zigzag >>= 7;
+        if (zigzag != 0)
+            byte |= 0x80;
+        data[length++] = byte;
+    } while (zigzag != 0);
+    return length;
+}
+
+// Returns the number of bytes consumed, or 0 if the varint is truncated
+static uint8_t DS2438_LogGetVarint(const uint8_t* data, uint8_t size, int32_t* value)
+{
+    uint32_t zigzag = 0;
+    uint8_t length = 0;
+    while ((length < size) && (length < 5))
+    {
+        uint8_t byte = data[length];
+        zigzag |= (uint32_t)(byte & 0x7F) << (7 * length);
+        length++;
+        if ((byte & 0x80) == 0)
+        {
+            *value = (int32_t)((zigzag >> 1) ^ (0 - (zigzag & 0x01)));
+            return length;
+        }
+    }
+    return 0;
+}
+
+static void DS2438_LogSampleFields(const DS2438_LogSample* sample, uint32_t* fields)
+{
+    fields[0] = sample->timestamp_ms;
+    fields[1] = sample->voltage;
+    fields[2] = sample->temperature;
+    fields[3] = sample->current;
+    fields[4] = sample->ica;
+    fields[5] = sample->cca;
+    fields[6] = sample->dca;
+}
+
+// Encode samples from the ring buffer into slot_buffer, returns the number of samples encoded
+static uint8_t DS2438_LogEncodeBatch(void)
+{
+    uint32_t previous[SAMPLE_FIELDS] = {0};
+    uint32_t fields[SAMPLE_FIELDS];
+    uint8_t length = 0;
+    uint8_t n_samples = 0;
+    uint8_t encoded[SAMPLE_MAX_ENCODED_SIZE];
+
+    while (n_samples < ring_count)
+    {
+        uint8_t encoded_length = 0;
+        DS2438_LogSampleFields(&ring[(ring_tail + n_samples) % DS2438_LOG_RAM_SAMPLES], fields);
+        for (uint8_t i = 0; i < SAMPLE_FIELDS; i++)
+        {
+            encoded_length += DS2438_LogPutVarint(&encoded[encoded_length], (int32_t)(fields[i] - previous[i]));
+        }
+        if ((length + encoded_length) > SLOT_PAYLOAD_SIZE)
+            break;
+        memcpy(&slot_buffer[SLOT_HEADER_SIZE + length], encoded, encoded_length);
+        length += encoded_length;
+        for (uint8_t i = 0; i < SAMPLE_FIELDS; i++)
+        {
+            previous[i] = fields[i];
+        }
+        n_samples++;
+    }
+
+    slot_buffer[0] = SLOT_MAGIC & 0xFF;
+    slot_buffer[1] = SLOT_MAGIC >> 8;
+    slot_buffer[2] = next_sequence & 0xFF;
+    slot_buffer[3] = (next_sequence >> 8) & 0xFF;
+    slot_buffer[4] = (next_sequence >> 16) & 0xFF;
+    slot_buffer[5] = (next_sequence >> 24) & 0xFF;
+    slot_buffer[6] = n_samples;
+    slot_buffer[7] = length;
+    slot_buffer[8] = 0;
+    slot_buffer[8] = DS2438_ComputeCrc(slot_buffer, SLOT_HEADER_SIZE + length);
+    return n_samples;
+}
+
+// Read and validate a slot into slot_buffer
+static uint8_t DS2438_LogLoadSlot(uint16_t slot)
+{
+    if (log_flash->read((uint32_t)slot * DS2438_LOG_SLOT_SIZE, slot_buffer, DS2438_LOG_SLOT_SIZE) != DS2438_OK)
+        return DS2438_ERROR;
+    if ((((slot_buffer[1] << 8) | slot_buffer[0]) != SLOT_MAGIC) ||
+        (slot_buffer[7] > SLOT_PAYLOAD_SIZE))
+        return DS2438_ERROR;
+    uint8_t crc = slot_buffer[8];
+    slot_buffer[8] = 0;
+    if (DS2438_ComputeCrc(slot_buffer, SLOT_HEADER_SIZE + slot_buffer[7]) != crc)
+        return DS2438_ERROR;
+    slot_buffer[8] = crc;
+    return DS2438_OK;
+}
+
+static uint32_t DS2438_LogSlotSequence(void)
+{
+    return ((uint32_t)slot_buffer[5] << 24) | ((uint32_t)slot_buffer[4] << 16) |
+           ((uint32_t)slot_buffer[3] << 8) | slot_buffer[2];
+}
+
+// Write one batch to the next slot
+static uint8_t DS2438_LogWriteBatch(void)
+{
+    uint32_t offset = (uint32_t)next_slot * DS2438_LOG_SLOT_SIZE;
+    uint8_t n_samples = DS2438_LogEncodeBatch();
+
+    if (log_flash->write(offset, slot_buffer, SLOT_HEADER_SIZE + slot_buffer[7]) != DS2438_OK)
+    {
+        stats.write_errors++;
+        return DS2438_ERROR;
+    }
+    ring_tail = (ring_tail + n_samples) % DS2438_LOG_RAM_SAMPLES;
+    ring_count -= n_samples;
+    next_slot = (next_slot + 1) % n_slots;
+    next_sequence++;
+    stats.batches++;
+    return DS2438_OK;
+}
+
+// ===========================================================
+//                      LOG FUNCTIONS
+// ===========================================================
+
+uint8_t DS2438_LogStart(const DS2438_LogFlash* flash)
+{
+    uint8_t found = 0;
+    uint32_t last_sequence = 0;
+
+    log_flash = (flash != NULL) ? flash : &storage_flash;
+    n_slots = log_flash->size / DS2438_LOG_SLOT_SIZE;
+    next_slot = 0;
+    next_sequence = 0;
+    ring_tail = 0;
+    ring_count = 0;
+    stats.appended = 0;
+    stats.dropped = 0;
+    stats.batches = 0;
+    stats.write_errors = 0;
+    if (n_slots == 0)
+        return DS2438_ERROR;
+
+    // Resume after the most recent valid batch
+    for (uint16_t slot = 0; slot < n_slots; slot++)
+    {
+        if (DS2438_LogLoadSlot(slot) != DS2438_OK)
+            continue;
+        uint32_t sequence = DS2438_LogSlotSequence();
+        if ((found == 0) || ((int32_t)(sequence - last_sequence) > 0))
+        {
+            found = 1;
+            last_sequence = sequence;
+            next_slot = (slot + 1) % n_slots;
+        }
+    }
+    if (found)
+        next_sequence = last_sequence + 1;
+    return DS2438_OK;
+}
+
+void DS2438_LogAppend(const DS2438_LogSample* sample)
+{
+    if (ring_count == DS2438_LOG_RAM_SAMPLES)
+    {
+        // Drop oldest sample
+        ring_tail = (ring_tail + 1) % DS2438_LOG_RAM_SAMPLES;
+        ring_count--;
+        stats.dropped++;
+    }
+    ring[(ring_tail + ring_count) % DS2438_LOG_RAM_SAMPLES] = *sample;
+    ring_count++;
+    stats.appended++;
+}
+
+uint8_t DS2438_LogService(uint32_t idle_ms)
+{
+    if ((n_slots == 0) || (ring_count < DS2438_LOG_BATCH_SAMPLES) || (idle_ms < DS2438_LOG_FLUSH_TIME_MS))
+        return DS2438_OK;
+    return DS2438_LogWriteBatch();
+}
+
+uint8_t DS2438_LogFlush(void)
+{
+    if (n_slots == 0)
+        return DS2438_ERROR;
+    while (ring_count > 0)
+    {
+        if (DS2438_LogWriteBatch() != DS2438_OK)
+            return DS2438_ERROR;
+    }
+    return DS2438_OK;
+}
+
+uint8_t DS2438_LogReadBatch(uint16_t slot, DS2438_LogSample* samples, uint8_t max_samples,
+                            uint8_t* n_samples, uint32_t* sequence)
+{
+    uint32_t fields[SAMPLE_FIELDS] = {0};
+    uint8_t position = SLOT_HEADER_SIZE;
+    uint8_t count = 0;
+
+    if (slot >= n_slots)
+        return DS2438_BAD_PARAM;
+    if (DS2438_LogLoadSlot(slot) != DS2438_OK)
+        return DS2438_ERROR;
+
+    uint8_t end = SLOT_HEADER_SIZE + slot_buffer[7];
+    while ((count < slot_buffer[6]) && (count < max_samples))
+    {
+        for (uint8_t i = 0; i < SAMPLE_FIELDS; i++)
+        {
+            int32_t delta;
+            uint8_t length = DS2438_LogGetVarint(&slot_buffer[position], end - position, &delta);
+            if (length == 0)
+                return DS2438_ERROR;
+            fields[i] += (uint32_t)delta;
+            position += length;
+        }
+        samples[count].timestamp_ms = fields[0];
+        samples[count].voltage = fields[1];
+        samples[count].temperature = fields[2];
+        samples[count].current = fields[3];
+        samples[count].ica = fields[4];
+        samples[count].cca = fields[5];
+        samples[count].dca = fields[6];
+        count++;
+    }
+    *n_samples = count;
+    *sequence = DS2438_LogSlotSequence();
+    return DS2438_OK;
+}
+
+void DS2438_LogGetStats(DS2438_LogStats* log_stats)
+{
+    *log_stats = stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,149 @@
+/**
+ * \file DS2438_Log.h
+ * \brief Sample log for the DS2438 Library.
+ *
+ * Samples are appended to a RAM ring buffer, which only requires
+ * a copy of the sample. When enough samples are available and the
+ * application has enough idle time, they are compressed and written
+ * to flash in a single batch.
+ *
+ * The flash region is split in slots that are written in round robin,
+ * so that writes are spread over the whole region. Each slot holds one
+ * batch: a header with sequence number and CRC, the delta-encoded
+ * samples, written with a single flash write. A batch is only
+ * considered valid if its CRC matches, so a power failure during a
+ * write never corrupts the log.
+ *
+ * Flash accesses go through a #DS2438_LogFlash interface, so that the
+ * log can be used with the emulated EEPROM of the storage module or
+ * with a model of the flash memory.
+*/
+#ifndef __DS2438_LOG_H__
+    #define __DS2438_LOG_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Number of samples of the RAM ring buffer.
+    */
+    #define DS2438_LOG_RAM_SAMPLES      32
+
+    /**
+    *   \brief Number of samples that triggers a flush to flash.
+    */
+    #define DS2438_LOG_BATCH_SAMPLES    16
+
+    /**
+    *   \brief Size of a flash slot, in bytes.
+    */
+    #define DS2438_LOG_SLOT_SIZE        128
+
+    /**
+    *   \brief Worst case time required to write a batch to flash, in milliseconds.
+    */
+    #define DS2438_LOG_FLUSH_TIME_MS    50
+
+    /**
+    *   \brief Logged sample.
+    */
+    typedef struct {
+        uint32_t timestamp_ms;      ///< Time at which the sample was taken
+        uint16_t voltage;           ///< Raw voltage
+        uint16_t temperature;       ///< Raw temperature
+        uint16_t current;           ///< Raw current
+        uint8_t ica;                ///< Integrated current accumulator
+        uint16_t cca;               ///< Charging current accumulator
+        uint16_t dca;               ///< Discharging current accumulator
+    } DS2438_LogSample;
+
+    /**
+    *   \brief Flash memory interface used by the log.
+    */
+    typedef struct {
+        uint8_t (*read)(uint32_t offset, void* data, uint32_t size);          ///< Read from flash, returns #DS2438_OK on success
+        uint8_t (*write)(uint32_t offset, const void* data, uint32_t size);   ///< Write to flash, returns #DS2438_OK on success
+        uint32_t size;                                                          ///< Size of the flash region, in bytes
+    } DS2438_LogFlash;
+
+    /**
+    *   \brief Statistics of the log.
+    */
+    typedef struct {
+        uint32_t appended;          ///< Samples appended to the RAM ring buffer
+        uint32_t dropped;           ///< Samples dropped because the RAM ring buffer was full
+        uint32_t batches;           ///< Batches written to flash
+        uint32_t write_errors;      ///< Failed flash writes
+    } DS2438_LogStats;
+
+    /**
+    *   \brief Start the log.
+    *
+    *   This function scans the flash slots to find the most recent
+    *   valid batch, and resumes writing from the following slot.
+    *   \param flash the flash interface, or NULL to use the storage module.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if the flash could not be accessed.
+    */
+    uint8_t DS2438_LogStart(const DS2438_LogFlash* flash);
+
+    /**
+    *   \brief Append a sample to the log.
+    *
+    *   The sample is copied to the RAM ring buffer. If the ring buffer
+    *   is full, the oldest sample is dropped.
+    *   \param sample pointer to the sample.
+    */
+    void DS2438_LogAppend(const DS2438_LogSample* sample);
+
+    /**
+    *   \brief Write samples to flash if needed.
+    *
+    *   A batch is written only if at least #DS2438_LOG_BATCH_SAMPLES samples
+    *   are available and the idle time is long enough for the write.
+    *   \param idle_ms time available before the next measurement, in milliseconds.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if the batch could not be written.
+    */
+    uint8_t DS2438_LogService(uint32_t idle_ms);
+
+    /**
+    *   \brief Write all the samples of the RAM ring buffer to flash.
+    *
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if a batch could not be written.
+    */
+    uint8_t DS2438_LogFlush(void);
+
+    /**
+    *   \brief Read a batch from flash.
+    *
+    *   \param slot the slot to be read.
+    *   \param samples pointer to array where samples will be stored.
+    *   \param max_samples size of the samples array.
+    *   \param n_samples pointer to variable where the number of samples will be stored.
+    *   \param sequence pointer to variable where the sequence number of the batch will be stored.
+    *   \retval #DS2438_OK if the slot holds a valid batch.
+    *   \retval #DS2438_ERROR if the slot is empty or its content is not valid.
+    *   \retval #DS2438_BAD_PARAM if the slot does not exist.
+    */
+    uint8_t DS2438_LogReadBatch(uint16_t slot, DS2438_LogSample* samples, uint8_t max_samples,
+                                uint8_t* n_samples, uint32_t* sequence);
+
+    /**
+    *   \brief Get statistics of the log.
+    *
+    *   \param stats pointer to variable where statistics will be stored.
+    */
+    void DS2438_LogGetStats(DS2438_LogStats* stats);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
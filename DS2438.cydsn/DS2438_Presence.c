@@ -0,0 +1,328 @@
+/********************************************
+*
+*   \brief Source code for the hot-plug detection.
+*
+*   The reset hook of OneWire.c records the result of
+*   every reset on the watched pin. A missing presence
+*   pulse detaches all the devices at once; a presence
+*   pulse with no known device starts an identification.
+*
+*   The bus time of the watcher is limited with a token
+*   bucket: tokens are bus time, credited at the budget
+*   rate and saved up to DS2438_PRESENCE_BURST_US, and a
+*   transaction is only started with a positive balance.
+*   Its measured duration is then charged, so a ROM read
+*   or a search pass can take the balance below zero,
+*   and the following ones wait for it to recover.
+*
+*   The search is the one of OneWire.c, one pass (one
+*   ROM) per poll. A sweep ends with the pass that has
+*   no discrepancy left; devices not found by a complete
+*   sweep are detached.
+*
+**********************************************/
+
+#include "DS2438_Presence.h"
+#include "DS2438.h"
+#include "DS2438_Cache.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include "project.h"
+#include <string.h>
+
+// Parameters
+static unsigned int watched_pin;
+static uint8_t watcher_started = 0;
+static uint8_t multidrop_bus;
+static uint32_t probe_interval_ms;
+static uint16_t budget;
+static DS2438_PresenceCallback presence_callback;
+static void* presence_context;
+static OneWire_ResetHook previous_hook;
+
+// Resets observed on the watched pin since the last poll
+static volatile uint8_t seen_absent;
+static volatile uint8_t seen_present;
+static volatile uint8_t last_result;
+static volatile uint32_t last_reset_ms;
+
+// Bus time budget
+static int32_t tokens_us;
+static uint32_t refill_us;
+static DS2438_PresenceStats stats;
+
+// Devices present, and identification in progress
+static uint8_t roms[DS2438_PRESENCE_MAX_DEVICES][8];
+static uint8_t seen[DS2438_PRESENCE_MAX_DEVICES];
+static uint8_t n_devices;
+static uint8_t identify;
+static uint8_t last_rom[8];
+static uint8_t has_last_rom;
+
+// ROM search state
+static uint8_t search_rom[8];
+static uint8_t last_discrepancy;
+static uint8_t sweep_started;
+
+static void DS2438_PresenceResetHook(unsigned int pin, int result)
+{
+    if (previous_hook != NULL)
+        previous_hook(pin, result);
+    if (pin != watched_pin)
+        return;
+    if (result)
+        seen_absent = 1;
+    else
+        seen_present = 1;
+    last_result = result;
+    last_reset_ms = Timebase_GetMs();
+}
+
+// ===========================================================
+//                      BUDGET
+// ===========================================================
+
+static void DS2438_PresenceRefill(void)
+{
+    uint32_t now_us = Timebase_GetUs();
+    int64_t balance_us = tokens_us + (int64_t)(((uint64_t)(now_us - refill_us) * budget) / 1000);
+    refill_us = now_us;
+    tokens_us = (balance_us > DS2438_PRESENCE_BURST_US) ? DS2438_PRESENCE_BURST_US : (int32_t)balance_us;
+}
+
+static void DS2438_PresenceCharge(uint32_t start_us)
+{
+    uint32_t cost_us = Timebase_GetUs() - start_us;
+    tokens_us -= (int32_t)cost_us;
+    stats.bus_us += cost_us;
+}
+
+// ===========================================================
+//                      DEVICES
+// ===========================================================
+
+static void DS2438_PresenceNotify(const uint8_t* rom, uint8_t event)
+{
+    // Pages cached by the blocking API may belong to another device
+    if (watched_pin == DS2438_Pin_0)
+        DS2438_CacheInvalidate(DS2438_GetPageCache(), DS2438_CACHE_ALL_PAGES);
+    if (presence_callback != NULL)
+        presence_callback(rom, event, presence_context);
+}
+
+static void DS2438_PresenceAttach(const uint8_t* rom)
+{
+    uint8_t event = DS2438_PRESENCE_ATTACHED;
+    if (n_devices == DS2438_PRESENCE_MAX_DEVICES)
+        return;
+    if (!multidrop_bus && has_last_rom && (memcmp(rom, last_rom, 8) != 0))
+        event = DS2438_PRESENCE_REPLACED;
+    memcpy(roms[n_devices], rom, 8);
+    seen[n_devices] = 1;
+    n_devices++;
+    DS2438_PresenceNotify(rom, event);
+}
+
+static void DS2438_PresenceDetach(uint8_t index)
+{
+    uint8_t rom[8];
+    memcpy(rom, roms[index], 8);
+    memcpy(last_rom, rom, 8);
+    has_last_rom = 1;
+    n_devices--;
+    for (uint8_t i = index; i < n_devices; i++)
+    {
+        memcpy(roms[i], roms[i + 1], 8);
+        seen[i] = seen[i + 1];
+    }
+    DS2438_PresenceNotify(rom, DS2438_PRESENCE_DETACHED);
+}
+
+static int8_t DS2438_PresenceFind(const uint8_t* rom)
+{
+    for (uint8_t i = 0; i < n_devices; i++)
+    {
+        if (memcmp(roms[i], rom, 8) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// ===========================================================
+//                      IDENTIFICATION
+// ===========================================================
+
+// Read the ROM of the single device of the bus
+static uint8_t DS2438_PresenceReadRom(uint8_t* rom)
+{
+    if (OneWire_TouchReset(watched_pin) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    OneWire_WriteByte(watched_pin, ONEWIRE_READ_ROM);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        rom[i] = OneWire_ReadByte(watched_pin);
+    }
+    if (OneWire_CheckRom(rom) != ONEWIRE_SEARCH_OK)
+        return DS2438_CRC_FAIL;
+    return DS2438_OK;
+}
+
+static void DS2438_PresenceIdentifySingle(void)
+{
+    uint8_t rom[8];
+    uint8_t error = DS2438_PresenceReadRom(rom);
+    stats.identifications++;
+    if (error == DS2438_OK)
+    {
+        DS2438_PresenceAttach(rom);
+        identify = 0;
+    }
+    else if (error == DS2438_DEV_NOT_FOUND)
+    {
+        identify = 0;
+    }
+    else
+    {
+        // Retried at the next poll
+        stats.failures++;
+    }
+}
+
+static void DS2438_PresenceSearch(void)
+{
+    if (!sweep_started)
+    {
+        last_discrepancy = 0;
+        memset(seen, 0, sizeof(seen));
+        sweep_started = 1;
+    }
+    int result = OneWire_SearchPass(watched_pin, search_rom, &last_discrepancy);
+    stats.identifications++;
+    if (result != ONEWIRE_SEARCH_OK)
+    {
+        // Incomplete sweep, started again at the next poll
+        if (result == ONEWIRE_SEARCH_BAD_ROM)
+            stats.failures++;
+        sweep_started = 0;
+        return;
+    }
+    int8_t index = DS2438_PresenceFind(search_rom);
+    if (index < 0)
+        DS2438_PresenceAttach(search_rom);
+    else
+        seen[index] = 1;
+    if (last_discrepancy != 0)
+        return;
+
+    // Sweep complete
+    sweep_started = 0;
+    identify = 0;
+    for (uint8_t i = n_devices; i > 0; i--)
+    {
+        if (!seen[i - 1])
+            DS2438_PresenceDetach(i - 1);
+    }
+}
+
+// ===========================================================
+//                      FUNCTIONS
+// ===========================================================
+
+uint8_t DS2438_PresenceStart(unsigned int pin, uint8_t multidrop, uint32_t max_latency_ms,
+                             uint16_t budget_permille, DS2438_PresenceCallback callback, void* context)
+{
+    // A reset per interval must fit in the budget
+    if ((budget_permille == 0) || (budget_permille > 1000) ||
+        ((uint64_t)budget_permille * max_latency_ms < DS2438_PRESENCE_RESET_US))
+        return DS2438_BAD_PARAM;
+
+    DS2438_PresenceStop();
+    watched_pin = pin;
+    multidrop_bus = multidrop;
+    probe_interval_ms = max_latency_ms;
+    budget = budget_permille;
+    presence_callback = callback;
+    presence_context = context;
+    memset(&stats, 0, sizeof(stats));
+    n_devices = 0;
+    has_last_rom = 0;
+    sweep_started = 0;
+    identify = 1;
+    seen_absent = 0;
+    seen_present = 0;
+    last_result = 0;
+    Timebase_Start();
+    last_reset_ms = Timebase_GetMs();
+    refill_us = Timebase_GetUs();
+    tokens_us = DS2438_PRESENCE_BURST_US;
+    previous_hook = OneWire_SetResetHook(DS2438_PresenceResetHook);
+    watcher_started = 1;
+    return DS2438_OK;
+}
+
+void DS2438_PresenceStop(void)
+{
+    if (watcher_started)
+    {
+        OneWire_SetResetHook(previous_hook);
+        watcher_started = 0;
+    }
+}
+
+uint8_t DS2438_PresencePoll(void)
+{
+    if (!watcher_started)
+        return 0;
+    DS2438_PresenceRefill();
+
+    // Reset of the watcher, if no transaction did it
+    if (((Timebase_GetMs() - last_reset_ms) >= probe_interval_ms) && (tokens_us > 0))
+    {
+        uint32_t start_us = Timebase_GetUs();
+        OneWire_TouchReset(watched_pin);
+        DS2438_PresenceCharge(start_us);
+        stats.probes++;
+    }
+
+    if (seen_absent)
+    {
+        // All the devices left, some may already be back
+        while (n_devices > 0)
+            DS2438_PresenceDetach(n_devices - 1);
+        sweep_started = 0;
+        identify = (last_result == 0);
+    }
+    else if (seen_present && (n_devices == 0))
+    {
+        identify = 1;
+    }
+    seen_absent = 0;
+    seen_present = 0;
+
+    // Devices of a multi-drop bus are searched continuously
+    if ((identify || (multidrop_bus && (n_devices > 0))) && (tokens_us > 0))
+    {
+        uint32_t start_us = Timebase_GetUs();
+        if (multidrop_bus)
+            DS2438_PresenceSearch();
+        else
+            DS2438_PresenceIdentifySingle();
+        DS2438_PresenceCharge(start_us);
+    }
+    return n_devices;
+}
+
+uint8_t DS2438_PresenceGetRom(uint8_t index, uint8_t* rom)
+{
+    if (index >= n_devices)
+        return DS2438_BAD_PARAM;
+    memcpy(rom, roms[index], 8);
+    return DS2438_OK;
+}
+
+void DS2438_PresenceGetStats(DS2438_PresenceStats* stats_out)
+{
+    *stats_out = stats;
+}
+
+/* [] END OF FILE */
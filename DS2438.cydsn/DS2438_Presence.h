@@ -0,0 +1,141 @@
+/**
+ * \file DS2438_Presence.h
+ * \brief Hot-plug detection for the DS2438 Library.
+ *
+ * Every 1-Wire transaction starts with a reset, and the presence pulse
+ * answered by the devices tells whether they are still connected. This
+ * module follows the presence pulses of all the resets of the library,
+ * and only issues a reset of its own when the bus was idle for the
+ * detection latency, so a removal is detected at the first reset after
+ * it, at little or no bus cost.
+ *
+ * When devices answer again, the watcher identifies them: one READ ROM
+ * with a single device, or a ROM search on a multi-drop bus, one device
+ * per poll. Devices of a multi-drop bus are also searched continuously,
+ * because the removal of one of them does not change the presence pulse.
+ * The application is notified with a callback, and the page cache of the
+ * blocking API is invalidated when its pin is watched.
+ *
+ * The bus time used by the watcher (its resets, ROM reads and searches)
+ * is kept under a budget, as a fraction of the elapsed time, plus at most
+ * #DS2438_PRESENCE_BURST_US. On a multi-drop bus, a search pass takes
+ * about 16 ms at standard speed, so a sweep of N devices, and the
+ * detection of a change, takes about (N + 1) * 16 ms / budget.
+*/
+#ifndef __DS2438_PRESENCE_H__
+    #define __DS2438_PRESENCE_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Maximum number of devices followed on a multi-drop bus.
+    */
+    #define DS2438_PRESENCE_MAX_DEVICES     4
+
+    /**
+    *   \brief Bus time of a reset, in us, used to check the budget at start.
+    */
+    #define DS2438_PRESENCE_RESET_US        1000
+
+    /**
+    *   \brief Bus time that can be saved up when the watcher is idle, in us.
+    *
+    *   Must be longer than a ROM search pass (about 15 ms at standard speed).
+    */
+    #define DS2438_PRESENCE_BURST_US        20000
+
+    // ===========================================================
+    //                      EVENTS
+    // ===========================================================
+
+    #define DS2438_PRESENCE_DETACHED    0   ///< Device removed
+    #define DS2438_PRESENCE_ATTACHED    1   ///< Device connected, first one or same ROM as the last one removed
+    #define DS2438_PRESENCE_REPLACED    2   ///< Device connected in place of a device with another ROM
+
+    /**
+    *   \brief Function called when a device is attached or detached.
+    *
+    *   \param rom the 8 bytes of the ROM of the device.
+    *   \param event one of the DS2438_PRESENCE_* events.
+    *   \param context argument given to #DS2438_PresenceStart().
+    */
+    typedef void (*DS2438_PresenceCallback)(const uint8_t* rom, uint8_t event, void* context);
+
+    /**
+    *   \brief Statistics of the watcher.
+    */
+    typedef struct {
+        uint32_t probes;            ///< Resets issued by the watcher
+        uint32_t identifications;   ///< ROM reads and search passes
+        uint32_t failures;          ///< ROM reads and search passes with a CRC error
+        uint32_t bus_us;            ///< Bus time used by the watcher
+    } DS2438_PresenceStats;
+
+    // ===========================================================
+    //                      FUNCTIONS
+    // ===========================================================
+
+    /**
+    *   \brief Start watching a bus.
+    *
+    *   A removal is detected within max_latency_ms, plus the interval
+    *   between two calls to #DS2438_PresencePoll(), as long as the budget
+    *   allows a reset per interval. The devices present at start are
+    *   reported as attached by the following polls.
+    *   \param pin 1-Wire interface pin.
+    *   \param multidrop 1 if several devices can be connected to the bus.
+    *   \param max_latency_ms longest bus idle time before the watcher issues a reset.
+    *   \param budget_permille largest share of bus time used by the watcher, per mille.
+    *   \param callback function called on attach and detach, may be NULL.
+    *   \param context argument of the callback.
+    *   \retval #DS2438_OK if the watcher was started.
+    *   \retval #DS2438_BAD_PARAM if the budget does not allow a reset per max_latency_ms.
+    */
+    uint8_t DS2438_PresenceStart(unsigned int pin, uint8_t multidrop, uint32_t max_latency_ms,
+                                 uint16_t budget_permille, DS2438_PresenceCallback callback, void* context);
+
+    /**
+    *   \brief Stop the watcher.
+    */
+    void DS2438_PresenceStop(void);
+
+    /**
+    *   \brief Update the presence of the devices.
+    *
+    *   This function must be called often, e.g. at every iteration of the
+    *   main loop. It processes the resets observed since the last call,
+    *   issues a reset if the bus was idle for the detection latency, and
+    *   identifies new devices, within the budget. Callbacks are called
+    *   from this function.
+    *   \return the number of devices present.
+    */
+    uint8_t DS2438_PresencePoll(void);
+
+    /**
+    *   \brief Get the ROM of a device present on the bus.
+    *
+    *   \param index index of the device, from 0 to the number of devices present minus 1.
+    *   \param rom array of 8 bytes where the ROM will be stored.
+    *   \retval #DS2438_OK if the ROM was stored.
+    *   \retval #DS2438_BAD_PARAM if there is no such device.
+    */
+    uint8_t DS2438_PresenceGetRom(uint8_t index, uint8_t* rom);
+
+    /**
+    *   \brief Get the statistics of the watcher.
+    *
+    *   \param stats pointer to variable where the statistics will be stored.
+    */
+    void DS2438_PresenceGetStats(DS2438_PresenceStats* stats);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
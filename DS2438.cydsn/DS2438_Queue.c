@@ -0,0 +1,202 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 request queue.
+*
+*   Pending requests are kept in a singly linked
+*   list ordered by submission time, so the first
+*   request found for a page is the oldest one.
+*
+**********************************************/
+
+#include "DS2438_Queue.h"
+#include "DS2438.h"
+#include "Timebase.h"
+
+static DS2438_PageRequest* queue_head = NULL;
+static uint32_t queue_window_us = DS2438_QUEUE_WINDOW_US;
+static DS2438_QueueStats queue_stats;
+
+// Deliver the result of a read to a request and update statistics
+static void DS2438_QueueComplete(DS2438_PageRequest* request, uint8_t status, const uint8_t* page_data,
+                                 uint32_t data_us)
+{
+    uint32_t latency_us = Timebase_GetUs() - request->submit_us;
+    uint8_t bucket = 0;
+
+    // Page data is only valid after a successful read
+    if (status == DS2438_OK)
+    {
+        for (uint8_t i = 0; i < 9; i++)
+        {
+            request->page_data[i] = page_data[i];
+        }
+        request->data_us = data_us;
+    }
+    request->status = status;
+    request->state = DS2438_REQUEST_DONE;
+
+    queue_stats.requests++;
+    if (latency_us > queue_stats.max_latency_us)
+    {
+        queue_stats.max_latency_us = latency_us;
+    }
+    // Bucket is the position of the most significant bit
+    while (((latency_us >> 1) != 0) && (bucket < (DS2438_QUEUE_LATENCY_BUCKETS - 1)))
+    {
+        latency_us >>= 1;
+        bucket++;
+    }
+    queue_stats.latency_histogram[bucket]++;
+}
+
+// Look up a page in the cache, with the time at which it was read from the device
+static uint8_t DS2438_QueueLookup(uint8_t page_number, uint32_t max_age_ms, uint8_t* page_data, uint32_t* data_us)
+{
+    DS2438_PageCache* cache = DS2438_GetPageCache();
+    uint8_t status = DS2438_CacheLookupWithMaxAge(cache, page_number, max_age_ms, page_data);
+    if (status == DS2438_OK)
+    {
+        *data_us = Timebase_GetUs() - 1000 * (Timebase_GetMs() - cache->timestamp_ms[page_number]);
+    }
+    return status;
+}
+
+void DS2438_QueueInit(uint32_t window_us)
+{
+    queue_head = NULL;
+    queue_window_us = window_us;
+    queue_stats.requests = 0;
+    queue_stats.attempts = 0;
+    queue_stats.transactions = 0;
+    queue_stats.max_latency_us = 0;
+    for (uint8_t i = 0; i < DS2438_QUEUE_LATENCY_BUCKETS; i++)
+    {
+        queue_stats.latency_histogram[i] = 0;
+    }
+}
+
+uint8_t DS2438_QueueSubmit(DS2438_PageRequest* request, uint8_t page_number, uint32_t max_age_ms)
+{
+    if ((page_number > 0x07) || (request->state == DS2438_REQUEST_PENDING))
+        return DS2438_BAD_PARAM;
+
+    request->page_number = page_number;
+    request->max_age_ms = max_age_ms;
+    request->submit_us = Timebase_GetUs();
+    request->next = NULL;
+
+    // Served by a previous transaction if recent enough
+    uint8_t page_data[9];
+    uint32_t data_us;
+    if (DS2438_QueueLookup(page_number, max_age_ms, page_data, &data_us) == DS2438_OK)
+    {
+        DS2438_QueueComplete(request, DS2438_OK, page_data, data_us);
+        return DS2438_OK;
+    }
+
+    // Append to the tail of the queue
+    request->state = DS2438_REQUEST_PENDING;
+    DS2438_PageRequest** tail = &queue_head;
+    while (*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+    *tail = request;
+    return DS2438_OK;
+}
+
+void DS2438_QueueService(uint8_t flush)
+{
+    for (uint8_t page_number = 0; page_number < 8; page_number++)
+    {
+        // Find oldest request and tightest tolerance for this page
+        DS2438_PageRequest* oldest = NULL;
+        uint32_t max_age_ms = 0xFFFFFFFF;
+        for (DS2438_PageRequest* request = queue_head; request != NULL; request = request->next)
+        {
+            if (request->page_number == page_number)
+            {
+                if (oldest == NULL)
+                {
+                    oldest = request;
+                }
+                if (request->max_age_ms < max_age_ms)
+                {
+                    max_age_ms = request->max_age_ms;
+                }
+            }
+        }
+        if (oldest == NULL)
+            continue;
+        if ((flush == 0) && ((Timebase_GetUs() - oldest->submit_us) < queue_window_us))
+            continue;
+
+        // One read for all the requests of this page
+        uint8_t page_data[9];
+        uint32_t data_us;
+        uint8_t status = DS2438_QueueLookup(page_number, max_age_ms, page_data, &data_us);
+        if (status != DS2438_OK)
+        {
+            queue_stats.attempts++;
+            status = DS2438_ReadPageTimestamped(page_number, page_data, &data_us);
+            if ((status == DS2438_OK) && (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK))
+            {
+                // The read filled the cache with the corrupted page
+                DS2438_CacheInvalidate(DS2438_GetPageCache(), page_number);
+                status = DS2438_CRC_FAIL;
+            }
+            if (status == DS2438_OK)
+            {
+                queue_stats.transactions++;
+            }
+        }
+
+        // Complete and unlink requests
+        DS2438_PageRequest** link = &queue_head;
+        while (*link != NULL)
+        {
+            DS2438_PageRequest* request = *link;
+            if (request->page_number == page_number)
+            {
+                *link = request->next;
+                request->next = NULL;
+                DS2438_QueueComplete(request, status, page_data, data_us);
+            }
+            else
+            {
+                link = &request->next;
+            }
+        }
+    }
+}
+
+void DS2438_QueueGetStats(DS2438_QueueStats* stats)
+{
+    *stats = queue_stats;
+}
+
+uint32_t DS2438_QueueGetLatencyPercentile(const DS2438_QueueStats* stats, uint8_t percentile)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < DS2438_QUEUE_LATENCY_BUCKETS; i++)
+    {
+        total += stats->latency_histogram[i];
+    }
+    if (total == 0)
+        return 0;
+
+    // Number of requests below the percentile, rounded up
+    uint32_t target = (total * percentile + 99) / 100;
+    uint32_t count = 0;
+    for (uint8_t i = 0; i < DS2438_QUEUE_LATENCY_BUCKETS; i++)
+    {
+        count += stats->latency_histogram[i];
+        if (count >= target)
+        {
+            return (2UL << i) - 1;
+        }
+    }
+    return stats->max_latency_us;
+}
+
+/* [] END OF FILE */
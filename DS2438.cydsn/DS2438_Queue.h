@@ -0,0 +1,132 @@
+/**
+ * \file DS2438_Queue.h
+ * \brief Page request queue for the DS2438 Library.
+ *
+ * Different parts of the firmware can submit page reads to this
+ * queue together with a freshness tolerance. A request is completed
+ * immediately if the page cache holds data that are recent enough.
+ * Otherwise, requests for the same page that arrive within the
+ * coalescing window are served by a single bus transaction when
+ * #DS2438_QueueService() is called.
+ *
+ * Requests are owned by the caller and are linked in the queue,
+ * so no dynamic memory is required. The queue must be used from
+ * a single execution context (e.g. the main loop).
+*/
+#ifndef __DS2438_QUEUE_H__
+    #define __DS2438_QUEUE_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Default coalescing window, in microseconds.
+    */
+    #define DS2438_QUEUE_WINDOW_US          2000
+
+    /**
+    *   \brief Number of buckets of the latency histogram.
+    *
+    *   Bucket k counts the requests completed with a latency
+    *   in the range [2^k, 2^(k+1)) microseconds.
+    */
+    #define DS2438_QUEUE_LATENCY_BUCKETS    24
+
+    /**
+    *   \brief Request is not in the queue.
+    */
+    #define DS2438_REQUEST_IDLE             0
+
+    /**
+    *   \brief Request is waiting to be served.
+    */
+    #define DS2438_REQUEST_PENDING          1
+
+    /**
+    *   \brief Request has been completed.
+    */
+    #define DS2438_REQUEST_DONE             2
+
+    /**
+    *   \brief Page read request.
+    */
+    typedef struct DS2438_PageRequest {
+        uint8_t page_number;                ///< Page to be read
+        uint32_t max_age_ms;                ///< Maximum age of the returned data
+        uint8_t page_data[9];               ///< Page data, valid when state is #DS2438_REQUEST_DONE and status is #DS2438_OK
+        uint8_t status;                     ///< Error code of the read, valid when state is #DS2438_REQUEST_DONE
+        uint32_t data_us;                   ///< Time at which the page data were recalled, valid with page_data (to the millisecond when served by the cache)
+        uint8_t state;                      ///< State of the request
+        uint32_t submit_us;                 ///< Time at which the request was submitted
+        struct DS2438_PageRequest* next;    ///< Next request in the queue
+    } DS2438_PageRequest;
+
+    /**
+    *   \brief Statistics of the request queue.
+    */
+    typedef struct {
+        uint32_t requests;                                  ///< Number of completed requests
+        uint32_t attempts;                                  ///< Number of page reads from the device, failed ones included
+        uint32_t transactions;                              ///< Number of successful page reads from the device
+        uint32_t max_latency_us;                            ///< Worst case latency
+        uint32_t latency_histogram[DS2438_QUEUE_LATENCY_BUCKETS];  ///< Latency histogram
+    } DS2438_QueueStats;
+
+    /**
+    *   \brief Initialize the request queue.
+    *
+    *   \param window_us coalescing window, in microseconds.
+    */
+    void DS2438_QueueInit(uint32_t window_us);
+
+    /**
+    *   \brief Submit a page read request.
+    *
+    *   \param request pointer to the request, that must remain valid until it is completed.
+    *   \param page_number the page to be read.
+    *   \param max_age_ms maximum age of the returned data, in milliseconds.
+    *   \retval #DS2438_OK if the request was queued or completed.
+    *   \retval #DS2438_BAD_PARAM if the page number is not valid or the request is already pending.
+    */
+    uint8_t DS2438_QueueSubmit(DS2438_PageRequest* request, uint8_t page_number, uint32_t max_age_ms);
+
+    /**
+    *   \brief Serve pending requests.
+    *
+    *   For each page whose oldest pending request was submitted at least
+    *   one coalescing window ago, a single read is performed and its result
+    *   is delivered to all the pending requests for that page. A read whose
+    *   CRC does not match completes the requests with #DS2438_CRC_FAIL and
+    *   is dropped from the page cache.
+    *   \param flush if not 0, all pending requests are served regardless of the window.
+    */
+    void DS2438_QueueService(uint8_t flush);
+
+    /**
+    *   \brief Get statistics of the request queue.
+    *
+    *   The merge ratio is given by requests / attempts, and the bus cost
+    *   by attempts, since failed reads take the bus too.
+    *   \param stats pointer to structure where statistics will be stored.
+    */
+    void DS2438_QueueGetStats(DS2438_QueueStats* stats);
+
+    /**
+    *   \brief Get a latency percentile from the queue statistics.
+    *
+    *   \param stats pointer to statistics obtained with #DS2438_QueueGetStats().
+    *   \param percentile the percentile to be computed (e.g. 99).
+    *   \return upper bound of the latency percentile, in microseconds.
+    */
+    uint32_t DS2438_QueueGetLatencyPercentile(const DS2438_QueueStats* stats, uint8_t percentile);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
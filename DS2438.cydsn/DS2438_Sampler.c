@@ -0,0 +1,309 @@
+/********************************************
+*
+*   \brief Source code for the synchronized current sampler.
+*
+*   A change of the current register between two reads
+*   at t1 and t2 means that an update happened in (t1, t2].
+*   The window of the last update is projected to the
+*   following updates by adding the estimated period, and
+*   narrowed by intersecting it with such intervals. An
+*   empty intersection means that the phase drifted, and
+*   the window is restarted from the interval. Projected
+*   windows are widened by the error bound of the period.
+*
+*   A read with no change of the current does not give any
+*   information, since the current may be constant.
+*
+*   After a late poll, a read that falls in the window of
+*   an update does not tell if that update is returned:
+*   the read is repeated after the window.
+*
+**********************************************/
+
+#include "DS2438_Sampler.h"
+#include "DS2438.h"
+#include "Timebase.h"
+
+static uint8_t sampler_started = 0;
+
+// Window of the update with index window_index
+static uint8_t has_window;
+static uint32_t window_index;
+static uint32_t window_lo_us;
+static uint32_t window_hi_us;
+static uint32_t period_us;
+static uint32_t period_error_us;
+
+// Window used as reference to estimate the period
+static uint8_t has_anchor;
+static uint32_t anchor_index;
+static uint32_t anchor_us;
+static uint32_t anchor_width_us;
+
+// Last sampled update
+static uint8_t has_sample;
+static uint32_t last_index;
+static uint32_t last_sample_us;
+static uint32_t probed_index;
+
+// Last read
+static uint8_t has_read;
+static uint32_t last_read_us;
+static uint16_t last_current;
+static uint32_t recall_delay_us;
+static uint32_t next_read_us;
+
+static DS2438_SamplerStats stats;
+
+// Window of a following update
+static void DS2438_SamplerProject(uint32_t index, uint32_t* lo_us, uint32_t* hi_us)
+{
+    uint32_t periods = index - window_index;
+    *lo_us = window_lo_us + periods * (period_us - period_error_us);
+    *hi_us = window_hi_us + periods * (period_us + period_error_us);
+}
+
+// Move the window to a following update without narrowing it
+static void DS2438_SamplerMove(uint32_t index)
+{
+    uint32_t lo_us, hi_us;
+    DS2438_SamplerProject(index, &lo_us, &hi_us);
+    window_index = index;
+    window_lo_us = lo_us;
+    window_hi_us = hi_us;
+}
+
+// Intersect the window of an update with the interval in which it happened
+static void DS2438_SamplerNarrow(uint32_t index, uint32_t from_us, uint32_t to_us)
+{
+    uint32_t lo_us, hi_us;
+    DS2438_SamplerProject(index, &lo_us, &hi_us);
+    if ((int32_t)(from_us - lo_us) > 0)
+        lo_us = from_us;
+    if ((int32_t)(to_us - hi_us) < 0)
+        hi_us = to_us;
+    if ((int32_t)(hi_us - lo_us) < 0)
+    {
+        // Update outside of the predicted window
+        lo_us = from_us;
+        hi_us = to_us;
+        has_anchor = 0;
+        period_error_us = DS2438_SAMPLER_PERIOD_TOLERANCE_US;
+        stats.unlocks++;
+    }
+    window_index = index;
+    window_lo_us = lo_us;
+    window_hi_us = hi_us;
+
+    // Estimate the period from the distance to the anchor window. The
+    // error is bounded by the widths of both windows, spread over the
+    // number of periods between them, so it decreases as the distance
+    // grows, up to #DS2438_SAMPLER_ANCHOR_PERIODS.
+    uint32_t width_us = hi_us - lo_us;
+    uint32_t center_us = lo_us + width_us / 2;
+    if (has_anchor == 0)
+    {
+        has_anchor = 1;
+        anchor_index = index;
+        anchor_us = center_us;
+        anchor_width_us = width_us;
+    }
+    else if (index != anchor_index)
+    {
+        uint32_t periods = index - anchor_index;
+        uint32_t error_us = (anchor_width_us + width_us) / (2 * periods) + DS2438_SAMPLER_DRIFT_US;
+        uint32_t estimate_us = (center_us - anchor_us) / periods;
+        if (((error_us < period_error_us) || (periods >= DS2438_SAMPLER_ANCHOR_PERIODS)) &&
+            (estimate_us > (DS2438_SAMPLER_PERIOD_US - DS2438_SAMPLER_PERIOD_TOLERANCE_US)) &&
+            (estimate_us < (DS2438_SAMPLER_PERIOD_US + DS2438_SAMPLER_PERIOD_TOLERANCE_US)))
+        {
+            period_us = estimate_us;
+            period_error_us = error_us;
+        }
+        // Follow the drift of the oscillator: estimate from recent windows only
+        if (periods >= 2 * DS2438_SAMPLER_ANCHOR_PERIODS)
+        {
+            anchor_index = index;
+            anchor_us = center_us;
+            anchor_width_us = width_us;
+        }
+    }
+}
+
+// Schedule the read of the next update to be sampled
+static void DS2438_SamplerSchedule(uint32_t next)
+{
+    uint32_t target_us;
+    if (has_window == 0)
+    {
+        target_us = last_read_us + DS2438_SAMPLER_ACQUIRE_US;
+    }
+    else
+    {
+        uint32_t lo_us, hi_us;
+        DS2438_SamplerProject(next, &lo_us, &hi_us);
+        if (((hi_us - lo_us) > DS2438_SAMPLER_LOCK_WINDOW_US) && (probed_index != next))
+        {
+            // Probe in the middle of the window
+            target_us = lo_us + (hi_us - lo_us) / 2;
+            probed_index = next;
+        }
+        else
+        {
+            target_us = hi_us + DS2438_SAMPLER_GUARD_US;
+        }
+    }
+    // Account for the time from the start of the read to the recall
+    next_read_us = target_us - recall_delay_us;
+}
+
+void DS2438_SamplerStart(void)
+{
+    has_window = 0;
+    has_anchor = 0;
+    has_sample = 0;
+    has_read = 0;
+    period_us = DS2438_SAMPLER_PERIOD_US;
+    period_error_us = DS2438_SAMPLER_PERIOD_TOLERANCE_US;
+    last_index = 0xFFFFFFFF;
+    probed_index = 0xFFFFFFFF;
+    recall_delay_us = 0;
+    next_read_us = Timebase_GetUs();
+    stats.reads = 0;
+    stats.samples = 0;
+    stats.missed = 0;
+    stats.duplicates = 0;
+    stats.probes = 0;
+    stats.unlocks = 0;
+    sampler_started = 1;
+}
+
+uint8_t DS2438_SamplerPoll(DS2438_CurrentSample* sample, uint8_t* ready)
+{
+    uint8_t page_data[9];
+    uint32_t read_us;
+
+    *ready = 0;
+    if (sampler_started == 0)
+        DS2438_SamplerStart();
+    if (!Timebase_IsExpired(next_read_us))
+        return DS2438_OK;
+
+    uint32_t start_us = Timebase_GetUs();
+    uint8_t error = DS2438_ReadPageTimestamped(0x00, page_data, &read_us);
+    if (error != DS2438_OK)
+        return error;
+    if (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK)
+        return DS2438_CRC_FAIL;
+    recall_delay_us = read_us - start_us;
+    stats.reads++;
+
+    uint16_t current = (page_data[6] << 8) | page_data[5];
+    uint8_t changed = (has_read == 1) && (current != last_current);
+    uint8_t deliver = 1;
+    uint32_t index = last_index + 1;
+    uint32_t next = index;
+
+    if (has_window == 0)
+    {
+        if (changed)
+        {
+            has_window = 1;
+            window_index = index;
+            window_lo_us = last_read_us;
+            window_hi_us = read_us;
+        }
+        else if ((has_sample == 1) && ((read_us - last_sample_us) < period_us))
+        {
+            // No update detected yet, sample a constant current once per period
+            deliver = 0;
+            stats.probes++;
+        }
+    }
+    else
+    {
+        uint32_t lo_us, hi_us;
+        uint32_t previous_hi_us = window_hi_us;
+        DS2438_SamplerProject(index, &lo_us, &hi_us);
+        if ((int32_t)(read_us - hi_us) >= 0)
+        {
+            // After the window: account for the updates whose window
+            // passed too, missed by late polls
+            uint32_t next_lo_us, next_hi_us;
+            index += (read_us - hi_us) / (period_us + period_error_us);
+            DS2438_SamplerProject(index, &lo_us, &hi_us);
+            DS2438_SamplerProject(index + 1, &next_lo_us, &next_hi_us);
+            if (((int32_t)(read_us - next_lo_us) >= 0) && ((int32_t)(next_lo_us - hi_us) > 0))
+            {
+                // Inside the window of the following update: it may have
+                // happened or not, read again after its window
+                deliver = 0;
+                next = index + 1;
+            }
+            else if (changed && (index == last_index + 1) && ((int32_t)(last_read_us - previous_hi_us) >= 0))
+                DS2438_SamplerNarrow(index, last_read_us, read_us);
+            else
+                DS2438_SamplerMove(index);
+        }
+        else if ((int32_t)(read_us - lo_us) >= 0)
+        {
+            // Inside the window: a change narrows it, otherwise this was a probe
+            if (changed)
+            {
+                DS2438_SamplerNarrow(index, last_read_us, read_us);
+            }
+            else
+            {
+                deliver = 0;
+                stats.probes++;
+            }
+        }
+        else
+        {
+            // Before the window: a change means the phase drifted
+            if (changed)
+                DS2438_SamplerNarrow(index, last_read_us, read_us);
+            else
+                index = last_index;
+        }
+    }
+    has_read = 1;
+    last_read_us = read_us;
+    last_current = current;
+
+    if (deliver)
+    {
+        if ((has_sample == 1) && (index == last_index))
+        {
+            stats.duplicates++;
+        }
+        else
+        {
+            if (has_sample == 1)
+                stats.missed += index - last_index - 1;
+            has_sample = 1;
+            last_index = index;
+            last_sample_us = read_us;
+            sample->update_index = index;
+            sample->current = current;
+            sample->timestamp_us = ((has_window == 1) && (window_index == index)) ?
+                                   window_lo_us + (window_hi_us - window_lo_us) / 2 : read_us;
+            stats.samples++;
+            *ready = 1;
+        }
+        next = last_index + 1;
+    }
+    DS2438_SamplerSchedule(next);
+    return DS2438_OK;
+}
+
+void DS2438_SamplerGetStats(DS2438_SamplerStats* sampler_stats)
+{
+    stats.period_us = period_us;
+    stats.period_error_us = period_error_us;
+    stats.window_us = (has_window == 1) ? (window_hi_us - window_lo_us) : 0;
+    stats.locked = (has_window == 1) && ((window_hi_us - window_lo_us) <= DS2438_SAMPLER_LOCK_WINDOW_US);
+    *sampler_stats = stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,120 @@
+/**
+ * \file DS2438_Sampler.h
+ * \brief Current sampler synchronized to the DS2438 current A/D.
+ *
+ * When IAD is enabled, the DS2438 updates the current register
+ * 36.41 times per second, with a phase set by its internal oscillator.
+ * This module detects the updates from changes of the current register,
+ * and keeps a window of the time of the last update and an estimate of
+ * the update period. Page 0 is then read once per update, just after
+ * the end of the predicted window, so that every update is returned
+ * exactly once. While the window is wide, an additional probe read in
+ * the middle of the window halves it each time the current changes.
+*/
+#ifndef __DS2438_SAMPLER_H__
+    #define __DS2438_SAMPLER_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Nominal update period of the current register, in microseconds (1/36.41 Hz).
+    */
+    #define DS2438_SAMPLER_PERIOD_US            27465
+
+    /**
+    *   \brief Maximum deviation of the update period from the nominal one, in microseconds (5%).
+    */
+    #define DS2438_SAMPLER_PERIOD_TOLERANCE_US  1400
+
+    /**
+    *   \brief Minimum error of the estimated period, covering oscillator drift, in microseconds.
+    */
+    #define DS2438_SAMPLER_DRIFT_US             10
+
+    /**
+    *   \brief Updates over which the period is estimated, at least, before it follows a newer window.
+    *
+    *   The anchor window of the estimate is moved every twice this number
+    *   of updates, so the estimate follows the drift of the oscillator.
+    */
+    #define DS2438_SAMPLER_ANCHOR_PERIODS       256
+
+    /**
+    *   \brief Width of the update window below which the sampler is locked, in microseconds.
+    */
+    #define DS2438_SAMPLER_LOCK_WINDOW_US       2000
+
+    /**
+    *   \brief Delay between the end of the update window and the read, in microseconds.
+    */
+    #define DS2438_SAMPLER_GUARD_US             500
+
+    /**
+    *   \brief Interval between reads while no update has been detected, in microseconds.
+    */
+    #define DS2438_SAMPLER_ACQUIRE_US           5000
+
+    /**
+    *   \brief Current sample.
+    */
+    typedef struct {
+        uint32_t timestamp_us;      ///< Estimated time of the update of the current register
+        uint32_t update_index;      ///< Index of the update since the sampler was started
+        uint16_t current;           ///< Raw current
+    } DS2438_CurrentSample;
+
+    /**
+    *   \brief Statistics of the sampler.
+    */
+    typedef struct {
+        uint32_t reads;             ///< Page 0 reads
+        uint32_t samples;           ///< Samples returned
+        uint32_t missed;            ///< Updates without a sample, because the sampler was polled late
+        uint32_t duplicates;        ///< Reads returning an update already sampled
+        uint32_t probes;            ///< Reads performed to narrow the update window
+        uint32_t unlocks;           ///< Updates detected outside of the predicted window
+        uint32_t period_us;         ///< Estimated update period
+        uint32_t period_error_us;   ///< Error bound of the estimated period
+        uint32_t window_us;         ///< Width of the update window
+        uint8_t locked;             ///< 1 if the update window is narrower than #DS2438_SAMPLER_LOCK_WINDOW_US
+    } DS2438_SamplerStats;
+
+    /**
+    *   \brief Start the sampler.
+    *
+    *   IAD must be enabled in the device configuration.
+    */
+    void DS2438_SamplerStart(void);
+
+    /**
+    *   \brief Poll the sampler.
+    *
+    *   This function must be called often, e.g. from the main loop. It
+    *   does nothing until the next scheduled read, then it reads page 0
+    *   and returns a sample if the read follows a new update.
+    *   \param sample pointer to variable where the sample will be stored.
+    *   \param ready pointer to variable set to 1 if a sample was stored, 0 otherwise.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_DEV_NOT_FOUND if device is not present on the bus.
+    *   \retval #DS2438_CRC_FAIL if CRC check failed.
+    */
+    uint8_t DS2438_SamplerPoll(DS2438_CurrentSample* sample, uint8_t* ready);
+
+    /**
+    *   \brief Get statistics of the sampler.
+    *
+    *   \param stats pointer to variable where statistics will be stored.
+    */
+    void DS2438_SamplerGetStats(DS2438_SamplerStats* stats);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
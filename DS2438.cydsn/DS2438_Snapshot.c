@@ -0,0 +1,56 @@
+/********************************************
+*
+*   \brief Source code for the page 0 snapshot.
+*
+*   Snapshot of generation g is stored in
+*   buffer g % 2. While generation g is current,
+*   the writer fills buffer (g + 1) % 2, so a
+*   reader of generation g can only see a torn
+*   copy if the generation changed during the copy.
+*
+**********************************************/
+
+#include "DS2438_Snapshot.h"
+#include "Timebase.h"
+#include "project.h"
+
+static DS2438_Snapshot buffers[2];
+static volatile uint32_t generation = 0;
+
+void DS2438_SnapshotPublish(const uint8_t* page_data)
+{
+    uint32_t next = generation + 1;
+    DS2438_Snapshot* snapshot = &buffers[next & 0x01];
+
+    snapshot->timestamp_ms = Timebase_GetMs();
+    snapshot->status = page_data[0];
+    snapshot->temperature = (int16_t)((page_data[2] << 8) | page_data[1]) / 256.0;
+    snapshot->voltage = ((page_data[4] << 8) | page_data[3]) / 100.0;
+    snapshot->current = (int16_t)((page_data[6] << 8) | page_data[5]) / (4096. * DS2438_SENSE_RESISTOR);
+    // Buffer must be complete before it is published
+    DS2438_BARRIER();
+    generation = next;
+}
+
+uint32_t DS2438_SnapshotGeneration(void)
+{
+    return generation;
+}
+
+uint32_t DS2438_SnapshotRead(DS2438_Snapshot* snapshot)
+{
+    uint32_t first, last;
+    do
+    {
+        first = generation;
+        if (first == 0)
+            return 0;
+        DS2438_BARRIER();
+        *snapshot = buffers[first & 0x01];
+        DS2438_BARRIER();
+        last = generation;
+    } while (last != first);
+    return first;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,70 @@
+/**
+ * \file DS2438_Snapshot.h
+ * \brief Page 0 snapshot publication for the DS2438 Library.
+ *
+ * Every page 0 read from the device with a valid CRC is decoded and
+ * published to one of two buffers, together with a generation counter.
+ * The writer always fills the buffer that readers are not directed to,
+ * then increments the generation. Readers copy the buffer of the current
+ * generation and check that the generation did not change meanwhile.
+ *
+ * Readers never wait for the writer, so they can run in any context,
+ * including an interrupt that preempts the writer. A reader retries only
+ * if a new snapshot was published while it was copying, which can not
+ * happen more than once per sample period.
+*/
+#ifndef __DS2438_SNAPSHOT_H__
+    #define __DS2438_SNAPSHOT_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Decoded page 0 snapshot.
+    */
+    typedef struct {
+        uint32_t timestamp_ms;      ///< Time at which page 0 was read
+        float voltage;              ///< Voltage of the input selected by the AD bit, in V
+        float temperature;          ///< Temperature, in degrees Celsius
+        float current;              ///< Current, in A
+        uint8_t status;             ///< Status/configuration register
+    } DS2438_Snapshot;
+
+    /**
+    *   \brief Publish a page 0 snapshot.
+    *
+    *   This function is called by the library for every page 0 read
+    *   with a valid CRC. It must be called from a single context.
+    *   \param page_data the 9 bytes of page 0 read from the device.
+    */
+    void DS2438_SnapshotPublish(const uint8_t* page_data);
+
+    /**
+    *   \brief Get the generation of the last published snapshot.
+    *
+    *   The generation is incremented at every publication, so it can be
+    *   compared with the one returned by #DS2438_SnapshotRead() to know
+    *   whether new data are available.
+    *   \return the generation, 0 if no snapshot was published yet.
+    */
+    uint32_t DS2438_SnapshotGeneration(void);
+
+    /**
+    *   \brief Read the last published snapshot.
+    *
+    *   This function can be called from any context.
+    *   \param snapshot pointer to variable where the snapshot will be stored.
+    *   \return the generation of the snapshot, 0 if no snapshot was published yet.
+    */
+    uint32_t DS2438_SnapshotRead(DS2438_Snapshot* snapshot);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,55 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 storage.
+*
+*   The emulated EEPROM is the Em_EEPROM component
+*   instance of the design, named Em_EEPROM. The
+*   flash area it uses is reserved in this file,
+*   aligned to a flash row, as its datasheet shows.
+*
+**********************************************/
+
+#include "DS2438_Storage.h"
+#include "project.h"
+#include <stdint.h>
+
+#if (DS2438_STORAGE_SIZE > Em_EEPROM_EEPROM_SIZE)
+    #error "The EEPROM size of the Em_EEPROM component is smaller than DS2438_STORAGE_SIZE"
+#endif
+
+// Flash area of the emulated EEPROM
+CY_ALIGN(CY_EM_EEPROM_FLASH_SIZEOF_ROW)
+static const uint8_t storage_flash[Em_EEPROM_PHYSICAL_SIZE] = {0};
+
+static uint8_t storage_started = 0;
+
+uint8_t DS2438_StorageStart(void)
+{
+    if (storage_started == 0)
+    {
+        if (Em_EEPROM_Init((uint32_t)(uintptr_t)storage_flash) != CY_EM_EEPROM_SUCCESS)
+            return DS2438_ERROR;
+        storage_started = 1;
+    }
+    return DS2438_OK;
+}
+
+uint8_t DS2438_StorageRead(uint32_t offset, void* data, uint32_t size)
+{
+    if ((storage_started == 0) || ((offset + size) > DS2438_STORAGE_SIZE))
+        return DS2438_ERROR;
+    if (Em_EEPROM_Read(offset, data, size) != CY_EM_EEPROM_SUCCESS)
+        return DS2438_ERROR;
+    return DS2438_OK;
+}
+
+uint8_t DS2438_StorageWrite(uint32_t offset, const void* data, uint32_t size)
+{
+    if ((storage_started == 0) || ((offset + size) > DS2438_STORAGE_SIZE))
+        return DS2438_ERROR;
+    if (Em_EEPROM_Write(offset, (void*)data, size) != CY_EM_EEPROM_SUCCESS)
+        return DS2438_ERROR;
+    return DS2438_OK;
+}
+
+/* [] END OF FILE */
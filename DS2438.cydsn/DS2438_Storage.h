@@ -0,0 +1,106 @@
+/**
+ * \file DS2438_Storage.h
+ * \brief Non-volatile storage for the DS2438 Library.
+ *
+ * This module stores the data of the library that must survive
+ * resets in the emulated EEPROM of the Em_EEPROM component instance
+ * of the design, named Em_EEPROM, through its API (Em_EEPROM_Init(),
+ * Em_EEPROM_Read() and Em_EEPROM_Write(), which use the
+ * Em_EEPROM_Dynamic library). The size and the wear leveling of the
+ * emulated EEPROM are parameters of the instance: EEPROM size at least
+ * #DS2438_STORAGE_SIZE (checked at build time), wear leveling factor 2,
+ * blocking write, no redundant copy. The emulated EEPROM is split in
+ * regions, one for each user of the storage.
+*/
+#ifndef __DS2438_STORAGE_H__
+    #define __DS2438_STORAGE_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    // ===========================================================
+    //                      STORAGE LAYOUT
+    // ===========================================================
+
+    /**
+    *   \brief Offset of the extended accumulators record.
+    */
+    #define DS2438_STORAGE_ACCUMULATORS_OFFSET  0
+
+    /**
+    *   \brief Size of the extended accumulators record.
+    */
+    #define DS2438_STORAGE_ACCUMULATORS_SIZE    32
+
+    /**
+    *   \brief Offset of the sample log.
+    */
+    #define DS2438_STORAGE_LOG_OFFSET           (DS2438_STORAGE_ACCUMULATORS_OFFSET + DS2438_STORAGE_ACCUMULATORS_SIZE)
+
+    /**
+    *   \brief Size of the sample log (8 slots of 128 bytes).
+    */
+    #define DS2438_STORAGE_LOG_SIZE             1024
+
+    /**
+    *   \brief Offset of the boot configuration record.
+    */
+    #define DS2438_STORAGE_BOOT_OFFSET          (DS2438_STORAGE_LOG_OFFSET + DS2438_STORAGE_LOG_SIZE)
+
+    /**
+    *   \brief Size of the boot configuration record.
+    */
+    #define DS2438_STORAGE_BOOT_SIZE            48
+
+    /**
+    *   \brief Size of the emulated EEPROM, in bytes.
+    */
+    #define DS2438_STORAGE_SIZE                 (DS2438_STORAGE_BOOT_OFFSET + DS2438_STORAGE_BOOT_SIZE)
+
+    // ===========================================================
+    //                      STORAGE FUNCTIONS
+    // ===========================================================
+
+    /**
+    *   \brief Start the storage.
+    *
+    *   This function initializes the emulated EEPROM. Calling this
+    *   function more than once has no effect.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if the emulated EEPROM could not be initialized.
+    */
+    uint8_t DS2438_StorageStart(void);
+
+    /**
+    *   \brief Read data from the storage.
+    *
+    *   \param offset offset of the data in the storage.
+    *   \param data pointer to buffer where data will be stored.
+    *   \param size number of bytes to be read.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if data could not be read.
+    */
+    uint8_t DS2438_StorageRead(uint32_t offset, void* data, uint32_t size);
+
+    /**
+    *   \brief Write data to the storage.
+    *
+    *   This function blocks until data are written to flash.
+    *   \param offset offset of the data in the storage.
+    *   \param data pointer to data to be written.
+    *   \param size number of bytes to be written.
+    *   \retval #DS2438_OK if no error was generated.
+    *   \retval #DS2438_ERROR if data could not be written.
+    */
+    uint8_t DS2438_StorageWrite(uint32_t offset, const void* data, uint32_t size);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
@@ -1,167 +1,754 @@
-/* ========================================
- *
- * Copyright YOUR COMPANY, THE YEAR
- * All Rights Reserved
- * UNPUBLISHED, LICENSED SOFTWARE.
- *
- * CONFIDENTIAL AND PROPRIETARY INFORMATION
- * WHICH IS THE PROPERTY OF your company.
- *
- * ========================================
-*/
-#include "project.h"
-#include "OneWire.h"
-
-// Values of delays for 1-Wire communication protocol.
-
-#define DELAY_A 6
-#define DELAY_B 64
-#define DELAY_C 60
-#define DELAY_D 6
-#define DELAY_E 9
-#define DELAY_F 55
-#define DELAY_G 0
-#define DELAY_H 480
-#define DELAY_I 70
-#define DELAY_J 410
-
-//-----------------------------------------------------------------------------
-// Generate a 1-Wire reset, return 1 if no presence detect was found,
-// return 0 otherwise.
-int OneWire_TouchReset(unsigned int pin)
-{
-    int result;
-
-    CyDelayUs(DELAY_G);
-    CyPins_ClearPin(pin); // Drives DQ low
-    CyDelayUs(DELAY_H);
-    CyPins_SetPin(pin); // Releases the bus
-    CyDelayUs(DELAY_I);
-    result =  CyPins_ReadPin(pin) > 0 ? 1 : 0; // Sample for presence pulse from slave
-    CyDelayUs(DELAY_J); // Complete the reset sequence recovery
-    return result; // Return sample presence pulse result
-}
-
-//-----------------------------------------------------------------------------
-// Send a 1-Wire write bit. Provide 10us recovery time.
-//
-void OneWire_WriteBit(unsigned int pin, int bit)
-{
-    if (bit)
-    {
-        // Write '1' bit
-        CyPins_ClearPin(pin); // Drives DQ low
-        CyDelayUs(DELAY_A);
-        CyPins_SetPin(pin); // Releases the bus
-        CyDelayUs(DELAY_B); // Complete the time slot and 10us recovery
-    }
-    else
-    {
-        // Write '0' bit
-        CyPins_ClearPin(pin); // Drives DQ low
-        CyDelayUs(DELAY_C);
-        CyPins_SetPin(pin); // Releases the bus
-        CyDelayUs(DELAY_D);
-    }
-}
-
-//-----------------------------------------------------------------------------
-// Read a bit from the 1-Wire bus and return it. Provide 10us recovery time.
-//
-int OneWire_ReadBit(unsigned int pin)
-{
-    int result;
-
-    CyPins_ClearPin(pin); // Drives DQ low
-    CyDelayUs(DELAY_A); // A
-    CyPins_SetPin(pin); // Releases the bus
-    //OneWire_TickDelay(9); // E
-    CyDelayUs(DELAY_E);
-    result =  (CyPins_ReadPin(pin)>0) ? 0x01 : 0x00; // Sample the bit value from the slave
-    CyDelayUs(DELAY_F); // Complete the time slot and 10us recovery // F
-
-    return result;
-}
-
-//-----------------------------------------------------------------------------
-// Write 1-Wire data byte
-//
-void OneWire_WriteByte(unsigned int pin, int data)
-{
-    int loop;
-
-    // Loop to write each bit in the byte, LS-bit first
-    for (loop = 0; loop < 8; loop++)
-    {
-        OneWire_WriteBit(pin, data & 0x01);
-
-        // shift the data byte for the next bit
-        data >>= 1;
-    }
-    
-}
-
-//-----------------------------------------------------------------------------
-// Read 1-Wire data byte and return it
-//
-int OneWire_ReadByte(unsigned int pin)
-{
-    
-    int loop, result=0;
-
-    for (loop = 0; loop < 8; loop++)
-    {
-        // shift the result to get it ready for the next bit
-        result >>= 1;
-
-        // if result is one, then set MS bit
-        if (OneWire_ReadBit(pin))
-            result |= 0x80;
-    }
-    return result;
-}
-
-//-----------------------------------------------------------------------------
-// Write a 1-Wire data byte and return the sampled result.
-//
-int OneWire_TouchByte(unsigned int pin, int data)
-{
-    int loop, result=0;
-
-    for (loop = 0; loop < 8; loop++)
-    {
-        // shift the result to get it ready for the next bit
-        result >>= 1;
-
-        // If sending a '1' then read a bit else write a '0'
-        if (data & 0x01)
-        {
-            if (OneWire_ReadBit(pin))
-                    result |= 0x80;
-        }
-        else
-            OneWire_WriteBit(pin, 0);
-
-        // shift the data byte for the next bit
-        data >>= 1;
-    }
-    return result;
-}
-
-//-----------------------------------------------------------------------------
-// Write a block 1-Wire data bytes and return the sampled result in the same
-// buffer.
-//
-void OneWire_Block(unsigned int pin, unsigned char *data, int data_len)
-{
-    int loop;
-
-    for (loop = 0; loop < data_len; loop++)
-    {
-        data[loop] = OneWire_TouchByte(pin, data[loop]);
-    }
-}
-
-
-
-/* [] END OF FILE */
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "project.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <string.h>
+
+// Length of the window in which the line is oversampled after
+// the reset pulse, covering the presence pulse (tPDH + tPDL max).
+
+#define ONEWIRE_DIAG_WINDOW_US 400
+
+// Constant timing profiles, stored in flash. The delays are defined in
+// OneWire.h, so that DS2438.hpp uses the same ones.
+static const OneWire_Timing profile_table[ONEWIRE_PROFILE_CUSTOM] = {
+    {ONEWIRE_TIMING_STANDARD},
+    {ONEWIRE_TIMING_SHORT_TRACE},
+    {ONEWIRE_TIMING_LONG_LINE}
+};
+
+// Custom timing profile, set by calibration.
+static OneWire_Timing custom_timing = {ONEWIRE_TIMING_STANDARD};
+
+// Profiles attached to buses. Unattached buses use the standard profile.
+static struct {
+    unsigned int pin;
+    uint8_t profile;
+} bus_table[ONEWIRE_MAX_BUSES];
+static uint8_t n_buses = 0;
+
+// Last resolved bus, so that consecutive calls on the same pin
+// do not scan the bus table.
+static unsigned int last_pin = 0;
+static const OneWire_Timing* last_timing = NULL;
+
+// Number of reset pulses generated so far.
+static uint32_t reset_count = 0;
+
+// Function called after every reset pulse.
+static OneWire_ResetHook reset_hook = NULL;
+
+//-----------------------------------------------------------------------------
+// Return the timing of a profile.
+//
+static const OneWire_Timing* OneWire_ProfileTiming(uint8_t profile)
+{
+    if (profile == ONEWIRE_PROFILE_CUSTOM)
+        return &custom_timing;
+    return &profile_table[profile];
+}
+
+//-----------------------------------------------------------------------------
+// Return the timing of the profile attached to a bus.
+//
+static const OneWire_Timing* OneWire_BusTiming(unsigned int pin)
+{
+    if ((last_timing != NULL) && (pin == last_pin))
+        return last_timing;
+
+    last_pin = pin;
+    last_timing = &profile_table[ONEWIRE_PROFILE_STANDARD];
+    for (uint8_t bus = 0; bus < n_buses; bus++)
+    {
+        if (bus_table[bus].pin == pin)
+            last_timing = OneWire_ProfileTiming(bus_table[bus].profile);
+    }
+    return last_timing;
+}
+
+#if ONEWIRE_TRACE
+
+// Payload length of each record type.
+static const uint8_t trace_payload[8] = {0, 1, 1, 2, 0, 0, 4, 20};
+
+// Ring buffer of whole records, from trace_tail for trace_used bytes.
+static uint8_t trace_ring[ONEWIRE_TRACE_SIZE];
+static uint16_t trace_tail = 0;
+static uint16_t trace_used = 0;
+static uint8_t trace_enabled = 0;
+
+// Start of the last record, and pin described by the last pin record.
+// trace_synced is cleared when the following records need new pin and
+// timing records to be decoded.
+static uint32_t trace_last_us = 0;
+static unsigned int trace_pin = 0;
+static uint8_t trace_synced = 0;
+
+static uint32_t trace_records = 0;
+static uint32_t trace_overwritten = 0;
+
+//-----------------------------------------------------------------------------
+// Append a varint to a record.
+//
+static uint8_t OneWire_TraceVarint(uint8_t* record, uint32_t value)
+{
+    uint8_t length = 0;
+    while (value >= 0x80)
+    {
+        record[length++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    record[length++] = value;
+    return length;
+}
+
+//-----------------------------------------------------------------------------
+// Return the length of the record at a position of the ring buffer.
+//
+static uint8_t OneWire_TraceLength(uint16_t position)
+{
+    uint8_t length = 1 + trace_payload[trace_ring[position] & 0x07];
+    for (uint8_t varint = 0; varint < 2; varint++)
+    {
+        do
+        {
+            position = (position + 1) % ONEWIRE_TRACE_SIZE;
+            length++;
+        } while (trace_ring[position] & 0x80);
+    }
+    return length;
+}
+
+//-----------------------------------------------------------------------------
+// Write a record started at start_us, overwriting the oldest ones if needed.
+//
+static void OneWire_TraceRecord(uint32_t start_us, uint8_t header, const uint8_t* payload)
+{
+    uint8_t record[ONEWIRE_TRACE_MAX_RECORD];
+    uint8_t length = 0;
+
+    record[length++] = header;
+    length += OneWire_TraceVarint(&record[length], start_us - trace_last_us);
+    length += OneWire_TraceVarint(&record[length], Timebase_GetUs() - start_us);
+    for (uint8_t i = 0; i < trace_payload[header & 0x07]; i++)
+    {
+        record[length++] = payload[i];
+    }
+    trace_last_us = start_us;
+
+    while ((ONEWIRE_TRACE_SIZE - trace_used) < length)
+    {
+        uint8_t dropped = OneWire_TraceLength(trace_tail);
+        trace_tail = (trace_tail + dropped) % ONEWIRE_TRACE_SIZE;
+        trace_used -= dropped;
+        trace_overwritten++;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        trace_ring[(trace_tail + trace_used) % ONEWIRE_TRACE_SIZE] = record[i];
+        trace_used++;
+    }
+    trace_records++;
+}
+
+//-----------------------------------------------------------------------------
+// Return the start time of a traced operation, writing the pin and timing
+// records first if needed.
+//
+static uint32_t OneWire_TraceBegin(unsigned int pin)
+{
+    uint32_t now_us = Timebase_GetUs();
+    if ((trace_synced == 0) || (pin != trace_pin))
+    {
+        uint8_t payload[20];
+        const uint16_t* delays = &OneWire_BusTiming(pin)->a;
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            payload[i] = (pin >> (8 * i)) & 0xFF;
+        }
+        OneWire_TraceRecord(now_us, ONEWIRE_TRACE_PIN, payload);
+        for (uint8_t i = 0; i < 10; i++)
+        {
+            payload[2 * i] = delays[i] & 0xFF;
+            payload[2 * i + 1] = delays[i] >> 8;
+        }
+        OneWire_TraceRecord(now_us, ONEWIRE_TRACE_TIMING, payload);
+        trace_pin = pin;
+        trace_synced = 1;
+    }
+    return now_us;
+}
+
+// The start time is taken before the operation and the record is
+// written after it, so slot timing is not affected by the trace.
+#define TRACE_BEGIN(pin) uint32_t trace_start_us = trace_enabled ? OneWire_TraceBegin(pin) : 0
+#define TRACE_END(type, value, payload) \
+    do { if (trace_enabled) OneWire_TraceRecord(trace_start_us, (type) | ((value) << 4), (payload)); } while (0)
+#define TRACE_UNSYNC() (trace_synced = 0)
+
+#else
+
+#define TRACE_BEGIN(pin)
+#define TRACE_END(type, value, payload)
+#define TRACE_UNSYNC()
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Generate a 1-Wire reset with the given timing.
+//
+static int OneWire_TouchResetTimed(unsigned int pin, const OneWire_Timing* t)
+{
+    int result;
+
+    reset_count++;
+    CyDelayUs(t->g);
+    CyPins_ClearPin(pin); // Drives DQ low
+    CyDelayUs(t->h);
+    CyPins_SetPin(pin); // Releases the bus
+    CyDelayUs(t->i);
+    result =  CyPins_ReadPin(pin) > 0 ? 1 : 0; // Sample for presence pulse from slave
+    CyDelayUs(t->j); // Complete the reset sequence recovery
+    return result; // Return sample presence pulse result
+}
+
+//-----------------------------------------------------------------------------
+// Send a 1-Wire write bit with the given timing.
+//
+static void OneWire_WriteBitTimed(unsigned int pin, int bit, const OneWire_Timing* t)
+{
+    if (bit)
+    {
+        // Write '1' bit
+        CyPins_ClearPin(pin); // Drives DQ low
+        CyDelayUs(t->a);
+        CyPins_SetPin(pin); // Releases the bus
+        CyDelayUs(t->b); // Complete the time slot and recovery
+    }
+    else
+    {
+        // Write '0' bit
+        CyPins_ClearPin(pin); // Drives DQ low
+        CyDelayUs(t->c);
+        CyPins_SetPin(pin); // Releases the bus
+        CyDelayUs(t->d);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Read a bit from the 1-Wire bus with the given timing.
+//
+static int OneWire_ReadBitTimed(unsigned int pin, const OneWire_Timing* t)
+{
+    int result;
+
+    CyPins_ClearPin(pin); // Drives DQ low
+    CyDelayUs(t->a); // A
+    CyPins_SetPin(pin); // Releases the bus
+    CyDelayUs(t->e); // E
+    result =  (CyPins_ReadPin(pin)>0) ? 0x01 : 0x00; // Sample the bit value from the slave
+    CyDelayUs(t->f); // Complete the time slot and recovery // F
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Generate a 1-Wire reset, return 1 if no presence detect was found,
+// return 0 otherwise.
+int OneWire_TouchReset(unsigned int pin)
+{
+    TRACE_BEGIN(pin);
+    int result = OneWire_TouchResetTimed(pin, OneWire_BusTiming(pin));
+    TRACE_END(ONEWIRE_TRACE_RESET, result == 0, NULL);
+    if (reset_hook != NULL)
+        reset_hook(pin, result);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Send a 1-Wire write bit. Provide recovery time of the bus profile.
+//
+void OneWire_WriteBit(unsigned int pin, int bit)
+{
+    TRACE_BEGIN(pin);
+    OneWire_WriteBitTimed(pin, bit, OneWire_BusTiming(pin));
+    TRACE_END(ONEWIRE_TRACE_WRITE_BIT, bit != 0, NULL);
+}
+
+//-----------------------------------------------------------------------------
+// Read a bit from the 1-Wire bus and return it. Provide recovery time
+// of the bus profile.
+//
+int OneWire_ReadBit(unsigned int pin)
+{
+    TRACE_BEGIN(pin);
+    int result = OneWire_ReadBitTimed(pin, OneWire_BusTiming(pin));
+    TRACE_END(ONEWIRE_TRACE_READ_BIT, result, NULL);
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Write 1-Wire data byte
+//
+void OneWire_WriteByte(unsigned int pin, int data)
+{
+    int loop;
+    const OneWire_Timing* t = OneWire_BusTiming(pin);
+    TRACE_BEGIN(pin);
+    uint8_t written = data;
+
+    // Loop to write each bit in the byte, LS-bit first
+    for (loop = 0; loop < 8; loop++)
+    {
+        OneWire_WriteBitTimed(pin, data & 0x01, t);
+
+        // shift the data byte for the next bit
+        data >>= 1;
+    }
+    TRACE_END(ONEWIRE_TRACE_WRITE, 0, &written);
+    (void)written;
+}
+
+//-----------------------------------------------------------------------------
+// Read 1-Wire data byte and return it
+//
+int OneWire_ReadByte(unsigned int pin)
+{
+    
+    int loop, result=0;
+    const OneWire_Timing* t = OneWire_BusTiming(pin);
+    TRACE_BEGIN(pin);
+
+    for (loop = 0; loop < 8; loop++)
+    {
+        // shift the result to get it ready for the next bit
+        result >>= 1;
+
+        // if result is one, then set MS bit
+        if (OneWire_ReadBitTimed(pin, t))
+            result |= 0x80;
+    }
+    TRACE_END(ONEWIRE_TRACE_READ, 0, ((const uint8_t[]){result}));
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Write a 1-Wire data byte and return the sampled result.
+//
+int OneWire_TouchByte(unsigned int pin, int data)
+{
+    int loop, result=0;
+    const OneWire_Timing* t = OneWire_BusTiming(pin);
+    TRACE_BEGIN(pin);
+    uint8_t touched[2] = {data, 0};
+
+    for (loop = 0; loop < 8; loop++)
+    {
+        // shift the result to get it ready for the next bit
+        result >>= 1;
+
+        // If sending a '1' then read a bit else write a '0'
+        if (data & 0x01)
+        {
+            if (OneWire_ReadBitTimed(pin, t))
+                    result |= 0x80;
+        }
+        else
+            OneWire_WriteBitTimed(pin, 0, t);
+
+        // shift the data byte for the next bit
+        data >>= 1;
+    }
+    touched[1] = result;
+    TRACE_END(ONEWIRE_TRACE_TOUCH, 0, touched);
+    (void)touched;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+// Write a block 1-Wire data bytes and return the sampled result in the same
+// buffer.
+//
+void OneWire_Block(unsigned int pin, unsigned char *data, int data_len)
+{
+    int loop;
+
+    for (loop = 0; loop < data_len; loop++)
+    {
+        data[loop] = OneWire_TouchByte(pin, data[loop]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Compute the CRC8 of ROMs and scratchpads.
+//
+uint8_t OneWire_Crc8(const uint8_t* data, uint8_t length)
+{
+    uint8_t crc = 0;
+    for (uint8_t n = 0; n < length; n++)
+    {
+        uint8_t byte = data[n];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+//-----------------------------------------------------------------------------
+// Update the CRC16 used by memory devices with some bytes.
+//
+uint16_t OneWire_Crc16(const uint8_t* data, uint8_t length, uint16_t crc)
+{
+    for (uint8_t n = 0; n < length; n++)
+    {
+        crc ^= data[n];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            if (crc & 0x01)
+                crc = (crc >> 1) ^ 0xA001;
+            else
+                crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+//-----------------------------------------------------------------------------
+// Check a ROM read from the bus, a shorted line reads all zeros.
+//
+int OneWire_CheckRom(const uint8_t* rom)
+{
+    if ((rom[0] == 0x00) || (OneWire_Crc8(rom, 7) != rom[7]))
+        return ONEWIRE_SEARCH_BAD_ROM;
+    return ONEWIRE_SEARCH_OK;
+}
+
+//-----------------------------------------------------------------------------
+// One pass of the ROM search, from the ROM found by the previous one.
+//
+int OneWire_SearchPass(unsigned int pin, uint8_t* rom, uint8_t* last_discrepancy)
+{
+    uint8_t found[8] = {0};
+    uint8_t last_zero = 0;
+
+    if (OneWire_TouchReset(pin) != 0)
+        return ONEWIRE_SEARCH_NO_DEVICE;
+    OneWire_WriteByte(pin, ONEWIRE_SEARCH_ROM);
+    for (uint8_t bit = 1; bit <= 64; bit++)
+    {
+        uint8_t mask = 1 << ((bit - 1) % 8);
+        uint8_t index = (bit - 1) / 8;
+        int id_bit = OneWire_ReadBit(pin);
+        int complement = OneWire_ReadBit(pin);
+        uint8_t direction;
+        if (id_bit && complement)
+        {
+            // No device answered
+            return ONEWIRE_SEARCH_NO_DEVICE;
+        }
+        if (id_bit != complement)
+        {
+            direction = id_bit;
+        }
+        else
+        {
+            // Discrepancy: devices with both values
+            if (bit < *last_discrepancy)
+                direction = ((rom[index] & mask) != 0);
+            else
+                direction = (bit == *last_discrepancy);
+            if (direction == 0)
+                last_zero = bit;
+        }
+        if (direction)
+            found[index] |= mask;
+        OneWire_WriteBit(pin, direction);
+    }
+    if (OneWire_CheckRom(found) != ONEWIRE_SEARCH_OK)
+        return ONEWIRE_SEARCH_BAD_ROM;
+    memcpy(rom, found, 8);
+    *last_discrepancy = last_zero;
+    return ONEWIRE_SEARCH_OK;
+}
+
+//-----------------------------------------------------------------------------
+// Return the number of reset pulses generated so far.
+//
+uint32_t OneWire_GetResetCount(void)
+{
+    return reset_count;
+}
+
+//-----------------------------------------------------------------------------
+// Set the function called after every reset pulse.
+//
+OneWire_ResetHook OneWire_SetResetHook(OneWire_ResetHook hook)
+{
+    OneWire_ResetHook previous = reset_hook;
+    reset_hook = hook;
+    return previous;
+}
+
+//-----------------------------------------------------------------------------
+// Attach a timing profile to a bus.
+//
+int OneWire_AttachProfile(unsigned int pin, uint8_t profile)
+{
+    uint8_t bus;
+
+    if (profile >= ONEWIRE_N_PROFILES)
+        return 1;
+    for (bus = 0; bus < n_buses; bus++)
+    {
+        if (bus_table[bus].pin == pin)
+            break;
+    }
+    if (bus == n_buses)
+    {
+        if (n_buses == ONEWIRE_MAX_BUSES)
+            return 1;
+        bus_table[bus].pin = pin;
+        n_buses++;
+    }
+    bus_table[bus].profile = profile;
+    // Force next lookup to scan the bus table
+    last_timing = NULL;
+    TRACE_UNSYNC();
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Get the timing of a profile.
+//
+void OneWire_GetProfileTiming(uint8_t profile, OneWire_Timing* timing)
+{
+    if (profile < ONEWIRE_N_PROFILES)
+        *timing = *OneWire_ProfileTiming(profile);
+}
+
+//-----------------------------------------------------------------------------
+// Get the timing used on a bus.
+//
+void OneWire_GetBusTiming(unsigned int pin, OneWire_Timing* timing)
+{
+    *timing = *OneWire_BusTiming(pin);
+}
+
+//-----------------------------------------------------------------------------
+// Set the timing of the custom profile.
+//
+void OneWire_SetCustomTiming(const OneWire_Timing* timing)
+{
+    custom_timing = *timing;
+    TRACE_UNSYNC();
+}
+
+//-----------------------------------------------------------------------------
+// Return microseconds elapsed since a SysTick value. Only valid for
+// intervals shorter than one SysTick period (1ms).
+//
+static uint32_t OneWire_ElapsedUs(uint32_t start_ticks)
+{
+    uint32_t reload = CySysTickGetReload();
+    uint32_t now = CySysTickGetValue();
+    uint32_t ticks;
+
+    // SysTick counts down
+    if (start_ticks >= now)
+        ticks = start_ticks - now;
+    else
+        ticks = start_ticks + (reload + 1) - now;
+    return (ticks * 1000) / (reload + 1);
+}
+
+//-----------------------------------------------------------------------------
+// Release the line and return the time it takes to read high,
+// or ONEWIRE_DIAG_WINDOW_US if it does not.
+//
+static uint16_t OneWire_MeasureRise(unsigned int pin)
+{
+    uint32_t start_ticks, elapsed_us;
+
+    CyPins_SetPin(pin); // Releases the bus
+    start_ticks = CySysTickGetValue();
+    do
+    {
+        elapsed_us = OneWire_ElapsedUs(start_ticks);
+        if (CyPins_ReadPin(pin) > 0)
+            return elapsed_us;
+    } while (elapsed_us < ONEWIRE_DIAG_WINDOW_US);
+    return ONEWIRE_DIAG_WINDOW_US;
+}
+
+//-----------------------------------------------------------------------------
+// Oversample the line after reset and slots and fill the health report.
+//
+int OneWire_Diagnose(unsigned int pin, OneWire_LineReport* report)
+{
+    const OneWire_Timing* t = &profile_table[ONEWIRE_PROFILE_STANDARD];
+    uint32_t start_ticks, elapsed_us;
+    uint8_t interrupts, level, last_level;
+
+    report->presence_start_us = 0;
+    report->presence_width_us = 0;
+    report->slot_rise_us = 0;
+    report->flags = 0;
+
+    // Reset pulse followed by oversampling of the presence pulse
+    interrupts = CyEnterCriticalSection();
+    reset_count++;
+    CyPins_ClearPin(pin); // Drives DQ low
+    CyDelayUs(t->h);
+    start_ticks = CySysTickGetValue();
+    report->reset_rise_us = OneWire_MeasureRise(pin);
+    last_level = 1;
+    do
+    {
+        elapsed_us = OneWire_ElapsedUs(start_ticks);
+        level = (CyPins_ReadPin(pin) > 0) ? 1 : 0;
+        if ((last_level == 1) && (level == 0) && (report->presence_start_us == 0))
+            report->presence_start_us = elapsed_us;
+        if ((last_level == 0) && (level == 1) && (report->presence_width_us == 0))
+            report->presence_width_us = elapsed_us - report->presence_start_us;
+        last_level = level;
+    } while (elapsed_us < ONEWIRE_DIAG_WINDOW_US);
+    CyExitCriticalSection(interrupts);
+    CyDelayUs(t->i + t->j - ONEWIRE_DIAG_WINDOW_US); // Complete the reset sequence recovery
+
+    // Rise time after write 1 slots
+    for (uint8_t slot = 0; slot < ONEWIRE_DIAG_SLOTS; slot++)
+    {
+        uint16_t rise_us;
+        interrupts = CyEnterCriticalSection();
+        CyPins_ClearPin(pin); // Drives DQ low
+        CyDelayUs(t->a);
+        rise_us = OneWire_MeasureRise(pin);
+        CyExitCriticalSection(interrupts);
+        if (rise_us > report->slot_rise_us)
+            report->slot_rise_us = rise_us;
+        CyDelayUs(t->b); // Complete the time slot and recovery
+    }
+
+    // Detect issues
+    if ((report->reset_rise_us >= ONEWIRE_DIAG_WINDOW_US) || (report->slot_rise_us >= ONEWIRE_DIAG_WINDOW_US))
+        report->flags |= ONEWIRE_DIAG_SHORTED;
+    else if (report->presence_start_us == 0)
+        report->flags |= ONEWIRE_DIAG_NO_PRESENCE;
+    else if ((report->presence_start_us < 15) || (report->presence_start_us > 60) ||
+             (report->presence_width_us < 60) || (report->presence_width_us > 240))
+        report->flags |= ONEWIRE_DIAG_PRESENCE_TIMING;
+    if (report->slot_rise_us > ONEWIRE_DIAG_SLOW_RISE_US)
+        report->flags |= ONEWIRE_DIAG_SLOW_RISE;
+
+    // Recommend fastest profile compatible with the rise time
+    if (report->slot_rise_us <= ONEWIRE_DIAG_FAST_RISE_US)
+        report->recommended_profile = ONEWIRE_PROFILE_SHORT_TRACE;
+    else if (report->slot_rise_us <= ONEWIRE_DIAG_STANDARD_RISE_US)
+        report->recommended_profile = ONEWIRE_PROFILE_STANDARD;
+    else
+        report->recommended_profile = ONEWIRE_PROFILE_LONG_LINE;
+
+    return (report->flags == 0) ? 0 : 1;
+}
+
+//-----------------------------------------------------------------------------
+// Reduce recovery times of a timing by step/ONEWIRE_CALIBRATION_STEPS of
+// the margin between their value and their minimum value.
+//
+void OneWire_ShrinkTiming(const OneWire_Timing* base, uint8_t step, OneWire_Timing* shrunk)
+{
+    *shrunk = *base;
+    if (step > ONEWIRE_CALIBRATION_STEPS)
+        step = ONEWIRE_CALIBRATION_STEPS;
+    if (base->b > ONEWIRE_MIN_DELAY_B)
+        shrunk->b = base->b - ((base->b - ONEWIRE_MIN_DELAY_B) * step) / ONEWIRE_CALIBRATION_STEPS;
+    if (base->d > ONEWIRE_MIN_DELAY_D)
+        shrunk->d = base->d - ((base->d - ONEWIRE_MIN_DELAY_D) * step) / ONEWIRE_CALIBRATION_STEPS;
+    if (base->f > ONEWIRE_MIN_DELAY_F)
+        shrunk->f = base->f - ((base->f - ONEWIRE_MIN_DELAY_F) * step) / ONEWIRE_CALIBRATION_STEPS;
+    if (base->j > ONEWIRE_MIN_DELAY_J)
+        shrunk->j = base->j - ((base->j - ONEWIRE_MIN_DELAY_J) * step) / ONEWIRE_CALIBRATION_STEPS;
+}
+
+//-----------------------------------------------------------------------------
+// Enable or disable the trace recorder.
+//
+void OneWire_TraceEnable(uint8_t enable)
+{
+#if ONEWIRE_TRACE
+    if (enable)
+    {
+        trace_tail = 0;
+        trace_used = 0;
+        trace_records = 0;
+        trace_overwritten = 0;
+        trace_last_us = Timebase_GetUs();
+        trace_synced = 0;
+    }
+    trace_enabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Copy and remove the oldest whole records of the trace.
+//
+uint16_t OneWire_TraceRead(uint8_t* buffer, uint16_t size)
+{
+    uint16_t copied = 0;
+#if ONEWIRE_TRACE
+    while (trace_used > 0)
+    {
+        uint8_t length = OneWire_TraceLength(trace_tail);
+        if (copied + length > size)
+            break;
+        for (uint8_t i = 0; i < length; i++)
+        {
+            buffer[copied++] = trace_ring[trace_tail];
+            trace_tail = (trace_tail + 1) % ONEWIRE_TRACE_SIZE;
+        }
+        trace_used -= length;
+    }
+    if (copied > 0)
+        trace_synced = 0;
+#else
+    (void)buffer;
+    (void)size;
+#endif
+    return copied;
+}
+
+//-----------------------------------------------------------------------------
+// Return the statistics of the trace recorder.
+//
+void OneWire_TraceGetStats(OneWire_TraceStats* stats)
+{
+#if ONEWIRE_TRACE
+    stats->records = trace_records;
+    stats->overwritten = trace_overwritten;
+    stats->used = trace_used;
+#else
+    stats->records = 0;
+    stats->overwritten = 0;
+    stats->used = 0;
+#endif
+}
+
+/* [] END OF FILE */
@@ -1,99 +1,516 @@
-/** 
- * \file OneWire.h
- * \brief Library for the OneWire communication interface.
- *
- * This interface allows to implement the OneWire communication
- * interface on PSoC 3/5LP devices. This implementation is based 
- * on what is reported by Maxim Integrated in their application
- * note on 1-Wire interface, that can be found at this
- * [link](https://www.maximintegrated.com/en/design/technical-documents/app-notes/1/126.html).
-*/
-#ifndef __ONEWIRE_H__
-    #define __ONEWIRE_H__
-    
-    /**
-    *   \brief Reset device on 1-Wire interface.
-    *
-    *   This function resets the devices connected 
-    *   to the 1-Wire interface on the pin passed in
-    *   as parameter to the function.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \retval 1 if no device was found on 1-Wire interface
-    *   \retval 0 if a device was found on 1-Wire interface
-    */
-    int OneWire_TouchReset(unsigned int pin);
-    
-    /**
-    *   \brief Write a bit on 1-Wire interface.
-    *   
-    *   This function writes a single bit on the 1-Wire
-    *   interface.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \param bit the bit to be written.
-    */
-    void OneWire_WriteBit(unsigned int pin, int bit);
-    
-    /**
-    *   \brief Read a bit on 1-Wire interface.
-    *   
-    *   This function reads a single bit on the 1-Wire
-    *   interface.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \return the bit that was read.
-    */
-    int OneWire_ReadBit(unsigned int pin);
-    
-    /**
-    *   \brief Write a byte on 1-Wire interface.
-    *   
-    *   This function writes a byte on the 1-Wire
-    *   interface.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \param data the byte to be written.
-    */
-    void OneWire_WriteByte(unsigned int pin, int data);
-    
-    /**
-    *   \brief Read a byte on 1-Wire interface.
-    *   
-    *   This function reads a byte on the 1-Wire
-    *   interface.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \return the byte that was read.
-    */
-    int OneWire_ReadByte(unsigned int pin);
-    
-    /**
-    *   \brief Write a byte and read the sampled result.
-    *
-    *   This function writes a byte on the 1-Wire interface
-    *   and read the sampled result.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \param data the byte to be written.
-    *   \return the data that was read.
-    */
-    int OneWire_TouchByte(unsigned int pin, int data);
-    
-    /**
-    *   \brief Write a block of data and read the sampled result.
-    *
-    *   This function writes a block of bytes on the 1-Wire interface
-    *   and read the sampled result.
-    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
-    *       in the Pin folder in the Generated source folder.
-    *   \param data the byte to be written.
-    *   \param data_len the total number of bytes to be written. 
-    *        The sampled values are stored in the same buffer
-    */
-    void OneWire_Block(unsigned int pin, unsigned char *data, int data_len);
-    
-    
-    
-#endif
-/* [] END OF FILE */
+/** 
+ * \file OneWire.h
+ * \brief Library for the OneWire communication interface.
+ *
+ * This interface allows to implement the OneWire communication
+ * interface on PSoC 3/5LP devices. This implementation is based 
+ * on what is reported by Maxim Integrated in their application
+ * note on 1-Wire interface, that can be found at this
+ * [link](https://www.maximintegrated.com/en/design/technical-documents/app-notes/1/126.html).
+*/
+#ifndef __ONEWIRE_H__
+    #define __ONEWIRE_H__
+    
+    #include "cytypes.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+    
+    /**
+    *   \brief Number of steps used to reduce recovery times during calibration.
+    */
+    #define ONEWIRE_CALIBRATION_STEPS 8
+    
+    /**
+    *   \brief Maximum number of buses with an attached timing profile.
+    */
+    #define ONEWIRE_MAX_BUSES 4
+    
+    /**
+    *   \brief Standard speed timing of Maxim application note 126.
+    */
+    #define ONEWIRE_PROFILE_STANDARD 0
+    
+    /**
+    *   \brief Minimum recovery times, for short on-board traces.
+    */
+    #define ONEWIRE_PROFILE_SHORT_TRACE 1
+    
+    /**
+    *   \brief Long recovery times and late sampling, for long cabled lines.
+    */
+    #define ONEWIRE_PROFILE_LONG_LINE 2
+    
+    /**
+    *   \brief User defined timing, e.g. obtained by calibration.
+    */
+    #define ONEWIRE_PROFILE_CUSTOM 3
+    
+    /**
+    *   \brief Number of timing profiles.
+    */
+    #define ONEWIRE_N_PROFILES 4
+    
+    /**
+    *   \brief Delays A to J of #ONEWIRE_PROFILE_STANDARD, in microseconds.
+    */
+    #define ONEWIRE_DELAY_A 6
+    #define ONEWIRE_DELAY_B 64
+    #define ONEWIRE_DELAY_C 60
+    #define ONEWIRE_DELAY_D 6
+    #define ONEWIRE_DELAY_E 9
+    #define ONEWIRE_DELAY_F 55
+    #define ONEWIRE_DELAY_G 0
+    #define ONEWIRE_DELAY_H 480
+    #define ONEWIRE_DELAY_I 70
+    #define ONEWIRE_DELAY_J 410
+    
+    /**
+    *   \brief Minimum values of the delays that can be reduced by calibration, in microseconds.
+    *
+    *   Slots are kept at least 60us long (tSLOT) with 2us recovery, and
+    *   the first slot after a reset starts once the longest presence
+    *   pulse (tPDH + tPDL max, 300us after the release) has ended, with
+    *   2us recovery.
+    */
+    #define ONEWIRE_MIN_DELAY_B (60 - ONEWIRE_DELAY_A + 2)
+    #define ONEWIRE_MIN_DELAY_D 2
+    #define ONEWIRE_MIN_DELAY_F (60 - ONEWIRE_DELAY_A - ONEWIRE_DELAY_E + 2)
+    #define ONEWIRE_MIN_DELAY_J (300 - ONEWIRE_DELAY_I + 2)
+    
+    /**
+    *   \brief Delays A to J of #ONEWIRE_PROFILE_STANDARD, in the order of the fields of #OneWire_Timing.
+    */
+    #define ONEWIRE_TIMING_STANDARD ONEWIRE_DELAY_A, ONEWIRE_DELAY_B, ONEWIRE_DELAY_C, ONEWIRE_DELAY_D, \
+        ONEWIRE_DELAY_E, ONEWIRE_DELAY_F, ONEWIRE_DELAY_G, ONEWIRE_DELAY_H, ONEWIRE_DELAY_I, ONEWIRE_DELAY_J
+    
+    /**
+    *   \brief Delays A to J of #ONEWIRE_PROFILE_SHORT_TRACE: 2us recovery, reset
+    *   recovery covering tPDH + tPDL max.
+    */
+    #define ONEWIRE_TIMING_SHORT_TRACE ONEWIRE_DELAY_A, ONEWIRE_MIN_DELAY_B, ONEWIRE_DELAY_C, ONEWIRE_MIN_DELAY_D, \
+        ONEWIRE_DELAY_E, ONEWIRE_MIN_DELAY_F, ONEWIRE_DELAY_G, ONEWIRE_DELAY_H, ONEWIRE_DELAY_I, 240
+    
+    /**
+    *   \brief Delays A to J of #ONEWIRE_PROFILE_LONG_LINE: 20us recovery, early
+    *   release and sample at 18us, later than the standard 15us, to leave more
+    *   time to slow rising edges.
+    */
+    #define ONEWIRE_TIMING_LONG_LINE 5, 75, ONEWIRE_DELAY_C, 20, 13, 62, ONEWIRE_DELAY_G, ONEWIRE_DELAY_H, \
+        ONEWIRE_DELAY_I, 430
+    
+    /**
+    *   \brief No presence pulse was detected after reset.
+    */
+    #define ONEWIRE_DIAG_NO_PRESENCE 0x01
+    
+    /**
+    *   \brief The line did not return high after being released.
+    */
+    #define ONEWIRE_DIAG_SHORTED 0x02
+    
+    /**
+    *   \brief Presence pulse start or width is out of specification.
+    */
+    #define ONEWIRE_DIAG_PRESENCE_TIMING 0x04
+    
+    /**
+    *   \brief Rise time is long enough to affect sampling of read slots.
+    */
+    #define ONEWIRE_DIAG_SLOW_RISE 0x08
+    
+    /**
+    *   \brief Maximum rise time for which #ONEWIRE_PROFILE_SHORT_TRACE is recommended, in microseconds.
+    */
+    #define ONEWIRE_DIAG_FAST_RISE_US 1
+    
+    /**
+    *   \brief Maximum rise time for which #ONEWIRE_PROFILE_STANDARD is recommended, in microseconds.
+    */
+    #define ONEWIRE_DIAG_STANDARD_RISE_US 3
+    
+    /**
+    *   \brief Rise time above which #ONEWIRE_DIAG_SLOW_RISE is reported, in microseconds.
+    */
+    #define ONEWIRE_DIAG_SLOW_RISE_US 5
+    
+    /**
+    *   \brief Number of slots used to measure rise time.
+    */
+    #define ONEWIRE_DIAG_SLOTS 8
+    
+    // ===========================================================
+    //                      ROM COMMANDS
+    // ===========================================================
+    
+    #define ONEWIRE_READ_ROM   0x33    ///< Read the ROM of the only device of the bus
+    #define ONEWIRE_MATCH_ROM  0x55    ///< Select the device whose ROM follows
+    #define ONEWIRE_SKIP_ROM   0xCC    ///< Select all the devices of the bus
+    #define ONEWIRE_SEARCH_ROM 0xF0    ///< Find the ROMs of the devices of the bus
+    
+    // ===========================================================
+    //                      SEARCH RESULTS
+    // ===========================================================
+    
+    #define ONEWIRE_SEARCH_OK        0    ///< ROM found
+    #define ONEWIRE_SEARCH_NO_DEVICE 1    ///< No presence pulse, or no device answered a bit
+    #define ONEWIRE_SEARCH_BAD_ROM   2    ///< ROM with a wrong CRC, or all zero (shorted line)
+    
+    /**
+    *   \brief Compile the transaction trace recorder.
+    *
+    *   When 0, the trace functions do nothing and the bus
+    *   functions have no overhead.
+    */
+    #ifndef ONEWIRE_TRACE
+        #define ONEWIRE_TRACE 0
+    #endif
+    
+    /**
+    *   \brief Size of the trace ring buffer, in bytes.
+    *
+    *   Can be raised, up to 32768, to record longer sessions.
+    */
+    #ifndef ONEWIRE_TRACE_SIZE
+        #define ONEWIRE_TRACE_SIZE 512
+    #endif
+    
+    /**
+    *   \brief Maximum length of a trace record, in bytes.
+    */
+    #define ONEWIRE_TRACE_MAX_RECORD 31
+    
+    // ===========================================================
+    //                      TRACE RECORDS
+    // ===========================================================
+    //  Each record starts with a byte holding the record type in
+    //  bits 0-3 and a value in bits 4-7, followed by the time
+    //  elapsed since the start of the previous record and the
+    //  duration of the record, in us, as unsigned LEB128 varints,
+    //  and by the payload of the record type.
+    
+    #define ONEWIRE_TRACE_RESET     0   ///< Reset, value is 1 if a presence pulse was detected
+    #define ONEWIRE_TRACE_WRITE     1   ///< Byte written, payload is the byte
+    #define ONEWIRE_TRACE_READ      2   ///< Byte read, payload is the byte
+    #define ONEWIRE_TRACE_TOUCH     3   ///< Byte touched, payload is the byte written and the byte read
+    #define ONEWIRE_TRACE_WRITE_BIT 4   ///< Bit written, value is the bit
+    #define ONEWIRE_TRACE_READ_BIT  5   ///< Bit read, value is the bit
+    #define ONEWIRE_TRACE_PIN       6   ///< Following records are on a pin, payload is the pin (4 bytes, LSB first)
+    #define ONEWIRE_TRACE_TIMING    7   ///< Timing of the pin, payload is delays A to J (2 bytes each, LSB first)
+    
+    /**
+    *   \brief Statistics of the trace recorder.
+    */
+    typedef struct {
+        uint32_t records;       ///< Records written since the trace was enabled
+        uint32_t overwritten;   ///< Records overwritten before being read
+        uint16_t used;          ///< Bytes waiting to be read
+    } OneWire_TraceStats;
+    
+    /**
+    *   \brief Health report of a 1-Wire bus.
+    *
+    *   All times are measured from the release of the line by the
+    *   master, with a resolution of about 1us.
+    */
+    typedef struct {
+        uint16_t reset_rise_us;         ///< Rise time after the reset pulse
+        uint16_t presence_start_us;     ///< Start of the presence pulse
+        uint16_t presence_width_us;     ///< Width of the presence pulse
+        uint16_t slot_rise_us;          ///< Maximum rise time after a write 1 slot
+        uint8_t flags;                  ///< Detected issues, combination of ONEWIRE_DIAG_* flags
+        uint8_t recommended_profile;    ///< Fastest timing profile suitable for the bus
+    } OneWire_LineReport;
+    
+    /**
+    *   \brief Timing of the 1-Wire slots.
+    *
+    *   All delays are expressed in microseconds, and named
+    *   after the delays A to J of Maxim application note 126.
+    */
+    typedef struct {
+        uint16_t a;     ///< Low time at the start of write 1 and read slots
+        uint16_t b;     ///< Remainder of write 1 slot, including recovery
+        uint16_t c;     ///< Low time of write 0 slot
+        uint16_t d;     ///< Recovery after write 0 slot
+        uint16_t e;     ///< Delay from release to sample in read slot
+        uint16_t f;     ///< Remainder of read slot, including recovery
+        uint16_t g;     ///< Delay before reset
+        uint16_t h;     ///< Reset low time
+        uint16_t i;     ///< Delay from release to presence sample
+        uint16_t j;     ///< Reset recovery after presence sample
+    } OneWire_Timing;
+    
+    /**
+    *   \brief Reset device on 1-Wire interface.
+    *
+    *   This function resets the devices connected 
+    *   to the 1-Wire interface on the pin passed in
+    *   as parameter to the function.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \retval 1 if no device was found on 1-Wire interface
+    *   \retval 0 if a device was found on 1-Wire interface
+    */
+    int OneWire_TouchReset(unsigned int pin);
+    
+    /**
+    *   \brief Write a bit on 1-Wire interface.
+    *   
+    *   This function writes a single bit on the 1-Wire
+    *   interface.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param bit the bit to be written.
+    */
+    void OneWire_WriteBit(unsigned int pin, int bit);
+    
+    /**
+    *   \brief Read a bit on 1-Wire interface.
+    *   
+    *   This function reads a single bit on the 1-Wire
+    *   interface.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \return the bit that was read.
+    */
+    int OneWire_ReadBit(unsigned int pin);
+    
+    /**
+    *   \brief Write a byte on 1-Wire interface.
+    *   
+    *   This function writes a byte on the 1-Wire
+    *   interface.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param data the byte to be written.
+    */
+    void OneWire_WriteByte(unsigned int pin, int data);
+    
+    /**
+    *   \brief Read a byte on 1-Wire interface.
+    *   
+    *   This function reads a byte on the 1-Wire
+    *   interface.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \return the byte that was read.
+    */
+    int OneWire_ReadByte(unsigned int pin);
+    
+    /**
+    *   \brief Write a byte and read the sampled result.
+    *
+    *   This function writes a byte on the 1-Wire interface
+    *   and read the sampled result.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param data the byte to be written.
+    *   \return the data that was read.
+    */
+    int OneWire_TouchByte(unsigned int pin, int data);
+    
+    /**
+    *   \brief Write a block of data and read the sampled result.
+    *
+    *   This function writes a block of bytes on the 1-Wire interface
+    *   and read the sampled result.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param data the byte to be written.
+    *   \param data_len the total number of bytes to be written. 
+    *        The sampled values are stored in the same buffer
+    */
+    void OneWire_Block(unsigned int pin, unsigned char *data, int data_len);
+    
+    /**
+    *   \brief Compute the CRC8 of ROMs and scratchpads.
+    *
+    *   \param data the data from which to compute the CRC value.
+    *   \param length the length of the data.
+    *   \return the CRC value, 0 if the data ends with its CRC.
+    */
+    uint8_t OneWire_Crc8(const uint8_t* data, uint8_t length);
+    
+    /**
+    *   \brief Update the CRC16 used by memory devices with some bytes.
+    *
+    *   \param data the data from which to compute the CRC value.
+    *   \param length the length of the data.
+    *   \param crc the CRC of the previous bytes, 0 for the first ones.
+    *   \return the CRC value.
+    */
+    uint16_t OneWire_Crc16(const uint8_t* data, uint8_t length, uint16_t crc);
+    
+    /**
+    *   \brief Check a ROM read from the bus.
+    *
+    *   \param rom the ROM, family code first.
+    *   \retval #ONEWIRE_SEARCH_OK if the CRC of the ROM is valid.
+    *   \retval #ONEWIRE_SEARCH_BAD_ROM if the CRC is wrong or the family code is 0,
+    *       as read on a shorted line.
+    */
+    int OneWire_CheckRom(const uint8_t* rom);
+    
+    /**
+    *   \brief Run one pass of the ROM search.
+    *
+    *   A pass finds one ROM, following the branches left by the previous
+    *   pass: start with last_discrepancy at 0, and call again with the same
+    *   rom and last_discrepancy while last_discrepancy is not 0 to find all
+    *   the devices of the bus. The search state is only updated when a ROM
+    *   is found.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param rom the ROM found by the previous pass, replaced by the ROM found.
+    *   \param last_discrepancy the last branch taken towards 0 by the previous pass, updated.
+    *   \retval #ONEWIRE_SEARCH_OK if a ROM was found.
+    *   \retval #ONEWIRE_SEARCH_NO_DEVICE if no device answered.
+    *   \retval #ONEWIRE_SEARCH_BAD_ROM if the ROM found is not valid, see #OneWire_CheckRom().
+    */
+    int OneWire_SearchPass(unsigned int pin, uint8_t* rom, uint8_t* last_discrepancy);
+    
+    /**
+    *   \brief Get the number of reset pulses generated so far.
+    *
+    *   This function returns a counter that is incremented by
+    *   every call to #OneWire_TouchReset(), on any pin. It allows
+    *   upper layers to know whether a 1-Wire transaction is still
+    *   open, i.e. whether no reset was issued after a given command.
+    *   \return the number of reset pulses generated since startup.
+    */
+    uint32_t OneWire_GetResetCount(void);
+    
+    /**
+    *   \brief Function called after every reset pulse.
+    *
+    *   \param pin 1-Wire interface pin of the reset.
+    *   \param result 0 if a presence pulse was detected, 1 otherwise,
+    *       as returned by #OneWire_TouchReset().
+    */
+    typedef void (*OneWire_ResetHook)(unsigned int pin, int result);
+    
+    /**
+    *   \brief Set the function called after every reset pulse.
+    *
+    *   The function is called by #OneWire_TouchReset(), on any pin,
+    *   so that upper layers can follow the presence of devices from
+    *   the resets of all the transactions, at no bus cost. It must
+    *   not access the bus.
+    *   \param hook the function, or NULL to remove it.
+    *   \return the previous function, which the new one should call.
+    */
+    OneWire_ResetHook OneWire_SetResetHook(OneWire_ResetHook hook);
+    
+    /**
+    *   \brief Attach a timing profile to a bus.
+    *
+    *   All the following resets and slots on the bus use the
+    *   delays of the profile. Buses without an attached profile
+    *   use #ONEWIRE_PROFILE_STANDARD.
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param profile one of #ONEWIRE_PROFILE_STANDARD, #ONEWIRE_PROFILE_SHORT_TRACE,
+    *       #ONEWIRE_PROFILE_LONG_LINE, #ONEWIRE_PROFILE_CUSTOM.
+    *   \retval 0 if the profile was attached.
+    *   \retval 1 if the profile is not valid or #ONEWIRE_MAX_BUSES buses are already attached.
+    */
+    int OneWire_AttachProfile(unsigned int pin, uint8_t profile);
+    
+    /**
+    *   \brief Get the timing of a profile.
+    *
+    *   \param profile the timing profile.
+    *   \param timing pointer to variable where the timing will be stored.
+    */
+    void OneWire_GetProfileTiming(uint8_t profile, OneWire_Timing* timing);
+    
+    /**
+    *   \brief Get the timing used on a bus.
+    *
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param timing pointer to variable where the timing of the profile attached to the bus will be stored.
+    */
+    void OneWire_GetBusTiming(unsigned int pin, OneWire_Timing* timing);
+    
+    /**
+    *   \brief Set the timing of the custom profile.
+    *
+    *   The new timing is used by all the buses the
+    *   #ONEWIRE_PROFILE_CUSTOM profile is attached to.
+    *   \param timing pointer to the new timing.
+    */
+    void OneWire_SetCustomTiming(const OneWire_Timing* timing);
+    
+    /**
+    *   \brief Measure the quality of a 1-Wire bus.
+    *
+    *   This function generates a reset pulse and oversamples the
+    *   line to measure the rise time, the start and the width of
+    *   the presence pulse. It then generates #ONEWIRE_DIAG_SLOTS write 1
+    *   slots and measures the rise time of the line after each of them.
+    *   The rise time gives an indication of the line capacitance, and is
+    *   used to recommend a timing profile. Interrupts are disabled during
+    *   each measurement. The SysTick timer must be running (see #Timebase_Start()).
+    *   \param pin 1-Wire interface pin. This value can be found in the Pin_aliases.h file
+    *       in the Pin folder in the Generated source folder.
+    *   \param report pointer to variable where the health report will be stored.
+    *   \retval 0 if no issue was detected.
+    *   \retval 1 if at least one issue was detected (see report flags).
+    */
+    int OneWire_Diagnose(unsigned int pin, OneWire_LineReport* report);
+    
+    /**
+    *   \brief Reduce the recovery times of a timing.
+    *
+    *   This function reduces the recovery times (delays B, D, F and J)
+    *   of a timing towards their minimum values, which keep every slot
+    *   at least 60us long and start the first slot after a reset once
+    *   the longest presence pulse (tPDH + tPDL, 300us after the release)
+    *   has ended. The reset low time is never reduced.
+    *   \param base pointer to the timing to be reduced.
+    *   \param step reduction step, from 0 (no reduction) to #ONEWIRE_CALIBRATION_STEPS
+    *       (minimum values).
+    *   \param shrunk pointer to variable where the reduced timing will be stored.
+    */
+    void OneWire_ShrinkTiming(const OneWire_Timing* base, uint8_t step, OneWire_Timing* shrunk);
+    
+    /**
+    *   \brief Enable or disable the transaction trace recorder.
+    *
+    *   While enabled, every reset, bit and byte on any bus is recorded
+    *   with its start time and duration into a ring buffer of
+    *   #ONEWIRE_TRACE_SIZE bytes. When the buffer is full, the oldest
+    *   records are overwritten. Enabling the trace clears the buffer.
+    *   Requires #ONEWIRE_TRACE and the time base (see #Timebase_Start()).
+    *   \param enable 1 to enable the trace, 0 to disable it.
+    */
+    void OneWire_TraceEnable(uint8_t enable);
+    
+    /**
+    *   \brief Read and remove the oldest records of the trace.
+    *
+    *   Only whole records are copied. The records following a read
+    *   start with #ONEWIRE_TRACE_PIN and #ONEWIRE_TRACE_TIMING records,
+    *   so that every block read can be decoded on its own.
+    *   \param buffer pointer to the buffer where the records will be stored.
+    *   \param size size of the buffer, in bytes.
+    *   \return the number of bytes copied.
+    */
+    uint16_t OneWire_TraceRead(uint8_t* buffer, uint16_t size);
+    
+    /**
+    *   \brief Get the statistics of the trace recorder.
+    *
+    *   \param stats pointer to variable where the statistics will be stored.
+    */
+    void OneWire_TraceGetStats(OneWire_TraceStats* stats);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
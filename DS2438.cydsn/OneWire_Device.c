@@ -0,0 +1,286 @@
+/********************************************
+*
+*   \brief Source code for the 1-Wire device layer.
+*
+*   The sample cycle runs at most one transaction per
+*   call: the first conversion command whose devices
+*   are ready (their previous conversions are done),
+*   else the first device whose conversions are all
+*   done and that was not read yet. A device waits for
+*   the end of a conversion before the next one starts,
+*   but devices of other families are not held by it,
+*   so a DS2438 completes its two conversions while a
+*   DS18B20 converts the temperature.
+*
+*   The transactions of a cycle are counted with the
+*   resets of OneWire.c, so that drivers can use more
+*   than one transaction to read a device.
+*
+**********************************************/
+
+#include "OneWire_Device.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include "project.h"
+#include <string.h>
+
+static const OneWire_Driver* drivers[ONEWIRE_MAX_DRIVERS];
+static uint8_t n_drivers = 0;
+
+// ===========================================================
+//                      DEVICES
+// ===========================================================
+
+uint8_t OneWire_RegisterDriver(const OneWire_Driver* driver)
+{
+    for (uint8_t i = 0; i < n_drivers; i++)
+    {
+        if (drivers[i]->family == driver->family)
+        {
+            drivers[i] = driver;
+            return DS2438_OK;
+        }
+    }
+    if (n_drivers == ONEWIRE_MAX_DRIVERS)
+        return DS2438_ERROR;
+    drivers[n_drivers++] = driver;
+    return DS2438_OK;
+}
+
+static const OneWire_Driver* OneWire_FindDriver(uint8_t family)
+{
+    for (uint8_t i = 0; i < n_drivers; i++)
+    {
+        if (drivers[i]->family == family)
+            return drivers[i];
+    }
+    return NULL;
+}
+
+uint8_t OneWire_ScanBus(OneWire_DeviceBus* bus, unsigned int pin)
+{
+    uint8_t rom[8] = {0};
+    uint8_t last_discrepancy = 0;
+
+    bus->pin = pin;
+    bus->count = 0;
+    do
+    {
+        int result = OneWire_SearchPass(pin, rom, &last_discrepancy);
+        if (result != ONEWIRE_SEARCH_OK)
+        {
+            bus->count = 0;
+            return (result == ONEWIRE_SEARCH_NO_DEVICE) ? DS2438_DEV_NOT_FOUND : DS2438_CRC_FAIL;
+        }
+        if (bus->count == ONEWIRE_MAX_DEVICES)
+            return DS2438_ERROR;
+        OneWire_Device* device = &bus->devices[bus->count++];
+        device->pin = pin;
+        memcpy(device->rom, rom, 8);
+        device->driver = OneWire_FindDriver(rom[0]);
+        device->error = DS2438_DEV_NOT_FOUND;
+        memset(device->data, 0, sizeof(device->data));
+    } while (last_discrepancy != 0);
+
+    for (uint8_t d = 0; d < bus->count; d++)
+    {
+        bus->devices[d].alone = (bus->count == 1);
+    }
+    return DS2438_OK;
+}
+
+uint8_t OneWire_SelectDevice(const OneWire_Device* device)
+{
+    if (OneWire_TouchReset(device->pin) != 0)
+        return DS2438_DEV_NOT_FOUND;
+    if (device->alone)
+    {
+        OneWire_WriteByte(device->pin, ONEWIRE_SKIP_ROM);
+        return DS2438_OK;
+    }
+    OneWire_WriteByte(device->pin, ONEWIRE_MATCH_ROM);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        OneWire_WriteByte(device->pin, device->rom[i]);
+    }
+    return DS2438_OK;
+}
+
+// ===========================================================
+//                      SAMPLE CYCLE
+// ===========================================================
+
+// Duration of a conversion on a device
+static uint32_t OneWire_ConversionTime(const OneWire_Device* device, uint8_t command)
+{
+    for (uint8_t i = 0; i < device->driver->n_conversions; i++)
+    {
+        if (device->driver->conversions[i].command == command)
+            return device->driver->conversions[i].time_us;
+    }
+    return 0;
+}
+
+// A command can be sent to all the devices if the other ones ignore it
+static uint8_t OneWire_CanBroadcast(const OneWire_Cycle* cycle, uint8_t c)
+{
+    for (uint8_t d = 0; d < cycle->bus->count; d++)
+    {
+        const OneWire_Driver* driver = cycle->bus->devices[d].driver;
+        if (cycle->needed[d] & (1 << c))
+            continue;
+        if ((driver == NULL) || (driver->ignores == NULL) || !driver->ignores(cycle->commands[c]))
+            return 0;
+    }
+    return 1;
+}
+
+// Mark a command as started on a device
+static void OneWire_CycleStarted(OneWire_Cycle* cycle, uint8_t d, uint8_t c)
+{
+    cycle->started[d] |= 1 << c;
+    cycle->ready_us[d] = Timebase_GetUs() + OneWire_ConversionTime(&cycle->bus->devices[d], cycle->commands[c]);
+}
+
+// Start the first conversion whose devices are ready
+static uint8_t OneWire_CycleConvert(OneWire_Cycle* cycle)
+{
+    OneWire_DeviceBus* bus = cycle->bus;
+    for (uint8_t c = 0; c < cycle->n_commands; c++)
+    {
+        uint8_t bit = 1 << c;
+        uint8_t waiting = 0;
+        int8_t first = -1;
+        for (uint8_t d = 0; d < bus->count; d++)
+        {
+            if (((cycle->needed[d] & bit) == 0) || (cycle->started[d] & bit))
+                continue;
+            if (!Timebase_IsExpired(cycle->ready_us[d]))
+                waiting = 1;
+            else if (first < 0)
+                first = d;
+        }
+        if (cycle->broadcast[c] && (first >= 0) && !waiting)
+        {
+            if (OneWire_TouchReset(bus->pin) == 0)
+            {
+                OneWire_WriteByte(bus->pin, ONEWIRE_SKIP_ROM);
+                OneWire_WriteByte(bus->pin, cycle->commands[c]);
+            }
+            for (uint8_t d = 0; d < bus->count; d++)
+            {
+                if ((cycle->needed[d] & bit) && !(cycle->started[d] & bit))
+                    OneWire_CycleStarted(cycle, d, c);
+            }
+            return 1;
+        }
+        if (!cycle->broadcast[c] && (first >= 0))
+        {
+            if (OneWire_SelectDevice(&bus->devices[first]) == DS2438_OK)
+                OneWire_WriteByte(bus->pin, cycle->commands[c]);
+            OneWire_CycleStarted(cycle, first, c);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Read the first device whose conversions are done
+static uint8_t OneWire_CycleRead(OneWire_Cycle* cycle)
+{
+    for (uint8_t d = 0; d < cycle->bus->count; d++)
+    {
+        OneWire_Device* device = &cycle->bus->devices[d];
+        if (!cycle->pending[d] || (cycle->started[d] != cycle->needed[d]) || !Timebase_IsExpired(cycle->ready_us[d]))
+            continue;
+        device->error = device->driver->read(device);
+        if (device->error != DS2438_OK)
+            cycle->errors++;
+        cycle->pending[d] = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void OneWire_CycleStart(OneWire_Cycle* cycle, OneWire_DeviceBus* bus, uint8_t batch)
+{
+    cycle->bus = bus;
+    cycle->n_commands = 0;
+    cycle->start_us = Timebase_GetUs();
+    cycle->cycle_us = 0;
+    cycle->bus_us = 0;
+    cycle->transactions = 0;
+    cycle->errors = 0;
+
+    // Conversion commands, in order of first use
+    for (uint8_t d = 0; d < bus->count; d++)
+    {
+        const OneWire_Driver* driver = bus->devices[d].driver;
+        cycle->needed[d] = 0;
+        cycle->started[d] = 0;
+        cycle->pending[d] = (driver != NULL) && (driver->read != NULL);
+        cycle->ready_us[d] = cycle->start_us;
+        for (uint8_t i = 0; (driver != NULL) && (i < driver->n_conversions); i++)
+        {
+            uint8_t c = 0;
+            while ((c < cycle->n_commands) && (cycle->commands[c] != driver->conversions[i].command))
+                c++;
+            if (c == ONEWIRE_MAX_COMMANDS)
+                continue;
+            if (c == cycle->n_commands)
+                cycle->commands[cycle->n_commands++] = driver->conversions[i].command;
+            cycle->needed[d] |= 1 << c;
+        }
+    }
+    for (uint8_t c = 0; c < cycle->n_commands; c++)
+    {
+        cycle->broadcast[c] = batch && OneWire_CanBroadcast(cycle, c);
+    }
+    cycle->running = 1;
+}
+
+uint8_t OneWire_CycleRun(OneWire_Cycle* cycle)
+{
+    if (!cycle->running)
+        return 0;
+
+    uint32_t start_us = Timebase_GetUs();
+    uint32_t resets = OneWire_GetResetCount();
+    if (OneWire_CycleConvert(cycle) || OneWire_CycleRead(cycle))
+    {
+        cycle->transactions += OneWire_GetResetCount() - resets;
+        cycle->bus_us += Timebase_GetUs() - start_us;
+        return 1;
+    }
+
+    for (uint8_t d = 0; d < cycle->bus->count; d++)
+    {
+        if (cycle->pending[d] || (cycle->started[d] != cycle->needed[d]))
+            return 1;
+    }
+    cycle->running = 0;
+    cycle->cycle_us = Timebase_GetUs() - cycle->start_us;
+    return 0;
+}
+
+uint8_t OneWire_CycleNextWake(const OneWire_Cycle* cycle, uint32_t* wake_us)
+{
+    uint8_t found = 0;
+    if (!cycle->running)
+        return 0;
+    for (uint8_t d = 0; d < cycle->bus->count; d++)
+    {
+        if (!cycle->pending[d] && (cycle->started[d] == cycle->needed[d]))
+            continue;
+        if ((found == 0) || ((int32_t)(cycle->ready_us[d] - *wake_us) < 0))
+        {
+            *wake_us = cycle->ready_us[d];
+            found = 1;
+        }
+    }
+    if (found == 0)
+        *wake_us = Timebase_GetUs();
+    return 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,185 @@
+/**
+ * \file OneWire_Device.h
+ * \brief Device layer for 1-Wire buses shared by several device families.
+ *
+ * The devices of a bus are found with a ROM search, and each of them is
+ * handled by the driver registered for its family code (first byte of the
+ * ROM): DS2438_Driver.h, DS18B20.h and DS2431.h, or any other one. A device
+ * is selected with MATCH ROM, or with SKIP ROM when it is the only device
+ * of its bus.
+ *
+ * A driver declares the conversions run at each sample cycle, e.g. CONVERT
+ * T for temperature sensors, and the function to read their results. The
+ * sample cycle of a bus starts each conversion command once for all the
+ * devices with SKIP ROM, when every other device of the bus is known to
+ * ignore the command, so that DS2438 and DS18B20 temperature conversions
+ * share one transaction. Otherwise, the command is sent to each device
+ * with MATCH ROM. Each device is read once all its conversions are done.
+ *
+ * Functions return the error codes of DS2438_Defines.h.
+*/
+#ifndef __ONEWIRE_DEVICE_H__
+    #define __ONEWIRE_DEVICE_H__
+
+    #include "cytypes.h"
+    #include "DS2438_Defines.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Maximum number of devices of a bus.
+    */
+    #define ONEWIRE_MAX_DEVICES     8
+
+    /**
+    *   \brief Maximum number of registered drivers.
+    */
+    #define ONEWIRE_MAX_DRIVERS     4
+
+    /**
+    *   \brief Maximum number of different conversion commands of a bus.
+    */
+    #define ONEWIRE_MAX_COMMANDS    4
+
+    // ===========================================================
+    //                      DRIVERS
+    // ===========================================================
+
+    typedef struct OneWire_Device OneWire_Device;
+
+    /**
+    *   \brief Conversion run by a device at each sample cycle.
+    */
+    typedef struct {
+        uint8_t command;                ///< Function command that starts the conversion
+        uint32_t time_us;               ///< Longest duration of the conversion
+    } OneWire_Conversion;
+
+    /**
+    *   \brief Driver of a device family.
+    */
+    typedef struct {
+        uint8_t family;                             ///< Family code
+        const char* name;                           ///< Name of the family, e.g. "DS2438"
+        const OneWire_Conversion* conversions;      ///< Conversions of a sample cycle, in order
+        uint8_t n_conversions;                      ///< Number of conversions
+        uint8_t (*ignores)(uint8_t command);        ///< 1 if a command sent to all the devices has no effect on the family
+        uint8_t (*read)(OneWire_Device* device);    ///< Read the results of the conversions, NULL if none
+    } OneWire_Driver;
+
+    /**
+    *   \brief Device of a bus.
+    */
+    struct OneWire_Device {
+        unsigned int pin;               ///< Pin of the bus
+        uint8_t rom[8];                 ///< ROM of the device
+        uint8_t alone;                  ///< 1 if the only device of its bus
+        const OneWire_Driver* driver;   ///< Driver of the family, NULL if none
+        uint8_t error;                  ///< Result of the last read
+        uint8_t data[9];                ///< Data of the last read, decoded by the driver
+    };
+
+    /**
+    *   \brief Devices of a bus.
+    */
+    typedef struct {
+        unsigned int pin;                               ///< Pin of the bus
+        OneWire_Device devices[ONEWIRE_MAX_DEVICES];    ///< Devices, in order of ROM search
+        uint8_t count;                                  ///< Number of devices
+    } OneWire_DeviceBus;
+
+    /**
+    *   \brief Sample cycle of a bus.
+    *
+    *   The statistics of the last cycle are valid once it completes.
+    */
+    typedef struct {
+        OneWire_DeviceBus* bus;                     ///< Bus of the cycle
+        uint8_t running;                            ///< 1 until the cycle completes
+        uint8_t n_commands;                         ///< Number of conversion commands
+        uint8_t commands[ONEWIRE_MAX_COMMANDS];     ///< Conversion commands of the devices
+        uint8_t broadcast[ONEWIRE_MAX_COMMANDS];    ///< 1 if a command is sent once with SKIP ROM
+        uint8_t needed[ONEWIRE_MAX_DEVICES];        ///< Commands of each device, one bit per command
+        uint8_t started[ONEWIRE_MAX_DEVICES];       ///< Commands started on each device
+        uint8_t pending[ONEWIRE_MAX_DEVICES];       ///< 1 until the device is read
+        uint32_t ready_us[ONEWIRE_MAX_DEVICES];     ///< End of the conversions of each device
+        uint32_t start_us;                          ///< Start of the cycle
+        uint32_t cycle_us;                          ///< Duration of the cycle
+        uint32_t bus_us;                            ///< Time spent in transactions
+        uint16_t transactions;                      ///< Transactions run
+        uint8_t errors;                             ///< Devices whose read failed
+    } OneWire_Cycle;
+
+    // ===========================================================
+    //                      FUNCTIONS
+    // ===========================================================
+
+    /**
+    *   \brief Register the driver of a device family.
+    *
+    *   A driver registered for the same family is replaced. Drivers must
+    *   be registered before the buses are scanned.
+    *   \param driver pointer to the driver, which must remain valid.
+    *   \retval #DS2438_OK if the driver was registered.
+    *   \retval #DS2438_ERROR if the driver table is full.
+    */
+    uint8_t OneWire_RegisterDriver(const OneWire_Driver* driver);
+
+    /**
+    *   \brief Find the devices of a bus with a ROM search.
+    *
+    *   \param bus pointer to the bus, whose devices are replaced.
+    *   \param pin 1-Wire interface pin.
+    *   \retval #DS2438_OK if the devices were found.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device answered.
+    *   \retval #DS2438_CRC_FAIL if a ROM was not read correctly.
+    *   \retval #DS2438_ERROR if the bus has more than #ONEWIRE_MAX_DEVICES devices.
+    */
+    uint8_t OneWire_ScanBus(OneWire_DeviceBus* bus, unsigned int pin);
+
+    /**
+    *   \brief Reset the bus and select a device.
+    *
+    *   Drivers call this function to start each transaction, then send the
+    *   function command.
+    *   \param device pointer to the device.
+    *   \retval #DS2438_OK if the device is selected.
+    *   \retval #DS2438_DEV_NOT_FOUND if no device answered the reset.
+    */
+    uint8_t OneWire_SelectDevice(const OneWire_Device* device);
+
+    /**
+    *   \brief Start the sample cycle of a bus.
+    *
+    *   \param cycle pointer to the cycle.
+    *   \param bus pointer to a scanned bus.
+    *   \param batch 1 to start compatible conversions of all the devices at once,
+    *       0 to start them on each device, e.g. on a parasite-powered bus.
+    */
+    void OneWire_CycleStart(OneWire_Cycle* cycle, OneWire_DeviceBus* bus, uint8_t batch);
+
+    /**
+    *   \brief Run the next transaction of a sample cycle, if one is ready.
+    *
+    *   \param cycle pointer to the cycle.
+    *   \return 1 while the cycle is running, 0 once it completed.
+    */
+    uint8_t OneWire_CycleRun(OneWire_Cycle* cycle);
+
+    /**
+    *   \brief Get the earliest time at which the cycle can run a transaction.
+    *
+    *   \param cycle pointer to the cycle.
+    *   \param wake_us pointer to variable where the time will be stored.
+    *   \return 1 while the cycle is running; wake_us is not set if 0.
+    */
+    uint8_t OneWire_CycleNextWake(const OneWire_Cycle* cycle, uint32_t* wake_us);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
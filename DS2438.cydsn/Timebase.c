@@ -0,0 +1,59 @@
+/********************************************
+*
+*   \brief Source code for the time base.
+*
+*   The SysTick timer is reloaded every millisecond.
+*   The microsecond timestamp is obtained by combining
+*   the millisecond counter with the current value
+*   of the SysTick down-counter.
+*
+**********************************************/
+
+#include "Timebase.h"
+#include "project.h"
+
+static volatile uint32_t timebase_ms = 0;
+static uint8_t timebase_started = 0;
+
+static void Timebase_SysTickCallback(void)
+{
+    timebase_ms++;
+}
+
+void Timebase_Start(void)
+{
+    if (timebase_started == 0)
+    {
+        CySysTickStart();
+        CySysTickSetCallback(0, Timebase_SysTickCallback);
+        timebase_started = 1;
+    }
+}
+
+uint32_t Timebase_GetMs(void)
+{
+    return timebase_ms;
+}
+
+uint32_t Timebase_GetUs(void)
+{
+    uint32_t ms, ticks, reload;
+
+    // Read counter until no SysTick interrupt occurred in between
+    do
+    {
+        ms = timebase_ms;
+        ticks = CySysTickGetValue();
+    } while (ms != timebase_ms);
+
+    reload = CySysTickGetReload();
+    // SysTick counts down from reload to 0 every millisecond
+    return ms * 1000u + ((reload - ticks) * 1000u) / (reload + 1u);
+}
+
+uint8_t Timebase_IsExpired(uint32_t deadline_us)
+{
+    return ((int32_t)(Timebase_GetUs() - deadline_us) >= 0) ? 1 : 0;
+}
+
+/* [] END OF FILE */
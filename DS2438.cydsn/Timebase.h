@@ -0,0 +1,61 @@
+/**
+ * \file Timebase.h
+ * \brief Free-running time base for the DS2438 Library.
+ *
+ * This module uses the Cortex-M3 SysTick timer to provide
+ * a millisecond counter and a microsecond timestamp that
+ * are used to track deadlines of DS2438 operations
+ * (e.g. EEPROM copies and A/D conversions) without
+ * blocking the CPU.
+*/
+#ifndef __TIMEBASE_H__
+    #define __TIMEBASE_H__
+
+    #include "cytypes.h"
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Start the time base.
+    *
+    *   This function configures the SysTick timer to generate
+    *   an interrupt every millisecond and registers the callback
+    *   that updates the millisecond counter. Calling this function
+    *   more than once has no effect.
+    */
+    void Timebase_Start(void);
+
+    /**
+    *   \brief Get milliseconds elapsed since #Timebase_Start().
+    *
+    *   \return the number of milliseconds elapsed since the time base was started.
+    */
+    uint32_t Timebase_GetMs(void);
+
+    /**
+    *   \brief Get microseconds elapsed since #Timebase_Start().
+    *
+    *   The returned value wraps around every ~71 minutes, therefore
+    *   timestamps must only be compared using #Timebase_IsExpired()
+    *   or by computing their difference.
+    *   \return the number of microseconds elapsed since the time base was started.
+    */
+    uint32_t Timebase_GetUs(void);
+
+    /**
+    *   \brief Check if a deadline has been reached.
+    *
+    *   \param deadline_us the deadline, expressed as a #Timebase_GetUs() timestamp.
+    *   \retval 1 if the deadline has been reached.
+    *   \retval 0 otherwise.
+    */
+    uint8_t Timebase_IsExpired(uint32_t deadline_us);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
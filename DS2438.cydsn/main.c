@@ -1,151 +1,368 @@
-/* ========================================
- *
- * Copyright YOUR COMPANY, THE YEAR
- * All Rights Reserved
- * UNPUBLISHED, LICENSED SOFTWARE.
- *
- * CONFIDENTIAL AND PROPRIETARY INFORMATION
- * WHICH IS THE PROPERTY OF your company.
- *
- * ========================================
-*/
-#include "project.h"
-#include "DS2438.h"
-#include "stdio.h"
-
-#define DEBUG
-
-#ifdef DEBUG
-
-    #define DEBUG_TEST 1             
-    
-#else
-    
-    #define DEBUG_TEST 0
-    
-#endif
-
-#define debug_print(fmt) do { if (DEBUG_TEST) UART_PutString(fmt); } while (0)
-
-int main(void)
-{
-    CyGlobalIntEnable; /* Enable global interrupts. */
-    
-    /* Place your initialization/startup code here (e.g. MyInst_Start()) */
-    UART_Start();
-    debug_print("DS2438 Test\r\n");
-
-    char msg[50];
-    DS2438_Start();
-    DS2438_EnableIAD();
-    DS2438_EnableCA();
-    DS2438_EnableShadowEE();
-    
-    if (DS2438_IsDevicePresent() == DS2438_OK)
-    {
-        uint8_t serial_number[6];
-        if ( DS2438_ReadSerialNumber(serial_number) == DS2438_OK)
-        {
-            sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", serial_number[0], serial_number[1],
-                                                                                serial_number[2], serial_number[3],
-                                                                                serial_number[4], serial_number[5]);
-            debug_print(msg);
-        }
-        else
-        {
-            debug_print("CRC Check failed when reading serial number\r\n");
-        }
-        
-        for (uint8_t page = 0; page < 7; page++)
-        {
-           uint8_t page_data[9];
-            DS2438_ReadPage(page, page_data);    
-            sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", page_data[0], page_data[1],
-                                                                                page_data[2], page_data[3],
-                                                                                page_data[4], page_data[5],
-                                                                                page_data[6], page_data[7]);
-            debug_print(msg);
-        }
-    }
-    else
-    {
-        debug_print("Could not find device\r\n");
-    }
-    
-    DS2438_SelectInputSource(DS2438_INPUT_VOLTAGE_VDD);
-    DS2438_EnableIAD();
-    DS2438_EnableCA();
-    DS2438_EnableShadowEE();
-    
-    for (uint8_t page = 0; page < 7; page++)
-    {
-       uint8_t page_data[9];
-        DS2438_ReadPage(page, page_data);    
-        sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", page_data[0], page_data[1],
-                                                                            page_data[2], page_data[3],
-                                                                            page_data[4], page_data[5],
-                                                                            page_data[6], page_data[7]);
-        debug_print(msg);
-    }
-    float voltage, temperature, current, capacity = 0;
-    
-    for(;;)
-    {
-        
-        if (DS2438_ReadVoltage(&voltage) == DS2438_OK)
-        {
-            sprintf(msg, "Voltage: %d\r\n", (int)(voltage*1000));
-            debug_print(msg);
-            
-        }
-        else
-        {
-            debug_print("Could not read voltage\r\n");
-        }
-        
-        if (DS2438_ReadTemperature(&temperature) == DS2438_OK)
-        {
-            sprintf(msg, "Temperature: %d\r\n", (int)(temperature*1000));
-            debug_print(msg);
-        }
-        else
-        {
-            debug_print("Could not read temperature\r\n");
-        }
-        if (DS2438_GetCurrentData(&current) == DS2438_OK)
-        {
-            sprintf(msg, "mAmps: %d\r\n", (int)(current*1000));
-            debug_print(msg);
-            
-        }
-        else
-        {
-            debug_print("Could not read current\r\n");
-        }
-        if (DS2438_GetCapacity(&capacity) == DS2438_OK)
-        {
-            sprintf(msg, "Capacity: %d\r\n", (int)(capacity*1000));
-            debug_print(msg);
-            
-        }
-        else
-        {
-            debug_print("Could not read current\r\n");
-        }
-        for (uint8_t page = 0; page < 7; page++)
-        {
-           uint8_t page_data[9];
-            DS2438_ReadPage(page, page_data);    
-            sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", page_data[0], page_data[1],
-                                                                                page_data[2], page_data[3],
-                                                                                page_data[4], page_data[5],
-                                                                                page_data[6], page_data[7]);
-            debug_print(msg);
-        }
-        CyDelay(1000);
-        
-    }
-}
-
-
-/* [] END OF FILE */
+/* ========================================
+ *
+ * Copyright YOUR COMPANY, THE YEAR
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+#include "project.h"
+#include "DS2438.h"
+#include "DS2438_Accumulators.h"
+#include "DS2438_Boot.h"
+#include "DS2438_Events.h"
+#include "DS2438_History.h"
+#include "DS2438_Log.h"
+#include "DS2438_Presence.h"
+#include "Timebase.h"
+#include "stdio.h"
+#include "string.h"
+
+#define DEBUG
+
+#ifdef DEBUG
+
+    #define DEBUG_TEST 1             
+    
+#else
+    
+    #define DEBUG_TEST 0
+    
+#endif
+
+#define debug_print(fmt) do { if (DEBUG_TEST) UART_PutString(fmt); } while (0)
+
+// Interval between two measurement cycles
+// The cycle and these settings are run on the host by tools/host/main_cycle.c, keep both in line
+#define MEASUREMENT_PERIOD_MS 1000
+
+// Battery removal detected within this time, using at most 1% of the bus time
+#define PRESENCE_LATENCY_MS 100
+#define PRESENCE_BUDGET_PERMILLE 10
+
+// Measurements waiting to be sent over the UART
+static DS2438_EventQueue telemetry_queue;
+
+// Line being sent over the UART
+static char telemetry_line[72];
+static uint8_t telemetry_length = 0;
+static uint8_t telemetry_position = 0;
+static uint32_t telemetry_overwritten = 0;
+
+#if ONEWIRE_TRACE
+// Bus trace frozen after a CRC failure, waiting to be sent
+static uint8_t trace_frozen = 0;
+#endif
+
+static const char* const event_names[] = {"voltage", "temperature", "current", "capacity", "page", "history"};
+static const char* const presence_names[] = {"detached", "attached", "replaced"};
+
+// Push a measurement to the telemetry queue
+static void Telemetry_Push(uint8_t type, uint8_t error, int32_t value, const uint8_t* data)
+{
+    DS2438_Event event;
+    event.timestamp_ms = Timebase_GetMs();
+    event.type = (error == DS2438_OK) ? type : DS2438_EVENT_ERROR;
+    event.error = error;
+    event.index = (error == DS2438_OK) ? 0 : type;
+    event.value = value;
+    if ((type == DS2438_EVENT_PAGE) && (error == DS2438_OK))
+    {
+        // Failed reads keep the type in index, the page number is in value
+        event.index = value;
+        memcpy(event.data, data, 8);
+    }
+    else if (type == DS2438_EVENT_HISTORY)
+    {
+        memcpy(event.data, data, 4);
+    }
+    else if (type == DS2438_EVENT_PRESENCE)
+    {
+        memcpy(event.data, data, 8);
+    }
+    DS2438_EventQueuePush(&telemetry_queue, &event);
+#if ONEWIRE_TRACE
+    if ((error == DS2438_CRC_FAIL) && (trace_frozen == 0))
+    {
+        // Keep the transactions that led to the failure
+        OneWire_TraceEnable(0);
+        trace_frozen = 1;
+    }
+#endif
+}
+
+// Format an event as a line of text
+static uint8_t Telemetry_Format(const DS2438_Event* event, char* line)
+{
+    switch (event->type)
+    {
+        case DS2438_EVENT_VOLTAGE:
+            return sprintf(line, "Voltage: %ld\r\n", (long)event->value);
+        case DS2438_EVENT_TEMPERATURE:
+            return sprintf(line, "Temperature: %ld\r\n", (long)event->value);
+        case DS2438_EVENT_CURRENT:
+            return sprintf(line, "mAmps: %ld\r\n", (long)event->value);
+        case DS2438_EVENT_CAPACITY:
+            return sprintf(line, "Capacity: %ld\r\n", (long)event->value);
+        case DS2438_EVENT_PAGE:
+            return sprintf(line, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n",
+                           event->data[0], event->data[1], event->data[2], event->data[3],
+                           event->data[4], event->data[5], event->data[6], event->data[7]);
+        case DS2438_EVENT_HISTORY:
+            return sprintf(line, "ETM: %lu CCA: %u DCA: %u\r\n", (unsigned long)event->value,
+                           (event->data[1] << 8) | event->data[0], (event->data[3] << 8) | event->data[2]);
+        case DS2438_EVENT_PRESENCE:
+            return sprintf(line, "Battery %s: %02X %02X %02X %02X %02X %02X %02X %02X\r\n", presence_names[event->value],
+                           event->data[0], event->data[1], event->data[2], event->data[3],
+                           event->data[4], event->data[5], event->data[6], event->data[7]);
+        default:
+            if (event->index == DS2438_EVENT_PAGE)
+                return sprintf(line, "Could not read page %ld\r\n", (long)event->value);
+            if (event->index >= (sizeof(event_names) / sizeof(event_names[0])))
+                return sprintf(line, "Could not read event %u\r\n", event->index);
+            return sprintf(line, "Could not read %s\r\n", event_names[event->index]);
+    }
+}
+
+// Format the next records of a frozen bus trace as a line of hex text,
+// re-enable the trace once it was completely sent
+static uint8_t Telemetry_FormatTrace(char* line)
+{
+#if ONEWIRE_TRACE
+    uint8_t records[ONEWIRE_TRACE_MAX_RECORD];
+    if (trace_frozen == 0)
+        return 0;
+    uint16_t size = OneWire_TraceRead(records, sizeof(records));
+    if (size == 0)
+    {
+        trace_frozen = 0;
+        OneWire_TraceEnable(1);
+        return 0;
+    }
+    uint8_t length = sprintf(line, "TRACE ");
+    for (uint16_t i = 0; i < size; i++)
+    {
+        length += sprintf(&line[length], "%02X", records[i]);
+    }
+    length += sprintf(&line[length], "\r\n");
+    return length;
+#else
+    (void)line;
+    return 0;
+#endif
+}
+
+// Send queued events while the UART transmit buffer has room
+static void Telemetry_Drain(void)
+{
+    while (DEBUG_TEST && (UART_GetTxBufferSize() < UART_TX_BUFFER_SIZE))
+    {
+        if (telemetry_position == telemetry_length)
+        {
+            DS2438_Event event;
+            telemetry_position = 0;
+            if (telemetry_queue.overwritten != telemetry_overwritten)
+            {
+                telemetry_length = sprintf(telemetry_line, "Lost %lu events\r\n",
+                                           (unsigned long)(telemetry_queue.overwritten - telemetry_overwritten));
+                telemetry_overwritten = telemetry_queue.overwritten;
+            }
+            else
+            {
+                telemetry_length = Telemetry_FormatTrace(telemetry_line);
+                if ((telemetry_length == 0) && (DS2438_EventQueuePop(&telemetry_queue, &event) == DS2438_OK))
+                {
+                    telemetry_length = Telemetry_Format(&event, telemetry_line);
+                }
+                if (telemetry_length == 0)
+                {
+                    return;
+                }
+            }
+        }
+        UART_PutChar(telemetry_line[telemetry_position++]);
+    }
+}
+
+// Report battery swaps; cached pages were already invalidated by the watcher
+static void Presence_Changed(const uint8_t* rom, uint8_t event, void* context)
+{
+    (void)context;
+    Telemetry_Push(DS2438_EVENT_PRESENCE, DS2438_OK, event, rom);
+}
+
+// Configuration of the device: current measurement, accumulators with shadow, VDD input
+#define DS2438_BOOT_CONFIG (DS2438_CONFIG_IAD | DS2438_CONFIG_CA | DS2438_CONFIG_EE | DS2438_CONFIG_AD)
+
+int main(void)
+{
+    CyGlobalIntEnable; /* Enable global interrupts. */
+    
+    /* Place your initialization/startup code here (e.g. MyInst_Start()) */
+    UART_Start();
+    debug_print("DS2438 Test\r\n");
+
+    char msg[50];
+    DS2438_Start();
+    uint32_t boot_start_ms = Timebase_GetMs();
+    uint8_t first_sample = 1;
+    
+    uint8_t warm = 0;
+    if ((DS2438_WarmBoot(DS2438_BOOT_CONFIG, &warm) == DS2438_OK) && (warm == 1))
+    {
+        debug_print("Warm boot\r\n");
+    }
+    else
+    {
+        OneWire_LineReport report;
+        if (OneWire_Diagnose(DS2438_Pin_0, &report) != 0)
+        {
+            sprintf(msg, "Bus issues: 0x%02X\r\n", report.flags);
+            debug_print(msg);
+        }
+        sprintf(msg, "Rise: %d us, profile %d\r\n", report.slot_rise_us, report.recommended_profile);
+        debug_print(msg);
+        
+        OneWire_Timing timing;
+        if (DS2438_CalibrateTiming(&timing) == DS2438_OK)
+        {
+            sprintf(msg, "Timing B:%d D:%d F:%d J:%d\r\n", timing.b, timing.d, timing.f, timing.j);
+            debug_print(msg);
+        }
+        
+        // Bus time of a page read with each timing profile
+        for (uint8_t profile = 0; profile < ONEWIRE_N_PROFILES; profile++)
+        {
+            uint8_t page_data[9];
+            OneWire_AttachProfile(DS2438_Pin_0, profile);
+            uint32_t start_us = Timebase_GetUs();
+            for (uint8_t read = 0; read < 10; read++)
+            {
+                DS2438_ReadPageWithMaxAge(0x00, 0, page_data);
+            }
+            sprintf(msg, "Profile %d: %lu us/page\r\n", profile, (unsigned long)((Timebase_GetUs() - start_us) / 10));
+            debug_print(msg);
+        }
+        OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_CUSTOM);
+        
+        if (DS2438_IsDevicePresent() == DS2438_OK)
+        {
+            uint8_t serial_number[6];
+            if ( DS2438_ReadSerialNumber(serial_number) == DS2438_OK)
+            {
+                sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", serial_number[0], serial_number[1],
+                                                                                    serial_number[2], serial_number[3],
+                                                                                    serial_number[4], serial_number[5]);
+                debug_print(msg);
+            }
+            else
+            {
+                debug_print("CRC Check failed when reading serial number\r\n");
+            }
+            
+            if (DS2438_ColdBoot(DS2438_BOOT_CONFIG, ONEWIRE_PROFILE_CUSTOM) != DS2438_OK)
+            {
+                debug_print("Could not save boot configuration\r\n");
+            }
+        }
+        else
+        {
+            debug_print("Could not find device\r\n");
+        }
+    }
+    
+    for (uint8_t page = 0; page < 7; page++)
+    {
+       uint8_t page_data[9];
+        DS2438_ReadPage(page, page_data);    
+        sprintf(msg, "0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\r\n", page_data[0], page_data[1],
+                                                                            page_data[2], page_data[3],
+                                                                            page_data[4], page_data[5],
+                                                                            page_data[6], page_data[7]);
+        debug_print(msg);
+    }
+    DS2438_AccumulatorsStart();
+    DS2438_LogStart(NULL);
+    DS2438_EventQueueInit(&telemetry_queue, DS2438_EVENT_DROP_OLDEST);
+    DS2438_PresenceStart(DS2438_Pin_0, 0, PRESENCE_LATENCY_MS, PRESENCE_BUDGET_PERMILLE, Presence_Changed, NULL);
+    float voltage, temperature, current, capacity = 0;
+    uint32_t next_cycle_ms = Timebase_GetMs();
+    OneWire_TraceEnable(1);
+    
+    for(;;)
+    {
+        // Measurement cycle, never blocked by the UART
+        if ((int32_t)(Timebase_GetMs() - next_cycle_ms) >= 0)
+        {
+            next_cycle_ms += MEASUREMENT_PERIOD_MS;
+            
+            uint8_t error = DS2438_ReadVoltage(&voltage);
+            if ((error == DS2438_OK) && first_sample)
+            {
+                // Time from start to first valid sample
+                sprintf(msg, "First sample: %lu ms\r\n", (unsigned long)(Timebase_GetMs() - boot_start_ms));
+                debug_print(msg);
+                first_sample = 0;
+            }
+            Telemetry_Push(DS2438_EVENT_VOLTAGE, error, (int32_t)(voltage*1000), NULL);
+            error = DS2438_ReadTemperature(&temperature);
+            Telemetry_Push(DS2438_EVENT_TEMPERATURE, error, (int32_t)(temperature*1000), NULL);
+            error = DS2438_GetCurrentData(&current);
+            Telemetry_Push(DS2438_EVENT_CURRENT, error, (int32_t)(current*1000), NULL);
+            error = DS2438_GetCapacity(&capacity);
+            Telemetry_Push(DS2438_EVENT_CAPACITY, error, (int32_t)(capacity*1000), NULL);
+            
+            for (uint8_t page = 0; page < 7; page++)
+            {
+                uint8_t page_data[9];
+                error = DS2438_ReadPage(page, page_data);
+                Telemetry_Push(DS2438_EVENT_PAGE, error, page, page_data);
+            }
+            DS2438_AccumulatorsPoll();
+            if (DS2438_PollHistory() == DS2438_OK)
+            {
+                DS2438_History history;
+                if (DS2438_GetHistory(&history) == DS2438_OK)
+                {
+                    uint8_t data[4] = {history.cca & 0xFF, history.cca >> 8, history.dca & 0xFF, history.dca >> 8};
+                    Telemetry_Push(DS2438_EVENT_HISTORY, DS2438_OK, (int32_t)history.elapsed_time, data);
+                }
+            }
+            
+            // Log raw page 0, 1 and 7 values
+            uint8_t page_0[9], page_1[9], page_7[9];
+            if ((DS2438_ReadPage(0x00, page_0) == DS2438_OK) &&
+                (DS2438_ReadPage(0x01, page_1) == DS2438_OK) &&
+                (DS2438_ReadPage(0x07, page_7) == DS2438_OK))
+            {
+                DS2438_LogSample sample;
+                sample.timestamp_ms = Timebase_GetMs();
+                sample.temperature = (page_0[2] << 8) | page_0[1];
+                sample.voltage = (page_0[4] << 8) | page_0[3];
+                sample.current = (page_0[6] << 8) | page_0[5];
+                sample.ica = page_1[4];
+                sample.cca = DS2438_DecodeCCA(page_7);
+                sample.dca = DS2438_DecodeDCA(page_7);
+                DS2438_LogAppend(&sample);
+            }
+            // Flash writes only happen in the idle time before the next cycle
+            int32_t idle_ms = (int32_t)(next_cycle_ms - Timebase_GetMs());
+            if (idle_ms > 0)
+            {
+                DS2438_LogService(idle_ms);
+            }
+        }
+        
+        // Resets only when the bus is idle, so between measurement cycles
+        DS2438_PresencePoll();
+        
+        // Output only as much as the UART can take without blocking
+        Telemetry_Drain();
+    }
+}
+
+
+/* [] END OF FILE */
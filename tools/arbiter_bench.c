@@ -0,0 +1,436 @@
+/********************************************
+*
+*   \brief Bus arbitration benchmark.
+*
+*   Runs a mixed workload on a simulated 1-Wire bus, first
+*   with the executor of DS2438_Async.h, which runs the
+*   operations of a pin one after the other, then with the
+*   arbiter of DS2438_Arbiter.h, and compares the latency of
+*   each priority class:
+*   - urgent: read of page 0 of the first device, with the
+*     current, every few ms (the overcurrent check), or of
+*     another page with -p;
+*   - normal: temperature and voltage conversions of every
+*     device, every second;
+*   - background: dump of all the pages of every device,
+*     back to back, and write of page 3 of the first device
+*     every few seconds.
+*
+*   The devices are simulated with the pin-level model of
+*   tools/host/ds2438_model.h, addressed with SKIP ROM when
+*   there is one device and MATCH ROM otherwise. The pages
+*   dumped and written are checked against the model, to
+*   verify that interleaving the operations never returns
+*   the scratchpad of another operation.
+*
+*   Reported, for each class: operations completed, failed
+*   (CRC, presence or wrong contents) and missed (still in
+*   progress when due), mean and maximum latency from the
+*   time an operation is due to its completion, and, for
+*   the arbiter, the longest wait of a ready step, the
+*   bound of DS2438_ArbiterGetBound(), with the copy wait
+*   when the urgent page is the written one (-p 3), and
+*   the steps run ahead of the higher classes. Checked,
+*   for the arbiter: every class completes operations,
+*   none fails, even when the urgent class alone would keep the bus
+*   busy (-d 3); the urgent class, the only one alone in
+*   its class with no higher one, waits within the bound
+*   of DS2438_ArbiterGetBound(), and every class within
+*   the bound of DS2438_ArbiterGetAgingBound(). The exit
+*   status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o arbiter_bench tools/arbiter_bench.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/DS2438_Async.c
+*       DS2438.cydsn/DS2438_Arbiter.c DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c
+*       DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c DS2438.cydsn/DS2438_Snapshot.c
+*       DS2438.cydsn/DS2438_Accumulators.c DS2438.cydsn/DS2438_History.c DS2438.cydsn/DS2438_Storage.c
+*   Usage: arbiter_bench [-d devices] [-t seconds] [-u urgent_ms] [-w write_ms] [-p urgent_page]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438_Arbiter.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_DEVICES     3
+#define WRITE_PAGE      3
+#define PATTERNS        32
+
+typedef struct {
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t missed;
+    uint64_t sum_us;
+    uint64_t max_us;
+} ClassResults;
+
+typedef struct {
+    DS2438_Model model;
+    DS2438_AsyncOp sample_op;       // Temperature, then voltage
+    DS2438_AsyncOp dump_op;
+    uint8_t dump[8 * 9];
+    uint64_t dump_start_us;
+    uint32_t dump_patterns;         // Patterns written to page 3 when the dump started
+    uint64_t sample_due_us;         // Sample in progress
+} Device;
+
+// Parameters of a run
+static uint8_t n_devices = 1;
+static uint32_t duration_s = 20;
+static uint32_t urgent_us = 20000;
+static uint32_t write_us = 2000000;
+static uint8_t urgent_page = 0;
+
+static Device devices[MAX_DEVICES];
+static DS2438_Model* models[MAX_DEVICES];
+static DS2438_ModelBus model_bus;
+static DS2438_Executor executor;
+static DS2438_Arbiter arbiter;
+static uint8_t use_arbiter;
+static ClassResults results[DS2438_ARBITER_PRIORITIES];
+
+static DS2438_AsyncOp urgent_op;
+static uint64_t urgent_due_us;      // Next check
+static uint64_t urgent_start_us;    // Check in progress
+static DS2438_AsyncOp write_op;
+static uint64_t write_due_us;
+static uint64_t write_start_us;
+static uint8_t patterns[PATTERNS][8];   // Last patterns written to page 3, the first one is its initial contents
+static uint32_t n_patterns;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ===========================================================
+//                      OPERATIONS
+// ===========================================================
+
+static void Bench_Submit(DS2438_AsyncOp* op, uint8_t priority, Device* device)
+{
+    if (n_devices > 1)
+        DS2438_AsyncSetRom(op, device->model.rom);
+    if (use_arbiter)
+        DS2438_ArbiterSubmit(&arbiter, op, priority);
+    else
+        DS2438_ExecutorSubmit(&executor, op);
+}
+
+// Latency of an operation from the time it was due
+static void Bench_Complete(uint8_t priority, uint64_t due_us, uint8_t ok)
+{
+    ClassResults* r = &results[priority];
+    uint64_t latency_us = Host_GetUs() - due_us;
+    if (!ok)
+    {
+        r->failed++;
+        return;
+    }
+    r->completed++;
+    r->sum_us += latency_us;
+    if (latency_us > r->max_us)
+        r->max_us = latency_us;
+}
+
+static void Bench_OnUrgent(DS2438_AsyncOp* op, void* context)
+{
+    (void)context;
+    Bench_Complete(DS2438_PRIORITY_URGENT, urgent_start_us, op->error == DS2438_OK);
+}
+
+static void Bench_OnVoltage(DS2438_AsyncOp* op, void* context)
+{
+    Device* device = context;
+    Bench_Complete(DS2438_PRIORITY_NORMAL, device->sample_due_us, op->error == DS2438_OK);
+}
+
+static void Bench_OnTemperature(DS2438_AsyncOp* op, void* context)
+{
+    Device* device = context;
+    if (op->error != DS2438_OK)
+    {
+        Bench_Complete(DS2438_PRIORITY_NORMAL, device->sample_due_us, 0);
+        return;
+    }
+    DS2438_AsyncReadVoltage(op, 0, Bench_OnVoltage, device);
+    Bench_Submit(op, DS2438_PRIORITY_NORMAL, device);
+}
+
+// Page 3 of the first device holds one of the patterns written from the one in
+// memory when the dump started, as it is read once during the dump
+static uint8_t Bench_CheckPattern(const Device* device, const uint8_t* data)
+{
+    if ((device != &devices[0]) || (n_patterns - device->dump_patterns >= PATTERNS - 1))
+        return 0;
+    for (uint32_t n = device->dump_patterns - 1; n < n_patterns; n++)
+    {
+        if (memcmp(data, patterns[n % PATTERNS], 8) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Pages 4 to 7 never change, except the accumulators at the end of page 7
+static uint8_t Bench_CheckDump(const Device* device)
+{
+    for (uint8_t page = 3; page < 8; page++)
+    {
+        const uint8_t* data = &device->dump[page * 9];
+        if (memcmp(data, device->model.memory[page], (page == 7) ? 4 : 8) == 0)
+            continue;
+        if ((page == 3) && Bench_CheckPattern(device, data))
+            continue;
+        return 0;
+    }
+    return 1;
+}
+
+static void Bench_OnDump(DS2438_AsyncOp* op, void* context);
+
+// Dumps are run back to back
+static void Bench_StartDump(Device* device)
+{
+    device->dump_start_us = Host_GetUs();
+    device->dump_patterns = n_patterns;
+    DS2438_AsyncReadPages(&device->dump_op, 0, 0, 8, device->dump, Bench_OnDump, device);
+    Bench_Submit(&device->dump_op, DS2438_PRIORITY_BACKGROUND, device);
+}
+
+static void Bench_OnDump(DS2438_AsyncOp* op, void* context)
+{
+    Device* device = context;
+    uint8_t ok = (op->error == DS2438_OK) && Bench_CheckDump(device);
+    Bench_Complete(DS2438_PRIORITY_BACKGROUND, device->dump_start_us, ok);
+    Bench_StartDump(device);
+}
+
+static void Bench_OnWrite(DS2438_AsyncOp* op, void* context)
+{
+    (void)context;
+    uint8_t ok = (op->error == DS2438_OK) &&
+                 (memcmp(devices[0].model.memory[3], patterns[(n_patterns - 1) % PATTERNS], 8) == 0);
+    Bench_Complete(DS2438_PRIORITY_BACKGROUND, write_start_us, ok);
+}
+
+// Submit the operations that are due
+static void Bench_Schedule(uint64_t now_us)
+{
+    if (now_us >= urgent_due_us)
+    {
+        if (urgent_op.busy)
+        {
+            results[DS2438_PRIORITY_URGENT].missed++;
+        }
+        else
+        {
+            urgent_start_us = urgent_due_us;
+            DS2438_AsyncReadPage(&urgent_op, 0, urgent_page, Bench_OnUrgent, NULL);
+            Bench_Submit(&urgent_op, DS2438_PRIORITY_URGENT, &devices[0]);
+        }
+        urgent_due_us += urgent_us;
+    }
+    if (now_us >= write_due_us)
+    {
+        if (!write_op.busy)
+        {
+            write_start_us = write_due_us;
+            for (uint8_t i = 0; i < 8; i++)
+                patterns[n_patterns % PATTERNS][i] = Random();
+            DS2438_AsyncWritePage(&write_op, 0, WRITE_PAGE, patterns[n_patterns % PATTERNS], Bench_OnWrite, NULL);
+            n_patterns++;
+            Bench_Submit(&write_op, DS2438_PRIORITY_BACKGROUND, &devices[0]);
+        }
+        write_due_us += write_us;
+    }
+    for (uint8_t n = 0; n < n_devices; n++)
+    {
+        Device* device = &devices[n];
+        if (now_us < device->sample_due_us + 1000000)
+            continue;
+        device->sample_due_us += 1000000;
+        if (device->sample_op.busy)
+        {
+            results[DS2438_PRIORITY_NORMAL].missed++;
+            continue;
+        }
+        device->model.temperature = (20 + Random() % 20) << 8;
+        DS2438_AsyncReadTemperature(&device->sample_op, 0, Bench_OnTemperature, device);
+        Bench_Submit(&device->sample_op, DS2438_PRIORITY_NORMAL, device);
+    }
+}
+
+// ===========================================================
+//                      RUN
+// ===========================================================
+
+static void Bench_Run(uint8_t arbitrated)
+{
+    use_arbiter = arbitrated;
+    seed = 1;
+    memset(results, 0, sizeof(results));
+    for (uint8_t n = 0; n < n_devices; n++)
+    {
+        Device* device = &devices[n];
+        DS2438_ModelInit(&device->model, 0x100 + n);
+        for (uint8_t page = 3; page < 8; page++)
+        {
+            for (uint8_t i = 0; i < 8; i++)
+                device->model.memory[page][i] = Random();
+        }
+        models[n] = &device->model;
+        device->sample_op.busy = 0;
+        device->dump_op.busy = 0;
+    }
+    memcpy(patterns[0], devices[0].model.memory[WRITE_PAGE], 8);
+    n_patterns = 1;
+    urgent_op.busy = 0;
+    write_op.busy = 0;
+    DS2438_ModelBusInit(&model_bus, models, n_devices);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    Timebase_Start();
+    DS2438_ExecutorInit(&executor);
+    DS2438_ArbiterInit(&arbiter);
+
+    uint64_t start_us = Host_GetUs();
+    uint64_t end_us = start_us + (uint64_t)duration_s * 1000000;
+    urgent_due_us = start_us;
+    write_due_us = start_us + write_us;
+    for (uint8_t n = 0; n < n_devices; n++)
+    {
+        devices[n].sample_due_us = start_us - 1000000 + n * 1000;
+        Bench_StartDump(&devices[n]);
+    }
+
+    while (Host_GetUs() < end_us)
+    {
+        Bench_Schedule(Host_GetUs());
+        uint32_t wake_us;
+        uint8_t pending;
+        uint64_t before_us = Host_GetUs();
+        if (use_arbiter)
+        {
+            DS2438_ArbiterRun(&arbiter);
+            pending = DS2438_ArbiterNextWake(&arbiter, &wake_us);
+        }
+        else
+        {
+            DS2438_ExecutorRun(&executor);
+            pending = DS2438_ExecutorNextWake(&executor, &wake_us);
+        }
+        if (Host_GetUs() != before_us)
+            continue;
+
+        // Nothing was run: sleep until the next wake or due time
+        uint64_t next_us = urgent_due_us;
+        if (write_due_us < next_us)
+            next_us = write_due_us;
+        for (uint8_t n = 0; n < n_devices; n++)
+        {
+            if (devices[n].sample_due_us + 1000000 < next_us)
+                next_us = devices[n].sample_due_us + 1000000;
+        }
+        if (pending > 0)
+        {
+            int32_t wait_us = (int32_t)(wake_us - Timebase_GetUs());
+            uint64_t at_us = Host_GetUs() + ((wait_us > 0) ? (uint64_t)wait_us : 0);
+            if (at_us < next_us)
+                next_us = at_us;
+        }
+        Host_AdvanceUs((next_us > Host_GetUs()) ? (next_us - Host_GetUs()) : 1);
+    }
+}
+
+// Returns 1 if a class of the arbiter completed nothing or waited longer than its bound
+static int Bench_Report(const char* mode)
+{
+    static const char* const names[] = {"urgent", "normal", "background"};
+    int failed = 0;
+    for (uint8_t p = 0; p < DS2438_ARBITER_PRIORITIES; p++)
+    {
+        const ClassResults* r = &results[p];
+        printf("%-9s %-11s %8llu %6llu %6llu %10.2f %10.2f", mode, names[p], (unsigned long long)r->completed,
+               (unsigned long long)r->failed, (unsigned long long)r->missed,
+               r->completed ? r->sum_us / (1000.0 * r->completed) : 0.0, r->max_us / 1000.0);
+        if (use_arbiter)
+        {
+            DS2438_ArbiterStats stats;
+            DS2438_ArbiterGetStats(&arbiter, p, &stats);
+            uint32_t bound_us = DS2438_ArbiterGetBound(0, p, urgent_page == WRITE_PAGE);
+            if (p != DS2438_PRIORITY_URGENT)
+                bound_us = DS2438_ArbiterGetAgingBound(0, 1);
+            printf(" %10.2f %10.2f %8lu %6lu", stats.max_wait_us / 1000.0, bound_us / 1000.0,
+                   (unsigned long)stats.repeated, (unsigned long)stats.aged);
+            if (r->completed == 0)
+            {
+                printf("  starved");
+                failed = 1;
+            }
+            if (r->failed != 0)
+            {
+                printf("  failed");
+                failed = 1;
+            }
+            if (stats.max_wait_us > bound_us)
+            {
+                printf("  bound exceeded");
+                failed = 1;
+            }
+        }
+        printf("\n");
+    }
+    return failed;
+}
+
+// ===========================================================
+//                      MAIN
+// ===========================================================
+
+int main(int argc, char** argv)
+{
+    int option;
+    while ((option = getopt(argc, argv, "d:t:u:w:p:")) != -1)
+    {
+        switch (option)
+        {
+            case 'd': n_devices = atoi(optarg); break;
+            case 't': duration_s = atoi(optarg); break;
+            case 'u': urgent_us = atoi(optarg) * 1000; break;
+            case 'w': write_us = atoi(optarg) * 1000; break;
+            case 'p': urgent_page = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-d devices] [-t seconds] [-u urgent_ms] [-w write_ms] [-p urgent_page]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if ((n_devices < 1) || (n_devices > MAX_DEVICES) || (duration_s == 0) || (urgent_us == 0) || (write_us == 0) ||
+        (urgent_page > 7))
+    {
+        fprintf(stderr, "1 to %d devices, non-zero durations, pages 0 to 7\n", MAX_DEVICES);
+        return 1;
+    }
+
+    printf("%u device(s), %u s, urgent page %u every %u ms, write every %u ms\n\n", n_devices, duration_s,
+           urgent_page, urgent_us / 1000, write_us / 1000);
+    printf("%-9s %-11s %8s %6s %6s %10s %10s %10s %10s %8s %6s\n", "mode", "class", "done", "failed", "missed",
+           "mean ms", "max ms", "wait ms", "bound ms", "repeated", "aged");
+    Bench_Run(0);
+    Bench_Report("executor");
+    Bench_Run(1);
+    int failed = Bench_Report("arbiter");
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed;
+}
+
+/* [] END OF FILE */
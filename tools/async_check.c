@@ -0,0 +1,296 @@
+/********************************************
+*
+*   \brief Host check of the non-blocking operations of
+*   DS2438_Async.h.
+*
+*   Runs the step machine on a simulated device (see
+*   tools/host/ds2438_model.h) and checks:
+*   - every kind of operation against the model: page
+*     read, read of consecutive pages, page write with
+*     the wait for the copy, conversions;
+*   - preemption: a read repeats its recall when another
+*     operation filled the scratchpad of its page, and a
+*     copy whose transaction was closed is waited for its
+*     longest duration;
+*   - the state of the blocking API, when the operations
+*     address its device: a page written is seen by cached
+*     reads, the copy is tracked (a blocking read of the
+*     page waits for it), a write waits for a copy of the
+*     blocking API, a conversion invalidates page 0 and a
+*     page read fills the cache;
+*   - an operation on another device, addressed by ROM,
+*     leaves the cache alone.
+*
+*   The exit status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o async_check tools/async_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/DS2438_Async.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c
+*       DS2438.cydsn/DS2438_Cache.c DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: async_check
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "DS2438_Async.h"
+#include "DS2438_Cache.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <string.h>
+
+static DS2438_Model models[2];
+static DS2438_Model* model_list[2] = {&models[0], &models[1]};
+static DS2438_ModelBus model_bus;
+static DS2438_Executor executor;
+static int failed = 0;
+
+static uint32_t seed = 1;
+
+static uint8_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 16) & 0xFF;
+}
+
+static void Check(int condition, const char* what)
+{
+    printf("  %-64s %s\n", what, condition ? "ok" : "FAIL");
+    if (!condition)
+        failed++;
+}
+
+static void Check_RandomPage(uint8_t* page_data)
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        page_data[i] = Random();
+    }
+}
+
+// Run the executor until the operation completes, sleeping until the next wake
+static uint8_t Check_Run(DS2438_AsyncOp* op)
+{
+    uint32_t wake_us;
+    DS2438_ExecutorSubmit(&executor, op);
+    while (DS2438_ExecutorRun(&executor) != 0)
+    {
+        DS2438_ExecutorNextWake(&executor, &wake_us);
+        if (!Timebase_IsExpired(wake_us))
+            Host_AdvanceUs(wake_us - Timebase_GetUs());
+    }
+    return op->error;
+}
+
+// Submit an operation without running it, to run its steps one by one
+static void Check_Submit(DS2438_AsyncOp* op)
+{
+    DS2438_Executor unused;
+    DS2438_ExecutorInit(&unused);
+    DS2438_ExecutorSubmit(&unused, op);
+}
+
+// Run the steps of a submitted operation until it completes
+static void Check_Finish(DS2438_AsyncOp* op)
+{
+    while (op->busy)
+    {
+        if (!Timebase_IsExpired(op->wake_us))
+            Host_AdvanceUs(op->wake_us - Timebase_GetUs());
+        DS2438_AsyncStep(op);
+    }
+}
+
+// ===========================================================
+//                      OPERATIONS
+// ===========================================================
+
+static void Check_Operations(void)
+{
+    DS2438_AsyncOp op;
+    uint8_t page_data[8];
+    uint8_t pages[8 * 9];
+
+    printf("operations\n");
+    Check_RandomPage(models[0].memory[3]);
+    DS2438_AsyncReadPage(&op, DS2438_Pin_0, 3, NULL, NULL);
+    Check((Check_Run(&op) == DS2438_OK) && (memcmp(op.page_data, models[0].memory[3], 8) == 0), "read page");
+
+    for (uint8_t page = 3; page < 7; page++)
+    {
+        Check_RandomPage(models[0].memory[page]);
+    }
+    DS2438_AsyncReadPages(&op, DS2438_Pin_0, 3, 4, pages, NULL, NULL);
+    int same = (Check_Run(&op) == DS2438_OK);
+    for (uint8_t page = 3; page < 7; page++)
+    {
+        same &= (memcmp(&pages[(page - 3) * 9], models[0].memory[page], 8) == 0);
+    }
+    Check(same, "read of pages 3 to 6");
+
+    Check_RandomPage(page_data);
+    DS2438_AsyncWritePage(&op, DS2438_Pin_0, 5, page_data, NULL, NULL);
+    Check((Check_Run(&op) == DS2438_OK) && (memcmp(models[0].memory[5], page_data, 8) == 0) &&
+          (Host_GetUs() >= models[0].copy_until_us), "write page, completed after the copy");
+
+    models[0].temperature = 0x1B40;
+    DS2438_AsyncReadTemperature(&op, DS2438_Pin_0, NULL, NULL);
+    Check((Check_Run(&op) == DS2438_OK) && (op.value == 0x1B40), "temperature conversion");
+
+    models[0].vdd = 417;
+    DS2438_AsyncReadVoltage(&op, DS2438_Pin_0, NULL, NULL);
+    Check((Check_Run(&op) == DS2438_OK) && (op.value == 417), "voltage conversion");
+}
+
+static void Check_Preemption(void)
+{
+    DS2438_AsyncOp read, write;
+    uint8_t page_data[8];
+
+    printf("preemption\n");
+    // The write fills the scratchpad of page 3 between the recall and the read
+    Check_RandomPage(models[0].memory[3]);
+    Check_RandomPage(page_data);
+    DS2438_AsyncReadPage(&read, DS2438_Pin_0, 3, NULL, NULL);
+    DS2438_AsyncWritePage(&write, DS2438_Pin_0, 3, page_data, NULL, NULL);
+    Check_Submit(&read);
+    Check_Submit(&write);
+    DS2438_AsyncStep(&read);
+    DS2438_AsyncStep(&write);
+    Check(DS2438_AsyncPreempt(&read, &write) == 1, "read repeats its recall");
+    Check_Finish(&read);
+    Check((read.error == DS2438_OK) && (memcmp(read.page_data, models[0].memory[3], 8) == 0),
+          "read returns the page, not the scratchpad of the write");
+    Check_Finish(&write);
+
+    // The read closes the transaction of the copy
+    Check_RandomPage(page_data);
+    DS2438_AsyncWritePage(&write, DS2438_Pin_0, 6, page_data, NULL, NULL);
+    DS2438_AsyncReadPage(&read, DS2438_Pin_0, 2, NULL, NULL);
+    Check_Submit(&write);
+    Check_Submit(&read);
+    DS2438_AsyncStep(&write);
+    DS2438_AsyncStep(&write);
+    uint32_t copy_us = Timebase_GetUs();
+    DS2438_AsyncStep(&read);
+    DS2438_AsyncPreempt(&write, &read);
+    Check_Finish(&write);
+    Check((write.error == DS2438_OK) && (memcmp(models[0].memory[6], page_data, 8) == 0) &&
+          (Timebase_GetUs() - copy_us >= DS2438_COPY_TIME_US), "copy waited for its longest duration");
+    Check_Finish(&read);
+}
+
+// ===========================================================
+//                      BLOCKING API
+// ===========================================================
+
+static void Check_BlockingApi(void)
+{
+    DS2438_AsyncOp op;
+    uint8_t page_data[9];
+    uint8_t written[9] = {0};
+    uint32_t recall_us;
+    uint8_t copy = 0;
+
+    printf("state of the blocking API\n");
+    DS2438_ReadPage(4, page_data);
+    Check_RandomPage(written);
+    DS2438_AsyncWritePage(&op, DS2438_Pin_0, 4, written, NULL, NULL);
+    Check_Run(&op);
+    Check((DS2438_ReadPage(4, page_data) == DS2438_OK) && (memcmp(page_data, written, 8) == 0),
+          "cached read sees the page written");
+
+    // Stop after the copy command
+    Check_RandomPage(written);
+    DS2438_AsyncWritePage(&op, DS2438_Pin_0, 4, written, NULL, NULL);
+    Check_Submit(&op);
+    DS2438_AsyncStep(&op);
+    DS2438_AsyncStep(&op);
+    uint64_t copy_until_us = models[0].copy_until_us;
+    DS2438_CopyInProgress(&copy);
+    Check(copy == 1, "copy tracked by the blocking API");
+    Check((DS2438_ReadPageTimestamped(4, page_data, &recall_us) == DS2438_OK) &&
+          (memcmp(page_data, written, 8) == 0) && (Host_GetUs() >= copy_until_us),
+          "blocking read of the page waits for the copy");
+    Check_Finish(&op);
+
+    // Write with a copy of the blocking API in progress
+    uint8_t blocking[9] = {0};
+    Check_RandomPage(blocking);
+    Check_RandomPage(written);
+    DS2438_WritePageAsync(5, blocking, NULL);
+    copy_until_us = models[0].copy_until_us;
+    DS2438_AsyncWritePage(&op, DS2438_Pin_0, 5, written, NULL, NULL);
+    DS2438_ExecutorSubmit(&executor, &op);
+    DS2438_ExecutorRun(&executor);
+    Check((Host_GetUs() < copy_until_us) && (memcmp(models[0].scratchpad[5], blocking, 8) == 0),
+          "write waits for a copy of the blocking API");
+    DS2438_ExecutorInit(&executor);
+    Check((Check_Run(&op) == DS2438_OK) && (memcmp(models[0].memory[5], written, 8) == 0),
+          "write completed after it");
+
+    // Measurements are not cached by default
+    DS2438_CacheSetMaxAge(DS2438_GetPageCache(), DS2438_CACHE_MEASUREMENT, 1000);
+    uint16_t temperature = 0;
+    DS2438_ReadPage(0, page_data);
+    models[0].temperature = 0x1C80;
+    DS2438_AsyncReadTemperature(&op, DS2438_Pin_0, NULL, NULL);
+    Check_Run(&op);
+    Check((DS2438_GetRawTemperatureData(&temperature) == DS2438_OK) && (temperature == 0x1C80),
+          "cached read sees the conversion");
+    DS2438_CacheSetMaxAge(DS2438_GetPageCache(), DS2438_CACHE_MEASUREMENT, DS2438_CACHE_MEASUREMENT_MAX_AGE_MS);
+
+    uint32_t hits, misses, hits_after;
+    Check_RandomPage(models[0].memory[6]);
+    DS2438_AsyncReadPage(&op, DS2438_Pin_0, 6, NULL, NULL);
+    Check_Run(&op);
+    DS2438_CacheGetStats(DS2438_GetPageCache(), &hits, &misses);
+    DS2438_ReadPage(6, page_data);
+    DS2438_CacheGetStats(DS2438_GetPageCache(), &hits_after, &misses);
+    Check((hits_after == hits + 1) && (memcmp(page_data, models[0].memory[6], 8) == 0),
+          "page read fills the cache");
+}
+
+static void Check_OtherDevice(void)
+{
+    DS2438_AsyncOp op;
+    uint8_t page_data[9], cached[9], written[8];
+
+    printf("device addressed by ROM\n");
+    DS2438_ModelBusInit(&model_bus, model_list, 2);
+    DS2438_CacheLookup(DS2438_GetPageCache(), 4, cached);
+    Check_RandomPage(written);
+    DS2438_AsyncWritePage(&op, DS2438_Pin_0, 4, written, NULL, NULL);
+    DS2438_AsyncSetRom(&op, models[1].rom);
+    Check((Check_Run(&op) == DS2438_OK) && (memcmp(models[1].memory[4], written, 8) == 0),
+          "write to the second device");
+    Check((DS2438_CacheLookup(DS2438_GetPageCache(), 4, page_data) == DS2438_OK) &&
+          (memcmp(page_data, cached, 8) == 0) && (memcmp(models[0].memory[4], cached, 8) == 0),
+          "cache of the blocking API unchanged");
+}
+
+int main(void)
+{
+    DS2438_ModelInit(&models[0], 0x0102030405ull);
+    DS2438_ModelInit(&models[1], 0x0A0B0C0D0Eull);
+    DS2438_ModelBusInit(&model_bus, model_list, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+    DS2438_ExecutorInit(&executor);
+
+    Check_Operations();
+    Check_Preemption();
+    Check_BlockingApi();
+    Check_OtherDevice();
+
+    printf("%d failed\n", failed);
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
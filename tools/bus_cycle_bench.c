@@ -0,0 +1,231 @@
+/********************************************
+*
+*   \brief Sample cycle benchmark for buses shared by
+*   several device families.
+*
+*   Builds a simulated bus with DS2438, DS18B20 and DS2431
+*   devices (see tools/host/ds2438_model.h), finds them with
+*   OneWire_ScanBus(), and runs sample cycles of the device
+*   layer of OneWire_Device.h: first with the conversions
+*   started on each device, then with the compatible ones
+*   started once for all the devices. The measurements
+*   change at every cycle, and every value read is checked
+*   against the device model. The DS2431 rows are written
+*   and read back between cycles.
+*
+*   Reported, for each mode: transactions and bus time per
+*   cycle, duration of a cycle, and reads that failed or
+*   returned a wrong value.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o bus_cycle_bench tools/bus_cycle_bench.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire_Device.c
+*       DS2438.cydsn/DS2438_Driver.c DS2438.cydsn/DS18B20.c DS2438.cydsn/DS2431.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c
+*   Usage: bus_cycle_bench [-a ds2438] [-b ds18b20] [-e ds2431] [-n cycles]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "OneWire_Device.h"
+#include "DS2438_Driver.h"
+#include "DS18B20.h"
+#include "DS2431.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_MODELS  ONEWIRE_MAX_DEVICES
+
+static uint8_t n_ds2438 = 2;
+static uint8_t n_ds18b20 = 3;
+static uint8_t n_ds2431 = 1;
+static uint32_t n_cycles = 20;
+
+static DS2438_Model models[MAX_MODELS];
+static DS2438_Model* model_list[MAX_MODELS];
+static uint8_t n_models;
+static DS2438_ModelBus model_bus;
+static OneWire_DeviceBus bus;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static DS2438_Model* Bench_FindModel(const uint8_t* rom)
+{
+    for (uint8_t m = 0; m < n_models; m++)
+    {
+        if (memcmp(models[m].rom, rom, 8) == 0)
+            return &models[m];
+    }
+    return NULL;
+}
+
+// New measurements for the next cycle
+static void Bench_Vary(void)
+{
+    for (uint8_t m = 0; m < n_models; m++)
+    {
+        models[m].temperature = ((Random() % 60) << 8) | ((Random() % 16) << 4);
+        models[m].vdd = 300 + Random() % 300;
+        models[m].current = (int16_t)(Random() % 2001) - 1000;
+    }
+}
+
+// Check the values read by a cycle against the models
+static uint32_t Bench_Check(void)
+{
+    uint32_t wrong = 0;
+    for (uint8_t d = 0; d < bus.count; d++)
+    {
+        const OneWire_Device* device = &bus.devices[d];
+        const DS2438_Model* model = Bench_FindModel(device->rom);
+        float value;
+        if (device->rom[0] == DS2438_FAMILY_CODE)
+        {
+            float temperature, voltage, current;
+            if ((DS2438_DeviceGetTemperature(device, &temperature) != DS2438_OK) ||
+                (DS2438_DeviceGetVoltage(device, &voltage) != DS2438_OK) ||
+                (DS2438_DeviceGetCurrent(device, &current) != DS2438_OK) ||
+                (temperature != (int16_t)model->temperature / 256.0f) ||
+                (fabsf(voltage - model->vdd / 100.0f) > 0.001f) ||
+                (fabs(current - model->current / (4096.0 * DS2438_SENSE_RESISTOR)) > 0.001))
+                wrong++;
+        }
+        else if (device->rom[0] == DS18B20_FAMILY_CODE)
+        {
+            if ((DS18B20_GetTemperature(device, &value) != DS2438_OK) ||
+                (value != ((int16_t)model->temperature >> 4) / 16.0f))
+                wrong++;
+        }
+    }
+    return wrong;
+}
+
+// Write a row of each DS2431 and read the memory back
+static uint32_t Bench_Eeprom(uint32_t cycle)
+{
+    uint32_t wrong = 0;
+    for (uint8_t d = 0; d < bus.count; d++)
+    {
+        const OneWire_Device* device = &bus.devices[d];
+        if (device->rom[0] != DS2431_FAMILY_CODE)
+            continue;
+        uint8_t row[8], memory[128];
+        uint8_t address = (cycle % 16) * 8;
+        for (uint8_t i = 0; i < 8; i++)
+            row[i] = Random();
+        if ((DS2431_WriteRow(device, address, row) != DS2438_OK) ||
+            (DS2431_ReadMemory(device, 0, memory, sizeof(memory)) != DS2438_OK) ||
+            (memcmp(&memory[address], row, 8) != 0) ||
+            (memcmp(memory, Bench_FindModel(device->rom)->eeprom, sizeof(memory)) != 0))
+            wrong++;
+    }
+    return wrong;
+}
+
+static void Bench_Run(uint8_t batch)
+{
+    OneWire_Cycle cycle;
+    uint64_t transactions = 0, bus_us = 0, cycle_us = 0;
+    uint32_t failed = 0, wrong = 0, eeprom_wrong = 0;
+
+    seed = 1;
+    for (uint32_t n = 0; n < n_cycles; n++)
+    {
+        Bench_Vary();
+        OneWire_CycleStart(&cycle, &bus, batch);
+        while (OneWire_CycleRun(&cycle))
+        {
+            uint32_t wake_us;
+            if (OneWire_CycleNextWake(&cycle, &wake_us))
+            {
+                int32_t wait_us = (int32_t)(wake_us - Timebase_GetUs());
+                if (wait_us > 0)
+                    Host_AdvanceUs(wait_us);
+            }
+        }
+        transactions += cycle.transactions;
+        bus_us += cycle.bus_us;
+        cycle_us += cycle.cycle_us;
+        failed += cycle.errors;
+        wrong += Bench_Check();
+        eeprom_wrong += Bench_Eeprom(n);
+    }
+    printf("%-9s %8.1f %10.2f %10.2f %7lu %7lu %7lu\n", batch ? "batched" : "addressed",
+           (double)transactions / n_cycles, bus_us / (1000.0 * n_cycles), cycle_us / (1000.0 * n_cycles),
+           (unsigned long)failed, (unsigned long)wrong, (unsigned long)eeprom_wrong);
+}
+
+int main(int argc, char** argv)
+{
+    int option;
+    while ((option = getopt(argc, argv, "a:b:e:n:")) != -1)
+    {
+        switch (option)
+        {
+            case 'a': n_ds2438 = atoi(optarg); break;
+            case 'b': n_ds18b20 = atoi(optarg); break;
+            case 'e': n_ds2431 = atoi(optarg); break;
+            case 'n': n_cycles = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-a ds2438] [-b ds18b20] [-e ds2431] [-n cycles]\n", argv[0]);
+                return 1;
+        }
+    }
+    n_models = n_ds2438 + n_ds18b20 + n_ds2431;
+    if ((n_models == 0) || (n_models > MAX_MODELS) || (n_cycles == 0))
+    {
+        fprintf(stderr, "1 to %d devices, at least one cycle\n", MAX_MODELS);
+        return 1;
+    }
+
+    for (uint8_t m = 0; m < n_models; m++)
+    {
+        DS2438_ModelInit(&models[m], 0x1000 + m * 0x3579);
+        if (m >= n_ds2438 + n_ds18b20)
+            DS2438_ModelSetFamily(&models[m], DS2438_MODEL_DS2431);
+        else if (m >= n_ds2438)
+            DS2438_ModelSetFamily(&models[m], DS2438_MODEL_DS18B20);
+        model_list[m] = &models[m];
+    }
+    DS2438_ModelBusInit(&model_bus, model_list, n_models);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    Timebase_Start();
+
+    OneWire_RegisterDriver(&DS2438_Driver);
+    OneWire_RegisterDriver(&DS18B20_Driver);
+    OneWire_RegisterDriver(&DS2431_Driver);
+    uint8_t error = OneWire_ScanBus(&bus, 0);
+    if ((error != DS2438_OK) || (bus.count != n_models))
+    {
+        fprintf(stderr, "Scan failed: error %u, %u of %u devices\n", error, bus.count, n_models);
+        return 1;
+    }
+    printf("%u DS2438, %u DS18B20, %u DS2431, %u cycles\n", n_ds2438, n_ds18b20, n_ds2431, n_cycles);
+    for (uint8_t d = 0; d < bus.count; d++)
+    {
+        const OneWire_Device* device = &bus.devices[d];
+        printf("  %02X%02X%02X%02X%02X%02X%02X%02X %s\n", device->rom[0], device->rom[1], device->rom[2],
+               device->rom[3], device->rom[4], device->rom[5], device->rom[6], device->rom[7],
+               device->driver ? device->driver->name : "unknown");
+    }
+
+    printf("\n%-9s %8s %10s %10s %7s %7s %7s\n", "mode", "trans", "bus ms", "cycle ms", "failed", "wrong",
+           "eeprom");
+    Bench_Run(0);
+    Bench_Run(1);
+    return 0;
+}
+
+/* [] END OF FILE */
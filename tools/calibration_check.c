@@ -0,0 +1,157 @@
+/********************************************
+*
+*   \brief Host check of DS2438_CalibrateTiming().
+*
+*   Runs the calibration on a simulated device (see
+*   tools/host/ds2438_model.h) for several rise times of
+*   the line, and compares the calibrated timing with
+*   ONEWIRE_PROFILE_STANDARD: ROM and page reads are
+*   repeated with each timing, and the bus time of a page
+*   read is measured.
+*
+*   Reported, for each rise time: errors and bus time of
+*   a page read with the standard timing, the result of
+*   the calibration, its recovery times (delays B, D, F
+*   and J), and errors and bus time of a page read with
+*   the calibrated timing. Checked: when the standard
+*   timing reads without errors, the calibration succeeds,
+*   its timing reads without errors either, is not slower
+*   than the standard timing, and waits for the longest
+*   presence pulse after a reset; when it does not, the
+*   calibration fails. The exit status is 1 if any check
+*   failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o calibration_check tools/calibration_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire.c
+*       DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: calibration_check [-n reads] [rise_us ...]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "OneWire.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Page read to measure the bus time
+#define PAGE                3
+
+// End of the longest presence pulse after the release of the reset (tPDH + tPDL max), in us
+#define PRESENCE_END_MAX_US 300
+
+typedef struct {
+    uint32_t errors;
+    uint64_t page_us;
+} Result;
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+
+// Read the ROM and a page with the profile attached to the bus
+static Result Check_Reads(uint32_t n_reads)
+{
+    Result result = {0, 0};
+    uint8_t rom[8], page_data[9];
+    uint32_t recall_us;
+    for (uint32_t n = 0; n < n_reads; n++)
+    {
+        if ((DS2438_ReadRawRom(rom) != DS2438_OK) || (memcmp(rom, model.rom, 8) != 0))
+            result.errors++;
+        uint64_t start_us = Host_GetDelayUs();
+        if ((DS2438_ReadPageTimestamped(PAGE, page_data, &recall_us) != DS2438_OK) ||
+            (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK) ||
+            (memcmp(page_data, model.memory[PAGE], 8) != 0))
+            result.errors++;
+        result.page_us += Host_GetDelayUs() - start_us;
+    }
+    result.page_us /= n_reads;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    static const uint16_t default_rises_us[] = {0, 2, 4, 6, 8, 10};
+    uint32_t n_reads = 100;
+    int option;
+    while ((option = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_reads = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n reads] [rise_us ...]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (n_reads == 0)
+        n_reads = 1;
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        model.memory[PAGE][i] = 0x11 * (i + 1);
+    }
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+
+    int n_rises = (optind < argc) ? argc - optind : (int)(sizeof(default_rises_us) / sizeof(default_rises_us[0]));
+    int failed = 0;
+    printf("%7s | %8s %10s | %6s %4s %4s %4s %4s %8s %10s | %5s\n", "rise us", "standard", "page us",
+           "calib", "B", "D", "F", "J", "errors", "page us", "gain");
+    for (int n = 0; n < n_rises; n++)
+    {
+        uint16_t rise_us = (optind < argc) ? atoi(argv[optind + n]) : default_rises_us[n];
+        model_bus.rise_us = rise_us;
+
+        OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_STANDARD);
+        Result standard = Check_Reads(n_reads);
+
+        OneWire_Timing calibrated;
+        uint8_t error = DS2438_CalibrateTiming(&calibrated);
+        Result custom = {0, 0};
+        if (error == DS2438_OK)
+            custom = Check_Reads(n_reads);
+
+        int row_failed;
+        if (standard.errors != 0)
+        {
+            row_failed = (error == DS2438_OK);
+        }
+        else
+        {
+            row_failed = (error != DS2438_OK) || (custom.errors != 0) || (custom.page_us > standard.page_us) ||
+                         (calibrated.i + calibrated.j < PRESENCE_END_MAX_US);
+        }
+        if (error == DS2438_OK)
+        {
+            printf("%7u | %8u %10.1f | %6s %4u %4u %4u %4u %8u %10.1f | %4.1f%%  %s\n", rise_us, standard.errors,
+                   (double)standard.page_us, "ok", calibrated.b, calibrated.d, calibrated.f, calibrated.j,
+                   custom.errors, (double)custom.page_us,
+                   100.0 * ((double)standard.page_us - custom.page_us) / standard.page_us,
+                   row_failed ? "FAIL" : "ok");
+        }
+        else
+        {
+            printf("%7u | %8u %10.1f | %6s %4s %4s %4s %4s %8s %10s | %5s  %s\n", rise_us, standard.errors,
+                   (double)standard.page_us, "failed", "-", "-", "-", "-", "-", "-", "-", row_failed ? "FAIL" : "ok");
+        }
+        failed += row_failed;
+    }
+    printf("slots started before the line was high or during a presence pulse: %u\n", model_bus.collisions);
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
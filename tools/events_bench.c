@@ -0,0 +1,166 @@
+/********************************************
+*
+*   \brief Throughput benchmark of the event queue of DS2438_Events.h.
+*
+*   A producer thread pushes records back to back while
+*   a consumer thread pops them, with each overflow
+*   policy, as the measurement loop and the telemetry
+*   output of main.c do. Record i carries i in all its
+*   fields, so the consumer detects a record copied
+*   while the producer was overwriting it (torn) and
+*   records popped out of order. At the end, every
+*   record pushed must have been popped, overwritten
+*   (drop oldest) or dropped (drop newest).
+*
+*   The consumer yields when the queue is empty. On a
+*   single core the producer only yields at the end of
+*   its time slices, so most records are lost; -y makes
+*   it yield every few records to interleave the threads
+*   more often.
+*
+*   Reported, for each policy: pushes per second, pops,
+*   records overwritten or dropped, torn and out of order
+*   records, and whether the counters add up. The exit
+*   status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -pthread -Itools/host -IDS2438.cydsn -o events_bench tools/events_bench.c
+*       DS2438.cydsn/DS2438_Events.c
+*   Usage: events_bench [-n records] [-y records]
+*
+**********************************************/
+
+#include "DS2438_Events.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static DS2438_EventQueue queue;
+static uint32_t n_records = 20000000;
+static uint32_t yield_every = 0;
+static volatile int producer_done = 0;
+
+// Consumer results
+static uint64_t torn, out_of_order;
+
+static double Bench_Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void Bench_MakeEvent(uint32_t i, DS2438_Event* event)
+{
+    event->timestamp_ms = i;
+    event->type = i % 6;
+    event->error = DS2438_OK;
+    event->index = i & 0xFF;
+    event->value = (int32_t)i;
+    for (uint8_t n = 0; n < 8; n++)
+    {
+        event->data[n] = (i >> n) & 0xFF;
+    }
+}
+
+static int Bench_IsConsistent(const DS2438_Event* event)
+{
+    DS2438_Event expected;
+    Bench_MakeEvent((uint32_t)event->value, &expected);
+    if ((event->timestamp_ms != expected.timestamp_ms) || (event->type != expected.type) ||
+        (event->error != expected.error) || (event->index != expected.index))
+        return 0;
+    for (uint8_t n = 0; n < 8; n++)
+    {
+        if (event->data[n] != expected.data[n])
+            return 0;
+    }
+    return 1;
+}
+
+static void* Bench_Consumer(void* argument)
+{
+    (void)argument;
+    DS2438_Event event;
+    int64_t previous = -1;
+    for (;;)
+    {
+        // Last check of the queue after the producer is done
+        int done = producer_done;
+        if (DS2438_EventQueuePop(&queue, &event) != DS2438_OK)
+        {
+            if (done)
+                break;
+            sched_yield();
+            continue;
+        }
+        if (!Bench_IsConsistent(&event))
+            torn++;
+        if ((int64_t)(uint32_t)event.value <= previous)
+            out_of_order++;
+        previous = (uint32_t)event.value;
+    }
+    return NULL;
+}
+
+static int Bench_Run(uint8_t policy)
+{
+    pthread_t consumer;
+    DS2438_Event event;
+
+    DS2438_EventQueueInit(&queue, policy);
+    producer_done = 0;
+    torn = 0;
+    out_of_order = 0;
+    double start = Bench_Now();
+    pthread_create(&consumer, NULL, Bench_Consumer, NULL);
+    for (uint32_t i = 0; i < n_records; i++)
+    {
+        Bench_MakeEvent(i, &event);
+        DS2438_EventQueuePush(&queue, &event);
+        if ((yield_every != 0) && ((i % yield_every) == 0))
+            sched_yield();
+    }
+    double produced = Bench_Now();
+    producer_done = 1;
+    pthread_join(consumer, NULL);
+
+    uint32_t lost = (policy == DS2438_EVENT_DROP_OLDEST) ? queue.overwritten : queue.dropped;
+    int balanced = (policy == DS2438_EVENT_DROP_OLDEST) ?
+                   ((queue.pushed == n_records) && (queue.popped + queue.overwritten == queue.pushed)) :
+                   ((queue.pushed + queue.dropped == n_records) && (queue.popped == queue.pushed));
+    int ok = balanced && (torn == 0) && (out_of_order == 0);
+    printf("%-12s %8.2f %10lu %10lu %7llu %7llu %9s\n",
+           (policy == DS2438_EVENT_DROP_OLDEST) ? "drop oldest" : "drop newest",
+           n_records / (produced - start) / 1e6, (unsigned long)queue.popped, (unsigned long)lost,
+           (unsigned long long)torn, (unsigned long long)out_of_order, balanced ? "yes" : "NO");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    int option;
+    while ((option = getopt(argc, argv, "n:y:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_records = strtoul(optarg, NULL, 0); break;
+            case 'y': yield_every = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n records] [-y records]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    printf("%u records, queue of %d\n\n", n_records, DS2438_EVENT_QUEUE_SIZE);
+    printf("%-12s %8s %10s %10s %7s %7s %9s\n", "policy", "push M/s", "popped", "lost", "torn", "order",
+           "balanced");
+    int ok = Bench_Run(DS2438_EVENT_DROP_OLDEST);
+    ok &= Bench_Run(DS2438_EVENT_DROP_NEWEST);
+    return ok ? 0 : 1;
+}
+
+/* [] END OF FILE */
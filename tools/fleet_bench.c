@@ -0,0 +1,547 @@
+/********************************************
+*
+*   \brief Fleet simulation benchmark.
+*
+*   Simulates controllers, each one bit-banging several
+*   1-Wire buses with several DS2438 devices per bus, and
+*   measures how sampling scales with devices per bus and
+*   buses per controller.
+*
+*   A controller is the DS2438 Library built for the host
+*   platform: the non-blocking operations of DS2438_Async.c
+*   and OneWire.c drive pin-level device models (see
+*   tools/host/ds2438_model.h), one model bus per pin. The
+*   devices are addressed with MATCH ROM when they share a
+*   bus. Each device is sampled once per period: temperature
+*   conversion and read, then voltage conversion and read of
+*   page 0 with the current. Currents, temperatures and
+*   voltages change at every period, and read slots can be
+*   corrupted with a given probability.
+*
+*   As on target, one CPU runs all the buses of a controller
+*   and bit-banging blocks it, so the buses of a controller
+*   share its time. Controllers are independent processes,
+*   run in parallel on the host cores.
+*
+*   Reported, for each configuration:
+*   - samples completed, failed (CRC or presence), missed
+*     (device still busy with the previous sample when the
+*     next one is due) and wrong (CRC valid, value not the
+*     one of the device);
+*   - sample period of the devices, mean and maximum;
+*   - latency from the time a sample is due to the time it
+*     completes, percentiles;
+*   - bus utilisation (time with a transaction in progress)
+*     and controller load (sum over its buses);
+*   - host CPU time per sample and simulation speed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o fleet_bench tools/fleet_bench.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/DS2438_Async.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c DS2438.cydsn/DS2438_Accumulators.c DS2438.cydsn/DS2438_History.c
+*       DS2438.cydsn/DS2438_Storage.c
+*   Usage: fleet_bench [-c controllers] [-j jobs] [-b buses,...] [-d devices,...]
+*                      [-t seconds] [-P period_ms] [-n noise_ppm] [-S]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438_Async.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define MAX_CONFIGS     16
+
+// Histograms: 32 buckets per power of two, about 3% resolution
+#define HIST_SUB        32
+#define HIST_BUCKETS    1152
+#define HIST_MAX_US     ((1ull << 36) - 1)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t sum_us;
+    uint64_t max_us;
+} Histogram;
+
+// Results of a controller, written by its process in shared memory
+typedef struct {
+    uint64_t samples;
+    uint64_t failed;
+    uint64_t missed;
+    uint64_t wrong;
+    uint64_t busy_us;           // Sum over the buses
+    uint64_t elapsed_us;
+    double cpu_s;
+    Histogram latency;
+    Histogram period;
+} Results;
+
+typedef struct {
+    DS2438_Model model;
+    uint64_t due_us;            // Next sample
+    uint64_t requested_us;      // Sample in progress
+    uint64_t last_us;           // Last completed sample, 0 if none
+    uint8_t pending;
+    int16_t expected_temperature;
+    uint16_t expected_voltage;
+} Device;
+
+typedef struct {
+    unsigned int pin;
+    Device* devices;
+    DS2438_Model** models;
+    uint16_t n_devices;
+    DS2438_ModelBus model_bus;
+    DS2438_Executor executor;
+    DS2438_AsyncOp op;
+    int active;                 // Device being sampled, or -1
+    uint16_t* queue;            // Devices due, in order
+    uint16_t queue_head;
+    uint16_t queue_count;
+    uint64_t next_due_us;
+    Results* results;
+} Bus;
+
+// Parameters of a run
+static uint16_t n_buses = 4;
+static uint16_t n_devices = 8;
+static uint32_t period_us = 1000000;
+static uint32_t noise_ppm = 0;
+static uint32_t duration_s = 60;
+static uint8_t staggered = 0;
+
+static Bus* buses;
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ===========================================================
+//                      HISTOGRAMS
+// ===========================================================
+
+static unsigned HistogramIndex(uint64_t value)
+{
+    if (value > HIST_MAX_US)
+        value = HIST_MAX_US;
+    if (value < 2 * HIST_SUB)
+        return (unsigned)value;
+    unsigned shift = 63 - __builtin_clzll(value) - 5;
+    return shift * HIST_SUB + (unsigned)(value >> shift);
+}
+
+// Middle of the values of a bucket
+static double HistogramValue(unsigned index)
+{
+    if (index < 2 * HIST_SUB)
+        return index;
+    unsigned shift = index / HIST_SUB - 1;
+    return (double)((uint64_t)(index - shift * HIST_SUB) << shift) + (double)(1ull << shift) / 2;
+}
+
+static void HistogramAdd(Histogram* histogram, uint64_t value)
+{
+    histogram->counts[HistogramIndex(value)]++;
+    histogram->total++;
+    histogram->sum_us += value;
+    if (value > histogram->max_us)
+        histogram->max_us = value;
+}
+
+static void HistogramMerge(Histogram* into, const Histogram* from)
+{
+    for (unsigned i = 0; i < HIST_BUCKETS; i++)
+        into->counts[i] += from->counts[i];
+    into->total += from->total;
+    into->sum_us += from->sum_us;
+    if (from->max_us > into->max_us)
+        into->max_us = from->max_us;
+}
+
+static double HistogramPercentile(const Histogram* histogram, double percentile)
+{
+    if (histogram->total == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(percentile / 100.0 * histogram->total);
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += histogram->counts[i];
+        if (seen > rank)
+            return (HistogramValue(i) < histogram->max_us) ? HistogramValue(i) : histogram->max_us;
+    }
+    return histogram->max_us;
+}
+
+// ===========================================================
+//                      BUS DISPATCH
+// ===========================================================
+
+static void Fleet_Drive(void* context, uint32 pin, int low, uint64_t time_us)
+{
+    (void)context;
+    DS2438_ModelBusDrive(&buses[pin].model_bus, low, time_us);
+}
+
+static int Fleet_Sample(void* context, uint32 pin, uint64_t time_us)
+{
+    (void)context;
+    return DS2438_ModelBusSample(&buses[pin].model_bus, time_us);
+}
+
+// ===========================================================
+//                      SAMPLING
+// ===========================================================
+
+static void Fleet_OnTemperature(DS2438_AsyncOp* op, void* context);
+static void Fleet_OnVoltage(DS2438_AsyncOp* op, void* context);
+
+// Change the measurements of a device, as seen by its next conversions
+static void Fleet_Vary(Device* device)
+{
+    DS2438_Model* model = &device->model;
+    int current = model->current + (int)(Random() % 65) - 32;
+    if (current > 1000)
+        current = 1000;
+    if (current < -1000)
+        current = -1000;
+    model->current = current;
+    // 20 to 30 degree Celsius, 3.6 to 4.2 V
+    model->temperature = (uint16_t)((20 * 256 + Random() % (10 * 256)) & ~0x07);
+    model->vdd = 360 + Random() % 61;
+    device->expected_temperature = model->temperature;
+    device->expected_voltage = model->vdd;
+}
+
+static void Fleet_Start(Bus* bus)
+{
+    Device* device = &bus->devices[bus->queue[bus->queue_head]];
+    bus->active = bus->queue[bus->queue_head];
+    bus->queue_head = (bus->queue_head + 1) % bus->n_devices;
+    bus->queue_count--;
+    DS2438_AsyncReadTemperature(&bus->op, bus->pin, Fleet_OnTemperature, bus);
+    if (bus->n_devices > 1)
+        DS2438_AsyncSetRom(&bus->op, device->model.rom);
+    DS2438_ExecutorSubmit(&bus->executor, &bus->op);
+}
+
+static void Fleet_Complete(Bus* bus, uint8_t ok)
+{
+    Device* device = &bus->devices[bus->active];
+    uint64_t now_us = Host_GetUs();
+    if (ok)
+    {
+        bus->results->samples++;
+        HistogramAdd(&bus->results->latency, now_us - device->requested_us);
+        if (device->last_us != 0)
+            HistogramAdd(&bus->results->period, now_us - device->last_us);
+        device->last_us = now_us;
+    }
+    else
+    {
+        bus->results->failed++;
+    }
+    device->pending = 0;
+    bus->active = -1;
+}
+
+static void Fleet_OnTemperature(DS2438_AsyncOp* op, void* context)
+{
+    Bus* bus = context;
+    Device* device = &bus->devices[bus->active];
+    if (op->error != DS2438_OK)
+    {
+        Fleet_Complete(bus, 0);
+        return;
+    }
+    if (op->value != (uint16_t)device->expected_temperature)
+        bus->results->wrong++;
+    DS2438_AsyncReadVoltage(op, bus->pin, Fleet_OnVoltage, bus);
+    if (bus->n_devices > 1)
+        DS2438_AsyncSetRom(op, device->model.rom);
+    DS2438_ExecutorSubmit(&bus->executor, op);
+}
+
+static void Fleet_OnVoltage(DS2438_AsyncOp* op, void* context)
+{
+    Bus* bus = context;
+    Device* device = &bus->devices[bus->active];
+    if (op->error != DS2438_OK)
+    {
+        Fleet_Complete(bus, 0);
+        return;
+    }
+    int16_t current = (int16_t)((op->page_data[6] << 8) | op->page_data[5]);
+    if ((op->value != device->expected_voltage) || (current != device->model.current))
+        bus->results->wrong++;
+    Fleet_Complete(bus, 1);
+}
+
+// Queue the devices whose sample is due
+static void Fleet_Schedule(Bus* bus, uint64_t now_us)
+{
+    bus->next_due_us = UINT64_MAX;
+    for (uint16_t n = 0; n < bus->n_devices; n++)
+    {
+        Device* device = &bus->devices[n];
+        while (device->due_us <= now_us)
+        {
+            if (device->pending)
+            {
+                bus->results->missed++;
+            }
+            else
+            {
+                Fleet_Vary(device);
+                device->pending = 1;
+                device->requested_us = device->due_us;
+                bus->queue[(bus->queue_head + bus->queue_count) % bus->n_devices] = n;
+                bus->queue_count++;
+            }
+            device->due_us += period_us;
+        }
+        if (device->due_us < bus->next_due_us)
+            bus->next_due_us = device->due_us;
+    }
+}
+
+// ===========================================================
+//                      CONTROLLER
+// ===========================================================
+
+static void Fleet_RunController(uint16_t controller, Results* results)
+{
+    memset(results, 0, sizeof(*results));
+    seed = 1 + controller * 7919u;
+    buses = calloc(n_buses, sizeof(Bus));
+    for (uint16_t b = 0; b < n_buses; b++)
+    {
+        Bus* bus = &buses[b];
+        bus->pin = b;
+        bus->n_devices = n_devices;
+        bus->devices = calloc(n_devices, sizeof(Device));
+        bus->models = calloc(n_devices, sizeof(DS2438_Model*));
+        bus->queue = calloc(n_devices, sizeof(uint16_t));
+        bus->active = -1;
+        bus->results = results;
+        for (uint16_t n = 0; n < n_devices; n++)
+        {
+            Device* device = &bus->devices[n];
+            DS2438_ModelInit(&device->model, ((uint64_t)controller << 32) | ((uint32_t)b << 16) | n);
+            device->model.current = (int16_t)(Random() % 2001) - 1000;
+            device->due_us = staggered ? (Random() % period_us) : 0;
+            bus->models[n] = &device->model;
+        }
+        DS2438_ModelBusInit(&bus->model_bus, bus->models, n_devices);
+        bus->model_bus.noise_ppm = noise_ppm;
+        bus->model_bus.seed = 1 + controller * 65537u + b;
+        DS2438_ExecutorInit(&bus->executor);
+    }
+
+    Host_Bus host = {Fleet_Drive, Fleet_Sample, NULL};
+    Host_SetBus(&host);
+    Timebase_Start();
+
+    struct timespec cpu_start, cpu_end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    uint64_t start_us = Host_GetUs();
+    uint64_t end_us = start_us + (uint64_t)duration_s * 1000000;
+    for (uint16_t b = 0; b < n_buses; b++)
+    {
+        for (uint16_t n = 0; n < n_devices; n++)
+            buses[b].devices[n].due_us += start_us;
+    }
+
+    while (Host_GetUs() < end_us)
+    {
+        uint8_t progress = 0;
+        uint64_t next_us = end_us;
+        for (uint16_t b = 0; b < n_buses; b++)
+        {
+            Bus* bus = &buses[b];
+            if (Host_GetUs() >= bus->next_due_us)
+                Fleet_Schedule(bus, Host_GetUs());
+            if ((bus->active < 0) && (bus->queue_count > 0))
+                Fleet_Start(bus);
+            if (bus->executor.count > 0)
+            {
+                uint64_t busy_us = Host_GetDelayUs();
+                uint32_t steps = bus->executor.steps;
+                DS2438_ExecutorRun(&bus->executor);
+                results->busy_us += Host_GetDelayUs() - busy_us;
+                progress |= (bus->executor.steps != steps) || (bus->active < 0);
+            }
+            if (bus->next_due_us < next_us)
+                next_us = bus->next_due_us;
+        }
+        if (progress)
+            continue;
+
+        // Nothing to run: sleep until the next wake or due time
+        for (uint16_t b = 0; b < n_buses; b++)
+        {
+            uint32_t wake_us;
+            if (DS2438_ExecutorNextWake(&buses[b].executor, &wake_us) > 0)
+            {
+                int32_t wait_us = (int32_t)(wake_us - Timebase_GetUs());
+                uint64_t at_us = Host_GetUs() + ((wait_us > 0) ? (uint64_t)wait_us : 0);
+                if (at_us < next_us)
+                    next_us = at_us;
+            }
+        }
+        Host_AdvanceUs((next_us > Host_GetUs()) ? (next_us - Host_GetUs()) : 1);
+    }
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    results->cpu_s = (cpu_end.tv_sec - cpu_start.tv_sec) + (cpu_end.tv_nsec - cpu_start.tv_nsec) * 1e-9;
+    results->elapsed_us = Host_GetUs() - start_us;
+}
+
+// ===========================================================
+//                      MAIN
+// ===========================================================
+
+static int ParseList(const char* text, uint16_t* values)
+{
+    int count = 0;
+    char* end;
+    while ((count < MAX_CONFIGS) && (*text != '\0'))
+    {
+        long value = strtol(text, &end, 0);
+        if ((end == text) || (value < 1) || (value > 4096))
+            return -1;
+        values[count++] = (uint16_t)value;
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return count;
+}
+
+static void Usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-c controllers] [-j jobs] [-b buses,...] [-d devices,...]\n"
+                    "       [-t seconds] [-P period_ms] [-n noise_ppm] [-S]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint16_t n_controllers = (n_cpus > 0) ? (uint16_t)n_cpus : 1;
+    uint16_t n_jobs = n_controllers;
+    uint16_t bus_counts[MAX_CONFIGS] = {4}, device_counts[MAX_CONFIGS] = {8};
+    int n_bus_counts = 1, n_device_counts = 1;
+    int option;
+
+    while ((option = getopt(argc, argv, "c:j:b:d:t:P:n:S")) != -1)
+    {
+        switch (option)
+        {
+            case 'c': n_controllers = atoi(optarg); break;
+            case 'j': n_jobs = atoi(optarg); break;
+            case 'b': n_bus_counts = ParseList(optarg, bus_counts); break;
+            case 'd': n_device_counts = ParseList(optarg, device_counts); break;
+            case 't': duration_s = atoi(optarg); break;
+            case 'P': period_us = 1000u * atoi(optarg); break;
+            case 'n': noise_ppm = atoi(optarg); break;
+            case 'S': staggered = 1; break;
+            default: Usage(argv[0]);
+        }
+    }
+    if ((n_controllers < 1) || (n_jobs < 1) || (n_bus_counts < 1) || (n_device_counts < 1) ||
+        (duration_s < 1) || (period_us < 1000))
+        Usage(argv[0]);
+
+    Results* all = mmap(NULL, n_controllers * sizeof(Results), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (all == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    printf("%u controllers, %u s simulated, period %u ms, noise %u ppm, %s, %u jobs\n",
+           n_controllers, duration_s, period_us / 1000, noise_ppm, staggered ? "staggered" : "aligned", n_jobs);
+    printf("buses devices  samples  failed  missed wrong | period_ms mean   max | latency_ms p50    p90"
+           "    p99    max | bus_util ctrl_load | cpu_us/sample speed\n");
+    for (int bc = 0; bc < n_bus_counts; bc++)
+    {
+        for (int dc = 0; dc < n_device_counts; dc++)
+        {
+            n_buses = bus_counts[bc];
+            n_devices = device_counts[dc];
+
+            // One process per controller, at most n_jobs at a time
+            struct timespec wall_start, wall_end;
+            clock_gettime(CLOCK_MONOTONIC, &wall_start);
+            uint16_t running = 0;
+            for (uint16_t c = 0; c < n_controllers; c++)
+            {
+                if (running == n_jobs)
+                {
+                    wait(NULL);
+                    running--;
+                }
+                pid_t pid = fork();
+                if (pid == 0)
+                {
+                    Fleet_RunController(c, &all[c]);
+                    _exit(0);
+                }
+                if (pid < 0)
+                {
+                    perror("fork");
+                    return 1;
+                }
+                running++;
+            }
+            while (running-- > 0)
+                wait(NULL);
+            clock_gettime(CLOCK_MONOTONIC, &wall_end);
+            double wall_s = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) * 1e-9;
+
+            static Results total;
+            memset(&total, 0, sizeof(total));
+            for (uint16_t c = 0; c < n_controllers; c++)
+            {
+                total.samples += all[c].samples;
+                total.failed += all[c].failed;
+                total.missed += all[c].missed;
+                total.wrong += all[c].wrong;
+                total.busy_us += all[c].busy_us;
+                total.elapsed_us += all[c].elapsed_us;
+                total.cpu_s += all[c].cpu_s;
+                HistogramMerge(&total.latency, &all[c].latency);
+                HistogramMerge(&total.period, &all[c].period);
+            }
+            double controller_load = (double)total.busy_us / total.elapsed_us;
+            double period_mean = total.period.total ? (double)total.period.sum_us / total.period.total : 0;
+            printf("%5u %7u %8llu %7llu %7llu %5llu | %14.1f %5.0f | %13.2f %6.2f %6.2f %6.2f | %7.1f%% %8.1f%% |"
+                   " %13.1f %5.0fx\n",
+                   n_buses, n_devices, (unsigned long long)total.samples, (unsigned long long)total.failed,
+                   (unsigned long long)total.missed, (unsigned long long)total.wrong,
+                   period_mean / 1000, total.period.max_us / 1000.0,
+                   HistogramPercentile(&total.latency, 50) / 1000, HistogramPercentile(&total.latency, 90) / 1000,
+                   HistogramPercentile(&total.latency, 99) / 1000, total.latency.max_us / 1000.0,
+                   100 * controller_load / n_buses, 100 * controller_load,
+                   total.samples ? total.cpu_s * 1e6 / total.samples : 0,
+                   (double)total.elapsed_us / 1e6 / wall_s);
+            fflush(stdout);
+        }
+    }
+    munmap(all, n_controllers * sizeof(Results));
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,363 @@
+/********************************************
+*
+*   \brief Comparison of the C API and of the C++ template
+*   front end of DS2438.hpp on the host platform.
+*
+*   Both front ends run the same transactions on a
+*   simulated device (see tools/host/ds2438_model.h):
+*   page read from the device, page write with the copy
+*   to EEPROM, temperature and voltage conversions, each
+*   polled with page 0 reads until done. The measurements
+*   change at every call, with the same values for both
+*   front ends, and every value is checked against the
+*   model; the bus time of both front ends must be the
+*   same, as they issue the same slots. The template runs on
+*   PinBus<DS2438_Pin_0>, the bus of the C API, so the
+*   tool also checks that mixing the two keeps the state
+*   of the C API coherent: a read of the template waits
+*   for a copy issued by DS2438_WritePageAsync(), pages
+*   written by the template are seen by cached reads of
+*   the C API, and a conversion of the template is not
+*   hidden by a page 0 cached before it.
+*
+*   Reported, for each transaction and front end: bus
+*   time and total virtual time per call, in us, and host
+*   time per call, in ns, as a measure of the processing
+*   done around the slots. Then the code size of each
+*   front end, from the symbol table of the tool: the
+*   wrappers of the compared transactions and the
+*   functions they call, without the CRC, cache and
+*   snapshot functions used by both. Sizes are for the
+*   host compiler, not for the ARM target. The exit
+*   status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -c tools/host/host_platform.c tools/host/ds2438_model.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c
+*   g++ -std=c++17 -O2 -Wall -Itools/host -IDS2438.cydsn -o frontend_compare tools/frontend_compare.cpp
+*       host_platform.o ds2438_model.o OneWire.o Timebase.o DS2438.o DS2438_Cache.o DS2438_Snapshot.o
+*   Usage: frontend_compare [-n calls]
+*
+**********************************************/
+
+extern "C" {
+#include "ds2438_model.h"
+}
+#include "DS2438.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using Device = ds2438::Ds2438<ds2438::PinBus<DS2438_Pin_0>, ds2438::StandardTiming, ds2438::CrcCheck>;
+
+#define NOINLINE __attribute__((noinline))
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+static uint32_t n_calls = 50;
+static int failed = 0;
+
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ===========================================================
+//                      TRANSACTIONS
+// ===========================================================
+
+// Wrappers of the compared transactions, kept out of line for the size table
+
+NOINLINE static uint8_t C_ReadPage(uint8_t page_number, uint8_t* page_data)
+{
+    uint32_t recall_us;
+    return DS2438_ReadPageTimestamped(page_number, page_data, &recall_us);
+}
+
+NOINLINE static uint8_t C_WritePage(uint8_t page_number, uint8_t* page_data)
+{
+    DS2438_CopyToken token;
+    uint8_t error = DS2438_WritePageAsync(page_number, page_data, &token);
+    if (error == DS2438_OK)
+        error = DS2438_WaitCopy(&token);
+    return error;
+}
+
+NOINLINE static uint8_t C_ReadTemperature(uint16_t* temperature)
+{
+    return DS2438_ReadRawTemperature(temperature);
+}
+
+NOINLINE static uint8_t C_ReadVoltage(uint16_t* voltage)
+{
+    return DS2438_ReadRawVoltage(voltage);
+}
+
+NOINLINE static uint8_t Template_ReadPage(uint8_t page_number, uint8_t* page_data)
+{
+    return Device::ReadPage(page_number, page_data);
+}
+
+NOINLINE static uint8_t Template_WritePage(uint8_t page_number, uint8_t* page_data)
+{
+    return Device::WritePage(page_number, page_data);
+}
+
+NOINLINE static uint8_t Template_ReadTemperature(uint16_t* temperature)
+{
+    return Device::ReadRawTemperature(temperature);
+}
+
+NOINLINE static uint8_t Template_ReadVoltage(uint16_t* voltage)
+{
+    return Device::ReadRawVoltage(voltage);
+}
+
+struct FrontEnd {
+    const char* name;
+    uint8_t (*read_page)(uint8_t, uint8_t*);
+    uint8_t (*write_page)(uint8_t, uint8_t*);
+    uint8_t (*read_temperature)(uint16_t*);
+    uint8_t (*read_voltage)(uint16_t*);
+};
+
+static const FrontEnd front_ends[2] = {
+    {"C API", C_ReadPage, C_WritePage, C_ReadTemperature, C_ReadVoltage},
+    {"template", Template_ReadPage, Template_WritePage, Template_ReadTemperature, Template_ReadVoltage},
+};
+
+// ===========================================================
+//                      MEASUREMENTS
+// ===========================================================
+
+enum { OP_READ_PAGE, OP_WRITE_PAGE, OP_TEMPERATURE, OP_VOLTAGE, N_OPS };
+
+static const char* op_names[N_OPS] = {"read page", "write page", "temperature", "voltage"};
+
+// One call of a transaction with new values in the model, returns 1 if the result is right
+static int Compare_Call(const FrontEnd& front_end, int op)
+{
+    uint8_t page_data[9];
+    uint16_t value = 0;
+    switch (op)
+    {
+        case OP_READ_PAGE:
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                model.memory[3][i] = Random() & 0xFF;
+            }
+            return (front_end.read_page(3, page_data) == DS2438_OK) && (memcmp(page_data, model.memory[3], 8) == 0);
+        case OP_WRITE_PAGE:
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                page_data[i] = Random() & 0xFF;
+            }
+            page_data[8] = 0;
+            return (front_end.write_page(3, page_data) == DS2438_OK) && (memcmp(page_data, model.memory[3], 8) == 0);
+        case OP_TEMPERATURE:
+            model.temperature = ((Random() % 60) << 8) | ((Random() % 32) << 3);
+            return (front_end.read_temperature(&value) == DS2438_OK) && (value == model.temperature);
+        default:
+            model.vdd = 300 + Random() % 300;
+            return (front_end.read_voltage(&value) == DS2438_OK) && (value == model.vdd);
+    }
+}
+
+static void Compare_Run(int op)
+{
+    // Same values for both front ends: write 0 and write 1 slots have different lengths
+    uint64_t front_end_bus_us[2];
+    uint32_t run_seed = seed;
+    for (int f = 0; f < 2; f++)
+    {
+        const FrontEnd& front_end = front_ends[f];
+        seed = run_seed;
+        uint32_t wrong = 0;
+        uint64_t bus_us = Host_GetDelayUs();
+        uint64_t total_us = Host_GetUs();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < n_calls; n++)
+        {
+            wrong += Compare_Call(front_end, op) ? 0 : 1;
+        }
+        auto host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        printf("%-12s %-9s %9.0f %9.0f %9.0f %6u\n", op_names[op], front_end.name,
+               (double)(Host_GetDelayUs() - bus_us) / n_calls, (double)(Host_GetUs() - total_us) / n_calls,
+               (double)host_ns.count() / n_calls, wrong);
+        failed += wrong ? 1 : 0;
+        front_end_bus_us[f] = Host_GetDelayUs() - bus_us;
+    }
+    if (front_end_bus_us[0] != front_end_bus_us[1])
+    {
+        printf("%-12s bus time differs: the front ends do not issue the same transactions  FAIL\n", op_names[op]);
+        failed++;
+    }
+}
+
+// ===========================================================
+//                      MIXED USE
+// ===========================================================
+
+static void Compare_Check(int condition, const char* what)
+{
+    printf("  %-62s %s\n", what, condition ? "ok" : "FAIL");
+    if (!condition)
+        failed++;
+}
+
+static void Compare_Mixed(void)
+{
+    uint8_t page_data[9];
+    uint8_t written[9] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x00};
+    uint16_t temperature = 0;
+
+    printf("\nmixed use on the same bus\n");
+    // The model copies at once, so the wait is checked on the duration of the read
+    uint64_t read_us = Host_GetUs();
+    Device::ReadPage(4, page_data);
+    read_us = Host_GetUs() - read_us;
+    DS2438_WritePageAsync(4, written, NULL);
+    uint64_t start_us = Host_GetUs();
+    uint64_t copy_us = model.copy_until_us - start_us;
+    int ok = (Device::ReadPage(4, page_data) == DS2438_OK) && (memcmp(page_data, written, 8) == 0);
+    // One read slot of margin on the end of the copy
+    Compare_Check(ok && (Host_GetUs() - start_us + 100 >= copy_us + read_us),
+                  "template read waits for the copy of DS2438_WritePageAsync()");
+
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        written[i] ^= 0xFF;
+    }
+    DS2438_ReadPage(4, page_data);
+    Device::WritePage(4, written);
+    Compare_Check((DS2438_ReadPage(4, page_data) == DS2438_OK) && (memcmp(page_data, written, 8) == 0),
+                  "cached C read sees the page written by the template");
+
+    // Measurements are not cached by default
+    DS2438_CacheSetMaxAge(DS2438_GetPageCache(), DS2438_CACHE_MEASUREMENT, 1000);
+    DS2438_ReadPage(0, page_data);
+    model.temperature = 0x1A80;
+    Device::ReadRawTemperature(&temperature);
+    Compare_Check((DS2438_GetRawTemperatureData(&temperature) == DS2438_OK) && (temperature == 0x1A80),
+                  "cached C read sees the conversion of the template");
+    DS2438_CacheSetMaxAge(DS2438_GetPageCache(), DS2438_CACHE_MEASUREMENT, DS2438_CACHE_MEASUREMENT_MAX_AGE_MS);
+}
+
+// ===========================================================
+//                      CODE SIZE
+// ===========================================================
+
+// Functions of the C API called by the compared transactions, CRC and cache excluded
+static const char* c_functions[] = {
+    "DS2438_ReadPageTimestamped", "DS2438_ReadPageFromDevice", "DS2438_ReadScratchpadFromDevice",
+    "DS2438_ReadPage", "DS2438_WritePageAsync",
+    "DS2438_WaitCopy", "DS2438_PollCopy", "DS2438_ReadRawTemperature", "DS2438_StartTemperatureConversion",
+    "DS2438_HasTemperatureData", "DS2438_GetRawTemperatureData", "DS2438_ReadRawVoltage",
+    "DS2438_StartVoltageConversion", "DS2438_HasVoltageData", "DS2438_GetRawVoltageData",
+    "DS2438_WaitConversion", "OneWire_TouchReset", "OneWire_WriteBit", "OneWire_ReadBit", "OneWire_WriteByte",
+    "OneWire_ReadByte", "OneWire_GetResetCount", "OneWire_BusTiming", "OneWire_ProfileTiming",
+    "OneWire_TouchResetTimed", "OneWire_WriteBitTimed", "OneWire_ReadBitTimed", "OneWire_TraceBegin",
+    "OneWire_TraceRecord", "OneWire_TraceVarint", "OneWire_TraceLength",
+};
+
+static int Compare_IsCFunction(const std::string& symbol)
+{
+    if (symbol.compare(0, 2, "C_") == 0)
+        return 1;
+    for (const char* function : c_functions)
+    {
+        // Local functions can have a suffix added by the compiler
+        if ((symbol == function) || (symbol.compare(0, strlen(function) + 1, std::string(function) + ".") == 0))
+            return 1;
+    }
+    return 0;
+}
+
+static void Compare_CodeSize(void)
+{
+    char path[256];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0)
+        return;
+    path[length] = 0;
+    std::string command = std::string("nm -S --defined-only '") + path + "' 2>/dev/null";
+    FILE* nm = popen(command.c_str(), "r");
+    if (nm == NULL)
+        return;
+    unsigned long sizes[2] = {0, 0};
+    char line[512];
+    while (fgets(line, sizeof(line), nm) != NULL)
+    {
+        unsigned long address, size;
+        char type, name[400];
+        if (sscanf(line, "%lx %lx %c %399s", &address, &size, &type, name) != 4)
+            continue;
+        if ((type != 't') && (type != 'T'))
+            continue;
+        std::string symbol(name);
+        if (Compare_IsCFunction(symbol))
+            sizes[0] += size;
+        else if ((symbol.find("Template_") != std::string::npos) || (symbol.find("6Ds2438") != std::string::npos))
+            sizes[1] += size;
+    }
+    pclose(nm);
+    if (sizes[0] == 0)
+    {
+        printf("\nno symbol table, code size not reported\n");
+        return;
+    }
+    printf("\ncode size, bytes\n");
+    for (int f = 0; f < 2; f++)
+    {
+        printf("%-9s %6lu\n", front_ends[f].name, sizes[f]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int option;
+    while ((option = getopt(argc, argv, "n:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_calls = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n calls]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (n_calls == 0)
+        n_calls = 1;
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+
+    printf("%u calls per transaction\n\n", n_calls);
+    printf("%-12s %-9s %9s %9s %9s %6s\n", "transaction", "front end", "bus us", "total us", "host ns", "wrong");
+    for (int op = 0; op < N_OPS; op++)
+    {
+        Compare_Run(op);
+    }
+    Compare_Mixed();
+    Compare_CodeSize();
+
+    printf("%d failed\n", failed);
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,27 @@
+/**
+ * \file Em_EEPROM.h
+ * \brief Host replacement of the API generated for the Em_EEPROM component
+ * instance, configured as in the design (see DS2438_Storage.h).
+ *
+ * The functions keep the configuration and the context of the instance,
+ * as the generated ones, and call the library of cy_em_eeprom.h.
+*/
+#ifndef __HOST_EM_EEPROM_H__
+    #define __HOST_EM_EEPROM_H__
+
+    #include "cytypes.h"
+    #include "cy_em_eeprom.h"
+
+    #define Em_EEPROM_EEPROM_SIZE           2048u
+    #define Em_EEPROM_WEAR_LEVELING_FACTOR  2u
+    #define Em_EEPROM_REDUNDANT_COPY        0u
+    #define Em_EEPROM_BLOCKING_WRITE        1u
+    #define Em_EEPROM_PHYSICAL_SIZE         CY_EM_EEPROM_GET_PHYSICAL_SIZE(Em_EEPROM_EEPROM_SIZE, 0u, \
+                                                Em_EEPROM_WEAR_LEVELING_FACTOR, Em_EEPROM_REDUNDANT_COPY)
+
+    cy_en_em_eeprom_status_t Em_EEPROM_Init(uint32 startAddress);
+    cy_en_em_eeprom_status_t Em_EEPROM_Read(uint32 addr, void* eepromData, uint32 size);
+    cy_en_em_eeprom_status_t Em_EEPROM_Write(uint32 addr, void* eepromData, uint32 size);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,40 @@
+/**
+ * \file cy_em_eeprom.h
+ * \brief Host replacement of the Em_EEPROM library, backed by RAM.
+*/
+#ifndef __HOST_CY_EM_EEPROM_H__
+    #define __HOST_CY_EM_EEPROM_H__
+
+    #include "cytypes.h"
+
+    typedef enum {
+        CY_EM_EEPROM_SUCCESS = 0,
+        CY_EM_EEPROM_BAD_PARAM,
+        CY_EM_EEPROM_BAD_CHECKSUM,
+        CY_EM_EEPROM_BAD_DATA,
+        CY_EM_EEPROM_WRITE_FAIL
+    } cy_en_em_eeprom_status_t;
+
+    typedef struct {
+        uint32 eepromSize;
+        uint32 simpleMode;
+        uint32 wearLevelingFactor;
+        uint8 redundantCopy;
+        uint8 blockingWrite;
+        uint32 userFlashStartAddr;
+    } cy_stc_eeprom_config_t;
+
+    typedef struct {
+        uint32 eepromSize;
+    } cy_stc_eeprom_context_t;
+
+    #define CY_EM_EEPROM_FLASH_SIZEOF_ROW 256u
+    #define CY_EM_EEPROM_GET_PHYSICAL_SIZE(size, simple, wear, redundant) \
+        ((size) * 2u * (wear) * ((redundant) + 1u) + CY_EM_EEPROM_FLASH_SIZEOF_ROW)
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Init(cy_stc_eeprom_config_t* config, cy_stc_eeprom_context_t* context);
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Read(uint32 addr, void* data, uint32 size, cy_stc_eeprom_context_t* context);
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Write(uint32 addr, void* data, uint32 size, cy_stc_eeprom_context_t* context);
+
+#endif
+/* [] END OF FILE */
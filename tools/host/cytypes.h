@@ -0,0 +1,25 @@
+/**
+ * \file cytypes.h
+ * \brief Host replacement of the PSoC Creator base types.
+ *
+ * Only the definitions used by the DS2438 Library are provided.
+*/
+#ifndef __HOST_CYTYPES_H__
+    #define __HOST_CYTYPES_H__
+
+    #include <stdint.h>
+    #include <stddef.h>
+
+    typedef uint8_t uint8;
+    typedef uint16_t uint16;
+    typedef uint32_t uint32;
+    typedef int8_t int8;
+    typedef int16_t int16;
+    typedef int32_t int32;
+    typedef float float32;
+
+    #define CY_INLINE inline
+    #define CY_ALIGN(align) __attribute__((aligned(align)))
+
+#endif
+/* [] END OF FILE */
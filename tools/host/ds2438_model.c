@@ -0,0 +1,638 @@
+/********************************************
+*
+*   \brief Source code for the DS2438 device model.
+*
+*   Each device is a state machine fed with the
+*   complete time slots: the bus asks the devices
+*   for the bit they drive when the master samples
+*   the line, then passes the level left by the
+*   master (0 for write 0, 1 for write 1 and read)
+*   once the slot is over.
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include <string.h>
+
+// Device states
+#define STATE_IDLE      0   // Not selected, waiting for a reset
+#define STATE_ROM       1   // Receiving a ROM command
+#define STATE_MATCH     2   // Receiving the ROM of a MATCH ROM
+#define STATE_SEARCH    3   // SEARCH ROM
+#define STATE_FUNCTION  4   // Receiving a memory function command
+#define STATE_ARGUMENT  5   // Receiving the page number and data
+#define STATE_SEND      6   // Sending bytes
+#define STATE_BUSY      7   // Read slots report a conversion or a copy
+
+// Status bits of page 0
+#define STATUS_CONFIG   0x0F
+#define STATUS_IAD      0x01
+#define STATUS_CA       0x02
+#define STATUS_AD       0x08
+#define STATUS_TB       0x10
+#define STATUS_NVB      0x20
+#define STATUS_ADB      0x40
+
+// Line timing, in us
+#define RESET_MIN_US        240
+#define WRITE_0_MIN_US      15
+#define PRESENCE_START_US   15
+#define PRESENCE_END_US     135
+#define PRESENCE_WINDOW_US  480
+
+static uint8_t Model_Crc8(const uint8_t* data, uint8_t length)
+{
+    uint8_t crc = 0;
+    for (uint8_t n = 0; n < length; n++)
+    {
+        uint8_t byte = data[n];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t Model_Crc16(const uint8_t* data, uint8_t length, uint16_t crc)
+{
+    for (uint8_t n = 0; n < length; n++)
+    {
+        crc ^= data[n];
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x01) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+    }
+    return crc;
+}
+
+void DS2438_ModelInit(DS2438_Model* model, uint64_t serial)
+{
+    memset(model, 0, sizeof(*model));
+    model->rom[0] = 0x26;
+    for (uint8_t n = 1; n < 7; n++)
+    {
+        model->rom[n] = serial & 0xFF;
+        serial >>= 8;
+    }
+    model->rom[7] = Model_Crc8(model->rom, 7);
+    model->memory[0][0] = STATUS_IAD | STATUS_CA | 0x04 | STATUS_AD;
+    model->present = 1;
+    model->temperature = 25 * 256;
+    model->vdd = 500;
+    model->vad = 500;
+    model->conversion_us = 10000;
+    model->copy_us = 10000;
+}
+
+void DS2438_ModelSetFamily(DS2438_Model* model, uint8_t family)
+{
+    static const uint8_t ds18b20_scratchpad[8] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10};
+    model->rom[0] = family;
+    model->rom[7] = Model_Crc8(model->rom, 7);
+    if (family == DS2438_MODEL_DS18B20)
+    {
+        memcpy(model->memory[0], ds18b20_scratchpad, 8);
+        model->conversion_us = 750000;
+    }
+    else if (family == DS2438_MODEL_DS2431)
+    {
+        memset(model->eeprom, 0xFF, sizeof(model->eeprom));
+    }
+}
+
+// ===========================================================
+//                      DEVICE
+// ===========================================================
+
+// Copy a page to its scratchpad, with the current value of the registers
+static void Model_Recall(DS2438_Model* model, uint8_t page_number, uint64_t time_us)
+{
+    uint8_t* page = model->scratchpad[page_number];
+    memcpy(page, model->memory[page_number], 8);
+    if (page_number == 0)
+    {
+        page[0] &= STATUS_CONFIG;
+        if (time_us < model->temperature_until_us)
+            page[0] |= STATUS_TB;
+        if (time_us < model->voltage_until_us)
+            page[0] |= STATUS_ADB;
+        if (time_us < model->copy_until_us)
+            page[0] |= STATUS_NVB;
+        if (model->memory[0][0] & STATUS_IAD)
+        {
+            page[5] = model->current & 0xFF;
+            page[6] = (model->current >> 8) & 0xFF;
+        }
+    }
+    else if (page_number == 1)
+    {
+        uint32_t etm = time_us / 1000000;
+        page[0] = etm & 0xFF;
+        page[1] = (etm >> 8) & 0xFF;
+        page[2] = (etm >> 16) & 0xFF;
+        page[3] = (etm >> 24) & 0xFF;
+        page[4] = model->ica;
+    }
+    else if ((page_number == 7) && (model->memory[0][0] & STATUS_CA))
+    {
+        page[4] = model->cca & 0xFF;
+        page[5] = model->cca >> 8;
+        page[6] = model->dca & 0xFF;
+        page[7] = model->dca >> 8;
+    }
+}
+
+static void Model_Send(DS2438_Model* model, const uint8_t* data, uint8_t length, uint8_t next)
+{
+    memcpy(model->tx, data, length);
+    model->tx_length = length;
+    model->tx_bit = 0;
+    model->tx_next = next;
+    model->state = STATE_SEND;
+}
+
+static void Model_RomCommand(DS2438_Model* model)
+{
+    switch (model->byte)
+    {
+        case 0x33:  // READ ROM
+            Model_Send(model, model->rom, 8, STATE_FUNCTION);
+            break;
+        case 0x55:  // MATCH ROM
+            model->state = STATE_MATCH;
+            model->count = 0;
+            break;
+        case 0xCC:  // SKIP ROM
+            model->state = STATE_FUNCTION;
+            break;
+        case 0xF0:  // SEARCH ROM
+            model->state = STATE_SEARCH;
+            model->search_bit = 0;
+            model->search_phase = 0;
+            break;
+        default:
+            model->state = STATE_IDLE;
+            break;
+    }
+}
+
+static void Model_FunctionDS18B20(DS2438_Model* model, uint64_t time_us)
+{
+    switch (model->command)
+    {
+        case 0x44:  // CONVERT T, 1/16 degree Celsius
+        {
+            int16_t temperature = (int16_t)model->temperature >> 4;
+            model->memory[0][0] = temperature & 0xFF;
+            model->memory[0][1] = (temperature >> 8) & 0xFF;
+            model->temperature_until_us = time_us + model->conversion_us;
+            model->state = STATE_BUSY;
+            break;
+        }
+        case 0xBE:  // READ SCRATCHPAD
+        {
+            uint8_t scratchpad[9];
+            memcpy(scratchpad, model->memory[0], 8);
+            scratchpad[8] = Model_Crc8(scratchpad, 8);
+            Model_Send(model, scratchpad, 9, STATE_IDLE);
+            break;
+        }
+        case 0xB4:  // READ POWER SUPPLY: externally powered
+        {
+            uint8_t powered = 0xFF;
+            Model_Send(model, &powered, 1, STATE_IDLE);
+            break;
+        }
+        default:
+            model->state = STATE_IDLE;
+            break;
+    }
+}
+
+static void Model_FunctionDS2431(DS2438_Model* model)
+{
+    switch (model->command)
+    {
+        case 0x0F:  // WRITE SCRATCHPAD
+        case 0x55:  // COPY SCRATCHPAD
+        case 0xF0:  // READ MEMORY
+            model->state = STATE_ARGUMENT;
+            break;
+        case 0xAA:  // READ SCRATCHPAD
+        {
+            // Target, ending offset and row, then the CRC of the command and of the bytes sent
+            uint8_t data[13];
+            data[0] = model->target & 0xFF;
+            data[1] = model->target >> 8;
+            data[2] = model->es;
+            memcpy(&data[3], model->scratchpad[0], 8);
+            uint16_t crc = ~Model_Crc16(data, 11, Model_Crc16(&model->command, 1, 0));
+            data[11] = crc & 0xFF;
+            data[12] = crc >> 8;
+            Model_Send(model, data, 13, STATE_IDLE);
+            break;
+        }
+        default:
+            model->state = STATE_IDLE;
+            break;
+    }
+}
+
+// Arguments of the DS2431 commands: target address, then data or authorization
+static void Model_ArgumentDS2431(DS2438_Model* model)
+{
+    uint8_t count = model->count++;
+    if (count == 0)
+    {
+        model->target = model->byte;
+        return;
+    }
+    if (count == 1)
+    {
+        model->target |= model->byte << 8;
+        if (model->command == 0x0F)
+            model->es = 0x00;
+        else if (model->command == 0xF0)
+            Model_Send(model, &model->eeprom[model->target & 0x7F], 128 - (model->target & 0x7F), STATE_IDLE);
+        return;
+    }
+    if (model->command == 0x0F)
+    {
+        model->scratchpad[0][(count - 2) & 0x07] = model->byte;
+        if (count == 9)
+        {
+            // Whole row written: ending offset 7, CRC of command, target and data
+            uint8_t data[11];
+            data[0] = model->command;
+            data[1] = model->target & 0xFF;
+            data[2] = model->target >> 8;
+            memcpy(&data[3], model->scratchpad[0], 8);
+            uint16_t crc = ~Model_Crc16(data, 11, 0);
+            uint8_t crc_bytes[2] = {crc & 0xFF, crc >> 8};
+            model->es = 0x07;
+            Model_Send(model, crc_bytes, 2, STATE_IDLE);
+        }
+        return;
+    }
+    // COPY SCRATCHPAD: authorization with the ending offset, then 0xAA once programmed
+    if ((model->byte == model->es) && (model->es == 0x07) && ((model->target & 0x07) == 0) &&
+        (model->target < 128))
+    {
+        uint8_t done[8];
+        memcpy(&model->eeprom[model->target], model->scratchpad[0], 8);
+        model->es |= 0x80;
+        memset(done, 0xAA, sizeof(done));
+        Model_Send(model, done, 8, STATE_IDLE);
+    }
+    else
+    {
+        model->state = STATE_IDLE;
+    }
+}
+
+static void Model_FunctionCommand(DS2438_Model* model, uint64_t time_us)
+{
+    model->command = model->byte;
+    model->count = 0;
+    if (model->rom[0] == DS2438_MODEL_DS18B20)
+    {
+        Model_FunctionDS18B20(model, time_us);
+        return;
+    }
+    if (model->rom[0] == DS2438_MODEL_DS2431)
+    {
+        Model_FunctionDS2431(model);
+        return;
+    }
+    switch (model->command)
+    {
+        case 0x44:  // CONVERT T
+            model->memory[0][1] = model->temperature & 0xFF;
+            model->memory[0][2] = model->temperature >> 8;
+            model->temperature_until_us = time_us + model->conversion_us;
+            model->state = STATE_BUSY;
+            break;
+        case 0xB4:  // CONVERT V
+        {
+            uint16_t voltage = (model->memory[0][0] & STATUS_AD) ? model->vdd : model->vad;
+            model->memory[0][3] = voltage & 0xFF;
+            model->memory[0][4] = voltage >> 8;
+            model->voltage_until_us = time_us + model->conversion_us;
+            model->state = STATE_BUSY;
+            break;
+        }
+        case 0xB8:  // RECALL MEMORY
+        case 0xBE:  // READ SCRATCHPAD
+        case 0x4E:  // WRITE SCRATCHPAD
+        case 0x48:  // COPY SCRATCHPAD
+            model->state = STATE_ARGUMENT;
+            break;
+        default:
+            model->state = STATE_IDLE;
+            break;
+    }
+}
+
+static void Model_Argument(DS2438_Model* model, uint64_t time_us)
+{
+    if (model->rom[0] == DS2438_MODEL_DS2431)
+    {
+        Model_ArgumentDS2431(model);
+        return;
+    }
+    if (model->count == 0)
+    {
+        model->page_number = model->byte & 0x07;
+        model->count = 1;
+        switch (model->command)
+        {
+            case 0xB8:
+                Model_Recall(model, model->page_number, time_us);
+                model->state = STATE_IDLE;
+                break;
+            case 0xBE:
+            {
+                uint8_t page[9];
+                memcpy(page, model->scratchpad[model->page_number], 8);
+                page[8] = Model_Crc8(page, 8);
+                Model_Send(model, page, 9, STATE_IDLE);
+                break;
+            }
+            case 0x48:
+                memcpy(model->memory[model->page_number], model->scratchpad[model->page_number], 8);
+                model->copy_until_us = time_us + model->copy_us;
+                model->copies++;
+                model->state = STATE_BUSY;
+                break;
+        }
+        return;
+    }
+    // WRITE SCRATCHPAD data
+    if (model->count <= 8)
+        model->scratchpad[model->page_number][model->count - 1] = model->byte;
+    model->count++;
+}
+
+// Bit driven by the device in the current slot, 1 if it leaves the line released
+static uint8_t Model_Output(const DS2438_Model* model, uint64_t time_us)
+{
+    switch (model->state)
+    {
+        case STATE_SEND:
+            return (model->tx[model->tx_bit / 8] >> (model->tx_bit % 8)) & 0x01;
+        case STATE_SEARCH:
+        {
+            uint8_t bit = (model->rom[model->search_bit / 8] >> (model->search_bit % 8)) & 0x01;
+            if (model->search_phase == 0)
+                return bit;
+            if (model->search_phase == 1)
+                return bit ^ 0x01;
+            return 1;
+        }
+        case STATE_BUSY:
+            return (time_us >= model->temperature_until_us) && (time_us >= model->voltage_until_us) &&
+                   (time_us >= model->copy_until_us);
+        default:
+            return 1;
+    }
+}
+
+// End of a slot, with the level left by the master
+static void Model_Slot(DS2438_Model* model, uint8_t level, uint64_t time_us)
+{
+    switch (model->state)
+    {
+        case STATE_ROM:
+        case STATE_MATCH:
+        case STATE_FUNCTION:
+        case STATE_ARGUMENT:
+            model->byte |= level << model->bits;
+            if (++model->bits < 8)
+                return;
+            model->bits = 0;
+            if (model->state == STATE_ROM)
+            {
+                Model_RomCommand(model);
+            }
+            else if (model->state == STATE_MATCH)
+            {
+                if (model->byte != model->rom[model->count])
+                    model->state = STATE_IDLE;
+                else if (++model->count == 8)
+                    model->state = STATE_FUNCTION;
+            }
+            else if (model->state == STATE_FUNCTION)
+            {
+                Model_FunctionCommand(model, time_us);
+            }
+            else
+            {
+                Model_Argument(model, time_us);
+            }
+            model->byte = 0;
+            break;
+        case STATE_SEND:
+            if (++model->tx_bit == 8 * model->tx_length)
+                model->state = model->tx_next;
+            break;
+        case STATE_SEARCH:
+            if (model->search_phase < 2)
+            {
+                model->search_phase++;
+            }
+            else if (level != ((model->rom[model->search_bit / 8] >> (model->search_bit % 8)) & 0x01))
+            {
+                model->state = STATE_IDLE;
+            }
+            else
+            {
+                model->search_phase = 0;
+                if (++model->search_bit == 64)
+                    model->state = STATE_FUNCTION;
+            }
+            break;
+    }
+}
+
+// ===========================================================
+//                      BUS
+// ===========================================================
+
+void DS2438_ModelBusInit(DS2438_ModelBus* bus, DS2438_Model** devices, uint16_t count)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->devices = devices;
+    bus->count = count;
+    bus->seed = 1;
+}
+
+static void Model_BusSlot(DS2438_ModelBus* bus, uint8_t level, uint64_t time_us)
+{
+    bus->pending = 0;
+    bus->slots++;
+    for (uint16_t n = 0; n < bus->count; n++)
+    {
+        if (bus->devices[n]->present)
+            Model_Slot(bus->devices[n], level, time_us);
+    }
+}
+
+// No device drives read slots: short pulses can only be writes of 1
+static uint8_t Model_BusReceiving(const DS2438_ModelBus* bus)
+{
+    for (uint16_t n = 0; n < bus->count; n++)
+    {
+        uint8_t state = bus->devices[n]->state;
+        if (bus->devices[n]->present && ((state == STATE_SEND) || (state == STATE_SEARCH) || (state == STATE_BUSY)))
+            return 0;
+    }
+    return 1;
+}
+
+// A device sends its presence pulse
+static uint8_t Model_BusInPresence(const DS2438_ModelBus* bus, uint64_t time_us)
+{
+    uint64_t elapsed_us = time_us - bus->release_us;
+    if (!bus->presence_window || (elapsed_us < PRESENCE_START_US) || (elapsed_us >= PRESENCE_END_US))
+        return 0;
+    for (uint16_t n = 0; n < bus->count; n++)
+    {
+        if (bus->devices[n]->present)
+            return 1;
+    }
+    return 0;
+}
+
+void DS2438_ModelBusDrive(DS2438_ModelBus* bus, int low, uint64_t time_us)
+{
+    if (low)
+    {
+        if (Model_BusInPresence(bus, time_us))
+        {
+            // No falling edge for the devices: the slot is lost
+            bus->collisions++;
+            bus->presence_window = 0;
+            bus->pending = 0;
+            bus->low = 2;
+            return;
+        }
+        bus->presence_window = 0;
+        bus->low = 1;
+        if (time_us < bus->high_us)
+        {
+            // Still low from the previous pulse, that goes on
+            bus->collisions++;
+            bus->pending = 0;
+            return;
+        }
+        if (bus->pending)
+            Model_BusSlot(bus, 1, time_us);
+        bus->low_start_us = time_us;
+        return;
+    }
+    if (bus->low == 0)
+        return;
+    bus->high_us = time_us + bus->rise_us;
+    if (bus->low == 2)
+    {
+        bus->low = 0;
+        return;
+    }
+    bus->low = 0;
+    uint64_t low_us = bus->high_us - bus->low_start_us;
+    if (low_us >= RESET_MIN_US)
+    {
+        bus->resets++;
+        bus->presence_window = 1;
+        bus->release_us = time_us;
+        for (uint16_t n = 0; n < bus->count; n++)
+        {
+            DS2438_Model* model = bus->devices[n];
+            model->state = STATE_ROM;
+            model->bits = 0;
+            model->byte = 0;
+        }
+    }
+    else if (low_us >= WRITE_0_MIN_US)
+    {
+        Model_BusSlot(bus, 0, time_us);
+    }
+    else if (Model_BusReceiving(bus))
+    {
+        // Write 1: decoded now, so that commands start at the end of their last slot
+        Model_BusSlot(bus, 1, time_us);
+    }
+    else
+    {
+        // Write 1 or read slot, decoded at the sample or at the next slot
+        bus->pending = 1;
+    }
+}
+
+int DS2438_ModelBusSample(DS2438_ModelBus* bus, uint64_t time_us)
+{
+    if (bus->low || (time_us < bus->high_us))
+        return 0;
+    if (bus->presence_window)
+    {
+        uint64_t elapsed_us = time_us - bus->release_us;
+        if (elapsed_us >= PRESENCE_WINDOW_US)
+        {
+            bus->presence_window = 0;
+            return 1;
+        }
+        if ((elapsed_us < PRESENCE_START_US) || (elapsed_us >= PRESENCE_END_US))
+            return 1;
+        for (uint16_t n = 0; n < bus->count; n++)
+        {
+            if (bus->devices[n]->present)
+                return 0;
+        }
+        return 1;
+    }
+    if (bus->pending == 0)
+        return 1;
+
+    // Read slot: wired-AND of the devices
+    uint8_t line = 1;
+    for (uint16_t n = 0; n < bus->count; n++)
+    {
+        if (bus->devices[n]->present)
+            line &= Model_Output(bus->devices[n], time_us);
+    }
+    if (bus->noise_ppm > 0)
+    {
+        bus->seed = bus->seed * 1103515245u + 12345u;
+        if (((bus->seed >> 8) % 1000000u) < bus->noise_ppm)
+        {
+            line ^= 0x01;
+            bus->flipped++;
+        }
+    }
+    Model_BusSlot(bus, 1, time_us);
+    return line;
+}
+
+static void Model_HostDrive(void* context, uint32 pin, int low, uint64_t time_us)
+{
+    (void)pin;
+    DS2438_ModelBusDrive((DS2438_ModelBus*)context, low, time_us);
+}
+
+static int Model_HostSample(void* context, uint32 pin, uint64_t time_us)
+{
+    (void)pin;
+    return DS2438_ModelBusSample((DS2438_ModelBus*)context, time_us);
+}
+
+Host_Bus DS2438_ModelBusHost(DS2438_ModelBus* bus)
+{
+    Host_Bus host = {Model_HostDrive, Model_HostSample, bus};
+    return host;
+}
+
+/* [] END OF FILE */
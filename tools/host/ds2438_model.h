@@ -0,0 +1,159 @@
+/**
+ * \file ds2438_model.h
+ * \brief Pin-level model of DS2438 devices for the host platform.
+ *
+ * A model bus decodes resets and time slots from the pin accesses of the
+ * library, as a device does from the line: low pulses of 240 us or more
+ * are resets, pulses of 15 us or more write 0, shorter pulses write 1 or,
+ * when the line is sampled, read the wired-AND of the bits driven by the
+ * devices. Several devices can share a bus: ROM commands (READ, MATCH,
+ * SKIP and SEARCH ROM) select them as on a real multi-drop bus.
+ *
+ * Devices implement the memory function commands used by the library
+ * (conversions, recall, read, write and copy of the scratchpad). The
+ * measured values are fields of the model, which the caller can change at
+ * any time; a conversion latches them when it is started, and the status
+ * byte reports the conversion or the copy as busy for the datasheet time.
+ *
+ * A device can also be turned into a DS18B20 temperature sensor or a
+ * DS2431 EEPROM with #DS2438_ModelSetFamily(), to simulate buses shared
+ * with other families. The DS18B20 implements CONVERT T, READ SCRATCHPAD
+ * and READ POWER SUPPLY, with its scratchpad in page 0 of memory; the
+ * DS2431 implements the scratchpad commands, on whole rows, and READ
+ * MEMORY, with its memory in eeprom.
+*/
+#ifndef __DS2438_MODEL_H__
+    #define __DS2438_MODEL_H__
+
+    #include "host_platform.h"
+
+    #define DS2438_MODEL_DS2438     0x26    ///< Family code of the DS2438
+    #define DS2438_MODEL_DS18B20    0x28    ///< Family code of the DS18B20
+    #define DS2438_MODEL_DS2431     0x2D    ///< Family code of the DS2431
+
+    // ===========================================================
+    //                      DEVICE
+    // ===========================================================
+
+    /**
+    *   \brief Simulated DS2438.
+    */
+    typedef struct {
+        uint8_t rom[8];                 ///< ROM ID, family code 0x26 and CRC
+        uint8_t memory[8][8];           ///< Memory pages
+        uint8_t scratchpad[8][8];       ///< Scratchpad of each page
+        uint8_t present;                ///< 1 while connected to the bus
+        uint16_t temperature;           ///< Temperature register, 1/256 degree Celsius, bits 0-2 at 0
+        uint16_t vdd;                   ///< VDD, 10 mV
+        uint16_t vad;                   ///< VAD, 10 mV
+        int16_t current;                ///< Current register, -1024 to 1023
+        uint8_t ica;                    ///< Integrated current accumulator
+        uint16_t cca;                   ///< Charging current accumulator
+        uint16_t dca;                   ///< Discharging current accumulator
+        uint32_t conversion_us;         ///< Duration of a conversion
+        uint32_t copy_us;               ///< Duration of a copy to memory
+        uint8_t eeprom[128];            ///< Memory of a DS2431
+        uint32_t copies;                ///< Copies to memory, that is write cycles of the EEPROM
+
+        // Protocol state, managed by the bus
+        uint8_t state;
+        uint8_t bits;
+        uint8_t byte;
+        uint8_t command;
+        uint8_t page_number;
+        uint8_t count;
+        uint8_t tx[128];
+        uint8_t tx_length;
+        uint16_t tx_bit;
+        uint8_t tx_next;
+        uint8_t search_phase;
+        uint8_t search_bit;
+        uint16_t target;
+        uint8_t es;
+        uint64_t temperature_until_us;
+        uint64_t voltage_until_us;
+        uint64_t copy_until_us;
+    } DS2438_Model;
+
+    /**
+    *   \brief Initialize a device.
+    *
+    *   Pages are cleared, except the status byte (IAD, CA, EE and AD set),
+    *   and the measurements are set to 25 degree Celsius, 5 V and no current.
+    *   \param model pointer to the device.
+    *   \param serial 48-bit serial number; family code and CRC are added.
+    */
+    void DS2438_ModelInit(DS2438_Model* model, uint64_t serial);
+
+    /**
+    *   \brief Change the family of a device.
+    *
+    *   The family code and the CRC of the ROM are replaced. A DS18B20
+    *   starts with its power-on scratchpad (85 degree Celsius) and 750 ms
+    *   conversions, and converts the temperature field; a DS2431 starts
+    *   with an erased memory.
+    *   \param model pointer to a device initialized by #DS2438_ModelInit().
+    *   \param family one of the DS2438_MODEL_* family codes.
+    */
+    void DS2438_ModelSetFamily(DS2438_Model* model, uint8_t family);
+
+    // ===========================================================
+    //                      BUS
+    // ===========================================================
+
+    /**
+    *   \brief Bus of simulated devices.
+    *
+    *   With a rise time, the line reads low for rise_us after each release:
+    *   devices see each low pulse longer by rise_us, and a slot started
+    *   before the line is high merges with the previous pulse. A slot started
+    *   while a device sends its presence pulse is not seen by the devices.
+    */
+    typedef struct {
+        DS2438_Model** devices;         ///< Devices connected to the bus
+        uint16_t count;                 ///< Number of devices
+        uint32_t noise_ppm;             ///< Probability of a corrupted read slot, per million
+        uint32_t seed;                  ///< State of the noise generator
+        uint16_t rise_us;               ///< Time for the line to read high after a release
+
+        // Line decoding
+        uint8_t low;
+        uint8_t pending;
+        uint8_t presence_window;
+        uint64_t low_start_us;
+        uint64_t release_us;
+        uint64_t high_us;
+
+        // Statistics
+        uint32_t resets;                ///< Reset pulses
+        uint32_t slots;                 ///< Time slots
+        uint32_t flipped;               ///< Read slots corrupted by noise
+        uint32_t collisions;            ///< Slots started before the line was high or during a presence pulse
+    } DS2438_ModelBus;
+
+    /**
+    *   \brief Initialize a bus.
+    *
+    *   \param bus pointer to the bus.
+    *   \param devices array of devices, which must remain valid.
+    *   \param count number of devices.
+    */
+    void DS2438_ModelBusInit(DS2438_ModelBus* bus, DS2438_Model** devices, uint16_t count);
+
+    /**
+    *   \brief Forward a pin access of the master: low (1) or release (0).
+    */
+    void DS2438_ModelBusDrive(DS2438_ModelBus* bus, int low, uint64_t time_us);
+
+    /**
+    *   \brief Sample the line; returns 0 if it is low.
+    */
+    int DS2438_ModelBusSample(DS2438_ModelBus* bus, uint64_t time_us);
+
+    /**
+    *   \brief Get a host bus model where every pin is connected to the same bus.
+    */
+    Host_Bus DS2438_ModelBusHost(DS2438_ModelBus* bus);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,202 @@
+/********************************************
+*
+*   \brief Source code for the host platform.
+*
+*   The SysTick is emulated with a reload value
+*   giving a 1 ms period at 64 MHz, so that the
+*   time base computes microseconds as on target.
+*
+**********************************************/
+
+#include "host_platform.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SYSTICK_RELOAD 63999u
+
+static uint64_t time_us = 0;
+static uint64_t delay_us = 0;
+static Host_Bus host_bus;
+static uint8_t has_bus = 0;
+static cySysTickCallback systick_callback = NULL;
+
+// Emulated EEPROM content
+static uint8_t eeprom[4096];
+
+void Host_SetBus(const Host_Bus* bus)
+{
+    has_bus = (bus != NULL);
+    if (has_bus)
+        host_bus = *bus;
+}
+
+uint64_t Host_GetUs(void)
+{
+    return time_us;
+}
+
+void Host_AdvanceUs(uint64_t microseconds)
+{
+    uint64_t end_us = time_us + microseconds;
+    // Call the SysTick callback at every millisecond boundary
+    while ((time_us / 1000) < (end_us / 1000))
+    {
+        time_us = (time_us / 1000 + 1) * 1000;
+        if (systick_callback != NULL)
+            systick_callback();
+    }
+    time_us = end_us;
+}
+
+uint64_t Host_GetDelayUs(void)
+{
+    return delay_us;
+}
+
+// ===========================================================
+//                      PINS AND DELAYS
+// ===========================================================
+
+void CyPins_ClearPin(uint32 pin)
+{
+    if (has_bus)
+        host_bus.drive(host_bus.context, pin, 1, time_us);
+}
+
+void CyPins_SetPin(uint32 pin)
+{
+    if (has_bus)
+        host_bus.drive(host_bus.context, pin, 0, time_us);
+}
+
+uint8 CyPins_ReadPin(uint32 pin)
+{
+    if (has_bus)
+        return host_bus.sample(host_bus.context, pin, time_us) ? 1 : 0;
+    return 1;
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    delay_us += microseconds;
+    Host_AdvanceUs(microseconds);
+}
+
+void CyDelay(uint32 milliseconds)
+{
+    Host_AdvanceUs(1000ull * milliseconds);
+}
+
+// ===========================================================
+//                      SYSTICK
+// ===========================================================
+
+void CySysTickStart(void)
+{
+}
+
+cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function)
+{
+    cySysTickCallback previous = systick_callback;
+    (void)number;
+    systick_callback = function;
+    return previous;
+}
+
+uint32 CySysTickGetValue(void)
+{
+    // Down-counter, reloaded every millisecond
+    return SYSTICK_RELOAD - (uint32)((time_us % 1000) * (SYSTICK_RELOAD + 1) / 1000);
+}
+
+uint32 CySysTickGetReload(void)
+{
+    return SYSTICK_RELOAD;
+}
+
+uint8 CyEnterCriticalSection(void)
+{
+    return 0;
+}
+
+void CyExitCriticalSection(uint8 saved)
+{
+    (void)saved;
+}
+
+// ===========================================================
+//                      UART
+// ===========================================================
+
+void UART_Start(void)
+{
+}
+
+void UART_PutString(const char* string)
+{
+    fputs(string, stdout);
+}
+
+void UART_PutChar(uint8 character)
+{
+    fputc(character, stdout);
+}
+
+uint8 UART_GetTxBufferSize(void)
+{
+    return 0;
+}
+
+// ===========================================================
+//                      EMULATED EEPROM
+// ===========================================================
+
+cy_en_em_eeprom_status_t Cy_Em_EEPROM_Init(cy_stc_eeprom_config_t* config, cy_stc_eeprom_context_t* context)
+{
+    if (config->eepromSize > sizeof(eeprom))
+        return CY_EM_EEPROM_BAD_PARAM;
+    context->eepromSize = config->eepromSize;
+    return CY_EM_EEPROM_SUCCESS;
+}
+
+cy_en_em_eeprom_status_t Cy_Em_EEPROM_Read(uint32 addr, void* data, uint32 size, cy_stc_eeprom_context_t* context)
+{
+    if (addr + size > context->eepromSize)
+        return CY_EM_EEPROM_BAD_PARAM;
+    memcpy(data, &eeprom[addr], size);
+    return CY_EM_EEPROM_SUCCESS;
+}
+
+cy_en_em_eeprom_status_t Cy_Em_EEPROM_Write(uint32 addr, void* data, uint32 size, cy_stc_eeprom_context_t* context)
+{
+    if (addr + size > context->eepromSize)
+        return CY_EM_EEPROM_BAD_PARAM;
+    memcpy(&eeprom[addr], data, size);
+    return CY_EM_EEPROM_SUCCESS;
+}
+
+static cy_stc_eeprom_config_t em_eeprom_config;
+static cy_stc_eeprom_context_t em_eeprom_context;
+
+cy_en_em_eeprom_status_t Em_EEPROM_Init(uint32 startAddress)
+{
+    em_eeprom_config.eepromSize = Em_EEPROM_EEPROM_SIZE;
+    em_eeprom_config.simpleMode = 0;
+    em_eeprom_config.wearLevelingFactor = Em_EEPROM_WEAR_LEVELING_FACTOR;
+    em_eeprom_config.redundantCopy = Em_EEPROM_REDUNDANT_COPY;
+    em_eeprom_config.blockingWrite = Em_EEPROM_BLOCKING_WRITE;
+    em_eeprom_config.userFlashStartAddr = startAddress;
+    return Cy_Em_EEPROM_Init(&em_eeprom_config, &em_eeprom_context);
+}
+
+cy_en_em_eeprom_status_t Em_EEPROM_Read(uint32 addr, void* eepromData, uint32 size)
+{
+    return Cy_Em_EEPROM_Read(addr, eepromData, size, &em_eeprom_context);
+}
+
+cy_en_em_eeprom_status_t Em_EEPROM_Write(uint32 addr, void* eepromData, uint32 size)
+{
+    return Cy_Em_EEPROM_Write(addr, eepromData, size, &em_eeprom_context);
+}
+
+/* [] END OF FILE */
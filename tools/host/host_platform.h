@@ -0,0 +1,53 @@
+/**
+ * \file host_platform.h
+ * \brief Host platform for running the DS2438 Library on Linux.
+ *
+ * The library sources are compiled unchanged against the headers of this
+ * folder. Time is virtual: it only advances with CyDelayUs(), CyDelay()
+ * and Host_AdvanceUs(), and the SysTick callback registered by the time
+ * base is called at every millisecond boundary. Pin accesses are forwarded
+ * to a bus model, which plays the role of the devices.
+*/
+#ifndef __HOST_PLATFORM_H__
+    #define __HOST_PLATFORM_H__
+
+    #include "project.h"
+
+    /**
+    *   \brief Bus model.
+    *
+    *   drive is called when the master drives a pin low (low = 1) or
+    *   releases it (low = 0), sample when it reads the pin, which must
+    *   return 0 if the line is low. Both receive the virtual time in us.
+    */
+    typedef struct {
+        void (*drive)(void* context, uint32 pin, int low, uint64_t time_us);
+        int (*sample)(void* context, uint32 pin, uint64_t time_us);
+        void* context;
+    } Host_Bus;
+
+    /**
+    *   \brief Register the bus model. With no model, the line reads high.
+    */
+    void Host_SetBus(const Host_Bus* bus);
+
+    /**
+    *   \brief Get the virtual time, in us.
+    */
+    uint64_t Host_GetUs(void);
+
+    /**
+    *   \brief Advance the virtual time, e.g. over idle periods.
+    */
+    void Host_AdvanceUs(uint64_t microseconds);
+
+    /**
+    *   \brief Get the time spent in CyDelayUs() since startup, in us.
+    *
+    *   All the delays of OneWire.c are 1-Wire slot and reset times,
+    *   so this is the bus time of the build.
+    */
+    uint64_t Host_GetDelayUs(void);
+
+#endif
+/* [] END OF FILE */
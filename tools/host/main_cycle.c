@@ -0,0 +1,43 @@
+/********************************************
+*
+*   \brief Source code for the main loop of main.c
+*   on the host.
+*
+*   Same transactions as the measurement cycle of
+*   main.c, in the same order; the results are only
+*   read, as the telemetry is not sent.
+*
+**********************************************/
+
+#include "main_cycle.h"
+#include "DS2438.h"
+#include "DS2438_Accumulators.h"
+#include "DS2438_History.h"
+
+void MainCycle_Run(void)
+{
+    float voltage, temperature, current, capacity;
+    uint8_t page_data[9], page_1[9], page_7[9];
+
+    DS2438_ReadVoltage(&voltage);
+    DS2438_ReadTemperature(&temperature);
+    DS2438_GetCurrentData(&current);
+    DS2438_GetCapacity(&capacity);
+    for (uint8_t page = 0; page < 7; page++)
+    {
+        DS2438_ReadPage(page, page_data);
+    }
+    DS2438_AccumulatorsPoll();
+    if (DS2438_PollHistory() == DS2438_OK)
+    {
+        DS2438_History history;
+        DS2438_GetHistory(&history);
+    }
+    if ((DS2438_ReadPage(0x00, page_data) == DS2438_OK) &&
+        (DS2438_ReadPage(0x01, page_1) == DS2438_OK))
+    {
+        DS2438_ReadPage(0x07, page_7);
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,42 @@
+/**
+ * \file main_cycle.h
+ * \brief Main loop of main.c for the host tools.
+ *
+ * The measurement cycle and the settings of the demo application, without
+ * the output, so that the tools run the same transactions as the firmware:
+ * one cycle every #MAIN_CYCLE_PERIOD_MS, and the presence watcher polled at
+ * every iteration of the main loop, so in the idle time between cycles.
+ * Keep in line with main.c.
+*/
+#ifndef __MAIN_CYCLE_H__
+    #define __MAIN_CYCLE_H__
+
+    #include "project.h"
+
+    /**
+    *   \brief Period of the measurement cycle, in ms.
+    */
+    #define MAIN_CYCLE_PERIOD_MS            1000
+
+    /**
+    *   \brief Detection latency of the presence watcher, in ms.
+    */
+    #define MAIN_PRESENCE_LATENCY_MS        100
+
+    /**
+    *   \brief Bus time budget of the presence watcher, per mille.
+    */
+    #define MAIN_PRESENCE_BUDGET_PERMILLE   10
+
+    /**
+    *   \brief Interval between two iterations of the main loop in the idle time, in us.
+    */
+    #define MAIN_LOOP_US                    1000
+
+    /**
+    *   \brief Run one measurement cycle of main.c, without the output.
+    */
+    void MainCycle_Run(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,48 @@
+/**
+ * \file project.h
+ * \brief Host replacement of the PSoC Creator generated API.
+ *
+ * Provides the pin, delay, SysTick, critical section, UART and emulated
+ * EEPROM functions used by the DS2438 Library, implemented in host_platform.c on top of a
+ * virtual clock. Pin accesses are forwarded to the bus model registered
+ * with Host_SetBus().
+*/
+#ifndef __HOST_PROJECT_H__
+    #define __HOST_PROJECT_H__
+
+    #include "cytypes.h"
+    #include "cy_em_eeprom.h"
+    #include "Em_EEPROM.h"
+
+    /**
+    *   \brief Pin of the DS2438, as a bus number for the host bus model.
+    */
+    #define DS2438_Pin_0 0u
+
+    #define CyGlobalIntEnable
+
+    typedef void (*cySysTickCallback)(void);
+
+    void CyPins_ClearPin(uint32 pin);
+    void CyPins_SetPin(uint32 pin);
+    uint8 CyPins_ReadPin(uint32 pin);
+
+    void CyDelayUs(uint16 microseconds);
+    void CyDelay(uint32 milliseconds);
+
+    void CySysTickStart(void);
+    cySysTickCallback CySysTickSetCallback(uint32 number, cySysTickCallback function);
+    uint32 CySysTickGetValue(void);
+    uint32 CySysTickGetReload(void);
+
+    uint8 CyEnterCriticalSection(void);
+    void CyExitCriticalSection(uint8 saved);
+
+    void UART_Start(void);
+    void UART_PutString(const char* string);
+    void UART_PutChar(uint8 character);
+    uint8 UART_GetTxBufferSize(void);
+    #define UART_TX_BUFFER_SIZE 64u
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,254 @@
+/********************************************
+*
+*   \brief Host check of the sample log of DS2438_Log.h.
+*
+*   The log runs on a model of the flash region, a RAM
+*   array behind a #DS2438_LogFlash interface, which can
+*   tear a write after a given number of bytes, as a
+*   power failure would. A restart is simulated by
+*   calling DS2438_LogStart() again, which loses the RAM
+*   ring buffer and scans the slots. Checked:
+*   - wrap-around: more batches than slots are written,
+*     the slots hold the most recent ones, in order;
+*   - recovery: after a restart, writing resumes after
+*     the highest written sequence number;
+*   - a single flash write per batch;
+*   - torn writes, in the header, in the payload and
+*     right before the last byte of the payload: the torn
+*     slot is never reported as a batch, even over an
+*     older batch of the same slot, unless the bytes left
+*     from the older batch are the ones of the new batch,
+*     and the next batch goes to the next slot.
+*
+*   Sample i is made from i, so every decoded sample is
+*   checked, and batches of consecutive sequence numbers
+*   must hold consecutive samples, unless a restart lost
+*   the ring buffer between them. The exit status is 1
+*   if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o log_check tools/log_check.c
+*       tools/host/host_platform.c DS2438.cydsn/DS2438_Log.c DS2438.cydsn/DS2438_Storage.c
+*       DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c DS2438.cydsn/DS2438_Snapshot.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c
+*   Usage: log_check
+*
+**********************************************/
+
+#include "host_platform.h"
+#include "DS2438_Log.h"
+#include <stdio.h>
+#include <string.h>
+
+#define FLASH_SLOTS     4
+#define FLASH_SIZE      (FLASH_SLOTS * DS2438_LOG_SLOT_SIZE)
+#define NO_TEAR         0xFFFFFFFF
+#define TEAR_LAST_BYTE  0xFFFFFFFE
+
+static uint8_t flash_memory[FLASH_SIZE];
+static uint32_t tear_after = NO_TEAR;   // Bytes written before the power fails
+static uint32_t next_sample = 0;
+static uint8_t after_restart[64];       // 1 for the first batch written after a restart
+static uint32_t writes = 0;             // Completed flash writes
+static int failed = 0;
+
+// ===========================================================
+//                      FLASH MODEL
+// ===========================================================
+
+static uint8_t Flash_Read(uint32_t offset, void* data, uint32_t size)
+{
+    if ((offset + size) > FLASH_SIZE)
+        return DS2438_ERROR;
+    memcpy(data, &flash_memory[offset], size);
+    return DS2438_OK;
+}
+
+static uint8_t Flash_Write(uint32_t offset, const void* data, uint32_t size)
+{
+    if ((offset + size) > FLASH_SIZE)
+        return DS2438_ERROR;
+    if (tear_after == TEAR_LAST_BYTE)
+        tear_after = size - 1;
+    if (tear_after < size)
+    {
+        // Power lost during the write: only the first bytes are programmed
+        memcpy(&flash_memory[offset], data, tear_after);
+        tear_after = 0;
+        return DS2438_ERROR;
+    }
+    memcpy(&flash_memory[offset], data, size);
+    if (tear_after != NO_TEAR)
+        tear_after -= size;
+    writes++;
+    return DS2438_OK;
+}
+
+static const DS2438_LogFlash flash = {Flash_Read, Flash_Write, FLASH_SIZE};
+
+// ===========================================================
+//                      CHECKS
+// ===========================================================
+
+static void Check(int condition, const char* what)
+{
+    printf("  %-58s %s\n", what, condition ? "ok" : "FAIL");
+    if (!condition)
+        failed++;
+}
+
+static DS2438_LogSample Check_MakeSample(uint32_t i)
+{
+    DS2438_LogSample sample;
+    sample.timestamp_ms = 1000 * i + 7;
+    sample.voltage = i;
+    sample.temperature = 6400 + (i % 7) * 8;
+    sample.current = (uint16_t)((i * 37) % 2048 - 1024);
+    sample.ica = i & 0xFF;
+    sample.cca = i / 3;
+    sample.dca = i / 5;
+    return sample;
+}
+
+// Append samples until a batch is written, returns the result of the write
+static uint8_t Check_WriteBatch(void)
+{
+    DS2438_LogStats before, after;
+    DS2438_LogGetStats(&before);
+    for (uint8_t n = 0; n < DS2438_LOG_RAM_SAMPLES; n++)
+    {
+        DS2438_LogSample sample = Check_MakeSample(next_sample++);
+        DS2438_LogAppend(&sample);
+        uint8_t error = DS2438_LogService(DS2438_LOG_FLUSH_TIME_MS);
+        DS2438_LogGetStats(&after);
+        if ((error != DS2438_OK) || (after.batches != before.batches))
+            return error;
+    }
+    return DS2438_ERROR;
+}
+
+// Read a slot and check its samples; returns the index of its first sample, or -1
+static int32_t Check_ReadSlot(uint16_t slot, uint32_t* sequence, uint8_t* n_samples)
+{
+    DS2438_LogSample samples[DS2438_LOG_RAM_SAMPLES];
+    if (DS2438_LogReadBatch(slot, samples, DS2438_LOG_RAM_SAMPLES, n_samples, sequence) != DS2438_OK)
+        return -1;
+    for (uint8_t n = 0; n < *n_samples; n++)
+    {
+        DS2438_LogSample expected = Check_MakeSample(samples[0].voltage + n);
+        if ((samples[n].timestamp_ms != expected.timestamp_ms) || (samples[n].voltage != expected.voltage) ||
+            (samples[n].temperature != expected.temperature) || (samples[n].current != expected.current) ||
+            (samples[n].ica != expected.ica) || (samples[n].cca != expected.cca) || (samples[n].dca != expected.dca))
+            return -2;
+    }
+    return samples[0].voltage;
+}
+
+// Check that the slots hold the batches of the given sequence numbers, in consecutive samples
+static void Check_Slots(uint32_t first_sequence, uint32_t last_sequence, int16_t torn_slot)
+{
+    int32_t first_sample[FLASH_SLOTS];
+    uint32_t sequences[FLASH_SLOTS];
+    uint8_t counts[FLASH_SLOTS];
+    int ok = 1;
+
+    for (uint16_t slot = 0; slot < FLASH_SLOTS; slot++)
+    {
+        first_sample[slot] = Check_ReadSlot(slot, &sequences[slot], &counts[slot]);
+        if (slot == torn_slot)
+        {
+            ok &= (first_sample[slot] == -1);
+            continue;
+        }
+        ok &= (first_sample[slot] >= 0) && (sequences[slot] % FLASH_SLOTS == slot) &&
+              (sequences[slot] >= first_sequence) && (sequences[slot] <= last_sequence);
+    }
+    // Consecutive sequence numbers hold consecutive samples
+    for (uint16_t slot = 0; ok && (slot < FLASH_SLOTS); slot++)
+    {
+        uint16_t next = (slot + 1) % FLASH_SLOTS;
+        if ((slot == torn_slot) || (next == torn_slot) || (sequences[next] != sequences[slot] + 1) ||
+            after_restart[sequences[next]])
+            continue;
+        ok &= (first_sample[next] == first_sample[slot] + counts[slot]);
+    }
+    char what[80];
+    snprintf(what, sizeof(what), "slots hold sequences %u to %u%s", first_sequence, last_sequence,
+             (torn_slot >= 0) ? ", torn slot rejected" : "");
+    Check(ok, what);
+}
+
+// Tear the next batch after some bytes, restart, and check that the log recovers
+static void Check_Tear(uint32_t bytes, const char* where, uint32_t* sequence)
+{
+    uint16_t torn_slot = (*sequence + 1) % FLASH_SLOTS;
+    uint32_t read_sequence;
+    uint8_t n_samples;
+    printf("torn write %s\n", where);
+    tear_after = bytes;
+    Check(Check_WriteBatch() == DS2438_ERROR, "write reports the failure");
+    tear_after = NO_TEAR;
+
+    Check(DS2438_LogStart(&flash) == DS2438_OK, "restart");
+    if ((Check_ReadSlot(torn_slot, &read_sequence, &n_samples) >= 0) && (read_sequence == *sequence + 1))
+    {
+        // The bytes left from the older batch were the ones of the new batch
+        *sequence += 1;
+        Check_Slots(*sequence + 1 - FLASH_SLOTS, *sequence, -1);
+        Check(1, "torn slot holds the whole batch");
+    }
+    else
+    {
+        Check_Slots(*sequence + 1 - (FLASH_SLOTS - 1), *sequence, torn_slot);
+    }
+    // Samples of the ring buffer are lost with the power
+    uint16_t next_slot = (*sequence + 1) % FLASH_SLOTS;
+    Check(Check_WriteBatch() == DS2438_OK, "next batch written");
+    *sequence += 1;
+    after_restart[*sequence] = 1;
+    Check((Check_ReadSlot(next_slot, &read_sequence, &n_samples) >= 0) && (read_sequence == *sequence),
+          "next batch goes to the next slot, after the last sequence");
+}
+
+int main(void)
+{
+    uint32_t sequence;
+    uint32_t read_sequence;
+    uint8_t n_samples;
+
+    memset(flash_memory, 0xFF, sizeof(flash_memory));
+
+    printf("empty flash\n");
+    Check(DS2438_LogStart(&flash) == DS2438_OK, "start");
+    Check(Check_ReadSlot(0, &read_sequence, &n_samples) == -1, "no batch reported");
+
+    printf("wrap-around\n");
+    uint32_t start_writes = writes;
+    for (sequence = 0; sequence < 3 * FLASH_SLOTS + 1; sequence++)
+    {
+        if (Check_WriteBatch() != DS2438_OK)
+            break;
+    }
+    Check(sequence == 3 * FLASH_SLOTS + 1, "13 batches written on 4 slots");
+    Check(writes - start_writes == sequence, "one flash write per batch");
+    sequence--;
+    Check_Slots(sequence + 1 - FLASH_SLOTS, sequence, -1);
+
+    printf("recovery\n");
+    Check(DS2438_LogStart(&flash) == DS2438_OK, "restart");
+    Check(Check_WriteBatch() == DS2438_OK, "batch written");
+    sequence++;
+    after_restart[sequence] = 1;
+    Check((Check_ReadSlot(sequence % FLASH_SLOTS, &read_sequence, &n_samples) >= 0) && (read_sequence == sequence),
+          "batch follows the highest written sequence");
+    Check_Slots(sequence + 1 - FLASH_SLOTS, sequence, -1);
+
+    Check_Tear(DS2438_LOG_SLOT_SIZE / 2, "in the payload", &sequence);
+    Check_Tear(TEAR_LAST_BYTE, "before the last byte", &sequence);
+    Check_Tear(3, "in the header", &sequence);
+
+    printf("%d failed\n", failed);
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,520 @@
+/********************************************
+*
+*   \brief Replay of recorded 1-Wire traces against the driver.
+*
+*   The DS2438 Library (OneWire.c included) is built for
+*   the host platform, and a bus model plays the recorded
+*   device: it decodes resets and slots from the pin
+*   accesses of the build, answers presence and read slots
+*   with the recorded values, and checks the written bits.
+*
+*   The build runs the main loop of main.c, from
+*   tools/host/main_cycle.h: the measurement cycle, then the
+*   presence watcher, polled in the idle time. Its
+*   transactions (reset to reset) are matched in order with
+*   the recorded ones; when the bits written before the first
+*   read differ, the next recorded transactions are searched
+*   for a match, so that transactions added or removed by the
+*   build are reported without losing the rest of the replay.
+*   Idle time follows the recording, so cache ages and
+*   deadlines behave as in the field.
+*
+*   Reported: transactions matched, missing (recorded, not
+*   issued by the build), extra (issued by the build, not
+*   recorded), diverged (different bits or length), resets,
+*   and the bus time of the recording and of the build. The
+*   exit status is 1 if any difference was found.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o onewire_replay tools/onewire_replay.c
+*       tools/host/host_platform.c tools/host/main_cycle.c DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c
+*       DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c DS2438.cydsn/DS2438_Snapshot.c
+*       DS2438.cydsn/DS2438_Accumulators.c DS2438.cydsn/DS2438_History.c DS2438.cydsn/DS2438_Storage.c
+*       DS2438.cydsn/DS2438_Presence.c
+*   Usage: onewire_replay [-p profile] [-n max_reports] trace
+*
+**********************************************/
+
+#include "onewire_trace.h"
+#include "host_platform.h"
+#include "main_cycle.h"
+#include "DS2438.h"
+#include "DS2438_Presence.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <unistd.h>
+
+// Low times classifying the pulses of the master, in us
+#define RESET_MIN_US            240
+#define WRITE_0_MIN_US          15
+
+// Presence is answered to samples up to this time after the reset pulse
+#define PRESENCE_WINDOW_US      480
+
+// Recorded transactions searched for a match
+#define RESYNC_WINDOW           64
+
+#define MAX_SLOTS               1024
+
+typedef struct {
+    uint8_t read;       // Read slot, or write slot
+    uint8_t value;      // Bit written, or bit read
+} Slot;
+
+typedef struct {
+    uint64_t time_us;   // Start of the reset
+    uint8_t presence;
+    Slot* slots;
+    size_t n_slots;
+    uint64_t bus_us;    // Recorded duration of the operations
+} Transaction;
+
+static struct {
+    Transaction* recorded;
+    size_t n_recorded;
+    size_t position;            // First recorded transaction not yet matched
+
+    // Transaction of the build
+    uint8_t active;
+    long candidate;             // Matched recorded transaction, -1 if none
+    Slot slots[MAX_SLOTS];
+    size_t n_slots;
+    uint8_t reads;              // A read slot was answered
+    uint8_t diverged;
+    uint64_t release_us;        // End of the reset pulse
+
+    // Line decoding
+    uint8_t low;
+    uint64_t low_start_us;
+    uint8_t pending_one;        // Short pulse: write 1, or read if sampled
+
+    // Recording time to host time
+    uint8_t aligned;
+    int64_t offset_us;
+
+    // Results
+    size_t skipped_at_start;
+    size_t matched;
+    size_t missing;
+    size_t extra;
+    size_t divergences;
+    size_t resets;
+    uint64_t recorded_bus_us;
+    unsigned max_reports;
+} replay;
+
+// ===========================================================
+//                      RECORDED TRANSACTIONS
+// ===========================================================
+
+static void AddRecordedSlot(Transaction* transaction, size_t* capacity, uint8_t read, uint8_t value)
+{
+    if (transaction->n_slots == *capacity)
+    {
+        *capacity = (*capacity == 0) ? 64 : 2 * *capacity;
+        transaction->slots = realloc(transaction->slots, *capacity * sizeof(Slot));
+    }
+    transaction->slots[transaction->n_slots].read = read;
+    transaction->slots[transaction->n_slots].value = value;
+    transaction->n_slots++;
+}
+
+// Split the trace at resets, expanding bytes to slots
+static size_t BuildTransactions(const Trace* trace)
+{
+    size_t dropped = 0, capacity = 0, slot_capacity = 0;
+    Transaction* current = NULL;
+
+    for (size_t n = 0; n < trace->count; n++)
+    {
+        const Trace_Record* record = &trace->records[n];
+        if (record->type == TRACE_RESET)
+        {
+            if (replay.n_recorded == capacity)
+            {
+                capacity = (capacity == 0) ? 256 : 2 * capacity;
+                replay.recorded = realloc(replay.recorded, capacity * sizeof(Transaction));
+            }
+            current = &replay.recorded[replay.n_recorded++];
+            current->time_us = record->time_us;
+            current->presence = record->value;
+            current->slots = NULL;
+            current->n_slots = 0;
+            current->bus_us = record->duration_us;
+            slot_capacity = 0;
+            continue;
+        }
+        if (current == NULL)
+        {
+            // Operations before the first reset belong to a partial transaction
+            dropped++;
+            continue;
+        }
+        current->bus_us += record->duration_us;
+        switch (record->type)
+        {
+            case TRACE_WRITE:
+                for (int bit = 0; bit < 8; bit++)
+                    AddRecordedSlot(current, &slot_capacity, 0, (record->data[0] >> bit) & 0x01);
+                break;
+            case TRACE_READ:
+                for (int bit = 0; bit < 8; bit++)
+                    AddRecordedSlot(current, &slot_capacity, 1, (record->data[0] >> bit) & 0x01);
+                break;
+            case TRACE_TOUCH:
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    if ((record->data[0] >> bit) & 0x01)
+                        AddRecordedSlot(current, &slot_capacity, 1, (record->data[1] >> bit) & 0x01);
+                    else
+                        AddRecordedSlot(current, &slot_capacity, 0, 0);
+                }
+                break;
+            case TRACE_WRITE_BIT:
+                AddRecordedSlot(current, &slot_capacity, 0, record->value);
+                break;
+            case TRACE_READ_BIT:
+                AddRecordedSlot(current, &slot_capacity, 1, record->value);
+                break;
+        }
+    }
+    return dropped;
+}
+
+// ===========================================================
+//                      MATCHING
+// ===========================================================
+
+// Level left by the master in a slot: 0 for write 0, 1 for write 1 and read
+static uint8_t MasterLevel(const Slot* slot)
+{
+    return slot->read ? 1 : slot->value;
+}
+
+static void FormatSlots(const Slot* slots, size_t n_slots, char* text, size_t size)
+{
+    size_t length = 0;
+    text[0] = 0;
+    for (size_t byte = 0; (byte * 8 < n_slots) && (length + 4 < size); byte++)
+    {
+        uint8_t value = 0, reads = 0;
+        size_t bits = (n_slots - byte * 8 < 8) ? n_slots - byte * 8 : 8;
+        for (size_t bit = 0; bit < bits; bit++)
+        {
+            const Slot* slot = &slots[byte * 8 + bit];
+            value |= (slot->read ? slot->value : MasterLevel(slot)) << bit;
+            reads |= slot->read;
+        }
+        length += snprintf(&text[length], size - length, "%s%02X%s", reads ? "r" : "",
+                           value, (bits < 8) ? "~" : "");
+        if ((byte + 1) * 8 < n_slots)
+            length += snprintf(&text[length], size - length, " ");
+    }
+}
+
+static void Report(const char* what)
+{
+    replay.divergences++;
+    if (replay.divergences > replay.max_reports)
+        return;
+    char build[256], recorded[256] = "none";
+    FormatSlots(replay.slots, replay.n_slots, build, sizeof(build));
+    if (replay.candidate >= 0)
+    {
+        const Transaction* transaction = &replay.recorded[replay.candidate];
+        FormatSlots(transaction->slots, transaction->n_slots, recorded, sizeof(recorded));
+    }
+    printf("%s, at %llu ms of the build\n  build:    %s\n  recorded: %s\n", what,
+           (unsigned long long)(Host_GetUs() / 1000), build, recorded);
+}
+
+// Check whether a recorded transaction starts with the slots written by the build
+static int MatchesPrefix(const Transaction* transaction)
+{
+    if (transaction->n_slots < replay.n_slots)
+        return 0;
+    for (size_t n = 0; n < replay.n_slots; n++)
+    {
+        if (MasterLevel(&transaction->slots[n]) != MasterLevel(&replay.slots[n]))
+            return 0;
+    }
+    return 1;
+}
+
+// Look for the recorded transaction issued by the build
+static void Resync(void)
+{
+    size_t last = replay.position + RESYNC_WINDOW;
+    replay.candidate = -1;
+    for (size_t n = replay.position; (n < replay.n_recorded) && (n < last); n++)
+    {
+        if (MatchesPrefix(&replay.recorded[n]))
+        {
+            replay.candidate = n;
+            return;
+        }
+    }
+}
+
+static void AddSlot(uint8_t read, uint8_t value)
+{
+    if (replay.n_slots == MAX_SLOTS)
+        return;
+    replay.slots[replay.n_slots++] = (Slot){read, value};
+    if ((replay.candidate < 0) || replay.diverged)
+        return;
+    const Transaction* transaction = &replay.recorded[replay.candidate];
+    size_t n = replay.n_slots - 1;
+    if ((n < transaction->n_slots) && (MasterLevel(&transaction->slots[n]) == MasterLevel(&replay.slots[n])))
+        return;
+    if (replay.reads == 0)
+    {
+        // Only commands were written so far: another transaction may match
+        Resync();
+    }
+    else
+    {
+        replay.diverged = 1;
+        Report("Different bits");
+    }
+}
+
+static void BeginTransaction(uint64_t release_us)
+{
+    replay.active = 1;
+    replay.n_slots = 0;
+    replay.reads = 0;
+    replay.diverged = 0;
+    replay.release_us = release_us;
+    replay.resets++;
+    replay.candidate = (replay.position < replay.n_recorded) ? (long)replay.position : -1;
+}
+
+static void EndTransaction(void)
+{
+    if (replay.active == 0)
+        return;
+    if (replay.pending_one)
+    {
+        replay.pending_one = 0;
+        AddSlot(0, 1);
+    }
+    replay.active = 0;
+    if (replay.candidate < 0)
+    {
+        if (replay.position < replay.n_recorded)
+        {
+            replay.extra++;
+            Report("Extra transaction");
+        }
+        return;
+    }
+
+    const Transaction* transaction = &replay.recorded[replay.candidate];
+    if ((replay.diverged == 0) && (replay.n_slots != transaction->n_slots))
+        Report("Different length");
+    if (replay.aligned == 0)
+    {
+        replay.skipped_at_start = replay.candidate - replay.position;
+        replay.aligned = 1;
+        replay.offset_us = (int64_t)Host_GetUs() - (int64_t)transaction->time_us;
+    }
+    else if ((size_t)replay.candidate > replay.position)
+    {
+        char what[64];
+        snprintf(what, sizeof(what), "%zu recorded transactions missing before", replay.candidate - replay.position);
+        replay.missing += replay.candidate - replay.position;
+        Report(what);
+    }
+    replay.matched++;
+    replay.recorded_bus_us += transaction->bus_us;
+    replay.position = replay.candidate + 1;
+}
+
+// ===========================================================
+//                      BUS MODEL
+// ===========================================================
+
+static void ReplayDrive(void* context, uint32 pin, int low, uint64_t time_us)
+{
+    (void)context;
+    (void)pin;
+    if (low)
+    {
+        if (replay.pending_one)
+        {
+            // Short pulse not sampled: write 1
+            replay.pending_one = 0;
+            AddSlot(0, 1);
+        }
+        replay.low = 1;
+        replay.low_start_us = time_us;
+        return;
+    }
+    if (replay.low == 0)
+        return;
+    replay.low = 0;
+    uint64_t low_us = time_us - replay.low_start_us;
+    if (low_us >= RESET_MIN_US)
+    {
+        EndTransaction();
+        BeginTransaction(time_us);
+        // Follow the idle time of the recording
+        if (replay.aligned && (replay.candidate >= 0))
+        {
+            int64_t start_us = (int64_t)replay.recorded[replay.candidate].time_us + replay.offset_us;
+            if (start_us > (int64_t)time_us)
+                Host_AdvanceUs(start_us - time_us);
+            replay.release_us = Host_GetUs();
+        }
+    }
+    else if (replay.active == 0)
+    {
+        // Slots before the first reset are ignored
+    }
+    else if (low_us >= WRITE_0_MIN_US)
+    {
+        AddSlot(0, 0);
+    }
+    else
+    {
+        replay.pending_one = 1;
+    }
+}
+
+static int ReplaySample(void* context, uint32 pin, uint64_t time_us)
+{
+    (void)context;
+    (void)pin;
+    if (replay.low)
+        return 0;
+    if (replay.active && (replay.n_slots == 0) && (replay.pending_one == 0))
+    {
+        if (time_us - replay.release_us > PRESENCE_WINDOW_US)
+            return 1;
+        if (replay.candidate < 0)
+            return 1;
+        return replay.recorded[replay.candidate].presence ? 0 : 1;
+    }
+    if (replay.pending_one == 0)
+        return 1;
+
+    // Read slot: answer with the recorded bit
+    replay.pending_one = 0;
+    if ((replay.candidate >= 0) && (replay.reads == 0) && (replay.diverged == 0) &&
+        !MatchesPrefix(&replay.recorded[replay.candidate]))
+        Resync();
+    uint8_t value = 1;
+    size_t n = replay.n_slots;
+    if ((replay.candidate >= 0) && (replay.diverged == 0))
+    {
+        const Transaction* transaction = &replay.recorded[replay.candidate];
+        if ((n < transaction->n_slots) && (MasterLevel(&transaction->slots[n]) == 1))
+            value = transaction->slots[n].read ? transaction->slots[n].value : 1;
+    }
+    replay.reads = 1;
+    AddSlot(1, value);
+    return value;
+}
+
+int main(int argc, char** argv)
+{
+    int profile = -1;
+    int option;
+
+    replay.max_reports = 20;
+    while ((option = getopt(argc, argv, "p:n:")) != -1)
+    {
+        switch (option)
+        {
+            case 'p': profile = atoi(optarg); break;
+            case 'n': replay.max_reports = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-p profile] [-n max_reports] trace\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-p profile] [-n max_reports] trace\n", argv[0]);
+        return 2;
+    }
+
+    Trace trace;
+    if (Trace_Load(argv[optind], &trace) != 0)
+        return 1;
+    size_t dropped = BuildTransactions(&trace);
+    if (replay.n_recorded == 0)
+    {
+        fprintf(stderr, "%s: no transaction in the trace\n", argv[optind]);
+        return 1;
+    }
+
+    // Start the library without the bus model, then select the timing:
+    // by default the one of the recording, so that bus times compare
+    DS2438_Start();
+    if ((profile < 0) || (profile == ONEWIRE_PROFILE_CUSTOM))
+    {
+        OneWire_Timing timing;
+        const uint16_t* t = trace.records[0].timing;
+        timing = (OneWire_Timing){t[TA], t[TB], t[TC], t[TD], t[TE], t[TF], t[TG], t[TH], t[TI], t[TJ]};
+        OneWire_SetCustomTiming(&timing);
+        profile = ONEWIRE_PROFILE_CUSTOM;
+    }
+    if (OneWire_AttachProfile(DS2438_Pin_0, profile) != 0)
+    {
+        fprintf(stderr, "invalid profile %d\n", profile);
+        return 2;
+    }
+    // Started before the recording, as in main.c
+    DS2438_PresenceStart(DS2438_Pin_0, 0, MAIN_PRESENCE_LATENCY_MS, MAIN_PRESENCE_BUDGET_PERMILLE, NULL, NULL);
+    Host_Bus bus = {ReplayDrive, ReplaySample, NULL};
+    Host_SetBus(&bus);
+
+    uint64_t start_us = Host_GetUs();
+    uint64_t start_delay_us = Host_GetDelayUs();
+    size_t stalled = 0;
+    while ((replay.position < replay.n_recorded) && (stalled < 3))
+    {
+        size_t position = replay.position;
+        uint64_t cycle_us = Host_GetUs();
+        MainCycle_Run();
+        EndTransaction();
+        // The watcher is polled at every iteration of the main loop, so it
+        // issues its resets in the idle time
+        uint64_t next_us = cycle_us + 1000ull * MAIN_CYCLE_PERIOD_MS;
+        for (;;)
+        {
+            DS2438_PresencePoll();
+            EndTransaction();
+            if (Host_GetUs() >= next_us)
+                break;
+            uint64_t idle_us = next_us - Host_GetUs();
+            Host_AdvanceUs((idle_us < MAIN_LOOP_US) ? idle_us : MAIN_LOOP_US);
+        }
+        stalled = (replay.position == position) ? stalled + 1 : 0;
+    }
+    if (replay.position < replay.n_recorded)
+    {
+        replay.missing += replay.n_recorded - replay.position;
+        printf("Replay stopped: %zu recorded transactions left\n", replay.n_recorded - replay.position);
+        replay.divergences++;
+    }
+
+    uint64_t build_bus_us = Host_GetDelayUs() - start_delay_us;
+    printf("recorded_transactions=%zu\n", replay.n_recorded);
+    printf("partial_operations_dropped=%zu\n", dropped);
+    printf("skipped_at_start=%zu\n", replay.skipped_at_start);
+    printf("matched=%zu\n", replay.matched);
+    printf("missing=%zu\n", replay.missing);
+    printf("extra=%zu\n", replay.extra);
+    printf("divergences=%zu\n", replay.divergences);
+    printf("resets_recorded=%zu\n", replay.matched + replay.missing);
+    printf("resets_build=%zu\n", replay.resets);
+    printf("bus_time_recorded_us=%llu\n", (unsigned long long)replay.recorded_bus_us);
+    printf("bus_time_build_us=%llu\n", (unsigned long long)build_bus_us);
+    printf("replay_time_ms=%llu\n", (unsigned long long)((Host_GetUs() - start_us) / 1000));
+    return (replay.divergences == 0) ? 0 : 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,573 @@
+/********************************************
+*
+*   \brief Converter of 1-Wire traces to VCD and sigrok files.
+*
+*   Reads a trace recorded with ONEWIRE_TRACE (binary, or
+*   the "TRACE" lines of the UART log) and writes:
+*   - a listing of the bus operations, with decoded DS2438
+*     commands and the operations that took longer than
+*     their nominal duration (default);
+*   - a VCD file with the DQ line, the bytes and the
+*     decoded commands (-v), the latter as a string
+*     variable as supported by GTKWave;
+*   - a sigrok session file with the DQ line (-s), which
+*     can be decoded in PulseView with the 1-Wire decoders.
+*
+*   The line is rebuilt from the timing of the bus: only
+*   the start and duration of each operation are recorded,
+*   so the time in excess of the nominal duration of a
+*   byte is shown after its last slot. Presence pulses and
+*   read 0 slots use typical device timings.
+*
+*   Build: gcc -O2 -Wall -o onewire_trace onewire_trace.c
+*   Usage: onewire_trace [-t us] [-v out.vcd] [-s out.sr] [-g us] trace
+*
+**********************************************/
+
+#include "onewire_trace.h"
+#include <unistd.h>
+
+// Typical device timings, in us
+#define PRESENCE_DELAY_US   30      // From release to presence pulse
+#define PRESENCE_WIDTH_US   120     // Presence pulse
+#define READ_HOLD_US        6       // Read 0 held after the master sample
+
+// Decoder state, restarted by every reset
+enum {
+    DECODE_ROM,         // ROM command expected
+    DECODE_READ_ROM,    // ROM bytes read
+    DECODE_MATCH_ROM,   // ROM bytes written
+    DECODE_FUNCTION,    // Function command expected
+    DECODE_PAGE,        // Page number expected
+    DECODE_READ_DATA,   // Scratchpad bytes read
+    DECODE_WRITE_DATA,  // Scratchpad bytes written
+    DECODE_BUSY,        // Conversion or copy in progress
+    DECODE_UNKNOWN      // Unknown command
+};
+
+typedef struct {
+    int state;
+    int count;
+    uint8_t command;
+    uint8_t page;
+    uint8_t data[9];
+} Decoder;
+
+typedef struct {
+    uint64_t start_us;
+    uint64_t end_us;
+} Interval;
+
+typedef struct {
+    Interval* lows;
+    size_t count;
+    size_t capacity;
+} Line;
+
+static uint8_t Crc8(const uint8_t* data, int length)
+{
+    uint8_t crc = 0;
+    for (int i = 0; i < length; i++)
+    {
+        uint8_t byte = data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+static const char* FunctionName(uint8_t command)
+{
+    switch (command)
+    {
+        case 0x44: return "CONVERT T";
+        case 0xB4: return "CONVERT V";
+        case 0xB8: return "RECALL MEMORY";
+        case 0xBE: return "READ SCRATCHPAD";
+        case 0x4E: return "WRITE SCRATCHPAD";
+        case 0x48: return "COPY SCRATCHPAD";
+    }
+    return NULL;
+}
+
+// Annotate a record with the DS2438 transaction it belongs to
+static void Decode(Decoder* decoder, const Trace_Record* record, char* text, size_t size)
+{
+    text[0] = 0;
+    if (record->type == TRACE_RESET)
+    {
+        decoder->state = DECODE_ROM;
+        decoder->count = 0;
+        snprintf(text, size, record->value ? "presence" : "no presence");
+        return;
+    }
+    if ((record->type == TRACE_WRITE_BIT) || (record->type == TRACE_READ_BIT))
+    {
+        if (decoder->state == DECODE_BUSY)
+            snprintf(text, size, record->value ? "done" : "busy");
+        return;
+    }
+    uint8_t byte = (record->type == TRACE_WRITE) ? record->data[0] :
+                   (record->type == TRACE_READ) ? record->data[0] : record->data[1];
+    switch (decoder->state)
+    {
+        case DECODE_ROM:
+            decoder->count = 0;
+            if (byte == 0x33)
+                decoder->state = DECODE_READ_ROM;
+            else if (byte == 0x55)
+                decoder->state = DECODE_MATCH_ROM;
+            else if (byte == 0xCC)
+                decoder->state = DECODE_FUNCTION;
+            else
+                decoder->state = DECODE_UNKNOWN;
+            snprintf(text, size, "%s", (byte == 0x33) ? "READ ROM" : (byte == 0x55) ? "MATCH ROM" :
+                     (byte == 0xCC) ? "SKIP ROM" : (byte == 0xF0) ? "SEARCH ROM" : "unknown ROM command");
+            break;
+
+        case DECODE_READ_ROM:
+        case DECODE_MATCH_ROM:
+            decoder->data[decoder->count] = byte;
+            if (decoder->count == 0)
+                snprintf(text, size, "family 0x%02X", byte);
+            else if (decoder->count < 7)
+                snprintf(text, size, "serial[%d]", decoder->count - 1);
+            else
+                snprintf(text, size, "ROM CRC %s", (Crc8(decoder->data, 7) == byte) ? "ok" : "FAIL");
+            if (++decoder->count == 8)
+                decoder->state = (decoder->state == DECODE_MATCH_ROM) ? DECODE_FUNCTION : DECODE_UNKNOWN;
+            break;
+
+        case DECODE_FUNCTION:
+            decoder->command = byte;
+            decoder->count = 0;
+            if (FunctionName(byte) == NULL)
+            {
+                snprintf(text, size, "unknown function 0x%02X", byte);
+                decoder->state = DECODE_UNKNOWN;
+            }
+            else
+            {
+                snprintf(text, size, "%s", FunctionName(byte));
+                decoder->state = ((byte == 0x44) || (byte == 0xB4)) ? DECODE_BUSY : DECODE_PAGE;
+            }
+            break;
+
+        case DECODE_PAGE:
+            decoder->page = byte;
+            snprintf(text, size, "page %d", byte);
+            if (decoder->command == 0xBE)
+                decoder->state = DECODE_READ_DATA;
+            else if (decoder->command == 0x4E)
+                decoder->state = DECODE_WRITE_DATA;
+            else if (decoder->command == 0x48)
+                decoder->state = DECODE_BUSY;
+            else
+                decoder->state = DECODE_UNKNOWN;
+            break;
+
+        case DECODE_READ_DATA:
+        case DECODE_WRITE_DATA:
+            if (decoder->count < 8)
+            {
+                decoder->data[decoder->count] = byte;
+                snprintf(text, size, "page %d byte %d", decoder->page, decoder->count);
+            }
+            else if ((decoder->count == 8) && (decoder->state == DECODE_READ_DATA))
+            {
+                snprintf(text, size, "page CRC %s", (Crc8(decoder->data, 8) == byte) ? "ok" : "FAIL");
+            }
+            decoder->count++;
+            break;
+
+        case DECODE_BUSY:
+            snprintf(text, size, (byte == 0xFF) ? "done" : "busy");
+            break;
+    }
+}
+
+static const char* OperationName(const Trace_Record* record, char* text, size_t size)
+{
+    switch (record->type)
+    {
+        case TRACE_RESET:       snprintf(text, size, "RESET"); break;
+        case TRACE_WRITE:       snprintf(text, size, "W %02X", record->data[0]); break;
+        case TRACE_READ:        snprintf(text, size, "R %02X", record->data[0]); break;
+        case TRACE_TOUCH:       snprintf(text, size, "T %02X>%02X", record->data[0], record->data[1]); break;
+        case TRACE_WRITE_BIT:   snprintf(text, size, "W bit %d", record->value); break;
+        case TRACE_READ_BIT:    snprintf(text, size, "R bit %d", record->value); break;
+        default:                snprintf(text, size, "?"); break;
+    }
+    return text;
+}
+
+// ===========================================================
+//                      LINE RECONSTRUCTION
+// ===========================================================
+
+static void LineLow(Line* line, uint64_t start_us, uint64_t end_us)
+{
+    if ((line->count > 0) && (start_us <= line->lows[line->count - 1].end_us))
+    {
+        // Overlaps the previous low interval
+        if (end_us > line->lows[line->count - 1].end_us)
+            line->lows[line->count - 1].end_us = end_us;
+        return;
+    }
+    if (line->count == line->capacity)
+    {
+        line->capacity = (line->capacity == 0) ? 4096 : 2 * line->capacity;
+        line->lows = realloc(line->lows, line->capacity * sizeof(Interval));
+        if (line->lows == NULL)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    line->lows[line->count].start_us = start_us;
+    line->lows[line->count].end_us = end_us;
+    line->count++;
+}
+
+// Slot starting at start_us: write (read == 0) or read slot, return its nominal length
+static uint32_t LineSlot(Line* line, const uint16_t* t, uint64_t start_us, int read, int bit)
+{
+    if (read)
+    {
+        LineLow(line, start_us, start_us + t[TA] + (bit ? 0 : t[TE] + READ_HOLD_US));
+        return t[TA] + t[TE] + t[TF];
+    }
+    LineLow(line, start_us, start_us + (bit ? t[TA] : t[TC]));
+    return bit ? t[TA] + t[TB] : t[TC] + t[TD];
+}
+
+// Rebuild the DQ line. Idle gaps longer than max_gap_us (if not 0) are
+// shortened to max_gap_us, and start_us receives the start of every record.
+static void LineBuild(const Trace* trace, uint64_t max_gap_us, Line* line, uint64_t* start_us)
+{
+    uint64_t removed_us = 0, end_us = 0;
+    for (size_t n = 0; n < trace->count; n++)
+    {
+        const Trace_Record* record = &trace->records[n];
+        const uint16_t* t = record->timing;
+        uint64_t s = record->time_us - removed_us;
+        if ((max_gap_us > 0) && (n > 0) && (s > end_us + max_gap_us))
+        {
+            removed_us += s - end_us - max_gap_us;
+            s = end_us + max_gap_us;
+        }
+        start_us[n] = s;
+        end_us = s + record->duration_us;
+
+        switch (record->type)
+        {
+            case TRACE_RESET:
+            {
+                uint64_t release_us = s + t[TG] + t[TH];
+                LineLow(line, s + t[TG], release_us);
+                if (record->value)
+                    LineLow(line, release_us + PRESENCE_DELAY_US, release_us + PRESENCE_DELAY_US + PRESENCE_WIDTH_US);
+                break;
+            }
+            case TRACE_WRITE:
+            case TRACE_READ:
+            case TRACE_TOUCH:
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    int written = (record->data[0] >> bit) & 0x01;
+                    int read = (record->type == TRACE_READ) || ((record->type == TRACE_TOUCH) && written);
+                    int value = (record->type == TRACE_WRITE) ? written :
+                                (record->type == TRACE_READ) ? (record->data[0] >> bit) & 0x01 :
+                                (record->data[1] >> bit) & 0x01;
+                    s += LineSlot(line, t, s, read, value);
+                }
+                break;
+            case TRACE_WRITE_BIT:
+                LineSlot(line, t, s, 0, record->value);
+                break;
+            case TRACE_READ_BIT:
+                LineSlot(line, t, s, 1, record->value);
+                break;
+        }
+    }
+}
+
+// ===========================================================
+//                      OUTPUT
+// ===========================================================
+
+static void WriteListing(const Trace* trace, uint32_t threshold_us)
+{
+    Decoder decoder = {DECODE_UNKNOWN, 0, 0, 0, {0}};
+    uint32_t pin = 0;
+    size_t slow = 0;
+    char operation[32], annotation[64];
+
+    printf("%12s %7s %7s  %-10s %s\n", "time_us", "dur_us", "nom_us", "operation", "DS2438");
+    for (size_t n = 0; n < trace->count; n++)
+    {
+        const Trace_Record* record = &trace->records[n];
+        if ((n == 0) || (record->pin != pin))
+        {
+            const uint16_t* t = record->timing;
+            pin = record->pin;
+            printf("-- pin 0x%08X, timing A-J: %u %u %u %u %u %u %u %u %u %u\n", pin,
+                   t[TA], t[TB], t[TC], t[TD], t[TE], t[TF], t[TG], t[TH], t[TI], t[TJ]);
+        }
+        uint32_t nominal_us = Trace_NominalUs(record);
+        Decode(&decoder, record, annotation, sizeof(annotation));
+        printf("%12llu %7u %7u  %-10s %s", (unsigned long long)record->time_us, record->duration_us,
+               nominal_us, OperationName(record, operation, sizeof(operation)), annotation);
+        if (record->duration_us > nominal_us + threshold_us)
+        {
+            printf("  SLOW +%u us", record->duration_us - nominal_us);
+            slow++;
+        }
+        printf("\n");
+    }
+    printf("-- %zu operations, %zu slower than nominal + %u us\n", trace->count, slow, threshold_us);
+}
+
+static int WriteVcd(const Trace* trace, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    Line line = {NULL, 0, 0};
+    uint64_t* start_us = malloc((trace->count + 1) * sizeof(uint64_t));
+    LineBuild(trace, 0, &line, start_us);
+
+    fprintf(file, "$comment 1-Wire trace rebuilt from OneWire.c records $end\n");
+    fprintf(file, "$timescale 1us $end\n$scope module onewire $end\n");
+    fprintf(file, "$var wire 1 ! dq $end\n$var reg 8 \" byte $end\n$var string 1 # ds2438 $end\n");
+    fprintf(file, "$upscope $end\n$enddefinitions $end\n#0\n1!\n");
+
+    // Merge line edges and record starts in time order
+    Decoder decoder = {DECODE_UNKNOWN, 0, 0, 0, {0}};
+    size_t low = 0, record = 0;
+    int level_low = 0;
+    uint64_t time_us = 0;
+    char annotation[64];
+    for (;;)
+    {
+        uint64_t edge_us = UINT64_MAX, record_us = UINT64_MAX;
+        if (low < line.count)
+            edge_us = level_low ? line.lows[low].end_us : line.lows[low].start_us;
+        if (record < trace->count)
+            record_us = start_us[record];
+        if ((edge_us == UINT64_MAX) && (record_us == UINT64_MAX))
+            break;
+        if (record_us <= edge_us)
+        {
+            const Trace_Record* r = &trace->records[record++];
+            if (record_us != time_us)
+                fprintf(file, "#%llu\n", (unsigned long long)record_us);
+            time_us = record_us;
+            if ((r->type == TRACE_WRITE) || (r->type == TRACE_READ) || (r->type == TRACE_TOUCH))
+            {
+                uint8_t byte = (r->type == TRACE_TOUCH) ? r->data[1] : r->data[0];
+                fprintf(file, "b");
+                for (int bit = 7; bit >= 0; bit--)
+                    fputc('0' + ((byte >> bit) & 0x01), file);
+                fprintf(file, " \"\n");
+            }
+            Decode(&decoder, r, annotation, sizeof(annotation));
+            for (char* c = annotation; *c; c++)
+                if (*c == ' ')
+                    *c = '_';
+            fprintf(file, "s%s #\n", (annotation[0] != 0) ? annotation : "-");
+        }
+        else
+        {
+            if (edge_us != time_us)
+                fprintf(file, "#%llu\n", (unsigned long long)edge_us);
+            time_us = edge_us;
+            fprintf(file, "%c!\n", level_low ? '1' : '0');
+            if (level_low)
+                low++;
+            level_low = !level_low;
+        }
+    }
+    fclose(file);
+    free(line.lows);
+    free(start_us);
+    return 0;
+}
+
+// ZIP archive with stored (uncompressed) entries, as used by .sr files
+typedef struct {
+    FILE* file;
+    uint32_t offsets[3];
+    uint32_t crcs[3];
+    uint32_t sizes[3];
+    const char* names[3];
+    int count;
+} Zip;
+
+static uint32_t Crc32(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 0x01)));
+    }
+    return ~crc;
+}
+
+static void ZipPut(FILE* file, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        fputc((value >> (8 * i)) & 0xFF, file);
+}
+
+static void ZipAdd(Zip* zip, const char* name, const uint8_t* data, uint32_t size)
+{
+    int n = zip->count++;
+    zip->names[n] = name;
+    zip->offsets[n] = ftell(zip->file);
+    zip->crcs[n] = Crc32(data, size);
+    zip->sizes[n] = size;
+    ZipPut(zip->file, 0x04034B50, 4);
+    ZipPut(zip->file, 10, 2);               // Version needed
+    ZipPut(zip->file, 0, 2);                // Flags
+    ZipPut(zip->file, 0, 2);                // Stored
+    ZipPut(zip->file, 0x00210000, 4);       // Time and date: 1980-01-01
+    ZipPut(zip->file, zip->crcs[n], 4);
+    ZipPut(zip->file, size, 4);
+    ZipPut(zip->file, size, 4);
+    ZipPut(zip->file, strlen(name), 2);
+    ZipPut(zip->file, 0, 2);                // Extra field
+    fwrite(name, 1, strlen(name), zip->file);
+    fwrite(data, 1, size, zip->file);
+}
+
+static void ZipClose(Zip* zip)
+{
+    uint32_t directory = ftell(zip->file);
+    for (int n = 0; n < zip->count; n++)
+    {
+        ZipPut(zip->file, 0x02014B50, 4);
+        ZipPut(zip->file, 10, 2);           // Version made by
+        ZipPut(zip->file, 10, 2);           // Version needed
+        ZipPut(zip->file, 0, 2);            // Flags
+        ZipPut(zip->file, 0, 2);            // Stored
+        ZipPut(zip->file, 0x00210000, 4);   // Time and date: 1980-01-01
+        ZipPut(zip->file, zip->crcs[n], 4);
+        ZipPut(zip->file, zip->sizes[n], 4);
+        ZipPut(zip->file, zip->sizes[n], 4);
+        ZipPut(zip->file, strlen(zip->names[n]), 2);
+        ZipPut(zip->file, 0, 2);            // Extra field
+        ZipPut(zip->file, 0, 2);            // Comment
+        ZipPut(zip->file, 0, 2);            // Disk
+        ZipPut(zip->file, 0, 2);            // Internal attributes
+        ZipPut(zip->file, 0, 4);            // External attributes
+        ZipPut(zip->file, zip->offsets[n], 4);
+        fwrite(zip->names[n], 1, strlen(zip->names[n]), zip->file);
+    }
+    uint32_t end = ftell(zip->file);
+    ZipPut(zip->file, 0x06054B50, 4);
+    ZipPut(zip->file, 0, 2);
+    ZipPut(zip->file, 0, 2);
+    ZipPut(zip->file, zip->count, 2);
+    ZipPut(zip->file, zip->count, 2);
+    ZipPut(zip->file, end - directory, 4);
+    ZipPut(zip->file, directory, 4);
+    ZipPut(zip->file, 0, 2);
+    fclose(zip->file);
+}
+
+// sigrok session: one logic channel sampled at 1 MHz
+static int WriteSigrok(const Trace* trace, const char* path, uint64_t max_gap_us)
+{
+    Zip zip = {fopen(path, "wb"), {0}, {0}, {0}, {NULL}, 0};
+    if (zip.file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    Line line = {NULL, 0, 0};
+    uint64_t* start_us = malloc((trace->count + 1) * sizeof(uint64_t));
+    LineBuild(trace, max_gap_us, &line, start_us);
+
+    uint64_t samples = 1;
+    if (trace->count > 0)
+        samples = start_us[trace->count - 1] + trace->records[trace->count - 1].duration_us + 1;
+    if (samples > 0xFFFFFFFF)
+    {
+        fprintf(stderr, "%s: trace too long, use -g\n", path);
+        fclose(zip.file);
+        return -1;
+    }
+    uint8_t* logic = malloc(samples);
+    memset(logic, 0x01, samples);
+    for (size_t n = 0; n < line.count; n++)
+    {
+        uint64_t end_us = (line.lows[n].end_us < samples) ? line.lows[n].end_us : samples;
+        if (line.lows[n].start_us < end_us)
+            memset(&logic[line.lows[n].start_us], 0x00, end_us - line.lows[n].start_us);
+    }
+
+    const char* metadata = "[global]\nsigrok version=0.5.1\n\n[device 1]\ncapturefile=logic-1\n"
+                           "total probes=1\nsamplerate=1 MHz\ntotal analog=0\nprobe1=DQ\nunitsize=1\n";
+    ZipAdd(&zip, "version", (const uint8_t*)"2", 1);
+    ZipAdd(&zip, "metadata", (const uint8_t*)metadata, strlen(metadata));
+    ZipAdd(&zip, "logic-1-1", logic, samples);
+    ZipClose(&zip);
+    free(logic);
+    free(line.lows);
+    free(start_us);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* vcd_path = NULL;
+    const char* sigrok_path = NULL;
+    uint32_t threshold_us = 20;
+    uint64_t max_gap_us = 10000;
+    int option;
+
+    while ((option = getopt(argc, argv, "t:v:s:g:")) != -1)
+    {
+        switch (option)
+        {
+            case 't': threshold_us = strtoul(optarg, NULL, 0); break;
+            case 'v': vcd_path = optarg; break;
+            case 's': sigrok_path = optarg; break;
+            case 'g': max_gap_us = strtoull(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-t slow_us] [-v out.vcd] [-s out.sr] [-g max_gap_us] trace\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-t slow_us] [-v out.vcd] [-s out.sr] [-g max_gap_us] trace\n", argv[0]);
+        return 2;
+    }
+
+    Trace trace;
+    if (Trace_Load(argv[optind], &trace) != 0)
+        return 1;
+    if ((vcd_path == NULL) && (sigrok_path == NULL))
+        WriteListing(&trace, threshold_us);
+    if ((vcd_path != NULL) && (WriteVcd(&trace, vcd_path) != 0))
+        return 1;
+    if ((sigrok_path != NULL) && (WriteSigrok(&trace, sigrok_path, max_gap_us) != 0))
+        return 1;
+    free(trace.records);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,237 @@
+/**
+ * \file onewire_trace.h
+ * \brief Host-side parser of the 1-Wire traces recorded by OneWire.c.
+ *
+ * Traces are read either from a binary file holding the bytes returned
+ * by OneWire_TraceRead(), or from a UART log in which they were sent as
+ * "TRACE <hex>" lines; other lines of the log are ignored. Record types
+ * and layout must match the ONEWIRE_TRACE_* definitions of OneWire.h.
+ *
+ * Header-only, shared by the host tools in this folder.
+*/
+#ifndef __ONEWIRE_TRACE_TOOL_H__
+    #define __ONEWIRE_TRACE_TOOL_H__
+
+    #ifndef _GNU_SOURCE
+        #define _GNU_SOURCE     // memmem
+    #endif
+    #include <stdint.h>
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <string.h>
+
+    // Record types, as in OneWire.h
+    #define TRACE_RESET     0
+    #define TRACE_WRITE     1
+    #define TRACE_READ      2
+    #define TRACE_TOUCH     3
+    #define TRACE_WRITE_BIT 4
+    #define TRACE_READ_BIT  5
+    #define TRACE_PIN       6
+    #define TRACE_TIMING    7
+
+    // Index of the delays A to J in Trace_Record.timing
+    enum { TA, TB, TC, TD, TE, TF, TG, TH, TI, TJ };
+
+    /**
+    *   \brief Decoded trace record.
+    */
+    typedef struct {
+        uint64_t time_us;           ///< Start, from the first record of the trace
+        uint32_t duration_us;       ///< Measured duration
+        uint8_t type;               ///< Record type
+        uint8_t value;              ///< Presence or bit value
+        uint8_t data[2];            ///< Byte written or read; written and read for touch
+        uint32_t pin;               ///< Pin of the bus
+        uint16_t timing[10];        ///< Delays A to J of the bus
+    } Trace_Record;
+
+    /**
+    *   \brief Decoded trace.
+    */
+    typedef struct {
+        Trace_Record* records;      ///< Bus operations, without pin and timing records
+        size_t count;               ///< Number of records
+        size_t blocks;              ///< Number of "TRACE" lines, 0 for binary input
+    } Trace;
+
+    static const uint8_t trace_payload_length[8] = {0, 1, 1, 2, 0, 0, 4, 20};
+
+    // Delays used until the first timing record: standard speed
+    static const uint16_t trace_standard_timing[10] = {6, 64, 60, 6, 9, 55, 0, 480, 70, 410};
+
+    static inline int Trace_Varint(const uint8_t* bytes, size_t size, size_t* position, uint32_t* value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (*position >= size)
+                return -1;
+            uint8_t byte = bytes[(*position)++];
+            *value |= (uint32_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return 0;
+        }
+        return -1;
+    }
+
+    // Decode a block of records, appending bus operations to the trace
+    static inline int Trace_Decode(Trace* trace, const uint8_t* bytes, size_t size, size_t* capacity,
+                            uint64_t* time_us, uint32_t* pin, uint16_t* timing)
+    {
+        size_t position = 0;
+        while (position < size)
+        {
+            uint8_t header = bytes[position++];
+            uint32_t delta_us, duration_us;
+            uint8_t type = header & 0x0F;
+            if ((type > TRACE_TIMING) ||
+                (Trace_Varint(bytes, size, &position, &delta_us) != 0) ||
+                (Trace_Varint(bytes, size, &position, &duration_us) != 0) ||
+                (position + trace_payload_length[type] > size))
+                return -1;
+            const uint8_t* payload = &bytes[position];
+            position += trace_payload_length[type];
+            *time_us += delta_us;
+
+            if (type == TRACE_PIN)
+            {
+                *pin = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+                continue;
+            }
+            if (type == TRACE_TIMING)
+            {
+                for (int i = 0; i < 10; i++)
+                    timing[i] = payload[2 * i] | (payload[2 * i + 1] << 8);
+                continue;
+            }
+            if (trace->count == *capacity)
+            {
+                *capacity = (*capacity == 0) ? 1024 : 2 * *capacity;
+                trace->records = realloc(trace->records, *capacity * sizeof(Trace_Record));
+                if (trace->records == NULL)
+                    return -1;
+            }
+            Trace_Record* record = &trace->records[trace->count++];
+            record->time_us = *time_us;
+            record->duration_us = duration_us;
+            record->type = type;
+            record->value = header >> 4;
+            record->data[0] = (trace_payload_length[type] > 0) ? payload[0] : 0;
+            record->data[1] = (trace_payload_length[type] > 1) ? payload[1] : 0;
+            record->pin = *pin;
+            memcpy(record->timing, timing, sizeof(record->timing));
+        }
+        return 0;
+    }
+
+    static inline int Trace_HexDigit(char c)
+    {
+        if ((c >= '0') && (c <= '9')) return c - '0';
+        if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+        if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+        return -1;
+    }
+
+    /**
+    *   \brief Load a binary trace or a UART log.
+    *
+    *   Records of consecutive "TRACE" lines form a single timeline.
+    *   \return 0 on success, -1 on error (message printed to stderr).
+    */
+    static inline int Trace_Load(const char* path, Trace* trace)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            perror(path);
+            return -1;
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        uint8_t* bytes = malloc(size + 1);
+        if ((bytes == NULL) || (fread(bytes, 1, size, file) != (size_t)size))
+        {
+            fprintf(stderr, "%s: read error\n", path);
+            fclose(file);
+            free(bytes);
+            return -1;
+        }
+        fclose(file);
+        bytes[size] = 0;
+
+        size_t capacity = 0;
+        uint64_t time_us = 0;
+        uint32_t pin = 0;
+        uint16_t timing[10];
+        memcpy(timing, trace_standard_timing, sizeof(timing));
+        trace->records = NULL;
+        trace->count = 0;
+        trace->blocks = 0;
+
+        int result = 0;
+        char* text = memmem(bytes, size, "TRACE ", 6);
+        if (text == NULL)
+        {
+            result = Trace_Decode(trace, bytes, size, &capacity, &time_us, &pin, timing);
+        }
+        else
+        {
+            // Hex lines, decoded in place
+            for (char* line = (char*)bytes; (line != NULL) && (result == 0); )
+            {
+                char* end = strchr(line, '\n');
+                if (strncmp(line, "TRACE ", 6) == 0)
+                {
+                    size_t n = 0;
+                    const char* hex = line + 6;
+                    while ((Trace_HexDigit(hex[0]) >= 0) && (Trace_HexDigit(hex[1]) >= 0))
+                    {
+                        ((uint8_t*)line)[n++] = (Trace_HexDigit(hex[0]) << 4) | Trace_HexDigit(hex[1]);
+                        hex += 2;
+                    }
+                    result = Trace_Decode(trace, (uint8_t*)line, n, &capacity, &time_us, &pin, timing);
+                    trace->blocks++;
+                }
+                line = (end != NULL) ? end + 1 : NULL;
+            }
+        }
+        free(bytes);
+        if (result != 0)
+            fprintf(stderr, "%s: malformed trace after %zu records\n", path, trace->count);
+        return result;
+    }
+
+    /**
+    *   \brief Nominal duration of a record, from its timing.
+    */
+    static inline uint32_t Trace_NominalUs(const Trace_Record* record)
+    {
+        const uint16_t* t = record->timing;
+        uint32_t slot_1 = t[TA] + t[TB], slot_0 = t[TC] + t[TD], slot_read = t[TA] + t[TE] + t[TF];
+        uint32_t total = 0;
+        switch (record->type)
+        {
+            case TRACE_RESET:
+                return t[TG] + t[TH] + t[TI] + t[TJ];
+            case TRACE_WRITE:
+                for (int bit = 0; bit < 8; bit++)
+                    total += ((record->data[0] >> bit) & 0x01) ? slot_1 : slot_0;
+                return total;
+            case TRACE_READ:
+                return 8 * slot_read;
+            case TRACE_TOUCH:
+                for (int bit = 0; bit < 8; bit++)
+                    total += ((record->data[0] >> bit) & 0x01) ? slot_read : slot_0;
+                return total;
+            case TRACE_WRITE_BIT:
+                return record->value ? slot_1 : slot_0;
+            case TRACE_READ_BIT:
+                return slot_read;
+        }
+        return 0;
+    }
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,483 @@
+/********************************************
+*
+*   \brief Source code for the batch page decoder.
+*
+*   The SIMD kernels load the images of 4 pages
+*   (36 bytes) with three unaligned 16-byte loads,
+*   and gather the bytes of each field into one
+*   32-bit lane per image with byte shuffles; the
+*   AVX2 kernel does the same in each 128-bit lane.
+*
+*   The CRC is linear, and the initial value is 0,
+*   so the CRC of 8 bytes is the XOR of the CRCs of
+*   each byte at its position. The contribution of
+*   a byte is the XOR of the ones of its nibbles,
+*   which are looked up with byte shuffles. The CRC
+*   kernels transpose 4 groups of images, so that a
+*   register holds the bytes at one position of 16
+*   images, and each lookup serves all the lanes.
+*
+*   Conversions follow the DS2438_Get* functions:
+*   the current is divided in double precision, as
+*   the firmware does, then rounded to float. The
+*   voltage is divided in single precision, which
+*   gives the same result as the double division
+*   rounded to float (a double has more than twice
+*   the precision of a float).
+*
+*   Pages 1 and 7 are plain byte moves, bound by
+*   memory bandwidth: all kernels use the scalar code.
+*
+**********************************************/
+
+#include "page_decoder.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define PAGE_DECODER_X86 1
+    #include <immintrin.h>
+#else
+    #define PAGE_DECODER_X86 0
+#endif
+
+// CRC of 8 bytes with a single non-zero byte, for each position and value
+static uint8_t crc_tables[8][256];
+// Same, for the low and high nibble of each position
+static uint8_t crc_nibbles[8][2][16] __attribute__((aligned(16)));
+
+static int kernel = PAGE_DECODER_AUTO;
+
+static uint8_t PageDecoder_Crc8(const uint8_t* data, uint8_t length)
+{
+    uint8_t crc = 0;
+    for (uint8_t n = 0; n < length; n++)
+    {
+        uint8_t byte = data[n];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+// ===========================================================
+//                      SCALAR
+// ===========================================================
+
+static size_t PageDecoder_CheckCrcScalar(const uint8_t* images, size_t count, uint8_t* valid)
+{
+    size_t n_valid = 0;
+    for (size_t n = 0; n < count; n++)
+    {
+        const uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        uint8_t crc = crc_tables[0][image[0]] ^ crc_tables[1][image[1]] ^ crc_tables[2][image[2]] ^
+                      crc_tables[3][image[3]] ^ crc_tables[4][image[4]] ^ crc_tables[5][image[5]] ^
+                      crc_tables[6][image[6]] ^ crc_tables[7][image[7]];
+        valid[n] = (crc == image[8]);
+        n_valid += valid[n];
+    }
+    return n_valid;
+}
+
+static void PageDecoder_DecodePage0Scalar(const uint8_t* images, size_t count, double divisor,
+                                          float* temperature, float* voltage, float* current)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        const uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        temperature[n] = (((int16_t)image[2] << 8) | (image[1] >> 3)) * 0.03125;
+        voltage[n] = ((image[4] << 8) | image[3]) / 100.0;
+        int16_t curr_data;
+        if ((image[6] & 0x03) > 1)
+        {
+            uint16_t data = (image[6] << 8) | image[5];
+            curr_data = -(int16_t)((~data) & 0x3FF);
+        }
+        else
+        {
+            curr_data = (image[6] << 8) | image[5];
+        }
+        current[n] = curr_data / divisor;
+    }
+}
+
+// ===========================================================
+//                      SIMD
+// ===========================================================
+
+#if PAGE_DECODER_X86
+
+// Fields gathered into 32-bit lanes, one per image: offset in the image and length.
+// Bytes of the transposed fields are stored by position, then by image.
+#define FIELD_TV    0   // Bytes 1-4: temperature and voltage
+#define FIELD_CUR   1   // Bytes 5-6: current
+#define FIELD_LOW   2   // Bytes 0-3, transposed
+#define FIELD_HIGH  3   // Bytes 4-7, transposed
+#define FIELD_CRC   4   // Byte 8, transposed: CRC of the 4 images in the first lane
+#define N_FIELDS    5
+
+static const uint8_t field_offset[N_FIELDS] = {1, 5, 0, 4, 8};
+static const uint8_t field_length[N_FIELDS] = {4, 2, 4, 4, 1};
+static const uint8_t field_transposed[N_FIELDS] = {0, 0, 1, 1, 1};
+
+// Shuffle masks for the loads at bytes 0, 16 and 20 of a group of 4 images
+static int8_t field_masks[N_FIELDS][3][16] __attribute__((aligned(16)));
+
+static void PageDecoder_InitMasks(void)
+{
+    static const uint8_t load_offset[3] = {0, 16, 20};
+    memset(field_masks, 0x80, sizeof(field_masks));
+    for (uint8_t field = 0; field < N_FIELDS; field++)
+    {
+        for (uint8_t image = 0; image < 4; image++)
+        {
+            for (uint8_t byte = 0; byte < field_length[field]; byte++)
+            {
+                uint8_t source = image * PAGE_DECODER_IMAGE_SIZE + field_offset[field] + byte;
+                uint8_t load = (source < 16) ? 0 : (source < 32) ? 1 : 2;
+                uint8_t destination = field_transposed[field] ? (byte * 4 + image) : (image * 4 + byte);
+                field_masks[field][load][destination] = source - load_offset[load];
+            }
+        }
+    }
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i PageDecoder_Field128(__m128i r0, __m128i r1, __m128i r2, int field)
+{
+    return _mm_or_si128(_mm_or_si128(
+        _mm_shuffle_epi8(r0, _mm_load_si128((const __m128i*)field_masks[field][0])),
+        _mm_shuffle_epi8(r1, _mm_load_si128((const __m128i*)field_masks[field][1]))),
+        _mm_shuffle_epi8(r2, _mm_load_si128((const __m128i*)field_masks[field][2])));
+}
+
+// 4x4 transpose of 32-bit lanes: lane i of register j goes to lane j of register i
+__attribute__((target("ssse3")))
+static inline void PageDecoder_Transpose128(__m128i* r)
+{
+    __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+    __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+    __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+    r[0] = _mm_unpacklo_epi64(t0, t1);
+    r[1] = _mm_unpackhi_epi64(t0, t1);
+    r[2] = _mm_unpacklo_epi64(t2, t3);
+    r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+__attribute__((target("ssse3")))
+static size_t PageDecoder_CheckCrcSsse3(const uint8_t* images, size_t count, uint8_t* valid)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    size_t n_valid = 0, n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        // Bytes at each position, and CRC, of 16 images
+        __m128i positions[8], crcs[4];
+        for (int g = 0; g < 4; g++)
+        {
+            const uint8_t* group = &images[(n + 4 * g) * PAGE_DECODER_IMAGE_SIZE];
+            __m128i r0 = _mm_loadu_si128((const __m128i*)group);
+            __m128i r1 = _mm_loadu_si128((const __m128i*)(group + 16));
+            __m128i r2 = _mm_loadu_si128((const __m128i*)(group + 20));
+            positions[g] = PageDecoder_Field128(r0, r1, r2, FIELD_LOW);
+            positions[4 + g] = PageDecoder_Field128(r0, r1, r2, FIELD_HIGH);
+            crcs[g] = PageDecoder_Field128(r0, r1, r2, FIELD_CRC);
+        }
+        PageDecoder_Transpose128(&positions[0]);
+        PageDecoder_Transpose128(&positions[4]);
+        PageDecoder_Transpose128(crcs);
+
+        __m128i crc = _mm_setzero_si128();
+        for (int position = 0; position < 8; position++)
+        {
+            __m128i lo = _mm_and_si128(positions[position], nibble);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(positions[position], 4), nibble);
+            crc = _mm_xor_si128(crc, _mm_shuffle_epi8(_mm_load_si128((const __m128i*)crc_nibbles[position][0]), lo));
+            crc = _mm_xor_si128(crc, _mm_shuffle_epi8(_mm_load_si128((const __m128i*)crc_nibbles[position][1]), hi));
+        }
+        __m128i match = _mm_cmpeq_epi8(crc, crcs[0]);
+        _mm_storeu_si128((__m128i*)&valid[n], _mm_and_si128(match, _mm_set1_epi8(0x01)));
+        n_valid += __builtin_popcount(_mm_movemask_epi8(match));
+    }
+    return n_valid + PageDecoder_CheckCrcScalar(&images[n * PAGE_DECODER_IMAGE_SIZE], count - n, &valid[n]);
+}
+
+__attribute__((target("ssse3")))
+static void PageDecoder_DecodePage0Ssse3(const uint8_t* images, size_t count, double divisor,
+                                         float* temperature, float* voltage, float* current)
+{
+    const __m128d divisor_pd = _mm_set1_pd(divisor);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        const uint8_t* group = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        __m128i r0 = _mm_loadu_si128((const __m128i*)group);
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(group + 16));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(group + 20));
+        __m128i tv = PageDecoder_Field128(r0, r1, r2, FIELD_TV);
+        __m128i raw = PageDecoder_Field128(r0, r1, r2, FIELD_CUR);
+
+        // (msb << 8) | (lsb >> 3), times 1/32
+        __m128i t = _mm_or_si128(_mm_and_si128(tv, _mm_set1_epi32(0xFF00)),
+                                 _mm_srli_epi32(_mm_and_si128(tv, _mm_set1_epi32(0xF8)), 3));
+        _mm_storeu_ps(&temperature[n], _mm_mul_ps(_mm_cvtepi32_ps(t), _mm_set1_ps(0.03125f)));
+        _mm_storeu_ps(&voltage[n], _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(tv, 16)), _mm_set1_ps(100.0f)));
+
+        // Negative if bit 1 of the MSB is set: -(~data & 0x3FF), else the 16-bit value
+        __m128i negative = _mm_cmpeq_epi32(_mm_and_si128(raw, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x200));
+        __m128i magnitude = _mm_xor_si128(_mm_and_si128(raw, _mm_set1_epi32(0x3FF)), _mm_set1_epi32(0x3FF));
+        __m128i negated = _mm_sub_epi32(_mm_setzero_si128(), magnitude);
+        __m128i extended = _mm_srai_epi32(_mm_slli_epi32(raw, 16), 16);
+        __m128i c = _mm_or_si128(_mm_and_si128(negative, negated), _mm_andnot_si128(negative, extended));
+        __m128 c_low = _mm_cvtpd_ps(_mm_div_pd(_mm_cvtepi32_pd(c), divisor_pd));
+        __m128 c_high = _mm_cvtpd_ps(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(c, c)), divisor_pd));
+        _mm_storeu_ps(&current[n], _mm_movelh_ps(c_low, c_high));
+    }
+    PageDecoder_DecodePage0Scalar(&images[n * PAGE_DECODER_IMAGE_SIZE], count - n, divisor,
+                                  &temperature[n], &voltage[n], &current[n]);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i PageDecoder_Field256(__m256i r0, __m256i r1, __m256i r2, int field)
+{
+    return _mm256_or_si256(_mm256_or_si256(
+        _mm256_shuffle_epi8(r0, _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)field_masks[field][0]))),
+        _mm256_shuffle_epi8(r1, _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)field_masks[field][1])))),
+        _mm256_shuffle_epi8(r2, _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)field_masks[field][2]))));
+}
+
+// Loads of two groups of 4 images, one per 128-bit lane, the second one distance images after the first one
+__attribute__((target("avx2")))
+static inline __m256i PageDecoder_Load256(const uint8_t* group, int offset, int distance)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(group + offset))),
+        _mm_loadu_si128((const __m128i*)(group + distance * PAGE_DECODER_IMAGE_SIZE + offset)), 1);
+}
+
+__attribute__((target("avx2")))
+static inline void PageDecoder_Transpose256(__m256i* r)
+{
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t2 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    r[0] = _mm256_unpacklo_epi64(t0, t1);
+    r[1] = _mm256_unpackhi_epi64(t0, t1);
+    r[2] = _mm256_unpacklo_epi64(t2, t3);
+    r[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+// 16 images per 128-bit lane
+__attribute__((target("avx2")))
+static size_t PageDecoder_CheckCrcAvx2(const uint8_t* images, size_t count, uint8_t* valid)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i tables[8][2];
+    for (int position = 0; position < 8; position++)
+    {
+        tables[position][0] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)crc_nibbles[position][0]));
+        tables[position][1] = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)crc_nibbles[position][1]));
+    }
+    size_t n_valid = 0, n = 0;
+    for (; n + 32 <= count; n += 32)
+    {
+        __m256i positions[8], crcs[4];
+        for (int g = 0; g < 4; g++)
+        {
+            const uint8_t* group = &images[(n + 4 * g) * PAGE_DECODER_IMAGE_SIZE];
+            __m256i r0 = PageDecoder_Load256(group, 0, 16);
+            __m256i r1 = PageDecoder_Load256(group, 16, 16);
+            __m256i r2 = PageDecoder_Load256(group, 20, 16);
+            positions[g] = PageDecoder_Field256(r0, r1, r2, FIELD_LOW);
+            positions[4 + g] = PageDecoder_Field256(r0, r1, r2, FIELD_HIGH);
+            crcs[g] = PageDecoder_Field256(r0, r1, r2, FIELD_CRC);
+        }
+        PageDecoder_Transpose256(&positions[0]);
+        PageDecoder_Transpose256(&positions[4]);
+        PageDecoder_Transpose256(crcs);
+
+        __m256i crc = _mm256_setzero_si256();
+        for (int position = 0; position < 8; position++)
+        {
+            __m256i lo = _mm256_and_si256(positions[position], nibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(positions[position], 4), nibble);
+            crc = _mm256_xor_si256(crc, _mm256_shuffle_epi8(tables[position][0], lo));
+            crc = _mm256_xor_si256(crc, _mm256_shuffle_epi8(tables[position][1], hi));
+        }
+        __m256i match = _mm256_cmpeq_epi8(crc, crcs[0]);
+        _mm256_storeu_si256((__m256i*)&valid[n], _mm256_and_si256(match, _mm256_set1_epi8(0x01)));
+        n_valid += __builtin_popcount((uint32_t)_mm256_movemask_epi8(match));
+    }
+    return n_valid + PageDecoder_CheckCrcScalar(&images[n * PAGE_DECODER_IMAGE_SIZE], count - n, &valid[n]);
+}
+
+__attribute__((target("avx2")))
+static void PageDecoder_DecodePage0Avx2(const uint8_t* images, size_t count, double divisor,
+                                        float* temperature, float* voltage, float* current)
+{
+    const __m256d divisor_pd = _mm256_set1_pd(divisor);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        const uint8_t* group = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        __m256i r0 = PageDecoder_Load256(group, 0, 4);
+        __m256i r1 = PageDecoder_Load256(group, 16, 4);
+        __m256i r2 = PageDecoder_Load256(group, 20, 4);
+        __m256i tv = PageDecoder_Field256(r0, r1, r2, FIELD_TV);
+        __m256i raw = PageDecoder_Field256(r0, r1, r2, FIELD_CUR);
+
+        __m256i t = _mm256_or_si256(_mm256_and_si256(tv, _mm256_set1_epi32(0xFF00)),
+                                    _mm256_srli_epi32(_mm256_and_si256(tv, _mm256_set1_epi32(0xF8)), 3));
+        _mm256_storeu_ps(&temperature[n], _mm256_mul_ps(_mm256_cvtepi32_ps(t), _mm256_set1_ps(0.03125f)));
+        _mm256_storeu_ps(&voltage[n], _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(tv, 16)),
+                                                    _mm256_set1_ps(100.0f)));
+
+        __m256i negative = _mm256_cmpeq_epi32(_mm256_and_si256(raw, _mm256_set1_epi32(0x200)),
+                                              _mm256_set1_epi32(0x200));
+        __m256i magnitude = _mm256_xor_si256(_mm256_and_si256(raw, _mm256_set1_epi32(0x3FF)),
+                                             _mm256_set1_epi32(0x3FF));
+        __m256i c = _mm256_blendv_epi8(_mm256_srai_epi32(_mm256_slli_epi32(raw, 16), 16),
+                                       _mm256_sub_epi32(_mm256_setzero_si256(), magnitude), negative);
+        __m128 c_low = _mm256_cvtpd_ps(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(c)), divisor_pd));
+        __m128 c_high = _mm256_cvtpd_ps(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(c, 1)), divisor_pd));
+        _mm256_storeu_ps(&current[n], _mm256_set_m128(c_high, c_low));
+    }
+    PageDecoder_DecodePage0Scalar(&images[n * PAGE_DECODER_IMAGE_SIZE], count - n, divisor,
+                                  &temperature[n], &voltage[n], &current[n]);
+}
+
+#endif
+
+// ===========================================================
+//                      DISPATCH
+// ===========================================================
+
+static void PageDecoder_Init(void)
+{
+    if (kernel != PAGE_DECODER_AUTO)
+        return;
+    for (uint8_t position = 0; position < 8; position++)
+    {
+        for (int value = 0; value < 256; value++)
+        {
+            uint8_t data[8] = {0};
+            data[position] = value;
+            crc_tables[position][value] = PageDecoder_Crc8(data, 8);
+        }
+        for (uint8_t value = 0; value < 16; value++)
+        {
+            crc_nibbles[position][0][value] = crc_tables[position][value];
+            crc_nibbles[position][1][value] = crc_tables[position][value << 4];
+        }
+    }
+    kernel = PAGE_DECODER_SCALAR;
+#if PAGE_DECODER_X86
+    PageDecoder_InitMasks();
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernel = PAGE_DECODER_AVX2;
+    else if (__builtin_cpu_supports("ssse3"))
+        kernel = PAGE_DECODER_SSSE3;
+#endif
+}
+
+int PageDecoder_SetKernel(int selected)
+{
+    kernel = PAGE_DECODER_AUTO;
+    PageDecoder_Init();
+    switch (selected)
+    {
+        case PAGE_DECODER_AUTO:
+            return 0;
+        case PAGE_DECODER_SCALAR:
+            kernel = PAGE_DECODER_SCALAR;
+            return 0;
+#if PAGE_DECODER_X86
+        case PAGE_DECODER_SSSE3:
+            if (!__builtin_cpu_supports("ssse3"))
+                return -1;
+            kernel = PAGE_DECODER_SSSE3;
+            return 0;
+        case PAGE_DECODER_AVX2:
+            if (!__builtin_cpu_supports("avx2"))
+                return -1;
+            kernel = PAGE_DECODER_AVX2;
+            return 0;
+#endif
+    }
+    return -1;
+}
+
+int PageDecoder_GetKernel(void)
+{
+    PageDecoder_Init();
+    return kernel;
+}
+
+const char* PageDecoder_KernelName(int selected)
+{
+    static const char* const names[] = {"auto", "scalar", "ssse3", "avx2"};
+    return ((selected >= 0) && (selected <= PAGE_DECODER_AVX2)) ? names[selected] : "unknown";
+}
+
+size_t PageDecoder_CheckCrc(const uint8_t* images, size_t count, uint8_t* valid)
+{
+    PageDecoder_Init();
+#if PAGE_DECODER_X86
+    if (kernel == PAGE_DECODER_AVX2)
+        return PageDecoder_CheckCrcAvx2(images, count, valid);
+    if (kernel == PAGE_DECODER_SSSE3)
+        return PageDecoder_CheckCrcSsse3(images, count, valid);
+#endif
+    return PageDecoder_CheckCrcScalar(images, count, valid);
+}
+
+void PageDecoder_DecodePage0(const uint8_t* images, size_t count, double sense_resistor,
+                             float* temperature, float* voltage, float* current)
+{
+    double divisor = 4096. * sense_resistor;
+    PageDecoder_Init();
+#if PAGE_DECODER_X86
+    if (kernel == PAGE_DECODER_AVX2)
+    {
+        PageDecoder_DecodePage0Avx2(images, count, divisor, temperature, voltage, current);
+        return;
+    }
+    if (kernel == PAGE_DECODER_SSSE3)
+    {
+        PageDecoder_DecodePage0Ssse3(images, count, divisor, temperature, voltage, current);
+        return;
+    }
+#endif
+    PageDecoder_DecodePage0Scalar(images, count, divisor, temperature, voltage, current);
+}
+
+void PageDecoder_DecodePage1(const uint8_t* images, size_t count, uint32_t* etm, uint8_t* ica,
+                             uint16_t* offset)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        const uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        etm[n] = image[0] | (image[1] << 8) | (image[2] << 16) | ((uint32_t)image[3] << 24);
+        ica[n] = image[4];
+        offset[n] = (image[6] << 8) | image[5];
+    }
+}
+
+void PageDecoder_DecodePage7(const uint8_t* images, size_t count, uint16_t* cca, uint16_t* dca)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        const uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        cca[n] = (image[5] << 8) | image[4];
+        dca[n] = (image[7] << 8) | image[6];
+    }
+}
+
+/* [] END OF FILE */
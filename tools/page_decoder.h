@@ -0,0 +1,116 @@
+/**
+ * \file page_decoder.h
+ * \brief Batch decoder of recorded DS2438 page images.
+ *
+ * Page images are the 9 bytes returned by a page read, 8 data bytes and
+ * the CRC, stored back to back. The functions of this module decode arrays
+ * of images into one array per field (structure of arrays), with the same
+ * conversions and the same floating-point results as the DS2438_Get*
+ * functions of the library, and check the CRC of many images at once.
+ *
+ * Each function has a scalar implementation and, on x86, SSSE3 and AVX2
+ * kernels processing 4 and 8 images per step (16 and 32 for the CRC
+ * check). The fastest kernel supported by the CPU is selected at the
+ * first call, unless one is forced with #PageDecoder_SetKernel(). All
+ * kernels give bit-exact results.
+*/
+#ifndef __PAGE_DECODER_H__
+    #define __PAGE_DECODER_H__
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    #ifdef __cplusplus
+    extern "C" {
+    #endif
+
+    /**
+    *   \brief Size of a page image, in bytes.
+    */
+    #define PAGE_DECODER_IMAGE_SIZE     9
+
+    // ===========================================================
+    //                      KERNELS
+    // ===========================================================
+
+    #define PAGE_DECODER_AUTO       0   ///< Fastest kernel supported by the CPU
+    #define PAGE_DECODER_SCALAR     1   ///< Portable C
+    #define PAGE_DECODER_SSSE3      2   ///< SSSE3, 4 images per step, 16 for the CRC
+    #define PAGE_DECODER_AVX2       3   ///< AVX2, 8 images per step, 32 for the CRC
+
+    /**
+    *   \brief Force a kernel.
+    *
+    *   \param kernel one of the PAGE_DECODER_* kernels.
+    *   \return 0 on success, -1 if the kernel is not supported by the CPU or the build.
+    */
+    int PageDecoder_SetKernel(int kernel);
+
+    /**
+    *   \brief Get the kernel in use, never #PAGE_DECODER_AUTO.
+    */
+    int PageDecoder_GetKernel(void);
+
+    /**
+    *   \brief Get the name of a kernel.
+    */
+    const char* PageDecoder_KernelName(int kernel);
+
+    // ===========================================================
+    //                      DECODING
+    // ===========================================================
+
+    /**
+    *   \brief Check the CRC of page images.
+    *
+    *   \param images page images.
+    *   \param count number of images.
+    *   \param valid array where 1 (CRC match) or 0 is stored for each image.
+    *   \return the number of images with a valid CRC.
+    */
+    size_t PageDecoder_CheckCrc(const uint8_t* images, size_t count, uint8_t* valid);
+
+    /**
+    *   \brief Decode images of page 0.
+    *
+    *   Results are the ones of DS2438_GetTemperatureData(),
+    *   DS2438_GetVoltageData() and DS2438_GetCurrentData().
+    *   \param images page images.
+    *   \param count number of images.
+    *   \param sense_resistor sense resistor, in ohm, as #DS2438_SENSE_RESISTOR.
+    *   \param temperature array where the temperatures will be stored, in degree Celsius.
+    *   \param voltage array where the voltages will be stored, in V.
+    *   \param current array where the currents will be stored, in A.
+    */
+    void PageDecoder_DecodePage0(const uint8_t* images, size_t count, double sense_resistor,
+                                 float* temperature, float* voltage, float* current);
+
+    /**
+    *   \brief Decode images of page 1.
+    *
+    *   \param images page images.
+    *   \param count number of images.
+    *   \param etm array where the elapsed time meters will be stored, in s.
+    *   \param ica array where the ICA registers will be stored.
+    *   \param offset array where the offset registers will be stored, as by DS2438_ReadOffset().
+    */
+    void PageDecoder_DecodePage1(const uint8_t* images, size_t count, uint32_t* etm, uint8_t* ica,
+                                 uint16_t* offset);
+
+    /**
+    *   \brief Decode images of page 7.
+    *
+    *   Results are the ones of DS2438_DecodeCCA() and DS2438_DecodeDCA().
+    *   \param images page images.
+    *   \param count number of images.
+    *   \param cca array where the CCA registers will be stored.
+    *   \param dca array where the DCA registers will be stored.
+    */
+    void PageDecoder_DecodePage7(const uint8_t* images, size_t count, uint16_t* cca, uint16_t* dca);
+
+    #ifdef __cplusplus
+    }
+    #endif
+
+#endif
+/* [] END OF FILE */
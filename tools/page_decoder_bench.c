@@ -0,0 +1,312 @@
+/********************************************
+*
+*   \brief Verification and benchmark of the batch page decoder.
+*
+*   Verification runs the DS2438 Library on the host
+*   platform against a simulated device, and compares
+*   the results of every kernel bit for bit with the
+*   ones of the firmware functions, for all the 65536
+*   values of each page 0 field and random pages 1
+*   and 7; CRC results are compared with
+*   DS2438_CheckCrcValue() on random, partly corrupted
+*   images.
+*
+*   The benchmark decodes and checks a large array of
+*   random images with each kernel supported by the
+*   CPU, and reports the throughput in GB/s of images.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o page_decoder_bench tools/page_decoder_bench.c
+*       tools/page_decoder.c tools/host/host_platform.c tools/host/ds2438_model.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c DS2438.cydsn/DS2438_Accumulators.c DS2438.cydsn/DS2438_History.c
+*       DS2438.cydsn/DS2438_Storage.c
+*   Usage: page_decoder_bench [-n images] [-r repeats]
+*
+**********************************************/
+
+#include "page_decoder.h"
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "DS2438_History.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define N_KERNELS   4
+
+static uint32_t seed = 12345;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// ===========================================================
+//                      VERIFICATION
+// ===========================================================
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+
+// Put a page in the simulated device, and read it through the library
+static void LoadPage(uint8_t page_number, const uint8_t* page_data, uint8_t* image)
+{
+    memcpy(model.memory[page_number], page_data, 8);
+    // Pages are read again once the cache entries are older than 1 s
+    Host_AdvanceUs(1000000);
+    if (DS2438_ReadPage(page_number, image) != DS2438_OK)
+    {
+        fprintf(stderr, "page %d not read\n", page_number);
+        exit(1);
+    }
+}
+
+static int CompareFloats(const char* what, const float* expected, const float* decoded, size_t count, int kernel)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        if (memcmp(&expected[n], &decoded[n], sizeof(float)) != 0)
+        {
+            printf("%s: %s mismatch at %zu: firmware %.9g, decoder %.9g\n", PageDecoder_KernelName(kernel),
+                   what, n, expected[n], decoded[n]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int VerifyPage0(void)
+{
+    const size_t count = 65536;
+    uint8_t* images = malloc(count * PAGE_DECODER_IMAGE_SIZE);
+    float* expected = malloc(3 * count * sizeof(float));
+    float* decoded = malloc(3 * count * sizeof(float));
+    int failures = 0;
+
+    // Current register is left to the page content
+    for (size_t n = 0; n < count; n++)
+    {
+        uint8_t lsb = n & 0xFF, msb = n >> 8;
+        uint8_t page_data[8] = {0x08, lsb, msb, lsb, msb, lsb, msb, 0x00};
+        uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        LoadPage(0, page_data, image);
+        if ((DS2438_GetTemperatureData(&expected[n]) != DS2438_OK) ||
+            (DS2438_GetVoltageData(&expected[count + n]) != DS2438_OK) ||
+            (DS2438_GetCurrentData(&expected[2 * count + n]) != DS2438_OK))
+        {
+            fprintf(stderr, "page 0 measurement not read\n");
+            exit(1);
+        }
+    }
+    for (int kernel = PAGE_DECODER_SCALAR; kernel < N_KERNELS; kernel++)
+    {
+        if (PageDecoder_SetKernel(kernel) != 0)
+            continue;
+        // Odd count, to check the tail of the SIMD loops
+        PageDecoder_DecodePage0(images, count - 3, DS2438_SENSE_RESISTOR, decoded, &decoded[count], &decoded[2 * count]);
+        PageDecoder_DecodePage0(&images[(count - 3) * PAGE_DECODER_IMAGE_SIZE], 3, DS2438_SENSE_RESISTOR,
+                                &decoded[count - 3], &decoded[2 * count - 3], &decoded[3 * count - 3]);
+        failures += CompareFloats("temperature", expected, decoded, count, kernel);
+        failures += CompareFloats("voltage", &expected[count], &decoded[count], count, kernel);
+        failures += CompareFloats("current", &expected[2 * count], &decoded[2 * count], count, kernel);
+        printf("page 0, %s: %zu images of each field, %s\n", PageDecoder_KernelName(kernel), count,
+               failures ? "FAILED" : "bit-exact");
+    }
+    free(images);
+    free(expected);
+    free(decoded);
+    return failures;
+}
+
+static int VerifyPages1And7(void)
+{
+    const size_t count = 4096;
+    uint8_t images[2][4096 * PAGE_DECODER_IMAGE_SIZE];
+    uint8_t ica[4096];
+    uint16_t offset[4096], cca[4096], dca[4096];
+    uint32_t etm[4096];
+    int failures = 0;
+
+    // CCA and DCA are not updated by the device
+    model.memory[0][0] &= ~0x03;
+    for (size_t n = 0; n < count; n++)
+    {
+        uint8_t page_data[8];
+        for (int i = 0; i < 8; i++)
+            page_data[i] = Random();
+        model.ica = page_data[4];
+        LoadPage(1, page_data, &images[0][n * PAGE_DECODER_IMAGE_SIZE]);
+        for (int i = 0; i < 8; i++)
+            page_data[i] = Random();
+        LoadPage(7, page_data, &images[1][n * PAGE_DECODER_IMAGE_SIZE]);
+    }
+    for (int kernel = PAGE_DECODER_SCALAR; kernel < N_KERNELS; kernel++)
+    {
+        if (PageDecoder_SetKernel(kernel) != 0)
+            continue;
+        PageDecoder_DecodePage1(images[0], count, etm, ica, offset);
+        PageDecoder_DecodePage7(images[1], count, cca, dca);
+        for (size_t n = 0; n < count; n++)
+        {
+            const uint8_t* page_1 = &images[0][n * PAGE_DECODER_IMAGE_SIZE];
+            const uint8_t* page_7 = &images[1][n * PAGE_DECODER_IMAGE_SIZE];
+            uint32_t expected_etm = page_1[0] | (page_1[1] << 8) | (page_1[2] << 16) | ((uint32_t)page_1[3] << 24);
+            uint16_t expected_offset;
+            uint8_t expected_ica;
+            model.ica = page_1[4];
+            model.memory[1][5] = page_1[5];
+            model.memory[1][6] = page_1[6];
+            Host_AdvanceUs(1000000);
+            if ((DS2438_GetICA(&expected_ica) != DS2438_OK) || (DS2438_ReadOffset(&expected_offset) != DS2438_OK) ||
+                (etm[n] != expected_etm) || (ica[n] != expected_ica) || (offset[n] != expected_offset) ||
+                (cca[n] != DS2438_DecodeCCA(page_7)) || (dca[n] != DS2438_DecodeDCA(page_7)))
+            {
+                printf("%s: page 1 or 7 mismatch at %zu\n", PageDecoder_KernelName(kernel), n);
+                failures++;
+                break;
+            }
+        }
+    }
+    printf("pages 1 and 7: %zu images, %s\n", count, failures ? "FAILED" : "bit-exact");
+    return failures;
+}
+
+static int VerifyCrc(void)
+{
+    const size_t count = 100003;
+    uint8_t* images = malloc(count * PAGE_DECODER_IMAGE_SIZE);
+    uint8_t* valid = malloc(count);
+    int failures = 0;
+
+    for (size_t n = 0; n < count; n++)
+    {
+        uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+        for (int i = 0; i < 8; i++)
+            image[i] = Random();
+        image[8] = 0;
+        for (uint8_t crc = 0; DS2438_CheckCrcValue(image, 8, crc) != DS2438_OK; crc++)
+            image[8] = crc + 1;
+        // One image out of four has a flipped bit
+        if ((Random() & 0x03) == 0)
+            image[Random() % 9] ^= 1 << (Random() % 8);
+    }
+    for (int kernel = PAGE_DECODER_SCALAR; kernel < N_KERNELS; kernel++)
+    {
+        if (PageDecoder_SetKernel(kernel) != 0)
+            continue;
+        size_t n_valid = PageDecoder_CheckCrc(images, count, valid);
+        size_t expected_valid = 0;
+        for (size_t n = 0; n < count; n++)
+        {
+            uint8_t* image = &images[n * PAGE_DECODER_IMAGE_SIZE];
+            uint8_t expected = (DS2438_CheckCrcValue(image, 8, image[8]) == DS2438_OK);
+            expected_valid += expected;
+            if (valid[n] != expected)
+            {
+                printf("%s: CRC mismatch at %zu\n", PageDecoder_KernelName(kernel), n);
+                failures++;
+                break;
+            }
+        }
+        if (n_valid != expected_valid)
+            failures++;
+        printf("CRC, %s: %zu images, %zu valid, %s\n", PageDecoder_KernelName(kernel), count, n_valid,
+               failures ? "FAILED" : "bit-exact");
+    }
+    free(images);
+    free(valid);
+    return failures;
+}
+
+// ===========================================================
+//                      BENCHMARK
+// ===========================================================
+
+static void Benchmark(size_t count, int repeats)
+{
+    uint8_t* images = malloc(count * PAGE_DECODER_IMAGE_SIZE);
+    uint8_t* valid = malloc(count);
+    float* temperature = malloc(count * sizeof(float));
+    float* voltage = malloc(count * sizeof(float));
+    float* current = malloc(count * sizeof(float));
+    for (size_t n = 0; n < count * PAGE_DECODER_IMAGE_SIZE; n++)
+        images[n] = Random();
+    double bytes = (double)count * PAGE_DECODER_IMAGE_SIZE * repeats;
+
+    printf("\n%zu images (%.0f MB), %d repeats\n", count, count * PAGE_DECODER_IMAGE_SIZE / 1e6, repeats);
+    printf("kernel   crc_GBps  page0_GBps  page0_ns_per_image\n");
+    for (int kernel = PAGE_DECODER_SCALAR; kernel < N_KERNELS; kernel++)
+    {
+        if (PageDecoder_SetKernel(kernel) != 0)
+            continue;
+        size_t sink = 0;
+        double start = Now();
+        for (int r = 0; r < repeats; r++)
+            sink += PageDecoder_CheckCrc(images, count, valid);
+        double crc_s = Now() - start;
+        start = Now();
+        for (int r = 0; r < repeats; r++)
+            PageDecoder_DecodePage0(images, count, DS2438_SENSE_RESISTOR, temperature, voltage, current);
+        double page0_s = Now() - start;
+        printf("%-8s %8.2f  %10.2f  %18.3f\n", PageDecoder_KernelName(kernel), bytes / crc_s / 1e9,
+               bytes / page0_s / 1e9, page0_s * 1e9 / ((double)count * repeats));
+        if (sink == (size_t)-1)
+            printf("%f\n", temperature[0] + voltage[0] + current[0]);
+    }
+    free(images);
+    free(valid);
+    free(temperature);
+    free(voltage);
+    free(current);
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 16 * 1024 * 1024;
+    int repeats = 5;
+    int option;
+    while ((option = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': count = strtoul(optarg, NULL, 0); break;
+            case 'r': repeats = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n images] [-r repeats]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "simulated device not found\n");
+        return 1;
+    }
+
+    int failures = VerifyPage0() + VerifyPages1And7() + VerifyCrc();
+    if (failures != 0)
+    {
+        printf("verification FAILED\n");
+        return 1;
+    }
+    Benchmark(count, repeats);
+    return 0;
+}
+
+/* [] END OF FILE */
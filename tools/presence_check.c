@@ -0,0 +1,291 @@
+/********************************************
+*
+*   \brief Host check of the presence watcher of
+*   DS2438_Presence.h in the main loop of main.c.
+*
+*   The main loop of tools/host/main_cycle.h runs on a
+*   simulated device (see tools/host/ds2438_model.h), with
+*   the watcher started as in main.c. The device is removed
+*   and connected again at random times, which can fall in
+*   a measurement cycle or in the idle time; the change
+*   takes effect on the line at that time, in the middle
+*   of a transaction if one is running.
+*
+*   Reported, for removals and connections: events, mean
+*   and longest time from the change to its report, split
+*   by what saw the change first, a transaction of the
+*   cycle or a reset of the watcher. Then the share of bus
+*   time used by the watcher and by the cycles. Checked:
+*   every change is reported once, with the right event;
+*   a change seen by the watcher is reported within the
+*   detection latency, plus one iteration of the main loop
+*   and the time the watcher waits to pay back the bus time
+*   of an identification at the budget rate; the bus time
+*   of the watcher stays within the budget rate, plus the
+*   saved up burst and one identification charged beyond
+*   it. The exit status is 1 if any check failed.
+*
+*   With -o, the bus operations are recorded, as with
+*   ONEWIRE_TRACE in the firmware, into a binary trace that
+*   tools/onewire_replay.c can replay.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -DONEWIRE_TRACE=1 -DONEWIRE_TRACE_SIZE=16384 -Itools/host -IDS2438.cydsn -o presence_check
+*       tools/presence_check.c tools/host/host_platform.c tools/host/ds2438_model.c tools/host/main_cycle.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c DS2438.cydsn/DS2438_Accumulators.c DS2438.cydsn/DS2438_History.c
+*       DS2438.cydsn/DS2438_Storage.c DS2438.cydsn/DS2438_Presence.c
+*   Usage: presence_check [-n changes] [-s seed] [-o trace]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "main_cycle.h"
+#include "DS2438.h"
+#include "DS2438_Presence.h"
+#include "OneWire.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Longest time to wait for a report, in us
+#define REPORT_TIMEOUT_US   5000000ull
+
+// Bus time of the identification of a device (reset and READ ROM), in us
+#define IDENTIFY_US         7000
+
+#define NO_CHANGE           UINT64_MAX
+
+#define SEEN_BY_CYCLE       0
+#define SEEN_BY_WATCHER     1
+
+typedef struct {
+    uint32_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+} Latency;
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+static Host_Bus model_host;
+static uint32_t seed = 1;
+static FILE* trace_file = NULL;
+
+// Scheduled change of the device, applied at the first line access after it
+static uint64_t change_us = NO_CHANGE;
+static uint8_t change_present;
+static uint8_t in_cycle = 0;
+static uint8_t seen_by;
+
+// Last report of the watcher
+static uint8_t reported = 0;
+static uint8_t reported_event;
+static uint64_t reported_us;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ===========================================================
+//                      BUS
+// ===========================================================
+
+static void Check_ApplyChange(uint64_t time_us)
+{
+    if (time_us < change_us)
+        return;
+    model.present = change_present;
+    change_us = NO_CHANGE;
+    seen_by = in_cycle ? SEEN_BY_CYCLE : SEEN_BY_WATCHER;
+}
+
+static void Check_Drive(void* context, uint32 pin, int low, uint64_t time_us)
+{
+    Check_ApplyChange(time_us);
+    model_host.drive(context, pin, low, time_us);
+}
+
+static int Check_Sample(void* context, uint32 pin, uint64_t time_us)
+{
+    Check_ApplyChange(time_us);
+    return model_host.sample(context, pin, time_us);
+}
+
+static void Check_Changed(const uint8_t* rom, uint8_t event, void* context)
+{
+    (void)rom;
+    (void)context;
+    reported = 1;
+    reported_event = event;
+    reported_us = Host_GetUs();
+}
+
+// ===========================================================
+//                      MAIN LOOP
+// ===========================================================
+
+static uint64_t next_cycle_us = 0;
+
+static void Check_SaveTrace(void)
+{
+    uint8_t buffer[1024];
+    uint16_t length;
+    if (trace_file == NULL)
+        return;
+    while ((length = OneWire_TraceRead(buffer, sizeof(buffer))) > 0)
+    {
+        fwrite(buffer, 1, length, trace_file);
+    }
+}
+
+// Run the main loop of main.c until the watcher reports a change or the time is reached
+static void Check_RunUntil(uint64_t until_us)
+{
+    reported = 0;
+    while ((reported == 0) && (Host_GetUs() < until_us))
+    {
+        if (Host_GetUs() >= next_cycle_us)
+        {
+            next_cycle_us += 1000ull * MAIN_CYCLE_PERIOD_MS;
+            in_cycle = 1;
+            MainCycle_Run();
+            in_cycle = 0;
+        }
+        DS2438_PresencePoll();
+        Check_SaveTrace();
+        Host_AdvanceUs(MAIN_LOOP_US);
+    }
+}
+
+static void Check_Print(const char* what, const Latency* latency)
+{
+    printf("%-34s %6u %9.1f %9.1f\n", what, latency->count,
+           latency->count ? latency->total_us / 1000.0 / latency->count : 0.0, latency->max_us / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n_changes = 20;
+    const char* trace_path = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "n:s:o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_changes = strtoul(optarg, NULL, 0); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'o': trace_path = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n changes] [-s seed] [-o trace]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    model_host = DS2438_ModelBusHost(&model_bus);
+    Host_Bus host = {Check_Drive, Check_Sample, model_host.context};
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+    if (trace_path != NULL)
+    {
+        trace_file = fopen(trace_path, "wb");
+        if (trace_file == NULL)
+        {
+            perror(trace_path);
+            return 1;
+        }
+    }
+    DS2438_PresenceStart(DS2438_Pin_0, 0, MAIN_PRESENCE_LATENCY_MS, MAIN_PRESENCE_BUDGET_PERMILLE,
+                         Check_Changed, NULL);
+    OneWire_TraceEnable(1);
+
+    int failed = 0;
+    uint64_t start_us = Host_GetUs();
+    uint64_t start_bus_us = Host_GetDelayUs();
+    next_cycle_us = start_us;
+    Check_RunUntil(start_us + REPORT_TIMEOUT_US);
+    if (!reported || (reported_event != DS2438_PRESENCE_ATTACHED))
+    {
+        printf("device present at start not reported\n");
+        failed++;
+    }
+
+    // [removed, connected][seen by the cycle, by the watcher]
+    Latency latencies[2][2] = {{{0}}};
+    uint32_t wrong = 0, missed = 0;
+    for (uint32_t n = 0; n < 2 * n_changes; n++)
+    {
+        uint8_t present = n % 2;
+        uint64_t at_us = Host_GetUs() + 500000 + Random() % 2000000;
+        Check_RunUntil(at_us);
+        if (reported)
+            wrong++;
+        change_us = at_us;
+        change_present = present;
+        Check_RunUntil(at_us + REPORT_TIMEOUT_US);
+        uint8_t expected = present ? DS2438_PRESENCE_ATTACHED : DS2438_PRESENCE_DETACHED;
+        if (!reported)
+        {
+            missed++;
+            continue;
+        }
+        if (reported_event != expected)
+            wrong++;
+        Latency* latency = &latencies[present][seen_by];
+        uint64_t elapsed_us = reported_us - at_us;
+        latency->count++;
+        latency->total_us += elapsed_us;
+        if (elapsed_us > latency->max_us)
+            latency->max_us = elapsed_us;
+    }
+    Check_SaveTrace();
+
+    uint64_t elapsed_us = Host_GetUs() - start_us;
+    uint64_t bus_us = Host_GetDelayUs() - start_bus_us;
+    DS2438_PresenceStats stats;
+    DS2438_PresenceGetStats(&stats);
+    OneWire_TraceStats trace_stats;
+    OneWire_TraceGetStats(&trace_stats);
+
+    printf("%u removals and connections, %.1f s, latency %d ms, budget %d permille\n\n", n_changes,
+           elapsed_us / 1e6, MAIN_PRESENCE_LATENCY_MS, MAIN_PRESENCE_BUDGET_PERMILLE);
+    printf("%-34s %6s %9s %9s\n", "change", "events", "mean ms", "max ms");
+    Check_Print("removal, seen by the cycle", &latencies[0][SEEN_BY_CYCLE]);
+    Check_Print("removal, seen by the watcher", &latencies[0][SEEN_BY_WATCHER]);
+    Check_Print("connection, seen by the cycle", &latencies[1][SEEN_BY_CYCLE]);
+    Check_Print("connection, seen by the watcher", &latencies[1][SEEN_BY_WATCHER]);
+    printf("\nwrong or repeated reports %u, missed %u\n", wrong, missed);
+    printf("bus time: watcher %.2f%% (%u probes, %u identifications), cycles %.2f%%\n",
+           100.0 * stats.bus_us / elapsed_us, stats.probes, stats.identifications,
+           100.0 * (bus_us - stats.bus_us) / elapsed_us);
+
+    // Resets of the watcher wait for the balance of the token bucket to be positive again
+    uint64_t bound_us = 1000ull * MAIN_PRESENCE_LATENCY_MS + MAIN_LOOP_US +
+                        1000ull * IDENTIFY_US / MAIN_PRESENCE_BUDGET_PERMILLE;
+    uint64_t budget_us = (uint64_t)MAIN_PRESENCE_BUDGET_PERMILLE * elapsed_us / 1000 +
+                         DS2438_PRESENCE_BURST_US + IDENTIFY_US;
+    printf("bounds: report %.1f ms after a change seen by the watcher, watcher bus time %.1f ms\n",
+           bound_us / 1000.0, budget_us / 1000.0);
+    failed += (wrong != 0) || (missed != 0);
+    failed += (latencies[0][SEEN_BY_WATCHER].max_us > bound_us) || (latencies[1][SEEN_BY_WATCHER].max_us > bound_us);
+    failed += (stats.bus_us > budget_us);
+    if (trace_file != NULL)
+    {
+        fclose(trace_file);
+        printf("trace: %u records, %u overwritten\n", trace_stats.records, trace_stats.overwritten);
+        failed += (trace_stats.overwritten != 0);
+    }
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
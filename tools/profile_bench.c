@@ -0,0 +1,144 @@
+/********************************************
+*
+*   \brief Benchmark of the timing profiles of OneWire.h.
+*
+*   Reads pages of a simulated device (see
+*   tools/host/ds2438_model.h) with each constant timing
+*   profile, for several rise times of the line, and
+*   reports the bus time of a page read (reset and RECALL
+*   MEMORY, reset and READ SCRATCHPAD with the nine bytes
+*   of the page) and the failed reads.
+*
+*   Checked: each profile reads without errors up to the
+*   rise time for which OneWire_Diagnose() recommends it,
+*   and ONEWIRE_PROFILE_LONG_LINE wherever the standard
+*   profile does; the long line profile samples read
+*   slots later than the standard one and keeps its
+*   slots at least 60 us long. The exit status is 1 if
+*   any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o profile_bench tools/profile_bench.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire.c
+*       DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: profile_bench [-n reads] [-r max_rise_us]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "OneWire.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define N_PROFILES  3
+
+// Page read by the benchmark
+#define PAGE        3
+
+static const char* profile_names[N_PROFILES] = {"standard", "short trace", "long line"};
+
+// Longest rise time for which each profile is recommended, in us
+static const uint16_t recommended_rise_us[N_PROFILES] = {
+    ONEWIRE_DIAG_STANDARD_RISE_US, ONEWIRE_DIAG_FAST_RISE_US, ONEWIRE_DIAG_SLOW_RISE_US
+};
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+
+// Read the page with the profile attached to the bus, returns the failed reads
+static uint32_t Bench_Reads(uint32_t n_reads, uint64_t* page_us)
+{
+    uint8_t page_data[9];
+    uint32_t recall_us, errors = 0;
+    uint64_t start_us = Host_GetDelayUs();
+    for (uint32_t n = 0; n < n_reads; n++)
+    {
+        if ((DS2438_ReadPageTimestamped(PAGE, page_data, &recall_us) != DS2438_OK) ||
+            (DS2438_CheckCrcValue(page_data, 8, page_data[8]) != DS2438_OK) ||
+            (memcmp(page_data, model.memory[PAGE], 8) != 0))
+            errors++;
+    }
+    *page_us = (Host_GetDelayUs() - start_us) / n_reads;
+    return errors;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n_reads = 100;
+    uint16_t max_rise_us = 12;
+    int option;
+    while ((option = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_reads = strtoul(optarg, NULL, 0); break;
+            case 'r': max_rise_us = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n reads] [-r max_rise_us]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (n_reads == 0)
+        n_reads = 1;
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        model.memory[PAGE][i] = 0x11 * (i + 1);
+    }
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+
+    int failed = 0;
+    OneWire_Timing timings[N_PROFILES];
+    for (uint8_t profile = 0; profile < N_PROFILES; profile++)
+    {
+        OneWire_GetProfileTiming(profile, &timings[profile]);
+        const OneWire_Timing* t = &timings[profile];
+        printf("%-12s sample at %2u us, write 1 slot %3u us, read slot %3u us, reset %3u us\n", profile_names[profile],
+               t->a + t->e, t->a + t->b, t->a + t->e + t->f, t->g + t->h + t->i + t->j);
+    }
+    const OneWire_Timing* standard = &timings[ONEWIRE_PROFILE_STANDARD];
+    const OneWire_Timing* long_line = &timings[ONEWIRE_PROFILE_LONG_LINE];
+    failed += (long_line->a + long_line->e <= standard->a + standard->e);
+    failed += (long_line->a + long_line->e + long_line->f < 60) || (long_line->a + long_line->b < 60);
+
+    printf("\n%7s", "rise us");
+    for (uint8_t profile = 0; profile < N_PROFILES; profile++)
+    {
+        printf(" | %-20s", profile_names[profile]);
+    }
+    printf("\n");
+    for (uint16_t rise_us = 0; rise_us <= max_rise_us; rise_us++)
+    {
+        uint32_t errors[N_PROFILES];
+        model_bus.rise_us = rise_us;
+        printf("%7u", rise_us);
+        for (uint8_t profile = 0; profile < N_PROFILES; profile++)
+        {
+            uint64_t page_us;
+            OneWire_AttachProfile(DS2438_Pin_0, profile);
+            errors[profile] = Bench_Reads(n_reads, &page_us);
+            printf(" | %8.1f us %4u err", (double)page_us, errors[profile]);
+            failed += (rise_us <= recommended_rise_us[profile]) && (errors[profile] != 0);
+        }
+        failed += (errors[ONEWIRE_PROFILE_STANDARD] == 0) && (errors[ONEWIRE_PROFILE_LONG_LINE] != 0);
+        printf("\n");
+    }
+    OneWire_AttachProfile(DS2438_Pin_0, ONEWIRE_PROFILE_STANDARD);
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,195 @@
+/********************************************
+*
+*   \brief Host check of the request queue of
+*   DS2438_Queue.h.
+*
+*   Clients of the main loop submit reads of pages 0 to 3
+*   of a simulated device (see tools/host/ds2438_model.h),
+*   the measurement, accumulator and timestamp pages and
+*   a user page, at random times, with a freshness
+*   tolerance of 0, 50 or 500 ms, and the queue is served
+*   once per iteration.
+*   Read slots are corrupted at the given rate, so some
+*   reads fail their CRC.
+*
+*   Reported: requests, reads from the device (attempts),
+*   successful ones, merge ratio (requests per attempt),
+*   and the median, 99th percentile and longest latency
+*   of the requests. Checked: every request completes;
+*   the data of a successful request match their CRC, are
+*   the page of the device for the user page and, for
+*   the other pages, were not older than the tolerance
+*   when the request was submitted; a read
+*   whose CRC does not match fails all its requests and
+*   counts as an attempt but not as a transaction; with
+*   the default load requests are merged (ratio above 1);
+*   the longest latency stays within the window, one
+*   iteration and the reads of all the pages. The exit
+*   status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o queue_check tools/queue_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/DS2438_Queue.c
+*       DS2438.cydsn/OneWire.c DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c
+*       DS2438.cydsn/DS2438_Cache.c DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: queue_check [-c clients] [-g gap_ms] [-w window_us] [-n noise_ppm] [-t seconds] [-s seed]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "DS2438_Queue.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_CLIENTS         32
+
+// Pages read by the clients: one page of each volatility class and the user page 3
+#define N_PAGES             4
+#define USER_PAGE           3
+
+// Period of the main loop, in us
+#define LOOP_US             1000
+
+// Bus time at standard speed of a page read (reset and RECALL, reset and READ SCRATCHPAD), in us
+#define PAGE_TRANSACTION_US 12000
+
+typedef struct {
+    DS2438_PageRequest request;
+    uint64_t next_us;
+} Client;
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+static Client clients[MAX_CLIENTS];
+static uint32_t seed = 1;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t n_clients = 8, gap_ms = 20, window_us = DS2438_QUEUE_WINDOW_US, noise_ppm = 200, duration_s = 60;
+    int option;
+    while ((option = getopt(argc, argv, "c:g:w:n:t:s:")) != -1)
+    {
+        switch (option)
+        {
+            case 'c': n_clients = strtoul(optarg, NULL, 0); break;
+            case 'g': gap_ms = strtoul(optarg, NULL, 0); break;
+            case 'w': window_us = strtoul(optarg, NULL, 0); break;
+            case 'n': noise_ppm = strtoul(optarg, NULL, 0); break;
+            case 't': duration_s = strtoul(optarg, NULL, 0); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-c clients] [-g gap_ms] [-w window_us] [-n noise_ppm] "
+                        "[-t seconds] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((n_clients == 0) || (n_clients > MAX_CLIENTS) || (gap_ms == 0))
+    {
+        fprintf(stderr, "1 to %d clients, gap above 0\n", MAX_CLIENTS);
+        return 1;
+    }
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        model.memory[USER_PAGE][i] = Random() & 0xFF;
+    }
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+    model_bus.noise_ppm = noise_ppm;
+    DS2438_QueueInit(window_us);
+
+    static const uint32_t tolerances_ms[3] = {0, 50, 500};
+    uint32_t submitted = 0, completed = 0, crc_failed = 0, other_failed = 0, wrong = 0, stale = 0;
+    uint64_t end_us = Host_GetUs() + 1000000ull * duration_s;
+    for (uint32_t n = 0; n < n_clients; n++)
+    {
+        clients[n].next_us = Host_GetUs() + Random() % (1000 * gap_ms);
+    }
+    while (Host_GetUs() < end_us)
+    {
+        for (uint32_t n = 0; n < n_clients; n++)
+        {
+            Client* client = &clients[n];
+            DS2438_PageRequest* request = &client->request;
+            if (request->state == DS2438_REQUEST_DONE)
+            {
+                completed++;
+                request->state = DS2438_REQUEST_IDLE;
+                if (request->status == DS2438_CRC_FAIL)
+                {
+                    crc_failed++;
+                }
+                else if (request->status != DS2438_OK)
+                {
+                    other_failed++;
+                }
+                else
+                {
+                    // Age of the data at the submission; cache times are kept to the millisecond
+                    int32_t age_us = (int32_t)(request->submit_us - request->data_us);
+                    wrong += (DS2438_CheckCrcValue(request->page_data, 8, request->page_data[8]) != DS2438_OK);
+                    wrong += (request->page_number == USER_PAGE) &&
+                             (memcmp(request->page_data, model.memory[USER_PAGE], 8) != 0);
+                    stale += (request->page_number != USER_PAGE) && (age_us > (int32_t)(1000 * request->max_age_ms + 1000));
+                }
+            }
+            if ((request->state == DS2438_REQUEST_IDLE) && (Host_GetUs() >= client->next_us))
+            {
+                uint8_t page = Random() % N_PAGES;
+                DS2438_QueueSubmit(request, page, tolerances_ms[Random() % 3]);
+                submitted++;
+                client->next_us = Host_GetUs() + Random() % (2000 * gap_ms);
+            }
+        }
+        DS2438_QueueService(0);
+        Host_AdvanceUs(LOOP_US);
+    }
+    DS2438_QueueService(1);
+    for (uint32_t n = 0; n < n_clients; n++)
+    {
+        completed += (clients[n].request.state == DS2438_REQUEST_DONE);
+    }
+
+    DS2438_QueueStats stats;
+    DS2438_QueueGetStats(&stats);
+    uint32_t bound_us = window_us + LOOP_US + N_PAGES * PAGE_TRANSACTION_US;
+    printf("%u clients, mean gap %u ms, window %u us, noise %u ppm, %u s\n\n",
+           n_clients, gap_ms, window_us, noise_ppm, duration_s);
+    printf("requests %u (submitted %u), attempts %u, transactions %u, merge ratio %.2f\n",
+           stats.requests, submitted, stats.attempts, stats.transactions,
+           stats.attempts ? (double)stats.requests / stats.attempts : 0.0);
+    printf("latency: p50 < %u us, p99 < %u us, max %u us, bound %u us\n",
+           DS2438_QueueGetLatencyPercentile(&stats, 50) + 1, DS2438_QueueGetLatencyPercentile(&stats, 99) + 1,
+           stats.max_latency_us, bound_us);
+    printf("failed: CRC %u, other %u; wrong data %u, stale data %u\n\n", crc_failed, other_failed, wrong, stale);
+
+    int failed = 0;
+    failed += (completed != submitted) || (stats.requests != submitted);
+    failed += (wrong != 0) || (stale != 0) || (other_failed != 0);
+    failed += (noise_ppm == 0) ? (crc_failed != 0) : (stats.attempts == stats.transactions);
+    failed += (stats.transactions > stats.attempts);
+    failed += (stats.max_latency_us > bound_us);
+    failed += (window_us >= DS2438_QUEUE_WINDOW_US) && (stats.requests <= stats.attempts);
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,250 @@
+/********************************************
+*
+*   \brief Host check of the synchronized current sampler
+*   of DS2438_Sampler.h.
+*
+*   The current register of a simulated device (see
+*   tools/host/ds2438_model.h) is updated as by the current
+*   A/D of a DS2438, at 36.41 Hz with a random phase, off
+*   by a frequency offset that drifts linearly during the
+*   run. Each update takes a new value, so the update a
+*   read returns is known. The main loop polls the sampler
+*   once per iteration, except for late polls injected at
+*   random times, during which one to three updates are
+*   left without a read.
+*
+*   Reported: updates, samples, missed and duplicated
+*   updates, reads and probes, the time to lock and the
+*   error of the sample timestamps once locked. Checked:
+*   each sample returns the update its index tells, so
+*   samples and missed updates add up to the updates; no
+*   update is returned twice; updates are only missed by
+*   late polls, and the missed count of the sampler matches
+*   them; the sampler locks within LOCK_BOUND_US, no
+*   update falls outside of its predicted window, and the
+*   timestamps of its samples are then within the lock
+*   window of the updates. The exit status
+*   is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o sampler_check tools/sampler_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire.c
+*       DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c DS2438.cydsn/DS2438_Sampler.c
+*   Usage: sampler_check [-t seconds] [-o offset_ppm] [-d drift_ppm] [-l late_polls] [-s seed]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include "DS2438_Sampler.h"
+#include "Timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Period of the main loop, in us
+#define LOOP_US             1000
+
+// Longest time from the start of the sampler to its lock, in us
+#define LOCK_BOUND_US       2000000
+
+// Values taken by the current register, one per update
+#define CURRENT_VALUES      1024
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+static Host_Bus model_host;
+static uint32_t seed = 1;
+
+// Current A/D of the device
+static double start_period_us, drift_us_per_us;
+static uint64_t start_us, next_update_us = UINT64_MAX;
+static uint64_t update_us[CURRENT_VALUES];
+static uint32_t updates = 0;
+
+static uint32_t Random(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+}
+
+// ===========================================================
+//                      BUS
+// ===========================================================
+
+// Apply the updates of the current register up to the time
+static void Check_Update(uint64_t time_us)
+{
+    while (time_us >= next_update_us)
+    {
+        updates++;
+        model.current = (int16_t)(updates % CURRENT_VALUES) - CURRENT_VALUES / 2;
+        update_us[updates % CURRENT_VALUES] = next_update_us;
+        next_update_us += (uint64_t)(start_period_us + drift_us_per_us * (next_update_us - start_us));
+    }
+}
+
+static void Check_Drive(void* context, uint32 pin, int low, uint64_t time_us)
+{
+    Check_Update(time_us);
+    model_host.drive(context, pin, low, time_us);
+}
+
+static int Check_Sample(void* context, uint32 pin, uint64_t time_us)
+{
+    Check_Update(time_us);
+    return model_host.sample(context, pin, time_us);
+}
+
+// Update whose value is in the current register, given an update close to it
+static uint32_t Check_UpdateOf(uint16_t current, uint32_t near)
+{
+    uint32_t value = ((int16_t)current + CURRENT_VALUES / 2) % CURRENT_VALUES;
+    int32_t offset = (int32_t)((value - near) % CURRENT_VALUES);
+    if (offset >= CURRENT_VALUES / 2)
+        offset -= CURRENT_VALUES;
+    return near + offset;
+}
+
+static void Check(int condition, const char* what, int* failed)
+{
+    printf("  %-60s %s\n", what, condition ? "ok" : "FAIL");
+    *failed += !condition;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t duration_s = 60, n_late = 10;
+    int32_t offset_ppm = 3000, drift_ppm = 2000;
+    int option;
+    while ((option = getopt(argc, argv, "t:o:d:l:s:")) != -1)
+    {
+        switch (option)
+        {
+            case 't': duration_s = strtoul(optarg, NULL, 0); break;
+            case 'o': offset_ppm = atoi(optarg); break;
+            case 'd': drift_ppm = atoi(optarg); break;
+            case 'l': n_late = strtoul(optarg, NULL, 0); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-t seconds] [-o offset_ppm] [-d drift_ppm] [-l late_polls] "
+                        "[-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (duration_s < 5)
+    {
+        fprintf(stderr, "Duration of 5 s at least\n");
+        return 1;
+    }
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    model_host = DS2438_ModelBusHost(&model_bus);
+    Host_Bus host = {Check_Drive, Check_Sample, model_host.context};
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+
+    // Frequency offset of the oscillator, drifting by drift_ppm over the run
+    uint64_t duration_us = 1000000ull * duration_s;
+    start_period_us = DS2438_SAMPLER_PERIOD_US * (1.0 + offset_ppm * 1e-6);
+    drift_us_per_us = DS2438_SAMPLER_PERIOD_US * drift_ppm * 1e-6 / duration_us;
+    start_us = Host_GetUs();
+    model.current = -CURRENT_VALUES / 2;
+    next_update_us = start_us + Random() % DS2438_SAMPLER_PERIOD_US;
+    uint64_t timebase_us = Host_GetUs() - Timebase_GetUs();
+
+    // Late polls, in the second half of the run, past the lock
+    uint64_t late_us[64];
+    if (n_late > 64)
+        n_late = 64;
+    for (uint32_t n = 0; n < n_late; n++)
+    {
+        late_us[n] = start_us + duration_us / 2 + (duration_us / 2 - 1000000) / n_late * n +
+                     Random() % 100000;
+    }
+
+    DS2438_SamplerStart();
+    uint32_t samples = 0, wrong = 0, unexpected_misses = 0, injected = 0, first_update = 0, last_sampled = 0;
+    uint32_t late = 0;
+    uint8_t after_late = 0;
+    uint64_t lock_us = 0, end_us = start_us + duration_us;
+    uint64_t max_error_us = 0;
+    while (Host_GetUs() < end_us)
+    {
+        if ((late < n_late) && (Host_GetUs() >= late_us[late]))
+        {
+            // Late poll: leave one to three updates without a read
+            Host_AdvanceUs((1 + Random() % 3) * DS2438_SAMPLER_PERIOD_US);
+            late++;
+            after_late = 1;
+        }
+        DS2438_CurrentSample sample;
+        uint8_t ready;
+        if ((DS2438_SamplerPoll(&sample, &ready) == DS2438_OK) && ready)
+        {
+            uint32_t update = Check_UpdateOf(sample.current, updates);
+            if (samples == 0)
+            {
+                first_update = update - sample.update_index;
+            }
+            else if (update - last_sampled > 1)
+            {
+                if (after_late)
+                    injected += update - last_sampled - 1;
+                else
+                    unexpected_misses += update - last_sampled - 1;
+            }
+            wrong += (update != first_update + sample.update_index) || (update > updates);
+            if (lock_us != 0)
+            {
+                int64_t error_us = (int64_t)(sample.timestamp_us + timebase_us) -
+                                   (int64_t)update_us[update % CURRENT_VALUES];
+                if ((uint64_t)llabs(error_us) > max_error_us)
+                    max_error_us = llabs(error_us);
+            }
+            last_sampled = update;
+            after_late = 0;
+            samples++;
+        }
+        DS2438_SamplerStats stats;
+        DS2438_SamplerGetStats(&stats);
+        if ((lock_us == 0) && stats.locked)
+            lock_us = Host_GetUs();
+        Host_AdvanceUs(LOOP_US);
+        Check_Update(Host_GetUs());
+    }
+
+    DS2438_SamplerStats stats;
+    DS2438_SamplerGetStats(&stats);
+    uint32_t sampled_updates = last_sampled - first_update + 1;
+    printf("%u s, frequency offset %d ppm drifting by %d ppm, %u late polls\n\n", duration_s, offset_ppm,
+           drift_ppm, n_late);
+    printf("updates %u, sampled span %u, samples %u, missed %u (late polls %u), duplicates %u\n", updates,
+           sampled_updates, stats.samples, stats.missed, injected, stats.duplicates);
+    printf("reads %u, probes %u, unlocks %u, period %u us +- %u us, window %u us\n", stats.reads, stats.probes,
+           stats.unlocks, stats.period_us, stats.period_error_us, stats.window_us);
+    printf("locked after %.1f ms, timestamp error once locked %.2f ms\n\n",
+           lock_us ? (lock_us - start_us) / 1000.0 : 0.0, max_error_us / 1000.0);
+
+    int failed = 0;
+    Check(wrong == 0, "each sample returns the update of its index", &failed);
+    Check(samples + stats.missed == sampled_updates, "samples and missed updates add up to the updates", &failed);
+    Check(stats.duplicates == 0, "no update returned twice", &failed);
+    Check(unexpected_misses == 0, "updates only missed by late polls", &failed);
+    Check(stats.missed == injected, "missed count matches the late polls", &failed);
+    Check((n_late == 0) || (injected > 0), "late polls miss updates", &failed);
+    Check((lock_us != 0) && (lock_us - start_us <= LOCK_BOUND_US), "locked within the bound", &failed);
+    Check(stats.unlocks == 0, "no update outside of the predicted window", &failed);
+    Check(max_error_us <= DS2438_SAMPLER_LOCK_WINDOW_US, "timestamps within the lock window", &failed);
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,158 @@
+/********************************************
+*
+*   \brief Stress test of the page 0 snapshot of DS2438_Snapshot.h.
+*
+*   One writer thread publishes page 0 images back to
+*   back, as the library does after every page 0 read,
+*   while reader threads call DS2438_SnapshotRead() in
+*   a loop. Publication g carries g in every field: the
+*   timestamp (virtual time advances 1 ms per
+*   publication), the status byte, and the raw
+*   temperature, voltage and current. A reader decodes
+*   g back from each field, so a snapshot copied while
+*   the writer was filling its buffer, or returned with
+*   the generation of another one, is reported as torn.
+*   Readers also check that generations never go back.
+*
+*   Reported: publications, reads, reads per thread per
+*   second, torn snapshots and generations going back.
+*   The exit status is 1 if any was found.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -pthread -Itools/host -IDS2438.cydsn -o snapshot_stress tools/snapshot_stress.c
+*       tools/host/host_platform.c DS2438.cydsn/DS2438_Snapshot.c DS2438.cydsn/Timebase.c -lm
+*   Usage: snapshot_stress [-n publications] [-r readers]
+*
+**********************************************/
+
+#include "host_platform.h"
+#include "DS2438_Snapshot.h"
+#include "Timebase.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_READERS 16
+
+// Fields carry the low bits of the generation
+#define FIELD_MASK  0x3FF
+
+typedef struct {
+    pthread_t thread;
+    uint64_t reads;
+    uint64_t torn;
+    uint64_t backwards;
+} Reader;
+
+static uint32_t n_publications = 20000000;
+static uint32_t n_readers = 2;
+static Reader readers[MAX_READERS];
+static volatile int writer_done = 0;
+
+static double Stress_Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Page 0 image of a publication
+static void Stress_MakePage(uint32_t g, uint8_t* page_data)
+{
+    uint16_t k = g & FIELD_MASK;
+    int16_t temperature = k << 5;           // k / 8 degree Celsius
+    int16_t current = (int16_t)k - 512;
+    page_data[0] = k & 0xFF;
+    page_data[1] = temperature & 0xFF;
+    page_data[2] = (temperature >> 8) & 0xFF;
+    page_data[3] = k & 0xFF;                // k * 10 mV
+    page_data[4] = k >> 8;
+    page_data[5] = current & 0xFF;
+    page_data[6] = (current >> 8) & 0xFF;
+    page_data[7] = 0;
+    page_data[8] = 0;
+}
+
+// 1 if every field of the snapshot comes from generation g
+static int Stress_IsConsistent(const DS2438_Snapshot* snapshot, uint32_t g)
+{
+    long k = g & FIELD_MASK;
+    return (snapshot->timestamp_ms == g) && (snapshot->status == (k & 0xFF)) &&
+           (lroundf(snapshot->temperature * 8) == k) && (lroundf(snapshot->voltage * 100) == k) &&
+           (lround(snapshot->current * 4096. * DS2438_SENSE_RESISTOR) + 512 == k);
+}
+
+static void* Stress_Reader(void* argument)
+{
+    Reader* reader = argument;
+    uint32_t previous = 0;
+    DS2438_Snapshot snapshot;
+    while (!writer_done)
+    {
+        uint32_t g = DS2438_SnapshotRead(&snapshot);
+        reader->reads++;
+        if (g == 0)
+            continue;
+        if (!Stress_IsConsistent(&snapshot, g))
+            reader->torn++;
+        if (g < previous)
+            reader->backwards++;
+        previous = g;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    int option;
+    while ((option = getopt(argc, argv, "n:r:")) != -1)
+    {
+        switch (option)
+        {
+            case 'n': n_publications = strtoul(optarg, NULL, 0); break;
+            case 'r': n_readers = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n publications] [-r readers]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((n_readers == 0) || (n_readers > MAX_READERS))
+    {
+        fprintf(stderr, "1 to %d readers\n", MAX_READERS);
+        return 1;
+    }
+
+    Timebase_Start();
+    double start = Stress_Now();
+    for (uint32_t r = 0; r < n_readers; r++)
+    {
+        pthread_create(&readers[r].thread, NULL, Stress_Reader, &readers[r]);
+    }
+    uint8_t page_data[9];
+    for (uint32_t g = 1; g <= n_publications; g++)
+    {
+        Host_AdvanceUs(1000);
+        Stress_MakePage(g, page_data);
+        DS2438_SnapshotPublish(page_data);
+    }
+    writer_done = 1;
+    uint64_t reads = 0, torn = 0, backwards = 0;
+    for (uint32_t r = 0; r < n_readers; r++)
+    {
+        pthread_join(readers[r].thread, NULL);
+        reads += readers[r].reads;
+        torn += readers[r].torn;
+        backwards += readers[r].backwards;
+    }
+    double elapsed = Stress_Now() - start;
+
+    printf("%u publications, %u readers, %.2f s\n", n_publications, n_readers, elapsed);
+    printf("reads %llu (%.1f M/s per reader), torn %llu, generation back %llu\n", (unsigned long long)reads,
+           reads / elapsed / n_readers / 1e6, (unsigned long long)torn, (unsigned long long)backwards);
+    return (torn || backwards) ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,206 @@
+/********************************************
+*
+*   \brief Host check of the voltage streaming mode of
+*   DS2438.h.
+*
+*   Streams the voltage of a simulated device (see
+*   tools/host/ds2438_model.h) from a main loop that calls
+*   DS2438_StreamService() once per iteration. The voltage
+*   of the device, on both inputs, changes at every
+*   iteration, so each conversion latches a different
+*   value.
+*
+*   First the loop reads the ring buffer at every
+*   iteration; then it stops reading it for a while, so
+*   the ring buffer fills up, and reads it again.
+*
+*   Reported: samples, mean period and rate, errors and
+*   dropped samples. Checked: while the ring buffer is
+*   read, no sample is dropped, and consecutive samples
+*   are one conversion apart, that is at least
+*   DS2438_CONVERSION_TIME_US and at most one conversion,
+*   the RECALL and conversion commands and one iteration;
+*   no sample is repeated; when the ring buffer is full,
+*   it keeps the oldest samples, each new sample counts as
+*   dropped, and the next sample read follows the dropped
+*   ones. The exit status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o stream_check tools/stream_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire.c
+*       DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: stream_check [-t seconds] [-b buffer_size] [-n noise_ppm]
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MAX_BUFFER_SIZE     1024
+
+// Period of the main loop, in us
+#define LOOP_US             1000
+
+// Bus time at standard speed of a RECALL (reset and three bytes) and of a
+// conversion command (reset and two bytes), in us
+#define RECALL_COMMAND_US   3000
+#define CONVERT_COMMAND_US  3000
+
+// Voltage register of the device
+#define VOLTAGE_MASK        0x3FF
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+static DS2438_VoltageStream stream;
+static DS2438_VoltageSample samples[MAX_BUFFER_SIZE];
+
+static uint32_t iteration = 0;
+static uint32_t read_samples = 0, repeated = 0, out_of_period = 0;
+static uint8_t has_last = 0;
+static DS2438_VoltageSample last;
+
+static void Check(int condition, const char* what, int* failed)
+{
+    printf("  %-60s %s\n", what, condition ? "ok" : "FAIL");
+    *failed += !condition;
+}
+
+// One iteration of the main loop
+static void Check_Iteration(void)
+{
+    model.vdd = iteration & VOLTAGE_MASK;
+    model.vad = iteration++ & VOLTAGE_MASK;
+    DS2438_StreamService(&stream);
+    Host_AdvanceUs(LOOP_US);
+}
+
+// Check a sample read from the ring buffer against the previous one
+static void Check_Sample(const DS2438_VoltageSample* sample, uint32_t max_period_us)
+{
+    if (has_last)
+    {
+        uint32_t period_us = sample->timestamp_us - last.timestamp_us;
+        repeated += (sample->voltage == last.voltage) || (period_us == 0);
+        out_of_period += (period_us < DS2438_CONVERSION_TIME_US) || (period_us > max_period_us);
+    }
+    last = *sample;
+    has_last = 1;
+    read_samples++;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t duration_s = 5, size = 16, noise_ppm = 0;
+    int option;
+    while ((option = getopt(argc, argv, "t:b:n:")) != -1)
+    {
+        switch (option)
+        {
+            case 't': duration_s = strtoul(optarg, NULL, 0); break;
+            case 'b': size = strtoul(optarg, NULL, 0); break;
+            case 'n': noise_ppm = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-t seconds] [-b buffer_size] [-n noise_ppm]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((size < 2) || (size > MAX_BUFFER_SIZE) || (duration_s == 0))
+    {
+        fprintf(stderr, "Buffer of 2 to %d samples, duration above 0\n", MAX_BUFFER_SIZE);
+        return 1;
+    }
+
+    DS2438_Model* devices[1] = {&model};
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+    model_bus.noise_ppm = noise_ppm;
+    // Samples lost to CRC errors lengthen the period by a conversion each
+    uint32_t max_period_us = DS2438_CONVERSION_TIME_US + RECALL_COMMAND_US + CONVERT_COMMAND_US + LOOP_US;
+    if (noise_ppm != 0)
+        max_period_us = UINT32_MAX;
+
+    int failed = 0;
+    DS2438_VoltageSample sample;
+    if (DS2438_StreamStart(&stream, samples, size) != DS2438_OK)
+    {
+        fprintf(stderr, "Streaming not started\n");
+        return 1;
+    }
+
+    // Read the ring buffer at every iteration
+    printf("ring buffer of %u samples, read at every iteration, %u s\n", size, duration_s);
+    uint64_t end_us = Host_GetUs() + 1000000ull * duration_s;
+    while (Host_GetUs() < end_us)
+    {
+        Check_Iteration();
+        while (DS2438_StreamRead(&stream, &sample) == DS2438_OK)
+        {
+            Check_Sample(&sample, max_period_us);
+        }
+    }
+    double rate = DS2438_StreamGetRate(&stream);
+    printf("  %u samples, mean period %.2f ms, %.1f samples/s, %u errors\n", stream.produced,
+           rate > 0 ? 1000.0 / rate : 0.0, rate, stream.errors);
+    Check(stream.produced > 0, "samples produced", &failed);
+    Check(stream.dropped == 0, "no sample dropped", &failed);
+    Check(read_samples == stream.produced, "every sample read", &failed);
+    Check(repeated == 0, "no sample repeated", &failed);
+    Check(out_of_period == 0, "samples one conversion apart", &failed);
+    Check((rate >= 1e6 / max_period_us) && (rate <= 1e6 / DS2438_CONVERSION_TIME_US),
+          "rate of one sample per conversion", &failed);
+
+    // Let the ring buffer fill up, for twice its size
+    printf("ring buffer not read for %u samples\n", 2 * size);
+    uint32_t produced = stream.produced, dropped = stream.dropped;
+    while (stream.produced - produced < 2 * size)
+    {
+        Check_Iteration();
+    }
+    produced = stream.produced - produced;
+    dropped = stream.dropped - dropped;
+    uint32_t kept = 0;
+    while (DS2438_StreamRead(&stream, &sample) == DS2438_OK)
+    {
+        Check_Sample(&sample, max_period_us);
+        kept++;
+    }
+    printf("  %u samples, %u kept, %u dropped\n", produced, kept, dropped);
+    Check(kept == size - 1, "ring buffer full, one slot kept free", &failed);
+    Check(dropped == produced - kept, "each new sample counts as dropped", &failed);
+    Check(out_of_period == 0, "oldest samples kept, following the last sample read", &failed);
+
+    // Read the ring buffer again: the next sample follows the dropped ones
+    uint32_t resumed = stream.produced;
+    while (stream.produced == resumed)
+    {
+        Check_Iteration();
+    }
+    if (DS2438_StreamRead(&stream, &sample) == DS2438_OK)
+    {
+        uint32_t gap_us = sample.timestamp_us - last.timestamp_us;
+        printf("  next sample read %.1f ms after the last one kept\n", gap_us / 1000.0);
+        Check((gap_us >= (dropped + 1) * DS2438_CONVERSION_TIME_US) &&
+              ((noise_ppm != 0) || (gap_us <= (dropped + 1) * max_period_us)),
+              "next sample follows the dropped ones", &failed);
+    }
+    else
+    {
+        Check(0, "next sample read", &failed);
+    }
+    DS2438_StreamStop(&stream);
+    printf("%s\n", failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,704 @@
+/********************************************
+*
+*   \brief Ingest of DS2438 telemetry captures into a columnar store.
+*
+*   Each input file is the capture of one monitor, named
+*   after the file (captures/rack3-07.log is monitor
+*   rack3-07). Two kinds of input are decoded:
+*
+*    - UART logs of the demo application: "Voltage:",
+*      "Temperature:", "mAmps:", "Capacity:", page and
+*      "ETM:" lines, errors and lost events. Lines can be
+*      prefixed by the capture time, in seconds since the
+*      epoch, as "1700000000.123 " or "[1700000000.123] ";
+*      without prefix, each measurement cycle is given the
+*      time of its position, counting back from the last
+*      modification of the file at one cycle per period.
+*    - raw page dumps, files with the .pages extension, made
+*      of 18-byte records: int64 time in ms since the epoch,
+*      page number, and the 9 bytes of the page with CRC.
+*      Pages are decoded as by the DS2438_Get* functions.
+*
+*   Monitors are ingested in parallel, one per thread, and
+*   merged with the samples already in the store. See
+*   telemetry_store.hpp for the file format.
+*
+*   Build, from the repository root:
+*   g++ -std=c++17 -O2 -Wall -pthread -o telemetry_ingest tools/telemetry_ingest.cpp
+*   Usage:
+*   telemetry_ingest ingest [-j threads] [-p period_ms] [-s start] -o store files...
+*   telemetry_ingest query [-r] [-b bucket_s] store monitor channel from to
+*   telemetry_ingest list store
+*   Times are seconds since the epoch or UTC dates (2024-05-01 or 2024-05-01T12:00:00).
+*
+**********************************************/
+
+#include "telemetry_store.hpp"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <dirent.h>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace telemetry;
+
+// Same period as main.c
+#define MEASUREMENT_PERIOD_MS   1000
+
+// Same value as DS2438_SENSE_RESISTOR in DS2438_Defines.h
+#define SENSE_RESISTOR          0.05
+
+// Event type of failed page reads, as in DS2438_Events.h
+#define EVENT_PAGE              4
+
+#define RAW_RECORD_SIZE         18
+
+struct Options {
+    int threads = 0;
+    int64_t period_ms = MEASUREMENT_PERIOD_MS;
+    int64_t start_ms = -1;
+    std::string store;
+};
+
+struct Monitor {
+    std::string name;
+    std::vector<std::string> files;
+    std::vector<Sample> channels[kChannels];
+};
+
+static std::atomic<uint64_t> total_bytes(0), total_lines(0), total_samples(0), total_errors(0);
+
+// ===========================================================
+//                      INPUT
+// ===========================================================
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0)
+        {
+            mtime_ms_ = int64_t(st.st_mtime) * 1000;
+            size_ = st.st_size;
+            if (size_ == 0)
+                ok_ = true;
+            else
+            {
+                void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED)
+                {
+                    data_ = static_cast<const char*>(map);
+                    madvise(map, size_, MADV_SEQUENTIAL);
+                    ok_ = true;
+                }
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile()
+    {
+        if (data_ != nullptr)
+            munmap(const_cast<char*>(data_), size_);
+    }
+    bool Ok() const { return ok_; }
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    int64_t ModifiedMs() const { return mtime_ms_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    int64_t mtime_ms_ = 0;
+    bool ok_ = false;
+};
+
+static uint8_t Crc8(const uint8_t* data, int length)
+{
+    static uint8_t table[256];
+    static std::once_flag once;
+    std::call_once(once, [] {
+        for (int n = 0; n < 256; n++)
+        {
+            uint8_t crc = n;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+            table[n] = crc;
+        }
+    });
+    uint8_t crc = 0;
+    for (int n = 0; n < length; n++)
+        crc = table[crc ^ data[n]];
+    return crc;
+}
+
+// Add the channels of a page image, with the conversions of the firmware
+static void DecodePage(Monitor& monitor, int64_t time_ms, uint8_t page, const uint8_t* data)
+{
+    switch (page)
+    {
+        case 0:
+        {
+            float temperature = (((int16_t)data[2] << 8) | (data[1] >> 3)) * 0.03125;
+            float voltage = ((data[4] << 8) | data[3]) / 100.0;
+            int16_t current = (data[6] << 8) | data[5];
+            if ((data[6] & 0x03) > 1)
+                current = -(int16_t)(~current & 0x3FF);
+            float amps = current / (4096. * SENSE_RESISTOR);
+            monitor.channels[kTemperature].push_back({time_ms, int32_t(temperature * 1000)});
+            monitor.channels[kVoltage].push_back({time_ms, int32_t(voltage * 1000)});
+            monitor.channels[kCurrent].push_back({time_ms, int32_t(amps * 1000)});
+            break;
+        }
+        case 1:
+            monitor.channels[kEtm].push_back({time_ms, int32_t(data[0] | (data[1] << 8) | (data[2] << 16) |
+                                                              (uint32_t(data[3]) << 24))});
+            monitor.channels[kIca].push_back({time_ms, data[4]});
+            break;
+        case 7:
+            monitor.channels[kCca].push_back({time_ms, (data[5] << 8) | data[4]});
+            monitor.channels[kDca].push_back({time_ms, (data[7] << 8) | data[6]});
+            break;
+    }
+}
+
+static bool IngestRaw(Monitor& monitor, const MappedFile& file)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(file.Data());
+    size_t records = file.Size() / RAW_RECORD_SIZE;
+    for (size_t n = 0; n < records; n++)
+    {
+        const uint8_t* record = &bytes[n * RAW_RECORD_SIZE];
+        int64_t time_ms;
+        memcpy(&time_ms, record, sizeof(time_ms));
+        const uint8_t* page_data = &record[9];
+        if ((record[8] > 7) || (Crc8(page_data, 8) != page_data[8]))
+        {
+            monitor.channels[kErrors].push_back({time_ms, EVENT_PAGE});
+            total_errors++;
+            continue;
+        }
+        DecodePage(monitor, time_ms, record[8], page_data);
+    }
+    total_lines += records;
+    return (file.Size() % RAW_RECORD_SIZE) == 0;
+}
+
+// Parse a decimal integer, advancing the pointer
+static bool ParseInt(const char*& p, const char* end, int64_t* value)
+{
+    bool negative = (p < end) && (*p == '-');
+    if (negative)
+        p++;
+    if ((p == end) || (*p < '0') || (*p > '9'))
+        return false;
+    int64_t result = 0;
+    while ((p < end) && (*p >= '0') && (*p <= '9'))
+        result = result * 10 + (*p++ - '0');
+    *value = negative ? -result : result;
+    return true;
+}
+
+// Parse a time prefix in seconds, "1700000000.123 " or "[1700000000.123] "
+static bool ParseTimePrefix(const char*& p, const char* end, int64_t* time_ms)
+{
+    const char* q = p;
+    bool bracket = (q < end) && (*q == '[');
+    if (bracket)
+        q++;
+    int64_t seconds;
+    if (!ParseInt(q, end, &seconds))
+        return false;
+    int64_t ms = seconds * 1000;
+    if ((q < end) && (*q == '.'))
+    {
+        int64_t scale = 100;
+        for (q++; (q < end) && (*q >= '0') && (*q <= '9'); q++, scale /= 10)
+            ms += (*q - '0') * scale;
+    }
+    if (bracket)
+    {
+        if ((q == end) || (*q != ']'))
+            return false;
+        q++;
+    }
+    if ((q == end) || ((*q != ' ') && (*q != '\t')))
+        return false;
+    while ((q < end) && ((*q == ' ') || (*q == '\t')))
+        q++;
+    p = q;
+    *time_ms = ms;
+    return true;
+}
+
+static bool StartsWith(const char*& p, const char* end, const char* prefix)
+{
+    size_t length = strlen(prefix);
+    if ((size_t(end - p) < length) || (memcmp(p, prefix, length) != 0))
+        return false;
+    p += length;
+    return true;
+}
+
+static int HexDigit(char c)
+{
+    if ((c >= '0') && (c <= '9')) return c - '0';
+    if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+    if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+    return -1;
+}
+
+// Parse a page line, "0x00 0x01 ... 0x07"
+static bool ParsePage(const char* p, const char* end, uint8_t* data)
+{
+    for (int n = 0; n < 8; n++)
+    {
+        if ((end - p < 4) || (p[0] != '0') || (p[1] != 'x') || (HexDigit(p[2]) < 0) || (HexDigit(p[3]) < 0))
+            return false;
+        data[n] = (HexDigit(p[2]) << 4) | HexDigit(p[3]);
+        p += 4;
+        if (n < 7)
+        {
+            if ((p == end) || (*p != ' '))
+                return false;
+            p++;
+        }
+    }
+    return p == end;
+}
+
+static void IngestText(Monitor& monitor, const MappedFile& file, const Options& options)
+{
+    static const char* const error_names[] = {"voltage", "temperature", "current", "capacity", "page", "history"};
+    const char* p = file.Data();
+    const char* const end = p + file.Size();
+
+    // Without time prefixes, the time field first holds the cycle number
+    std::vector<Sample> samples[kChannels];
+    bool timed = false;
+    int64_t line_ms = 0;
+    int64_t cycle = -1;
+    int page = 0;
+    bool pages_valid = false;
+    uint64_t lines = 0;
+
+    while (p < end)
+    {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* next = eol ? eol + 1 : end;
+        const char* line_end = eol ? eol : end;
+        if ((line_end > p) && (line_end[-1] == '\r'))
+            line_end--;
+        lines++;
+
+        int64_t prefix_ms;
+        if (ParseTimePrefix(p, line_end, &prefix_ms))
+        {
+            timed = true;
+            line_ms = prefix_ms;
+        }
+        int64_t value, cca, dca;
+        uint8_t page_data[8];
+        // A cycle starts with the voltage measurement
+        bool voltage_line = StartsWith(p, line_end, "Voltage: ");
+        bool voltage_error = !voltage_line && (size_t(line_end - p) == strlen("Could not read voltage")) &&
+                             (memcmp(p, "Could not read voltage", line_end - p) == 0);
+        if (voltage_line || voltage_error)
+        {
+            cycle++;
+            page = 0;
+            pages_valid = true;
+        }
+        int64_t time = timed ? line_ms : cycle;
+        if (cycle < 0)
+        {
+            // Boot messages, before the first cycle
+        }
+        else if (voltage_line)
+        {
+            if (ParseInt(p, line_end, &value))
+                samples[kVoltage].push_back({time, int32_t(value)});
+        }
+        else if (StartsWith(p, line_end, "Temperature: ") && ParseInt(p, line_end, &value))
+        {
+            samples[kTemperature].push_back({time, int32_t(value)});
+        }
+        else if (StartsWith(p, line_end, "mAmps: ") && ParseInt(p, line_end, &value))
+        {
+            samples[kCurrent].push_back({time, int32_t(value)});
+        }
+        else if (StartsWith(p, line_end, "Capacity: ") && ParseInt(p, line_end, &value))
+        {
+            samples[kCapacity].push_back({time, int32_t(value)});
+        }
+        else if (StartsWith(p, line_end, "ETM: ") && ParseInt(p, line_end, &value) &&
+                 StartsWith(p, line_end, " CCA: ") && ParseInt(p, line_end, &cca) &&
+                 StartsWith(p, line_end, " DCA: ") && ParseInt(p, line_end, &dca))
+        {
+            samples[kEtm].push_back({time, int32_t(value)});
+            samples[kCca].push_back({time, int32_t(cca)});
+            samples[kDca].push_back({time, int32_t(dca)});
+        }
+        else if (ParsePage(p, line_end, page_data))
+        {
+            // Pages 0 to 6 follow the measurements; page 0 values are already sent as text
+            if (pages_valid && (page == 1))
+                samples[kIca].push_back({time, page_data[4]});
+            page++;
+        }
+        else if (StartsWith(p, line_end, "Could not read page "))
+        {
+            samples[kErrors].push_back({time, EVENT_PAGE});
+            page++;
+        }
+        else if (StartsWith(p, line_end, "Could not read "))
+        {
+            for (int type = 0; type < 6; type++)
+            {
+                if ((size_t(line_end - p) == strlen(error_names[type])) &&
+                    (memcmp(p, error_names[type], line_end - p) == 0))
+                    samples[kErrors].push_back({time, type});
+            }
+        }
+        else if (StartsWith(p, line_end, "Lost ") && ParseInt(p, line_end, &value))
+        {
+            // Page lines of this cycle may be missing: their number is unknown
+            samples[kLost].push_back({time, int32_t(value)});
+            pages_valid = false;
+        }
+        p = next;
+    }
+
+    int64_t base_ms = 0, period_ms = options.period_ms;
+    if (timed)
+        period_ms = 1;
+    else if (options.start_ms >= 0)
+        base_ms = options.start_ms;
+    else
+        base_ms = file.ModifiedMs() - (cycle + 1) * period_ms;
+    for (int channel = 0; channel < kChannels; channel++)
+    {
+        for (Sample& sample : samples[channel])
+        {
+            sample.time_ms = base_ms + sample.time_ms * period_ms;
+            monitor.channels[channel].push_back(sample);
+        }
+        total_errors += (channel == kErrors) ? samples[channel].size() : 0;
+    }
+    total_lines += lines;
+}
+
+// ===========================================================
+//                      STORE
+// ===========================================================
+
+static bool EndsWith(const std::string& text, const std::string& suffix)
+{
+    return (text.size() >= suffix.size()) && (text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+static std::string MonitorName(const std::string& path)
+{
+    size_t slash = path.rfind('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find('.');
+    return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+// Sort the new samples and merge them with the stored ones; new samples replace stored ones at the same time.
+// Measurement channels keep one sample per time. Event channels keep every event of a time, as a cycle
+// can report several errors: the new events of a time replace all the stored events of that time.
+static bool StoreChannel(const std::string& directory, int channel, std::vector<Sample>& samples)
+{
+    if (samples.empty())
+        return true;
+    auto earlier = [](const Sample& a, const Sample& b) { return a.time_ms < b.time_ms; };
+    std::stable_sort(samples.begin(), samples.end(), earlier);
+    bool events = (channel == kErrors) || (channel == kLost);
+    std::string path = directory + "/" + kChannelNames[channel] + ".col";
+    ColumnFile stored;
+    std::vector<Sample> merged;
+    if (stored.Open(path))
+    {
+        merged.reserve(stored.Count() + samples.size());
+        const int64_t* times = stored.Times();
+        const int32_t* values = stored.Values();
+        for (uint64_t n = 0; n < stored.Count(); n++)
+        {
+            // Stored events of a time with new events are replaced
+            Sample sample = {times[n], values[n]};
+            if (!events || !std::binary_search(samples.begin(), samples.end(), sample, earlier))
+                merged.push_back(sample);
+        }
+        stored.Close();
+        size_t middle = merged.size();
+        merged.insert(merged.end(), samples.begin(), samples.end());
+        std::inplace_merge(merged.begin(), merged.begin() + middle, merged.end(), earlier);
+    }
+    else
+    {
+        merged.swap(samples);
+    }
+    if (!events)
+    {
+        // Keep the last sample of each time, i.e. the newest one
+        size_t kept = 0;
+        for (size_t n = 0; n < merged.size(); n++)
+        {
+            if ((kept > 0) && (merged[kept - 1].time_ms == merged[n].time_ms))
+                merged[kept - 1] = merged[n];
+            else
+                merged[kept++] = merged[n];
+        }
+        merged.resize(kept);
+    }
+    total_samples += merged.size();
+    return WriteColumn(path, merged);
+}
+
+static bool IngestMonitor(Monitor& monitor, const Options& options)
+{
+    bool ok = true;
+    for (const std::string& path : monitor.files)
+    {
+        MappedFile file(path);
+        if (!file.Ok())
+        {
+            fprintf(stderr, "%s: cannot read\n", path.c_str());
+            ok = false;
+            continue;
+        }
+        total_bytes += file.Size();
+        if (EndsWith(path, ".pages"))
+        {
+            if (!IngestRaw(monitor, file))
+                fprintf(stderr, "%s: partial record at the end ignored\n", path.c_str());
+        }
+        else
+        {
+            IngestText(monitor, file, options);
+        }
+    }
+    std::string directory = options.store + "/" + monitor.name;
+    mkdir(directory.c_str(), 0755);
+    for (int channel = 0; channel < kChannels; channel++)
+    {
+        if (!StoreChannel(directory, channel, monitor.channels[channel]))
+        {
+            fprintf(stderr, "%s: cannot write %s\n", directory.c_str(), kChannelNames[channel]);
+            ok = false;
+        }
+        std::vector<Sample>().swap(monitor.channels[channel]);
+    }
+    return ok;
+}
+
+// ===========================================================
+//                      COMMANDS
+// ===========================================================
+
+static int64_t ParseTime(const char* text)
+{
+    struct tm tm = {};
+    const char* end = strptime(text, "%Y-%m-%dT%H:%M:%S", &tm);
+    if ((end == nullptr) || (*end != 0))
+    {
+        tm = {};
+        end = strptime(text, "%Y-%m-%d", &tm);
+    }
+    if ((end != nullptr) && (*end == 0))
+        return int64_t(timegm(&tm)) * 1000;
+    return int64_t(strtod(text, nullptr) * 1000);
+}
+
+static int Ingest(int argc, char** argv)
+{
+    Options options;
+    int option;
+    while ((option = getopt(argc, argv, "j:p:s:o:")) != -1)
+    {
+        switch (option)
+        {
+            case 'j': options.threads = atoi(optarg); break;
+            case 'p': options.period_ms = atoll(optarg); break;
+            case 's': options.start_ms = ParseTime(optarg); break;
+            case 'o': options.store = optarg; break;
+            default: return 2;
+        }
+    }
+    if (options.store.empty() || (optind == argc) || (options.period_ms <= 0))
+    {
+        fprintf(stderr, "usage: telemetry_ingest ingest [-j threads] [-p period_ms] [-s start] -o store files...\n");
+        return 2;
+    }
+    mkdir(options.store.c_str(), 0755);
+
+    std::map<std::string, size_t> index;
+    std::vector<Monitor> monitors;
+    for (int n = optind; n < argc; n++)
+    {
+        std::string name = MonitorName(argv[n]);
+        auto found = index.find(name);
+        if (found == index.end())
+        {
+            found = index.emplace(name, monitors.size()).first;
+            monitors.emplace_back();
+            monitors.back().name = name;
+        }
+        monitors[found->second].files.push_back(argv[n]);
+    }
+
+    unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<size_t>(threads, monitors.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> ok(true);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned n = 0; n < threads; n++)
+    {
+        workers.emplace_back([&] {
+            for (size_t m = next++; m < monitors.size(); m = next++)
+            {
+                if (!IngestMonitor(monitors[m], options))
+                    ok = false;
+            }
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("monitors=%zu files=%d threads=%u\n", monitors.size(), argc - optind, threads);
+    printf("bytes=%llu lines=%llu samples_stored=%llu errors=%llu\n", (unsigned long long)total_bytes,
+           (unsigned long long)total_lines, (unsigned long long)total_samples, (unsigned long long)total_errors);
+    printf("time_s=%.3f throughput_MBps=%.1f\n", seconds, total_bytes / 1e6 / (seconds > 0 ? seconds : 1));
+    return ok ? 0 : 1;
+}
+
+static int Query(int argc, char** argv)
+{
+    bool rows = false;
+    int64_t bucket_ms = 0;
+    int option;
+    while ((option = getopt(argc, argv, "rb:")) != -1)
+    {
+        switch (option)
+        {
+            case 'r': rows = true; break;
+            case 'b': bucket_ms = int64_t(atof(optarg) * 1000); break;
+            default: return 2;
+        }
+    }
+    if (argc - optind != 5)
+    {
+        fprintf(stderr, "usage: telemetry_ingest query [-r] [-b bucket_s] store monitor channel from to\n");
+        return 2;
+    }
+    int channel = ChannelFromName(argv[optind + 2]);
+    if (channel < 0)
+    {
+        fprintf(stderr, "unknown channel %s\n", argv[optind + 2]);
+        return 2;
+    }
+    std::string path = std::string(argv[optind]) + "/" + argv[optind + 1] + "/" + kChannelNames[channel] + ".col";
+    int64_t from_ms = ParseTime(argv[optind + 3]);
+    int64_t to_ms = ParseTime(argv[optind + 4]);
+
+    auto start = std::chrono::steady_clock::now();
+    ColumnFile column;
+    if (!column.Open(path))
+    {
+        fprintf(stderr, "%s: no data\n", path.c_str());
+        return 1;
+    }
+    if (rows)
+    {
+        uint64_t first, last;
+        column.Range(from_ms, to_ms, &first, &last);
+        for (uint64_t n = first; n < last; n++)
+            printf("%lld.%03lld %d\n", (long long)(column.Times()[n] / 1000), (long long)(column.Times()[n] % 1000),
+                   column.Values()[n]);
+    }
+    else if (bucket_ms > 0)
+    {
+        for (int64_t time_ms = from_ms; time_ms < to_ms; time_ms += bucket_ms)
+        {
+            Aggregate aggregate = column.Reduce(time_ms, std::min(time_ms + bucket_ms, to_ms));
+            if (aggregate.count > 0)
+                printf("%lld count=%llu min=%d max=%d mean=%.3f\n", (long long)(time_ms / 1000),
+                       (unsigned long long)aggregate.count, aggregate.min, aggregate.max, aggregate.Mean());
+        }
+    }
+    else
+    {
+        Aggregate aggregate = column.Reduce(from_ms, to_ms);
+        printf("count=%llu", (unsigned long long)aggregate.count);
+        if (aggregate.count > 0)
+            printf(" min=%d max=%d mean=%.3f", aggregate.min, aggregate.max, aggregate.Mean());
+        printf("\n");
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "query_time_us=%.0f\n", us);
+    return 0;
+}
+
+static int List(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: telemetry_ingest list store\n");
+        return 2;
+    }
+    DIR* store = opendir(argv[1]);
+    if (store == nullptr)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    std::vector<std::string> names;
+    for (struct dirent* entry = readdir(store); entry != nullptr; entry = readdir(store))
+    {
+        if (entry->d_name[0] != '.')
+            names.push_back(entry->d_name);
+    }
+    closedir(store);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names)
+    {
+        for (int channel = 0; channel < kChannels; channel++)
+        {
+            ColumnFile column;
+            if (!column.Open(std::string(argv[1]) + "/" + name + "/" + kChannelNames[channel] + ".col") ||
+                (column.Count() == 0))
+                continue;
+            printf("%s %s count=%llu from=%lld to=%lld\n", name.c_str(), kChannelNames[channel],
+                   (unsigned long long)column.Count(), (long long)(column.Times()[0] / 1000),
+                   (long long)(column.Times()[column.Count() - 1] / 1000));
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2)
+    {
+        std::string command = argv[1];
+        if (command == "ingest")
+            return Ingest(argc - 1, argv + 1);
+        if (command == "query")
+            return Query(argc - 1, argv + 1);
+        if (command == "list")
+            return List(argc - 1, argv + 1);
+    }
+    fprintf(stderr, "usage: telemetry_ingest ingest|query|list ...\n");
+    return 2;
+}
+
+/* [] END OF FILE */
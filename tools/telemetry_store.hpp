@@ -0,0 +1,307 @@
+/**
+ * \file telemetry_store.hpp
+ * \brief Columnar telemetry store written by telemetry_ingest.
+ *
+ * A store is a directory with one folder per monitor and one file per
+ * channel, e.g. store/rack3-07/voltage.col. A channel file holds the
+ * samples sorted by time, as two columns, followed by a time index:
+ *
+ *  - header (#ColumnHeader, 64 bytes);
+ *  - times, int64 ms since the Unix epoch;
+ *  - values, int32, in the units of the UART output (mV, mA, ...);
+ *  - one #BlockSummary per block of #kBlockSize samples.
+ *
+ * All fields are little-endian and aligned to their size, so the file
+ * is used in place through mmap. Range queries find the first and last
+ * sample with a binary search on the times; aggregates use the block
+ * summaries for the blocks fully inside the range, and only read the
+ * samples of the two partial blocks at its ends.
+ *
+ * Header-only, requires C++17 and POSIX.
+*/
+#ifndef __TELEMETRY_STORE_HPP__
+    #define __TELEMETRY_STORE_HPP__
+
+    #include <algorithm>
+    #include <cstdint>
+    #include <cstdio>
+    #include <cstring>
+    #include <limits>
+    #include <string>
+    #include <vector>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+
+    namespace telemetry
+    {
+
+    /**
+    *   \brief Samples per block of the time index.
+    */
+    constexpr uint32_t kBlockSize = 4096;
+
+    /**
+    *   \brief Channels of a monitor.
+    */
+    enum Channel : uint8_t
+    {
+        kVoltage,           ///< Voltage, mV
+        kTemperature,       ///< Temperature, thousandths of degree Celsius
+        kCurrent,           ///< Current, mA
+        kCapacity,          ///< Remaining capacity, mAh
+        kIca,               ///< Raw ICA, from page 1
+        kEtm,               ///< Elapsed time meter, s
+        kCca,               ///< Raw CCA, from page 7 or history
+        kDca,               ///< Raw DCA, from page 7 or history
+        kErrors,            ///< Failed measurement, value is the event type (0 voltage to 5 history)
+        kLost,              ///< Events lost by the monitor, value is the count
+        kChannels
+    };
+
+    static const char* const kChannelNames[kChannels] = {
+        "voltage", "temperature", "current", "capacity", "ica",
+        "etm", "cca", "dca", "errors", "lost"
+    };
+
+    inline int ChannelFromName(const std::string& name)
+    {
+        for (int channel = 0; channel < kChannels; channel++)
+        {
+            if (name == kChannelNames[channel])
+                return channel;
+        }
+        return -1;
+    }
+
+    struct ColumnHeader
+    {
+        char magic[8];              ///< "DS2438TC"
+        uint32_t version;           ///< Format version, 1
+        uint32_t block_size;        ///< Samples per block
+        uint64_t count;             ///< Number of samples
+        uint64_t blocks;            ///< Number of block summaries
+        uint64_t times_offset;      ///< Offset of the times, in bytes
+        uint64_t values_offset;     ///< Offset of the values, in bytes
+        uint64_t index_offset;      ///< Offset of the block summaries, in bytes
+        uint64_t reserved;          ///< 0
+    };
+    static_assert(sizeof(ColumnHeader) == 64, "Column header layout");
+
+    struct BlockSummary
+    {
+        int64_t first_ms;           ///< Time of the first sample of the block
+        int64_t last_ms;            ///< Time of the last sample of the block
+        int64_t sum;                ///< Sum of the values
+        int32_t min;                ///< Minimum value
+        int32_t max;                ///< Maximum value
+    };
+    static_assert(sizeof(BlockSummary) == 32, "Block summary layout");
+
+    /**
+    *   \brief Sample of a channel.
+    */
+    struct Sample
+    {
+        int64_t time_ms;
+        int32_t value;
+    };
+
+    /**
+    *   \brief Aggregate of the samples of a time range.
+    */
+    struct Aggregate
+    {
+        uint64_t count = 0;
+        int64_t sum = 0;
+        int32_t min = std::numeric_limits<int32_t>::max();
+        int32_t max = std::numeric_limits<int32_t>::min();
+
+        void Add(int32_t value)
+        {
+            count++;
+            sum += value;
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        double Mean() const { return count ? double(sum) / count : 0.0; }
+    };
+
+    // ===========================================================
+    //                      READER
+    // ===========================================================
+
+    /**
+    *   \brief Memory-mapped channel file.
+    */
+    class ColumnFile
+    {
+    public:
+        ColumnFile() = default;
+        ColumnFile(const ColumnFile&) = delete;
+        ColumnFile& operator=(const ColumnFile&) = delete;
+        ~ColumnFile() { Close(); }
+
+        /**
+        *   \brief Map a channel file.
+        *   \return false if the file does not exist or is not valid.
+        */
+        bool Open(const std::string& path)
+        {
+            Close();
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(ColumnHeader)))
+            {
+                close(fd);
+                return false;
+            }
+            void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED)
+                return false;
+            map_ = static_cast<const uint8_t*>(map);
+            size_ = st.st_size;
+            const ColumnHeader* header = reinterpret_cast<const ColumnHeader*>(map_);
+            if ((memcmp(header->magic, "DS2438TC", 8) != 0) || (header->version != 1) ||
+                (header->block_size == 0) ||
+                (header->times_offset + header->count * sizeof(int64_t) > size_) ||
+                (header->values_offset + header->count * sizeof(int32_t) > size_) ||
+                (header->index_offset + header->blocks * sizeof(BlockSummary) > size_))
+            {
+                Close();
+                return false;
+            }
+            header_ = header;
+            return true;
+        }
+
+        void Close()
+        {
+            if (map_ != nullptr)
+                munmap(const_cast<uint8_t*>(map_), size_);
+            map_ = nullptr;
+            header_ = nullptr;
+            size_ = 0;
+        }
+
+        uint64_t Count() const { return header_ ? header_->count : 0; }
+        const int64_t* Times() const { return reinterpret_cast<const int64_t*>(map_ + header_->times_offset); }
+        const int32_t* Values() const { return reinterpret_cast<const int32_t*>(map_ + header_->values_offset); }
+        const BlockSummary* Blocks() const { return reinterpret_cast<const BlockSummary*>(map_ + header_->index_offset); }
+
+        /**
+        *   \brief Get the samples in [from_ms, to_ms), as a range of indexes.
+        */
+        void Range(int64_t from_ms, int64_t to_ms, uint64_t* first, uint64_t* last) const
+        {
+            const int64_t* times = Times();
+            *first = std::lower_bound(times, times + Count(), from_ms) - times;
+            *last = std::lower_bound(times + *first, times + Count(), to_ms) - times;
+        }
+
+        /**
+        *   \brief Aggregate the samples in [from_ms, to_ms).
+        */
+        Aggregate Reduce(int64_t from_ms, int64_t to_ms) const
+        {
+            Aggregate result;
+            if (Count() == 0)
+                return result;
+            uint64_t first, last;
+            Range(from_ms, to_ms, &first, &last);
+            const uint64_t block_size = header_->block_size;
+            const int32_t* values = Values();
+            const BlockSummary* blocks = Blocks();
+
+            // Partial block at the start
+            uint64_t index = first;
+            uint64_t aligned = std::min(last, (first + block_size - 1) / block_size * block_size);
+            for (; index < aligned; index++)
+                result.Add(values[index]);
+            // Whole blocks
+            for (; index + block_size <= last; index += block_size)
+            {
+                const BlockSummary& block = blocks[index / block_size];
+                result.count += block_size;
+                result.sum += block.sum;
+                result.min = std::min(result.min, block.min);
+                result.max = std::max(result.max, block.max);
+            }
+            // Partial block at the end
+            for (; index < last; index++)
+                result.Add(values[index]);
+            return result;
+        }
+
+    private:
+        const uint8_t* map_ = nullptr;
+        const ColumnHeader* header_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // ===========================================================
+    //                      WRITER
+    // ===========================================================
+
+    /**
+    *   \brief Write a channel file from samples sorted by time.
+    *
+    *   The file is written under a temporary name and renamed, so that
+    *   readers never map a partial file.
+    *   \return false on error.
+    */
+    inline bool WriteColumn(const std::string& path, const std::vector<Sample>& samples)
+    {
+        ColumnHeader header = {};
+        memcpy(header.magic, "DS2438TC", 8);
+        header.version = 1;
+        header.block_size = kBlockSize;
+        header.count = samples.size();
+        header.blocks = (samples.size() + kBlockSize - 1) / kBlockSize;
+        header.times_offset = sizeof(ColumnHeader);
+        header.values_offset = header.times_offset + header.count * sizeof(int64_t);
+        header.index_offset = (header.values_offset + header.count * sizeof(int32_t) + 7) & ~uint64_t(7);
+
+        std::vector<int64_t> times(samples.size());
+        std::vector<int32_t> values(samples.size());
+        std::vector<BlockSummary> blocks(header.blocks);
+        for (size_t n = 0; n < samples.size(); n++)
+        {
+            times[n] = samples[n].time_ms;
+            values[n] = samples[n].value;
+            BlockSummary& block = blocks[n / kBlockSize];
+            if (n % kBlockSize == 0)
+                block = {samples[n].time_ms, samples[n].time_ms, 0, values[n], values[n]};
+            block.last_ms = samples[n].time_ms;
+            block.sum += values[n];
+            block.min = std::min(block.min, values[n]);
+            block.max = std::max(block.max, values[n]);
+        }
+
+        std::string temporary = path + ".tmp";
+        FILE* file = fopen(temporary.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+        static const uint8_t padding[8] = {0};
+        bool ok = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+                  (fwrite(times.data(), sizeof(int64_t), times.size(), file) == times.size()) &&
+                  (fwrite(values.data(), sizeof(int32_t), values.size(), file) == values.size()) &&
+                  (fwrite(padding, 1, header.index_offset - header.values_offset - values.size() * sizeof(int32_t),
+                          file) == header.index_offset - header.values_offset - values.size() * sizeof(int32_t)) &&
+                  (fwrite(blocks.data(), sizeof(BlockSummary), blocks.size(), file) == blocks.size());
+        ok = (fclose(file) == 0) && ok;
+        if (ok)
+            ok = (rename(temporary.c_str(), path.c_str()) == 0);
+        if (!ok)
+            unlink(temporary.c_str());
+        return ok;
+    }
+
+    } // namespace telemetry
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,117 @@
+/********************************************
+*
+*   \brief Host check of DS2438_ReadBothVoltages().
+*
+*   Runs the DS2438 Library on the host platform against
+*   a simulated device (see tools/host/ds2438_model.h)
+*   whose VDD and VAD differ, with the AD bit of the
+*   stored configuration set and cleared, and checks
+*   that each input is read from the right channel, that
+*   the other input is left stored, that each call makes
+*   a single copy to memory and that it completes within
+*   two conversions, the copy and the bus time of the
+*   page 0 transactions. Voltages change between calls,
+*   so a result left over from a previous conversion is
+*   detected too.
+*
+*   The exit status is 1 if any check failed.
+*
+*   Build, from the repository root:
+*   gcc -O2 -Wall -Itools/host -IDS2438.cydsn -o voltage_check tools/voltage_check.c
+*       tools/host/host_platform.c tools/host/ds2438_model.c DS2438.cydsn/OneWire.c
+*       DS2438.cydsn/Timebase.c DS2438.cydsn/DS2438.c DS2438.cydsn/DS2438_Cache.c
+*       DS2438.cydsn/DS2438_Snapshot.c
+*   Usage: voltage_check
+*
+**********************************************/
+
+#include "ds2438_model.h"
+#include "DS2438.h"
+#include <stdio.h>
+
+#define STATUS_AD   0x08
+
+// Bus time at standard speed of a page transaction (reset and RECALL or WRITE
+// SCRATCHPAD, reset and READ SCRATCHPAD or COPY SCRATCHPAD) and of a conversion
+// command, in us
+#define PAGE_TRANSACTION_US     12000
+#define CONVERT_COMMAND_US      3000
+
+static DS2438_Model model;
+static DS2438_ModelBus model_bus;
+
+// Read both voltages with the given stored input, returns the number of failures
+static int Check_Read(uint8_t stored_ad, uint16_t vdd, uint16_t vad)
+{
+    uint16_t read_vdd = 0, read_vad = 0;
+    uint8_t config = (model.memory[0][0] & ~STATUS_AD) | stored_ad;
+    model.memory[0][0] = config;
+    model.vdd = vdd;
+    model.vad = vad;
+    uint32_t copies = model.copies;
+    uint64_t start_us = Host_GetUs();
+    uint8_t error = DS2438_ReadBothVoltages(&read_vdd, &read_vad);
+    uint64_t elapsed_us = Host_GetUs() - start_us;
+    copies = model.copies - copies;
+
+    // Two conversions with their page 0 read, one page 0 write and its copy
+    uint64_t bound_us = 2ull * (model.conversion_us + CONVERT_COMMAND_US) + model.copy_us +
+                        3 * PAGE_TRANSACTION_US;
+    int failed = (error != DS2438_OK) || (read_vdd != vdd) || (read_vad != vad) ||
+                 ((model.memory[0][0] & 0x0F) != ((config ^ STATUS_AD) & 0x0F)) ||
+                 (copies != 1) || (elapsed_us > bound_us);
+    printf("AD=%u vdd=%3u vad=%3u: error %u, read vdd=%3u vad=%3u, config %02X -> %02X, %u copies, %.1f ms  %s\n",
+           stored_ad ? 1 : 0, vdd, vad, error, read_vdd, read_vad, config & 0x0F, model.memory[0][0] & 0x0F,
+           copies, elapsed_us / 1000.0, failed ? "FAIL" : "ok");
+    return failed;
+}
+
+// Read both voltages twice without changing the configuration, returns the number of failures
+static int Check_Chained(uint16_t vdd, uint16_t vad)
+{
+    uint16_t read_vdd = 0, read_vad = 0;
+    uint8_t config = model.memory[0][0];
+    model.vdd = vdd;
+    model.vad = vad;
+    uint32_t copies = model.copies;
+    uint8_t error = DS2438_ReadBothVoltages(&read_vdd, &read_vad);
+    if (error == DS2438_OK)
+        error = DS2438_ReadBothVoltages(&read_vdd, &read_vad);
+    copies = model.copies - copies;
+
+    int failed = (error != DS2438_OK) || (read_vdd != vdd) || (read_vad != vad) ||
+                 ((model.memory[0][0] & 0x0F) != (config & 0x0F)) || (copies != 2);
+    printf("two calls vdd=%3u vad=%3u: error %u, read vdd=%3u vad=%3u, config %02X -> %02X, %u copies  %s\n",
+           vdd, vad, error, read_vdd, read_vad, config & 0x0F, model.memory[0][0] & 0x0F, copies,
+           failed ? "FAIL" : "ok");
+    return failed;
+}
+
+int main(void)
+{
+    DS2438_Model* devices[1] = {&model};
+    int failed = 0;
+
+    DS2438_ModelInit(&model, 0x0102030405ull);
+    DS2438_ModelBusInit(&model_bus, devices, 1);
+    Host_Bus host = DS2438_ModelBusHost(&model_bus);
+    Host_SetBus(&host);
+    if (DS2438_Start() != DS2438_OK)
+    {
+        fprintf(stderr, "Device not found\n");
+        return 1;
+    }
+
+    failed += Check_Read(STATUS_AD, 500, 123);
+    failed += Check_Read(0, 500, 123);
+    failed += Check_Read(STATUS_AD, 412, 37);
+    failed += Check_Read(0, 388, 251);
+    failed += Check_Read(0, 388, 251);
+    failed += Check_Read(STATUS_AD, 120, 480);
+    failed += Check_Chained(301, 99);
+
+    printf("%d failed\n", failed);
+    return failed ? 1 : 0;
+}
+
+/* [] END OF FILE */